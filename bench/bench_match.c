@@ -0,0 +1,153 @@
+/*
+ * =====================================================================================
+ * File: bench_match.c
+ * Description: Compares the substring kernels in match.c with the strstr loop the
+ *              inventory search used to run, over a block of synthetic inventory
+ *              records held in memory. Prints the time per record for each
+ *              kernel and each search term.
+ *
+ *              Usage: bin/bench_match [record count]
+ *
+ * Author: Chiemezie Agbo
+ * Date: 17-10-2026
+ * Version: 1.0
+ * =====================================================================================
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#include "../include/common.h"
+#include "../include/match.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <time.h>
+
+#define BENCH_DEFAULT_RECORDS 200000
+#define BENCH_ROUNDS 5
+
+static const char *words[] = {
+    "steel", "widget", "bracket", "copper", "pipe", "valve", "plastic", "small", "large", "blue",
+    "green", "red", "fitting", "washer", "bolt", "screw", "hinge", "handle", "spring", "gasket",
+};
+
+static double nowSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void appendWords(char *text, size_t width, int count) {
+    text[0] = '\0';
+    for (int i = 0; i < count; i++) {
+        const char *word = words[rand() % (int)(sizeof(words) / sizeof(words[0]))];
+        if (strlen(text) + strlen(word) + 2 > width) {
+            break;
+        }
+        if (i > 0) {
+            strcat(text, " ");
+        }
+        strcat(text, word);
+    }
+}
+
+static InventoryItem *generateItems(long count) {
+    InventoryItem *items = calloc((size_t)count, sizeof(InventoryItem));
+    if (items == NULL) {
+        return NULL;
+    }
+    for (long i = 0; i < count; i++) {
+        items[i].id = (int)i + 1;
+        appendWords(items[i].name, MAX_NAME_LENGTH, 2 + rand() % 2);
+        appendWords(items[i].description, MAX_DESCRIPTION_LENGTH, 4 + rand() % 20);
+    }
+    return items;
+}
+
+/* The loop searchInventoryItem ran before the kernels */
+static long strstrSearch(const InventoryItem *items, long count, const char *term) {
+    long found = 0;
+    for (long i = 0; i < count; i++) {
+        if (items[i].id > 0 && (strstr(items[i].name, term) || strstr(items[i].description, term))) {
+            found++;
+        }
+    }
+    return found;
+}
+
+static long kernelSearch(const InventoryItem *items, long count, const char *term, unsigned char *hits) {
+    static const MatchField fields[] = {
+        {offsetof(InventoryItem, name), MAX_NAME_LENGTH},
+        {offsetof(InventoryItem, description), MAX_DESCRIPTION_LENGTH},
+    };
+    matchRecords(items, count, sizeof(InventoryItem), fields, 2, term, hits);
+    long found = 0;
+    for (long i = 0; i < count; i++) {
+        found += hits[i] && items[i].id > 0;
+    }
+    return found;
+}
+
+int main(int argc, char *argv[]) {
+    long count = argc > 1 ? atol(argv[1]) : BENCH_DEFAULT_RECORDS;
+    if (count <= 0) {
+        printf("Usage: %s [record count]\n", argv[0]);
+        return 1;
+    }
+
+    srand(1);
+    InventoryItem *items = generateItems(count);
+    unsigned char *hits = malloc((size_t)count);
+    if (items == NULL || hits == NULL) {
+        printf("Out of memory!\n");
+        return 1;
+    }
+
+    const char *terms[] = {"bolt", "gasket spring", "xyz", "st"};
+    const char *kernels[] = {"strstr", "scalar", "sse2", "avx2"};
+
+    printf("%ld records, best of %d rounds, ns per record\n", count, BENCH_ROUNDS);
+    printf("%-16s", "term");
+    for (size_t k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++) {
+        printf("%12s", kernels[k]);
+    }
+    printf("%10s\n", "matches");
+
+    int failed = 0;
+    for (size_t t = 0; t < sizeof(terms) / sizeof(terms[0]); t++) {
+        long expected = strstrSearch(items, count, terms[t]);
+        printf("%-16s", terms[t]);
+
+        for (size_t k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++) {
+            int isStrstr = strcmp(kernels[k], "strstr") == 0;
+            if (!isStrstr && !matchSetKernel(kernels[k])) {
+                printf("%12s", "n/a");
+                continue;
+            }
+
+            double best = 0;
+            for (int round = 0; round < BENCH_ROUNDS; round++) {
+                double start = nowSeconds();
+                long found = isStrstr ? strstrSearch(items, count, terms[t]) : kernelSearch(items, count, terms[t], hits);
+                double elapsed = nowSeconds() - start;
+                if (found != expected) {
+                    failed = 1;
+                }
+                if (round == 0 || elapsed < best) {
+                    best = elapsed;
+                }
+            }
+            printf("%12.1f", best * 1e9 / (double)count);
+        }
+        printf("%10ld\n", expected);
+    }
+    matchSetKernel(NULL);
+
+    free(items);
+    free(hits);
+    if (failed) {
+        printf("Kernel results differ from strstr!\n");
+        return 1;
+    }
+    return 0;
+}
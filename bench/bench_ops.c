@@ -0,0 +1,296 @@
+/*
+ * =====================================================================================
+ * File: bench_ops.c
+ * Description: Times the core operations against the data set in data/ under
+ *              the current directory, bench_data/ when run by make bench (see
+ *              gen_data.c): ID lookups, inventory search, placing orders,
+ *              deleting items, the sales, profit and inventory value reports,
+ *              backup and restore. Prints the throughput of each operation and
+ *              the 50th, 90th and 99th percentile and maximum latency.
+ *
+ *              The run takes a backup before it changes anything and ends by
+ *              restoring it, so the data set is the same for the next run.
+ *              Operations pick their records with a fixed seed, so runs on the
+ *              same data set can be compared across releases.
+ *
+ *              Usage: bin/bench_ops [scale]
+ *              (scale multiplies the number of operations; default 1)
+ *
+ * Author: Chiemezie Agbo
+ * Date: 17-10-2026
+ * Version: 1.0
+ * =====================================================================================
+ */
+
+#define _DEFAULT_SOURCE
+#include "../include/common.h"
+#include "../include/table.h"
+#include "../include/cache.h"
+#include "../include/index.h"
+#include "../include/meta.h"
+#include "../include/inventory.h"
+#include "../include/orders.h"
+#include "../include/financial.h"
+#include "../include/search.h"
+#include "../include/backup.h"
+#include "../include/wal.h"
+#include "../include/utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+
+#define BENCH_LOOKUPS 100000
+#define BENCH_SEARCHES 200
+#define BENCH_REPORTS 10
+#define BENCH_ORDERS 2000
+#define BENCH_DELETES 1000
+#define BENCH_BACKUPS 3
+#define BENCH_RESTORES 3
+#define BENCH_BACKUP_NAME "bench_1"
+#define BENCH_FIRST_DATE "2024-01-01"
+#define BENCH_LAST_DATE "2025-12-31"
+
+static const char *terms[] = {"Steel", "Hinge", "Drill Bit", "blue", "Compact Brass", "pack of 12", "model Q",
+                              "Gasket", "xyz", "Oak Shelf"};
+
+typedef struct {
+    double *samples; /* Seconds per operation */
+    long count;
+    long failed;
+} Timing;
+
+static double nowSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static int compareSamples(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static int beginTiming(Timing *timing, long count) {
+    timing->samples = malloc((size_t)count * sizeof(double));
+    timing->count = 0;
+    timing->failed = 0;
+    return timing->samples != NULL;
+}
+
+static void record(Timing *timing, double start, int ok) {
+    timing->samples[timing->count++] = nowSeconds() - start;
+    timing->failed += !ok;
+}
+
+/* Nearest-rank percentile of sorted samples, in microseconds */
+static double percentile(const Timing *timing, double share) {
+    long rank = (long)(share * (double)timing->count + 0.999999);
+    rank = rank < 1 ? 1 : rank > timing->count ? timing->count : rank;
+    return timing->samples[rank - 1] * 1e6;
+}
+
+/**
+ * @brief Prints one line of results and frees the samples
+ * @return int 1 if every operation succeeded, 0 otherwise
+ */
+static int endTiming(Timing *timing, const char *name) {
+    double total = 0;
+    for (long i = 0; i < timing->count; i++) {
+        total += timing->samples[i];
+    }
+    qsort(timing->samples, (size_t)timing->count, sizeof(double), compareSamples);
+    printf("%-18s %8ld %10.3f %12.1f %10.1f %10.1f %10.1f %12.1f", name, timing->count, total,
+           total > 0 ? (double)timing->count / total : 0.0, percentile(timing, 0.50), percentile(timing, 0.90),
+           percentile(timing, 0.99), percentile(timing, 1.0));
+    if (timing->failed > 0) {
+        printf("  (%ld failed)", timing->failed);
+    }
+    printf("\n");
+    fflush(stdout);
+    free(timing->samples);
+    return timing->failed == 0;
+}
+
+/* The reports print their results; send them to /dev/null while timing */
+static int silenceOutput(void) {
+    fflush(stdout);
+    int saved = dup(STDOUT_FILENO);
+    int null = open("/dev/null", O_WRONLY);
+    if (null >= 0) {
+        dup2(null, STDOUT_FILENO);
+        close(null);
+    }
+    return saved;
+}
+
+static void restoreOutput(int saved) {
+    fflush(stdout);
+    if (saved >= 0) {
+        dup2(saved, STDOUT_FILENO);
+        close(saved);
+    }
+}
+
+/* The data files were replaced by a restore, as in the admin menu */
+static void reloadTables(void) {
+    for (int t = 0; t < TABLE_COUNT; t++) {
+        cacheInvalidate((TableId)t);
+    }
+    for (int t = 0; t < TABLE_COUNT; t++) {
+        indexRebuild((TableId)t);
+        metaReset((TableId)t);
+        tableRebuildDerived((TableId)t);
+    }
+}
+
+static int randomId(long count) {
+    return 1 + (int)(rand() % count);
+}
+
+int main(int argc, char *argv[]) {
+    long scale = argc > 1 ? atol(argv[1]) : 1;
+    if (scale <= 0) {
+        printf("Usage: %s [scale]\n", argv[0]);
+        return 1;
+    }
+
+    initializeSystem();
+    walCheckpoint();
+    long items = tableRecordCount(TABLE_INVENTORY);
+    long customers = tableRecordCount(TABLE_CUSTOMERS);
+    long orders = tableRecordCount(TABLE_ORDERS);
+    if (items <= 0 || customers <= 0 || orders <= 0) {
+        printf("No data set in data/; run make gen, then make bench\n");
+        return 1;
+    }
+
+    // Load the caches and indexes outside the timings
+    InventoryItem item;
+    Order order;
+    getInventoryItemById(1, &item);
+    getOrderById(1, &order);
+
+    srand(1);
+    printf("%ld items, %ld customers, %ld orders; latencies in microseconds\n", items, customers, orders);
+    printf("%-18s %8s %10s %12s %10s %10s %10s %12s\n", "operation", "ops", "total s", "ops/s", "p50", "p90",
+           "p99", "max");
+
+    int ok = 1;
+    Timing timing;
+
+    if (beginTiming(&timing, BENCH_LOOKUPS * scale)) {
+        for (long i = 0; i < BENCH_LOOKUPS * scale; i++) {
+            // IDs deleted from a hand-made data set simply miss
+            double start = nowSeconds();
+            getInventoryItemById(randomId(items), &item);
+            record(&timing, start, 1);
+        }
+        ok = endTiming(&timing, "item lookup") && ok;
+    }
+
+    if (beginTiming(&timing, BENCH_LOOKUPS * scale)) {
+        for (long i = 0; i < BENCH_LOOKUPS * scale; i++) {
+            double start = nowSeconds();
+            getOrderById(randomId(orders), &order);
+            record(&timing, start, 1);
+        }
+        ok = endTiming(&timing, "order lookup") && ok;
+    }
+
+    if (beginTiming(&timing, BENCH_SEARCHES * scale)) {
+        for (long i = 0; i < BENCH_SEARCHES * scale; i++) {
+            long *slots = NULL;
+            long count = 0;
+            double start = nowSeconds();
+            int found = searchTable(TABLE_INVENTORY, terms[i % (long)(sizeof(terms) / sizeof(terms[0]))], &slots,
+                                    &count);
+            record(&timing, start, found);
+            free(slots);
+        }
+        ok = endTiming(&timing, "inventory search") && ok;
+    }
+
+    const char *reports[] = {"sales report", "profit report", "inventory value"};
+    for (int r = 0; r < 3; r++) {
+        if (!beginTiming(&timing, BENCH_REPORTS * scale)) {
+            continue;
+        }
+        int saved = silenceOutput();
+        for (long i = 0; i < BENCH_REPORTS * scale; i++) {
+            SalesReport sales;
+            ProfitReport profit;
+            InventoryValueReport value;
+            double start = nowSeconds();
+            if (r == 0) {
+                generateSalesReport(BENCH_FIRST_DATE, BENCH_LAST_DATE, &sales);
+            } else if (r == 1) {
+                generateProfitReport(BENCH_FIRST_DATE, BENCH_LAST_DATE, &profit);
+            } else {
+                generateInventoryValue(&value);
+            }
+            record(&timing, start, 1);
+        }
+        restoreOutput(saved);
+        ok = endTiming(&timing, reports[r]) && ok;
+    }
+
+    // The first backup is the one restored at the end; the others only add what changed
+    char name[32];
+    if (beginTiming(&timing, BENCH_BACKUPS)) {
+        for (int i = 0; i < BENCH_BACKUPS; i++) {
+            snprintf(name, sizeof(name), "bench_%d", i + 1);
+            double start = nowSeconds();
+            record(&timing, start, backupCreate(name, NULL));
+        }
+        ok = endTiming(&timing, "backup") && ok;
+    }
+
+    if (beginTiming(&timing, BENCH_ORDERS * scale)) {
+        for (long i = 0; i < BENCH_ORDERS * scale; i++) {
+            OrderItemRequest requests[3];
+            int lineCount = 1 + rand() % 3;
+            for (int j = 0; j < lineCount; j++) {
+                requests[j].itemId = randomId(items);
+                requests[j].quantity = 1;
+            }
+            Order placed;
+            memset(&placed, 0, sizeof(placed));
+            placed.customerId = randomId(customers);
+            double start = nowSeconds();
+            OrderResult result = placeOrderBatch(&placed, requests, lineCount, NULL);
+            // Items that ran out of stock are a normal outcome, not a failure
+            record(&timing, start, result == ORDER_PLACED || result == ORDER_OUT_OF_STOCK);
+        }
+        ok = endTiming(&timing, "place order") && ok;
+    }
+
+    if (beginTiming(&timing, BENCH_DELETES * scale)) {
+        long step = items / (BENCH_DELETES * scale) > 0 ? items / (BENCH_DELETES * scale) : 1;
+        for (long i = 0; i < BENCH_DELETES * scale && i * step < items; i++) {
+            double start = nowSeconds();
+            record(&timing, start, tableDeleteById(TABLE_INVENTORY, (int)(i * step) + 1));
+        }
+        ok = endTiming(&timing, "delete item") && ok;
+    }
+
+    if (beginTiming(&timing, BENCH_RESTORES)) {
+        for (int i = 0; i < BENCH_RESTORES; i++) {
+            double start = nowSeconds();
+            walCheckpoint();
+            int restored = backupRestore(BENCH_BACKUP_NAME);
+            reloadTables();
+            record(&timing, start, restored);
+        }
+        ok = endTiming(&timing, "restore") && ok;
+    }
+
+    if (!ok) {
+        printf("Some operations failed!\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,128 @@
+/*
+ * =====================================================================================
+ * File: bench_scan.c
+ * Description: Times the full scans of data/orders.dat behind the sales and
+ *              profit reports: rebuilding the daily totals (rollups.c) and the
+ *              order columns (columns.c), which run whenever those files are
+ *              stale. Each is run with 1, 2, 4, ... threads up to one per core
+ *              and the speed-up over one thread is printed; the totals and
+ *              segments are checked to be the same for every thread count.
+ *
+ *              Usage: bin/bench_scan [runs]
+ *              (the best of runs, default 3, is reported for each count)
+ *
+ * Author: Chiemezie Agbo
+ * Date: 17-10-2026
+ * Version: 1.0
+ * =====================================================================================
+ */
+
+#define _DEFAULT_SOURCE
+#include "../include/common.h"
+#include "../include/table.h"
+#include "../include/scan.h"
+#include "../include/rollups.h"
+#include "../include/columns.h"
+#include "../include/wal.h"
+#include "../include/utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static double nowSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/* Totals over every day and the zone maps, to compare runs with */
+typedef struct {
+    DailyRollup total;
+    OrderSegment *segments;
+    long segmentCount;
+} ScanResult;
+
+static int readResult(ScanResult *result) {
+    OrderColumns columns;
+    if (!rollupsSum(0, rollupDay(time(NULL)) + 366, &result->total) ||
+        !columnsLoad(ORDER_COLUMN_MASK(ORDER_COLUMN_ID), &columns)) {
+        return 0;
+    }
+    result->segmentCount = columns.segmentCount;
+    result->segments = malloc((size_t)columns.segmentCount * sizeof(OrderSegment) + 1);
+    if (result->segments == NULL) {
+        return 0;
+    }
+    memcpy(result->segments, columns.segments, (size_t)columns.segmentCount * sizeof(OrderSegment));
+    return 1;
+}
+
+static int sameResult(const ScanResult *a, const ScanResult *b) {
+    return memcmp(&a->total, &b->total, sizeof(a->total)) == 0 && a->segmentCount == b->segmentCount &&
+           memcmp(a->segments, b->segments, (size_t)a->segmentCount * sizeof(OrderSegment)) == 0;
+}
+
+int main(int argc, char *argv[]) {
+    int runs = argc > 1 ? atoi(argv[1]) : 3;
+    if (runs <= 0) {
+        printf("Usage: %s [runs]\n", argv[0]);
+        return 1;
+    }
+
+    initializeSystem();
+    walCheckpoint();
+    long orders = tableRecordCount(TABLE_ORDERS);
+    if (orders <= 0) {
+        printf("No data set in data/; run make gen, then make bench\n");
+        return 1;
+    }
+
+    int cores = scanThreadCount();
+    printf("%ld orders, up to %d threads; best of %d runs in milliseconds\n", orders, cores, runs);
+    printf("%-8s %12s %10s %12s %10s\n", "threads", "rollups", "speed-up", "columns", "speed-up");
+
+    ScanResult first;
+    double serialRollups = 0, serialColumns = 0;
+    int ok = 1;
+    // Powers of two, then the core count itself
+    for (int threads = 1; ok && threads <= cores;
+         threads = threads < cores && threads * 2 > cores ? cores : threads * 2) {
+        scanSetThreadCount(threads);
+        double rollups = 0, columns = 0;
+        for (int run = 0; run < runs && ok; run++) {
+            double start = nowSeconds();
+            ok = rollupsRebuild();
+            double middle = nowSeconds();
+            ok = columnsRebuild() && ok;
+            double end = nowSeconds();
+            rollups = run == 0 || middle - start < rollups ? middle - start : rollups;
+            columns = run == 0 || end - middle < columns ? end - middle : columns;
+        }
+
+        ScanResult result;
+        ok = ok && readResult(&result);
+        if (!ok) {
+            break;
+        }
+        if (threads == 1) {
+            first = result;
+            serialRollups = rollups;
+            serialColumns = columns;
+        } else {
+            ok = sameResult(&first, &result);
+            free(result.segments);
+        }
+        printf("%-8d %12.1f %9.2fx %12.1f %9.2fx%s\n", threads, rollups * 1e3, serialRollups / rollups,
+               columns * 1e3, serialColumns / columns, ok ? "" : "  (results differ!)");
+        fflush(stdout);
+    }
+    scanSetThreadCount(0);
+
+    if (!ok) {
+        printf("Some scans failed!\n");
+        return 1;
+    }
+    free(first.segments);
+    return 0;
+}
@@ -0,0 +1,284 @@
+/*
+ * =====================================================================================
+ * File: gen_data.c
+ * Description: Writes a synthetic data set of a chosen size into data/: inventory
+ *              items, customers, and orders with their order lines, then rebuilds
+ *              the indexes and report data over them. The same arguments always
+ *              produce the same files, so benchmark runs on different releases
+ *              see identical data.
+ *
+ *              Items get names and descriptions built from a word list, costs
+ *              from a few cents to a couple of hundred dollars and a markup of
+ *              20-100%. Orders are spread over two years starting 2024-01-01 and
+ *              hold 1-5 lines each; a small share of the items takes most of
+ *              the sales. The users file is left alone.
+ *
+ *              The files are written directly, not through the log, so nothing
+ *              else may be using data/ meanwhile. data/ is relative to the
+ *              current directory; make gen runs the generator in bench_data/
+ *              so the business data in the checkout's data/ is never touched.
+ *              Existing inventory, customer or order files are only replaced
+ *              when -f is given.
+ *
+ *              Usage: bin/gen_data [-f] [items] [customers] [orders] [seed]
+ *              (make gen ITEMS=... CUSTOMERS=... ORDERS=... SEED=...)
+ *
+ * Author: Chiemezie Agbo
+ * Date: 17-10-2026
+ * Version: 1.0
+ * =====================================================================================
+ */
+
+#define _DEFAULT_SOURCE
+#include "../include/common.h"
+#include "../include/table.h"
+#include "../include/cache.h"
+#include "../include/index.h"
+#include "../include/meta.h"
+#include "../include/wal.h"
+#include "../include/utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/stat.h>
+
+#define GEN_DEFAULT_ITEMS 20000
+#define GEN_DEFAULT_CUSTOMERS 5000
+#define GEN_DEFAULT_ORDERS 100000
+#define GEN_DEFAULT_SEED 1
+#define GEN_START_DATE 1704067200 /* 2024-01-01 00:00:00 UTC */
+#define GEN_DAYS 730
+#define GEN_OPEN_DAYS 14 /* Orders this recent may still be pending or shipped */
+#define GEN_MAX_LINES 5
+
+#define COUNT_OF(array) ((long)(sizeof(array) / sizeof((array)[0])))
+
+static const char *adjectives[] = {
+    "Small", "Large", "Heavy", "Light", "Compact", "Deluxe", "Basic", "Pro", "Mini", "Industrial",
+};
+static const char *materials[] = {
+    "Steel", "Copper", "Brass", "Plastic", "Oak", "Aluminium", "Rubber", "Glass", "Nylon", "Cotton",
+};
+static const char *products[] = {
+    "Bolt", "Screw", "Hinge", "Bracket", "Valve", "Pipe", "Washer", "Handle", "Spring", "Gasket",
+    "Hammer", "Wrench", "Drill Bit", "Clamp", "Hook", "Shelf", "Lamp", "Cable", "Fan", "Filter",
+};
+static const char *colours[] = {"black", "white", "red", "blue", "green", "grey", "silver", "yellow"};
+static const char *firstNames[] = {
+    "James", "Mary", "John", "Linda", "Ahmed", "Ngozi", "Chen", "Sofia", "Lucas", "Amara",
+    "David", "Emma", "Ivan", "Priya", "Kofi", "Hana", "Mateo", "Zara", "Omar", "Grace",
+};
+static const char *lastNames[] = {
+    "Smith", "Johnson", "Okafor", "Garcia", "Chen", "Muller", "Rossi", "Khan", "Silva", "Nakamura",
+    "Brown", "Adeyemi", "Novak", "Dubois", "Kim", "Jensen", "Lopez", "Mensah", "Patel", "Walker",
+};
+static const char *streets[] = {"Main St", "Market Rd", "High St", "Station Rd", "Park Ave", "Church Ln"};
+static const char *cities[] = {"Springfield", "Riverside", "Lakeview", "Hillcrest", "Fairview", "Oakdale"};
+
+static uint64_t randomState;
+
+/* splitmix64, so the output does not depend on the C library's rand() */
+static uint64_t nextRandom(void) {
+    uint64_t z = (randomState += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+static long randomBelow(long bound) {
+    return (long)(nextRandom() % (uint64_t)bound);
+}
+
+static const char *pick(const char **words, long count) {
+    return words[randomBelow(count)];
+}
+
+/* Picks an item with a skew towards low IDs: the first 10% take about a third of the sales */
+static long popularItem(long itemCount) {
+    double u = (double)(nextRandom() >> 11) / 9007199254740992.0;
+    return (long)((double)itemCount * u * u);
+}
+
+static FILE *openOutput(const char *path) {
+    FILE *file = fopen(path, "wb");
+    if (file == NULL) {
+        printf("Error opening file %s!\n", path);
+    }
+    return file;
+}
+
+/**
+ * @brief Writes the inventory file
+ * @param costs Output for each item's cost, indexed by ID - 1
+ * @param prices Output for each item's price, indexed by ID - 1
+ * @return int 1 on success, 0 otherwise
+ */
+static int generateInventory(long count, Money *costs, Money *prices) {
+    FILE *file = openOutput(INVENTORY_FILE);
+    if (file == NULL) {
+        return 0;
+    }
+
+    int ok = 1;
+    for (long i = 0; ok && i < count; i++) {
+        InventoryItem item;
+        memset(&item, 0, sizeof(item));
+        item.id = (int)i + 1;
+        const char *material = pick(materials, COUNT_OF(materials));
+        const char *product = pick(products, COUNT_OF(products));
+        snprintf(item.name, sizeof(item.name), "%s %s %s", pick(adjectives, COUNT_OF(adjectives)), material,
+                 product);
+        snprintf(item.description, sizeof(item.description), "%s %s, %s finish, pack of %ld, model %c%04ld",
+                 material, product, pick(colours, COUNT_OF(colours)), 1 + randomBelow(50),
+                 (char)('A' + randomBelow(26)), randomBelow(10000));
+        item.cost = 5 + randomBelow(100) * randomBelow(200);
+        item.price = item.cost * (120 + randomBelow(81)) / 100;
+        item.quantity = (int)randomBelow(5000);
+        costs[i] = item.cost;
+        prices[i] = item.price;
+        ok = fwrite(&item, sizeof(item), 1, file) == 1;
+    }
+    return fclose(file) == 0 && ok;
+}
+
+static int generateCustomers(long count) {
+    FILE *file = openOutput(CUSTOMERS_FILE);
+    if (file == NULL) {
+        return 0;
+    }
+
+    int ok = 1;
+    for (long i = 0; ok && i < count; i++) {
+        Customer customer;
+        memset(&customer, 0, sizeof(customer));
+        customer.id = (int)i + 1;
+        const char *first = pick(firstNames, COUNT_OF(firstNames));
+        const char *last = pick(lastNames, COUNT_OF(lastNames));
+        snprintf(customer.name, sizeof(customer.name), "%s %s", first, last);
+        snprintf(customer.email, sizeof(customer.email), "%s.%s%ld@example.com", first, last, i + 1);
+        snprintf(customer.phone, sizeof(customer.phone), "555%07ld", randomBelow(10000000));
+        snprintf(customer.address, sizeof(customer.address), "%ld %s, %s", 1 + randomBelow(999),
+                 pick(streets, COUNT_OF(streets)), pick(cities, COUNT_OF(cities)));
+        ok = fwrite(&customer, sizeof(customer), 1, file) == 1;
+    }
+    return fclose(file) == 0 && ok;
+}
+
+/**
+ * @brief Writes the orders file and the order lines file
+ * @param lineCount Output for the number of order lines written
+ * @return int 1 on success, 0 otherwise
+ */
+static int generateOrders(long count, long customerCount, long itemCount, const Money *costs,
+                          const Money *prices, long *lineCount) {
+    FILE *orders = openOutput(ORDERS_FILE);
+    FILE *lines = openOutput(ORDER_LINES_FILE);
+    int ok = orders != NULL && lines != NULL;
+
+    static const char *openStatuses[] = {"Pending", "Shipped", "Completed"};
+    const time_t openFrom = GEN_START_DATE + (time_t)(GEN_DAYS - GEN_OPEN_DAYS) * 86400;
+    *lineCount = 0;
+    for (long i = 0; ok && i < count; i++) {
+        Order order;
+        memset(&order, 0, sizeof(order));
+        order.id = (int)i + 1;
+        order.customerId = (int)randomBelow(customerCount) + 1;
+        // Spread evenly over the period, in ID order, at some time of the day
+        order.orderDate = GEN_START_DATE + (time_t)(i * GEN_DAYS / count) * 86400 + (time_t)randomBelow(86400);
+        snprintf(order.status, sizeof(order.status), "%s",
+                 order.orderDate < openFrom ? "Completed" : pick(openStatuses, COUNT_OF(openStatuses)));
+
+        long lineTotal = 1 + randomBelow(GEN_MAX_LINES);
+        for (long j = 0; ok && j < lineTotal; j++) {
+            long item = popularItem(itemCount);
+            OrderLine line = {(int)(++*lineCount), order.id, (int)item + 1, 1 + (int)randomBelow(10), prices[item],
+                              costs[item], order.orderDate};
+            order.totalAmount += line.unitPrice * line.quantity;
+            order.profit += (line.unitPrice - line.unitCost) * line.quantity;
+            ok = fwrite(&line, sizeof(line), 1, lines) == 1;
+        }
+        ok = ok && fwrite(&order, sizeof(order), 1, orders) == 1;
+    }
+
+    if (orders != NULL) {
+        ok = fclose(orders) == 0 && ok;
+    }
+    if (lines != NULL) {
+        ok = fclose(lines) == 0 && ok;
+    }
+    return ok;
+}
+
+/* Rebuilds everything derived from the data files, as after a restore */
+static int rebuildTables(void) {
+    static const TableId tables[] = {TABLE_INVENTORY, TABLE_CUSTOMERS, TABLE_ORDER_LINES, TABLE_ORDERS};
+    int ok = 1;
+    for (long i = 0; i < COUNT_OF(tables); i++) {
+        cacheInvalidate(tables[i]);
+        ok = indexRebuild(tables[i]) && metaReset(tables[i]) && ok;
+        tableRebuildDerived(tables[i]);
+    }
+    return ok;
+}
+
+/* Tells whether any table the generator writes already holds records */
+static int holdsData(void) {
+    static const TableId tables[] = {TABLE_INVENTORY, TABLE_CUSTOMERS, TABLE_ORDERS, TABLE_ORDER_LINES};
+    for (long i = 0; i < COUNT_OF(tables); i++) {
+        struct stat st;
+        if (stat(getTableDef(tables[i])->dataFile, &st) == 0 && st.st_size > 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    int force = argc > 1 && strcmp(argv[1], "-f") == 0;
+    char **args = argv + force;
+    int count = argc - force;
+    long items = count > 1 ? atol(args[1]) : GEN_DEFAULT_ITEMS;
+    long customers = count > 2 ? atol(args[2]) : GEN_DEFAULT_CUSTOMERS;
+    long orders = count > 3 ? atol(args[3]) : GEN_DEFAULT_ORDERS;
+    long seed = count > 4 ? atol(args[4]) : GEN_DEFAULT_SEED;
+    if (items <= 0 || customers <= 0 || orders < 0 || items > INT32_MAX || customers > INT32_MAX ||
+        orders > INT32_MAX / GEN_MAX_LINES) {
+        printf("Usage: %s [-f] [items] [customers] [orders] [seed]\n", argv[0]);
+        return 1;
+    }
+    if (!force && holdsData()) {
+        printf("data/ already holds inventory, customers or orders; run make gen, which writes to\n"
+               "bench_data/, or pass -f to replace them\n");
+        return 1;
+    }
+
+    // Bring the tables up to date and empty the log, so nothing replays over the new files
+    initializeSystem();
+    if (!walCheckpoint()) {
+        printf("Error applying the write-ahead log!\n");
+        return 1;
+    }
+
+    Money *costs = malloc((size_t)items * sizeof(Money));
+    Money *prices = malloc((size_t)items * sizeof(Money));
+    if (costs == NULL || prices == NULL) {
+        printf("Out of memory!\n");
+        return 1;
+    }
+
+    randomState = (uint64_t)seed;
+    long lines = 0;
+    int ok = generateInventory(items, costs, prices) && generateCustomers(customers) &&
+             generateOrders(orders, customers, items, costs, prices, &lines) && rebuildTables();
+    free(costs);
+    free(prices);
+    if (!ok) {
+        printf("Data generation failed!\n");
+        return 1;
+    }
+
+    printf("Generated %ld items, %ld customers, %ld orders and %ld order lines (seed %ld)\n", items, customers,
+           orders, lines, seed);
+    return 0;
+}
@@ -4,19 +4,42 @@
 #define MAX_USERNAME_LENGTH 50
 #define MAX_PASSWORD_LENGTH 50
 
+#include <stdio.h>
+#include <time.h>
+#include "backup.h"
+
 typedef struct {
     char username[MAX_USERNAME_LENGTH];
     char password[MAX_PASSWORD_LENGTH];
     int is_admin;
 } User;
 
+/* Called by listUsers with every user account */
+typedef void (*UserVisitor)(const User *user, void *context);
+
 void adminMenu();
 void addUser();
 void viewUsers();
 void backupData();
 void restoreData();
+void restoreDataToPoint();
+void viewStorageStats();
+void viewOperationMetrics();
+void rebuildReportData();
 int loginUser(char *username, char *password);
+void ensureDefaultAdmin();
 void changePassword(char *username);
+int createUser(const User *user);
+int listUsers(UserVisitor visit, void *context);
+int printUsers(FILE *out);
+int setUserPassword(const char *username, const char *password);
+int createBackup(char *name, size_t nameSize, BackupStats *stats);
+int writeBackup(FILE *out);
+int restoreFromBackup(const char *name);
+int restoreFromBackupUntil(const char *name, time_t untilTime, int untilOrderId, long *changes);
+void printStorageStats(FILE *out);
+int printOperationMetrics(FILE *out);
+int rebuildReports(void);
 
 #endif // ADMIN_H
 
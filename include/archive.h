@@ -0,0 +1,13 @@
+#ifndef ARCHIVE_H
+#define ARCHIVE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef int (*ArchiveDataFn)(const unsigned char *data, size_t length, void *context);
+
+int archiveRange(uint64_t *startLsn, uint64_t *endLsn);
+int archiveAppend(const void *data, size_t length, uint64_t startLsn, uint64_t endLsn);
+int archiveRead(ArchiveDataFn consume, void *context);
+
+#endif // ARCHIVE_H
@@ -0,0 +1,23 @@
+#ifndef BACKUP_H
+#define BACKUP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define BACKUP_BLOCK_SIZE (64 * 1024)
+#define BACKUP_MANIFEST "MANIFEST"
+
+typedef struct {
+    int files;
+    long long totalBytes;
+    long long newBytes;
+    long long storedBytes;
+    long changes;
+} BackupStats;
+
+int backupCreate(const char *name, BackupStats *stats);
+int backupVerify(const char *name);
+int backupRestore(const char *name);
+int backupRestoreUntil(const char *name, int64_t untilTime, int untilOrderId, long *changes);
+
+#endif // BACKUP_H
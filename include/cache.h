@@ -0,0 +1,10 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include "table.h"
+
+const void *cacheTable(TableId table, long *count);
+void cacheInvalidate(TableId table);
+const void *cacheFile(TableId table, const char *path, size_t headerSize, size_t recordSize, long *count);
+
+#endif // CACHE_H
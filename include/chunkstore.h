@@ -0,0 +1,40 @@
+#ifndef CHUNKSTORE_H
+#define CHUNKSTORE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+    uint64_t words[2];
+} ChunkHash;
+
+typedef struct {
+    ChunkHash hash;
+    uint64_t offset;
+    uint32_t rawLength;
+    uint32_t storedLength;
+} ChunkEntry;
+
+typedef struct {
+    int packFd;
+    int indexFd;
+    int writable;
+    ChunkEntry *entries;
+    size_t count;
+    size_t capacity;
+    size_t syncedCount;
+    uint32_t *slots;
+    size_t slotCount;
+    uint64_t packEnd;
+} ChunkStore;
+
+ChunkHash chunkHash(const void *data, size_t length);
+int chunkStoreOpen(ChunkStore *store, int writable);
+void chunkStoreClose(ChunkStore *store);
+int chunkStoreHas(const ChunkStore *store, const ChunkHash *hash);
+int chunkStorePut(ChunkStore *store, const ChunkHash *hash, const void *stored, uint32_t storedLength,
+                  uint32_t rawLength);
+int chunkStoreGet(const ChunkStore *store, const ChunkHash *hash, void *block, size_t capacity, size_t *length);
+int chunkStoreSync(ChunkStore *store);
+
+#endif // CHUNKSTORE_H
@@ -0,0 +1,8 @@
+#ifndef CLIENT_H
+#define CLIENT_H
+
+#include "server.h"
+
+int clientSession(ServerClient *client);
+
+#endif // CLIENT_H
@@ -0,0 +1,65 @@
+#ifndef COLUMNS_H
+#define COLUMNS_H
+
+#include <stdint.h>
+#include "common.h"
+
+typedef enum {
+    ORDER_COLUMN_ID,
+    ORDER_COLUMN_CUSTOMER,
+    ORDER_COLUMN_DATE,
+    ORDER_COLUMN_AMOUNT,
+    ORDER_COLUMN_PROFIT,
+    ORDER_COLUMN_STATUS,
+    ORDER_COLUMN_COUNT
+} OrderColumn;
+
+#define ORDER_COLUMN_MASK(column) (1u << (column))
+
+/* Status codes stored in the status column */
+typedef enum {
+    ORDER_STATUS_OTHER,
+    ORDER_STATUS_PENDING,
+    ORDER_STATUS_SHIPPED,
+    ORDER_STATUS_COMPLETED,
+    ORDER_STATUS_DELETED = 0xFF
+} OrderStatusCode;
+
+/* Orders are grouped into segments of consecutive rows from the same month */
+#define ORDER_SEGMENT_ROWS 4096
+
+/* Zone map of one segment; dates and sums only cover orders that are not deleted */
+typedef struct {
+    int64_t firstRow;
+    int32_t rowCount;
+    int32_t liveCount;
+    int32_t month;
+    int32_t reserved;
+    int64_t minDate;
+    int64_t maxDate;
+    Money totalAmount;
+    Money profit;
+} OrderSegment;
+
+/* Contiguous per-column arrays of the orders table; unrequested columns are NULL */
+typedef struct {
+    long count;
+    const int32_t *id;
+    const int32_t *customerId;
+    const int64_t *orderDate;
+    const Money *totalAmount;
+    const Money *profit;
+    const uint8_t *status;
+    const OrderSegment *segments;
+    long segmentCount;
+} OrderColumns;
+
+uint8_t orderStatusCode(const char *status);
+int columnsLoad(unsigned columnMask, OrderColumns *columns);
+int columnsApplyWrite(long slot, const Order *order);
+void columnsBeginBatch(void);
+void columnsEndBatch(void);
+int columnsRebuild(void);
+void columnsSync(void);
+
+#endif // COLUMNS_H
@@ -0,0 +1,25 @@
+#ifndef COMMAND_H
+#define COMMAND_H
+
+#include <stdio.h>
+#include "admin.h"
+
+#define COMMAND_MAX_ARGS 256
+
+/* Who runs commands and how their results are printed */
+typedef struct {
+    char username[MAX_USERNAME_LENGTH];
+    int role;  // loginUser()'s 1 for a user or 2 for an admin, 0 before logging in
+    int table; // 1 prints results the way the menus show them instead of as JSON
+} CommandSession;
+
+int commandMain(int argc, char *argv[]);
+int commandRun(int argc, char *argv[], FILE *out);
+int commandRunAs(const CommandSession *session, int argc, char *argv[], FILE *out);
+int commandExclusive(int argc, char *argv[]);
+int commandSplitLine(char *line, char *argv[], int maxArgs);
+int commandRunLine(char *line, FILE *out);
+int commandRunScript(FILE *in, FILE *out);
+int commandAppendWord(char *line, size_t size, const char *word);
+
+#endif // COMMAND_H
@@ -5,12 +5,52 @@
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <stdint.h>
 
 #define INVENTORY_FILE "data/inventory.dat"
 #define ORDERS_FILE "data/orders.dat"
 #define CUSTOMERS_FILE "data/customers.dat"
 #define USERS_FILE "data/users.dat"
+#define ORDER_LINES_FILE "data/order_lines.dat"
 #define BACKUP_DIR "data/backup/"
+#define BACKUP_STORE_DIR "data/backup/store/"
+#define BACKUP_CHUNKS_FILE "data/backup/store/chunks.pack"
+#define BACKUP_CHUNK_INDEX_FILE "data/backup/store/chunks.idx"
+#define BACKUP_SNAPSHOT_DIR "data/backup/store/snapshots/"
+
+#define INVENTORY_INDEX_FILE "data/inventory.idx"
+#define ORDERS_INDEX_FILE "data/orders.idx"
+#define CUSTOMERS_INDEX_FILE "data/customers.idx"
+#define ORDER_LINES_INDEX_FILE "data/order_lines.idx"
+#define WAL_FILE "data/sbms.wal"
+#define ARCHIVE_FILE "data/sbms.arc"
+
+#define INVENTORY_META_FILE "data/inventory.meta"
+#define ORDERS_META_FILE "data/orders.meta"
+#define CUSTOMERS_META_FILE "data/customers.meta"
+#define USERS_META_FILE "data/users.meta"
+#define ORDER_LINES_META_FILE "data/order_lines.meta"
+
+#define INVENTORY_LOCK_FILE "data/inventory.lck"
+#define ORDERS_LOCK_FILE "data/orders.lck"
+#define CUSTOMERS_LOCK_FILE "data/customers.lck"
+#define USERS_LOCK_FILE "data/users.lck"
+#define ORDER_LINES_LOCK_FILE "data/order_lines.lck"
+
+#define ORDERS_COLUMNS_FILE "data/orders.cols"
+#define ROLLUPS_FILE "data/rollups.dat"
+#define ORDER_LINES_LINKS_FILE "data/order_lines.links"
+#define ORDER_LINES_BY_ORDER_FILE "data/order_lines.oidx"
+#define ORDER_LINES_BY_ITEM_FILE "data/order_lines.iidx"
+#define INVENTORY_SEARCH_FILE "data/inventory.tri"
+#define INVENTORY_SEARCH_DELTA_FILE "data/inventory.trd"
+#define CUSTOMERS_SEARCH_FILE "data/customers.tri"
+#define CUSTOMERS_SEARCH_DELTA_FILE "data/customers.trd"
+#define INVENTORY_HOT_FILE "data/inventory.hot"
+#define CUSTOMERS_HOT_FILE "data/customers.hot"
+#define DATA_FORMAT_FILE "data/sbms.format"
+#define METRICS_FILE "data/metrics.prom"
+#define SLOW_LOG_FILE "data/slowops.log"
 
 #define MAX_NAME_LENGTH 50
 #define MAX_DESCRIPTION_LENGTH 200
@@ -18,12 +58,18 @@
 #define MAX_PHONE_LENGTH 20
 #define MAX_ADDRESS_LENGTH 200
 
+/* Amounts of money in whole cents */
+typedef int64_t Money;
+
+#define MONEY_SCALE 100
+#define MONEY(amount) ((Money)((amount) * MONEY_SCALE + ((amount) < 0 ? -0.5 : 0.5)))
+
 typedef struct {
     int id;
     char name[MAX_NAME_LENGTH];
     char description[MAX_DESCRIPTION_LENGTH];
-    double cost;
-    double price;
+    Money cost;
+    Money price;
     int quantity;
 } InventoryItem;
 
@@ -31,11 +77,21 @@ typedef struct {
     int id;
     int customerId;
     time_t orderDate;
-    double totalAmount;
+    Money totalAmount;
     char status[20];
-    double profit;
+    Money profit;
 } Order;
 
+typedef struct {
+    int id;
+    int orderId;
+    int itemId;
+    int quantity;
+    Money unitPrice;
+    Money unitCost;
+    time_t orderDate;
+} OrderLine;
+
 typedef struct {
     int id;
     char name[MAX_NAME_LENGTH];
@@ -0,0 +1,13 @@
+#ifndef COMPRESS_H
+#define COMPRESS_H
+
+#include <stddef.h>
+
+/* Largest block compressBlock accepts; match offsets are stored in 16 bits */
+#define COMPRESS_MAX_BLOCK 65536
+
+size_t compressBound(size_t length);
+size_t compressBlock(const unsigned char *in, size_t length, unsigned char *out, size_t capacity);
+int decompressBlock(const unsigned char *in, size_t length, unsigned char *out, size_t rawLength);
+
+#endif // COMPRESS_H
@@ -2,6 +2,13 @@
 #define CUSTOMERS_H
 
 #include "../include/common.h"
+#include <stdio.h>
+
+/* Called by listCustomers with every customer that is not deleted */
+typedef void (*CustomerVisitor)(const Customer *customer, void *context);
+
+/* Called by editCustomer with the stored customer; returns 0 to leave it unchanged */
+typedef int (*CustomerEditor)(Customer *customer, void *context);
 
 void customerMenu();
 void addCustomer(Customer *customer);
@@ -12,6 +19,13 @@ void searchCustomer();
 int getCustomerById(int id, Customer *customer);
 int generateUniqueCustomerId();
 void clearInputBuffer();
+void printCustomerHeader(FILE *out);
+void printCustomerRow(FILE *out, const Customer *customer);
+int listCustomers(CustomerVisitor visit, void *context);
+int createCustomer(Customer *customer);
+int editCustomer(int id, Customer *customer, CustomerEditor edit, void *context);
+int removeCustomer(int id);
+int findCustomers(const char *term, CustomerVisitor visit, void *context, long *found);
 
 #endif // CUSTOMERS_H
 
@@ -2,30 +2,78 @@
 #define FINANCIAL_H
 
 #include "common.h"
+#include "hotstore.h"
+#include <stdio.h>
+#include <stdint.h>
 
 typedef struct {
-    double totalSales;
+    Money totalSales;
     int orderCount;
     double averageOrderValue;
+    long long pendingCount;
+    long long shippedCount;
+    long long completedCount;
 } SalesReport;
 
 typedef struct {
-    double totalRevenue;
-    double totalCost;
-    double totalProfit;
+    long long orderCount;
+    Money totalRevenue;
+    Money totalCost;
+    Money totalProfit;
     double profitMargin;
 } ProfitReport;
 
 typedef struct {
-    int totalItems;
-    double totalCost;
-    double totalValue;
+    long long totalItems;
+    Money totalCost;
+    Money totalValue;
+    Money potentialProfit;
+    double profitMargin;
 } InventoryValueReport;
 
+/* One order of the profit report */
+typedef struct {
+    int orderId;
+    int64_t orderDate;
+    Money revenue;
+    Money cost;
+    Money profit;
+} ProfitReportLine;
+
+/* Called by computeProfitReport with every order in the range */
+typedef void (*ProfitReportRow)(const ProfitReportLine *line, void *context);
+
+/* Called by computeInventoryValue with every live item */
+typedef void (*InventoryValueRow)(const InventoryHot *item, void *context);
+
+typedef struct {
+    int lineCount;
+    int unitsSold;
+    Money revenue;
+    Money cost;
+    Money profit;
+    int unitsInStock;
+    double sellThrough;
+    double turnover;
+} ProductReport;
+
 void financialMenu();
+int computeSalesReport(const char *startDate, const char *endDate, SalesReport *report);
+int computeProfitSummary(const char *startDate, const char *endDate, ProfitReport *report);
+int computeProfitReport(const char *startDate, const char *endDate, ProfitReport *report, ProfitReportRow row,
+                        void *context);
+int computeInventoryValue(InventoryValueReport *report, InventoryValueRow row, void *context);
+int computeProductReport(const InventoryItem *item, const char *startDate, const char *endDate, ProductReport *report);
+int writeSalesReport(FILE *out, const char *startDate, const char *endDate, SalesReport *report);
+int writeProfitReport(FILE *out, const char *startDate, const char *endDate, ProfitReport *report);
+int writeProfitSummary(FILE *out, const char *startDate, const char *endDate, ProfitReport *report);
+int writeInventoryValue(FILE *out, InventoryValueReport *report);
+int writeProductReport(FILE *out, int itemId, const char *startDate, const char *endDate, ProductReport *report);
 void generateSalesReport(const char *startDate, const char *endDate, SalesReport *report);
 void generateProfitReport(const char *startDate, const char *endDate, ProfitReport *report);
+void generateProfitSummary(const char *startDate, const char *endDate, ProfitReport *report);
 void generateInventoryValue(InventoryValueReport *report);
+void generateProductReport(int itemId, const char *startDate, const char *endDate, ProductReport *report);
 
 #endif // FINANCIAL_H
 
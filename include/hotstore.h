@@ -0,0 +1,30 @@
+#ifndef HOTSTORE_H
+#define HOTSTORE_H
+
+#include "table.h"
+
+/* Names longer than this are cut short in hot records; it must stay above the
+   30-character name column of the inventory value report */
+#define HOT_NAME_PREFIX 32
+
+typedef struct {
+    int id;
+    int quantity;
+    Money cost;
+    Money price;
+    char namePrefix[HOT_NAME_PREFIX];
+} InventoryHot;
+
+typedef struct {
+    int id;
+    char namePrefix[HOT_NAME_PREFIX];
+    char phone[MAX_PHONE_LENGTH];
+} CustomerHot;
+
+const void *hotTable(TableId table, long *count);
+int hotGetById(TableId table, int id, void *hot);
+int hotApplyWrite(TableId table, long slot, const void *record);
+int hotRebuild(TableId table);
+void hotSync(void);
+
+#endif // HOTSTORE_H
@@ -0,0 +1,11 @@
+#ifndef INDEX_H
+#define INDEX_H
+
+#include "table.h"
+
+long indexLookup(TableId table, int id);
+int indexAppend(TableId table, int id, long slot);
+int indexRemove(TableId table, int id);
+int indexRebuild(TableId table);
+
+#endif // INDEX_H
@@ -2,6 +2,13 @@
 #define INVENTORY_H
 
 #include "../include/common.h"
+#include <stdio.h>
+
+/* Called by listInventoryItems with every item that is not deleted */
+typedef void (*InventoryVisitor)(const InventoryItem *item, void *context);
+
+/* Called by editInventoryItem with the stored item; returns 0 to leave it unchanged */
+typedef int (*InventoryEditor)(InventoryItem *item, void *context);
 
 void inventoryMenu();
 void addInventoryItem();
@@ -12,6 +19,13 @@ void searchInventoryItem();
 int getInventoryItemById(int id, InventoryItem *item);
 int generateUniqueInventoryId();
 void updateInventoryItemById(InventoryItem *item);
+void printInventoryHeader(FILE *out);
+void printInventoryRow(FILE *out, const InventoryItem *item);
+int listInventoryItems(InventoryVisitor visit, void *context);
+int createInventoryItem(InventoryItem *item);
+int editInventoryItem(int id, InventoryItem *item, InventoryEditor edit, void *context);
+int removeInventoryItem(int id);
+int findInventoryItems(const char *term, InventoryVisitor visit, void *context, long *found);
 
 #endif // INVENTORY_H
 
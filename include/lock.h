@@ -0,0 +1,9 @@
+#ifndef LOCK_H
+#define LOCK_H
+
+#include "table.h"
+
+int recordLock(TableId table, long key);
+void recordUnlock(TableId table, long key);
+
+#endif // LOCK_H
@@ -0,0 +1,18 @@
+#ifndef MATCH_H
+#define MATCH_H
+
+#include <stddef.h>
+
+/* Where a fixed-width text field sits in a record */
+typedef struct {
+    size_t offset;
+    size_t width;
+} MatchField;
+
+int fieldContains(const char *field, size_t width, const char *needle, size_t needleLength);
+long matchRecords(const void *records, long count, size_t recordSize, const MatchField *fields, int fieldCount,
+                  const char *needle, unsigned char *hits);
+const char *matchKernelName(void);
+int matchSetKernel(const char *name);
+
+#endif // MATCH_H
@@ -0,0 +1,20 @@
+#ifndef META_H
+#define META_H
+
+#include <stdint.h>
+#include "table.h"
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    int64_t deadCount;
+    int64_t nextId;
+} TableMeta;
+
+int metaRead(TableId table, TableMeta *meta);
+int metaSetDead(TableId table, int64_t deadCount);
+int metaAddDead(TableId table, int64_t delta);
+int metaAllocateId(TableId table);
+int metaReset(TableId table);
+
+#endif // META_H
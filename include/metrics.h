@@ -0,0 +1,103 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+typedef enum {
+    METRIC_ADD_ITEM,
+    METRIC_UPDATE_ITEM,
+    METRIC_DELETE_ITEM,
+    METRIC_VIEW_ITEMS,
+    METRIC_SEARCH_ITEMS,
+    METRIC_GET_ITEM,
+    METRIC_NEW_ITEM_ID,
+    METRIC_UPDATE_ITEM_BY_ID,
+    METRIC_PLACE_ORDER,
+    METRIC_PLACE_ORDER_BATCH,
+    METRIC_COMMIT_ORDER,
+    METRIC_UPDATE_ORDER_STATUS,
+    METRIC_VIEW_ORDERS,
+    METRIC_SEARCH_ORDER,
+    METRIC_GET_ORDER,
+    METRIC_NEW_ORDER_ID,
+    METRIC_ADD_CUSTOMER,
+    METRIC_UPDATE_CUSTOMER,
+    METRIC_DELETE_CUSTOMER,
+    METRIC_VIEW_CUSTOMERS,
+    METRIC_SEARCH_CUSTOMERS,
+    METRIC_GET_CUSTOMER,
+    METRIC_NEW_CUSTOMER_ID,
+    METRIC_SALES_REPORT,
+    METRIC_PROFIT_REPORT,
+    METRIC_PROFIT_SUMMARY,
+    METRIC_INVENTORY_VALUE,
+    METRIC_PRODUCT_REPORT,
+    METRIC_ADD_USER,
+    METRIC_VIEW_USERS,
+    METRIC_CHANGE_PASSWORD,
+    METRIC_LOGIN,
+    METRIC_BACKUP,
+    METRIC_RESTORE,
+    METRIC_RESTORE_TO_POINT,
+    METRIC_STORAGE_STATS,
+    METRIC_REBUILD_REPORT_DATA,
+    METRIC_COUNT
+} MetricOp;
+
+/* Work done by one thread, counted where the storage code reads and writes */
+typedef struct {
+    uint64_t recordsScanned;
+    uint64_t bytesRead;
+    uint64_t bytesWritten;
+    uint64_t fileOpens;
+} IoCounters;
+
+typedef struct {
+    MetricOp op;
+    uint64_t startNs;
+    IoCounters io;    /* The thread's counters when the operation started */
+    int ids[2];       /* Records the call works on, named per operation; 0 if unset */
+    const char *from; /* Date range of a report, or NULL */
+    const char *to;
+} MetricSpan;
+
+typedef struct {
+    uint64_t count;
+    uint64_t totalNs;
+    uint64_t maxNs;
+    IoCounters io;
+} MetricTotals;
+
+/* Times the rest of the enclosing block as one call of op */
+#define METRICS_SPAN(op) \
+    MetricSpan metricsSpan __attribute__((cleanup(metricsEnd))) = metricsBegin(op)
+
+/* Arguments of the call, for the slow-operation log; only valid after METRICS_SPAN */
+#define METRICS_SPAN_IDS(id, otherId) (metricsSpan.ids[0] = (id), metricsSpan.ids[1] = (otherId))
+#define METRICS_SPAN_RANGE(start, end) (metricsSpan.from = (start), metricsSpan.to = (end))
+
+MetricSpan metricsBegin(MetricOp op);
+void metricsEnd(MetricSpan *span);
+void metricsRecord(MetricOp op, uint64_t nanoseconds, const IoCounters *io);
+void metricsGet(MetricOp op, MetricTotals *totals);
+uint64_t metricsQuantile(MetricOp op, double quantile);
+void metricsReset(void);
+int metricsWrite(FILE *out);
+int metricsDump(void);
+int metricsStartSignalDump(void);
+const char *metricsName(MetricOp op);
+
+void ioCountScan(long records);
+void ioCountersGet(IoCounters *counters);
+void ioCountersAdd(const IoCounters *counters);
+int ioOpen(const char *path, int flags, ...);
+FILE *ioFopen(const char *path, const char *mode);
+ssize_t ioPread(int fd, void *buffer, size_t length, off_t offset);
+ssize_t ioPwrite(int fd, const void *buffer, size_t length, off_t offset);
+ssize_t ioWrite(int fd, const void *buffer, size_t length);
+size_t ioFread(void *buffer, size_t size, size_t count, FILE *file);
+size_t ioFwrite(const void *buffer, size_t size, size_t count, FILE *file);
+
+#endif // METRICS_H
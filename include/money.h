@@ -0,0 +1,16 @@
+#ifndef MONEY_H
+#define MONEY_H
+
+#include "common.h"
+
+/* Version written to DATA_FORMAT_FILE once amounts are stored in cents */
+#define DATA_FORMAT_MONEY 2
+
+Money moneyFromDouble(double amount);
+double moneyToDouble(Money amount);
+Money moneySum(const Money *values, long count);
+Money moneySumSelected(const Money *values, const uint8_t *selected, long count);
+int moneyMigrate(void);
+int moneyMigrateTables(void);
+
+#endif // MONEY_H
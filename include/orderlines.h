@@ -0,0 +1,12 @@
+#ifndef ORDERLINES_H
+#define ORDERLINES_H
+
+#include "common.h"
+
+int orderLinesForOrder(int orderId, OrderLine **lines, long *count);
+int orderLinesForItem(int itemId, OrderLine **lines, long *count);
+int orderLinesApplyWrite(long slot, const OrderLine *before, const OrderLine *after);
+int orderLinesRebuildIndex(void);
+void orderLinesSync(void);
+
+#endif // ORDERLINES_H
@@ -2,6 +2,26 @@
 #define ORDERS_H
 
 #include "common.h"
+#include <stdio.h>
+
+#define MAX_ORDER_LINES 100
+
+typedef struct {
+    int itemId;
+    int quantity;
+} OrderItemRequest;
+
+typedef enum {
+    ORDER_PLACED,
+    ORDER_INVALID,
+    ORDER_UNKNOWN_CUSTOMER,
+    ORDER_UNKNOWN_ITEM,
+    ORDER_OUT_OF_STOCK,
+    ORDER_WRITE_FAILED
+} OrderResult;
+
+/* Called by listOrders with every order that is not deleted */
+typedef void (*OrderVisitor)(const Order *order, void *context);
 
 void orderMenu();
 void placeOrder();
@@ -9,6 +29,15 @@ void updateOrderStatus();
 void viewAllOrders();
 void searchOrder();
 int generateUniqueOrderId();
+int commitOrder(const Order *order, OrderLine *lines, int lineCount);
+OrderResult placeOrderBatch(Order *order, const OrderItemRequest *items, int itemCount, int *failedItem);
+OrderResult submitOrder(Order *order, const OrderItemRequest *items, int itemCount, int *failedItem);
+void printOrderHeader(FILE *out);
+void printOrderRow(FILE *out, const Order *order);
+void printOrderLines(FILE *out, const OrderLine *lines, long lineCount);
+int listOrders(OrderVisitor visit, void *context);
+int setOrderStatus(int id, const char *status, Order *order);
+int writeOrder(FILE *out, int id);
 
 // Add these function declarations
 int getOrderById(int id, Order *order);
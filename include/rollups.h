@@ -0,0 +1,27 @@
+#ifndef ROLLUPS_H
+#define ROLLUPS_H
+
+#include <stdint.h>
+#include <time.h>
+#include "common.h"
+
+/* Number of status codes counted per day: other, pending, shipped, completed */
+#define ROLLUP_STATUS_KINDS 4
+
+/* Totals of the orders placed on one day, deleted orders excluded */
+typedef struct {
+    int64_t orderCount;
+    Money revenue;
+    Money cost;
+    Money profit;
+    int64_t statusCounts[ROLLUP_STATUS_KINDS];
+} DailyRollup;
+
+long rollupDay(time_t timestamp);
+long rollupDayFromDate(const char *date);
+int rollupsSum(long firstDay, long lastDay, DailyRollup *total);
+int rollupsApplyWrite(long slot, const Order *before, const Order *after);
+int rollupsRebuild(void);
+void rollupsSync(void);
+
+#endif // ROLLUPS_H
@@ -0,0 +1,37 @@
+#ifndef SCAN_H
+#define SCAN_H
+
+#include <time.h>
+#include "table.h"
+
+#define SCAN_MAX_THREADS 16
+#define SCAN_MIN_PARTITION_RECORDS 16384 /* Smaller tables are split among fewer threads */
+#define SCAN_CHUNK_BYTES (1 << 20)       /* Read by a worker at a time */
+
+/* A table's data file opened for a scan; the record count is fixed when it is opened */
+typedef struct {
+    TableId table;
+    int fd;
+    size_t recordSize;
+    long records;
+} TableScan;
+
+/* Called with each run of records a worker has read and the state of its partition */
+typedef void (*ScanVisitor)(void *partial, const void *records, long firstSlot, long count, void *arg);
+
+/* The local day a worker last converted a timestamp to; zero-filled is empty */
+typedef struct {
+    time_t start; /* First second of the day */
+    time_t end;   /* First second of the next day */
+    struct tm date;
+} ScanDayCache;
+
+int scanThreadCount(void);
+void scanSetThreadCount(int threads);
+int scanOpen(TableId table, TableScan *scan);
+int scanRun(const TableScan *scan, ScanVisitor visit, void *arg, void *partials, size_t partialSize,
+            int *partitions);
+void scanClose(TableScan *scan);
+int scanLocalDate(ScanDayCache *cache, time_t timestamp, struct tm *date);
+
+#endif // SCAN_H
@@ -0,0 +1,14 @@
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include "table.h"
+
+/* Trigrams are hashed into this many posting lists */
+#define SEARCH_BUCKETS 65536
+
+int searchTable(TableId table, const char *term, long **slots, long *count);
+int searchIndexApplyWrite(TableId table, long slot);
+int searchIndexRebuild(TableId table);
+void searchIndexSync(void);
+
+#endif // SEARCH_H
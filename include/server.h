@@ -0,0 +1,23 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <stdio.h>
+
+#define SERVER_SOCKET_FILE "data/sbmsd.sock"
+#define SERVER_DEFAULT_WORKERS 4
+#define SERVER_MAX_WORKERS 64
+#define SERVER_MAX_CLIENTS 256
+#define SERVER_MAX_REQUEST 65536
+
+typedef struct {
+    int fd;
+    FILE *in;
+} ServerClient;
+
+int serverRun(const char *socketPath, int workers);
+void serverStop(void);
+int serverConnect(const char *socketPath, ServerClient *client);
+int serverRequest(ServerClient *client, const char *request, FILE *out);
+void serverDisconnect(ServerClient *client);
+
+#endif // SERVER_H
@@ -0,0 +1,17 @@
+#ifndef SLOWLOG_H
+#define SLOWLOG_H
+
+#include "metrics.h"
+
+#define SLOW_LOG_DEFAULT_MS 100
+#define SLOW_LOG_RING_SIZE 256 /* Entries waiting for the flush thread; a power of two */
+#define SLOW_LOG_FLUSH_MS 200
+
+int slowLogConfigure(const char *spec);
+void slowLogSetThreshold(MetricOp op, uint64_t nanoseconds);
+uint64_t slowLogThreshold(MetricOp op);
+void slowLogNote(const MetricSpan *span, uint64_t nanoseconds, const IoCounters *io);
+int slowLogFlush(void);
+int slowLogStart(void);
+
+#endif // SLOWLOG_H
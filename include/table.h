@@ -0,0 +1,53 @@
+#ifndef TABLE_H
+#define TABLE_H
+
+#include <stddef.h>
+#include "common.h"
+
+typedef enum {
+    TABLE_INVENTORY,
+    TABLE_CUSTOMERS,
+    TABLE_ORDERS,
+    TABLE_USERS,
+    TABLE_ORDER_LINES,
+    TABLE_COUNT
+} TableId;
+
+typedef struct {
+    const char *name;
+    const char *dataFile;
+    const char *indexFile;
+    const char *metaFile;
+    const char *lockFile;
+    size_t recordSize;
+} TableDef;
+
+typedef struct {
+    long totalRecords;
+    long deadRecords;
+    double deadRatio;
+    double compactionThreshold;
+    long long dataBytes;
+} TableStats;
+
+/* Compaction rewrites a table once this share of its records are tombstones */
+#define COMPACTION_THRESHOLD 0.25
+
+const TableDef *getTableDef(TableId table);
+int recordId(const void *record);
+long tableRecordCount(TableId table);
+int tableReadSlot(TableId table, long slot, void *record);
+int tableWriteSlot(TableId table, long slot, const void *record);
+long tableAppend(TableId table, const void *record);
+int tableGetById(TableId table, int id, void *record, long *slot);
+int tableUpdateById(TableId table, const void *record);
+int tableDeleteById(TableId table, int id);
+int tableApplyWrite(TableId table, long slot, const void *record);
+int tableApplyTombstone(TableId table, long slot);
+int tableCompact(TableId table);
+int tableNeedsCompaction(TableId table);
+void tableRecountDead(TableId table);
+void tableRebuildDerived(TableId table);
+void tableGetStats(TableId table, TableStats *stats);
+
+#endif // TABLE_H
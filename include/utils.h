@@ -2,14 +2,19 @@
 #define UTILS_H
 
 #include <time.h>
+#include <stdint.h>
+#include <stddef.h>
 
 void initializeSystem();
 time_t parseDate(const char *dateStr);
+time_t parseDateTime(const char *text);
 char* formatDate(time_t timestamp);
 int validateIntInput(int min, int max);
 double validateDoubleInput(double min, double max);
 void validateStringInput(char *output, int maxLength, const char *prompt);
 int validateDateInput(char *output);
+uint32_t computeCrc32(uint32_t crc, const void *data, size_t length);
+void tempFileName(char *output, size_t size, const char *path);
 
 #endif // UTILS_H
 
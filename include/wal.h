@@ -0,0 +1,40 @@
+#ifndef WAL_H
+#define WAL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "table.h"
+
+#define WAL_APPEND_SLOT -1L
+
+typedef struct WalTxn {
+    unsigned char *ops;
+    size_t length;
+    size_t capacity;
+    uint32_t opCount;
+    long *slots;
+    uint64_t lsn;
+    int done;
+    int ok;
+    struct WalTxn *next;
+} WalTxn;
+
+typedef int (*WalChangeFn)(TableId table, long slot, const void *record, int id, void *context);
+
+void walBegin(WalTxn *txn);
+int walLogWrite(WalTxn *txn, TableId table, long slot, const void *record);
+int walLogDelete(WalTxn *txn, TableId table, long slot, int id);
+int walCommit(WalTxn *txn);
+long walSlot(const WalTxn *txn, int op);
+void walEnd(WalTxn *txn);
+int walRecover(void);
+int walCheckpoint(void);
+int walCompactionDue(void);
+int walCompact(void);
+int walPin(uint64_t *lsn);
+void walUnpin(void);
+int walCutChanges(uint64_t *lsn, WalChangeFn apply, void *context);
+int walArchiveChanges(uint64_t fromLsn, int64_t untilTime, int untilOrderId, WalChangeFn apply, void *context,
+                      long *changes);
+
+#endif // WAL_H
@@ -17,15 +17,29 @@
  * =====================================================================================
  */
 
+#define _DEFAULT_SOURCE
 #include "../include/admin.h"
+#include "../include/table.h"
+#include "../include/cache.h"
+#include "../include/index.h"
+#include "../include/meta.h"
+#include "../include/lock.h"
+#include "../include/columns.h"
+#include "../include/rollups.h"
+#include "../include/orderlines.h"
+#include "../include/hotstore.h"
+#include "../include/money.h"
+#include "../include/wal.h"
+#include "../include/backup.h"
+#include "../include/metrics.h"
 #include "../include/utils.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
 #include <time.h>
 
 #define USERS_FILE "data/users.dat"
-#define BACKUP_DIR "data/backup/"
 
 /**
  * @brief Displays the admin menu and handles user choices
@@ -42,11 +56,15 @@ void adminMenu() {
         printf("║ 3. Change User Password    ║\n");
         printf("║ 4. Backup Data             ║\n");
         printf("║ 5. Restore Data            ║\n");
-        printf("║ 6. Back to Main Menu       ║\n");
+        printf("║ 6. Point-in-Time Restore   ║\n");
+        printf("║ 7. Storage Statistics      ║\n");
+        printf("║ 8. Operation Metrics       ║\n");
+        printf("║ 9. Rebuild Report Data     ║\n");
+        printf("║ 10. Back to Main Menu      ║\n");
         printf("╚════════════════════════════╝\n");
         printf("\033[0m");
         printf("Enter your choice: ");
-        choice = validateIntInput(1, 6);
+        choice = validateIntInput(1, 10);
 
         switch (choice) {
             case 1:
@@ -69,11 +87,33 @@ void adminMenu() {
                 restoreData();
                 break;
             case 6:
+                restoreDataToPoint();
+                break;
+            case 7:
+                viewStorageStats();
+                break;
+            case 8:
+                viewOperationMetrics();
+                break;
+            case 9:
+                rebuildReportData();
+                break;
+            case 10:
                 return;
         }
     } while (1);
 }
 
+/**
+ * @brief Stores a new user account
+ * @param user The user to add
+ * @return int 1 on success, 0 otherwise
+ */
+int createUser(const User *user) {
+    METRICS_SPAN(METRIC_ADD_USER);
+    return tableAppend(TABLE_USERS, user) >= 0;
+}
+
 /**
  * @brief Adds a new user to the system
  */
@@ -84,83 +124,299 @@ void addUser() {
     printf("Is this user an admin? (1 for Yes, 0 for No): ");
     user.is_admin = validateIntInput(0, 1);
 
-    FILE *file = fopen(USERS_FILE, "ab");
-    if (file == NULL) {
-        printf("Error opening file!\n");
-        return;
+    if (createUser(&user)) {
+        printf("User added successfully!\n");
     }
+}
 
-    fwrite(&user, sizeof(User), 1, file);
-    fclose(file);
+/**
+ * @brief Calls a function with every user account
+ * @param visit Called with each user in storage order
+ * @param context Passed on to visit
+ * @return int 1 on success, 0 if the users cannot be read
+ */
+int listUsers(UserVisitor visit, void *context) {
+    METRICS_SPAN(METRIC_VIEW_USERS);
+    long count;
+    const User *users = cacheTable(TABLE_USERS, &count);
+    if (count < 0) {
+        return 0;
+    }
+    ioCountScan(count);
 
-    printf("User added successfully!\n");
+    for (long i = 0; i < count; i++) {
+        visit(&users[i], context);
+    }
+    return 1;
+}
+
+static void printUserRow(const User *user, void *context) {
+    fprintf(context, "%-20s %-10s\n", user->username, user->is_admin ? "Yes" : "No");
+}
+
+/**
+ * @brief Prints every user account and whether it is an admin
+ * @param out Where the table goes
+ * @return int 1 on success, 0 otherwise
+ */
+int printUsers(FILE *out) {
+    fprintf(out, "\033[1;34m");
+    fprintf(out, "%-20s %-10s\n", "Username", "Admin");
+    fprintf(out, "==============================\n");
+    fprintf(out, "\033[0m");
+    if (!listUsers(printUserRow, out)) {
+        fprintf(out, "Error opening file!\n");
+        return 0;
+    }
+    return 1;
 }
 
 /**
  * @brief Displays all users in the system
  */
 void viewUsers() {
-    FILE *file = fopen(USERS_FILE, "rb");
-    if (file == NULL) {
-        printf("Error opening file!\n");
-        return;
-    }
+    printUsers(stdout);
+}
 
-    User user;
-    printf("\033[1;34m");
-    printf("%-20s %-10s\n", "Username", "Admin");
-    printf("==============================\n");
-    printf("\033[0m");
-    while (fread(&user, sizeof(User), 1, file)) {
-        printf("%-20s %-10s\n", user.username, user.is_admin ? "Yes" : "No");
+/**
+ * @brief Takes a backup named after the current time
+ * @param name Output for the backup's name, YYYYMMDD_HHMMSS
+ * @param nameSize Capacity of name, at least 16
+ * @param stats Output for the sizes and the changes made meanwhile
+ * @return int 1 on success, 0 otherwise
+ *
+ * Only blocks that no earlier backup holds are added to the backup store,
+ * compressed. Other terminals can keep working while the backup runs; it
+ * holds every table as of one moment.
+ */
+int createBackup(char *name, size_t nameSize, BackupStats *stats) {
+    METRICS_SPAN(METRIC_BACKUP);
+    time_t now = time(NULL);
+    struct tm tm;
+    strftime(name, nameSize, "%Y%m%d_%H%M%S", localtime_r(&now, &tm));
+    return backupCreate(name, stats);
+}
+
+/**
+ * @brief Takes a backup and prints what it stored
+ * @param out Where the result goes
+ * @return int 1 on success, 0 otherwise
+ */
+int writeBackup(FILE *out) {
+    char timestamp[20];
+    BackupStats stats;
+    if (!createBackup(timestamp, sizeof(timestamp), &stats)) {
+        fprintf(out, "Error creating backup %s\n", timestamp);
+        return 0;
     }
 
-    fclose(file);
+    fprintf(out, "Backup %s created successfully in %s\n", timestamp, BACKUP_STORE_DIR);
+    fprintf(out, "%d files, %.1f MB: %.1f MB new, stored in %.1f MB, %ld changes made meanwhile\n", stats.files,
+            stats.totalBytes / 1048576.0, stats.newBytes / 1048576.0, stats.storedBytes / 1048576.0, stats.changes);
+    return 1;
 }
 
 /**
  * @brief Creates a backup of the system data
  */
 void backupData() {
-    char timestamp[20];
-    time_t now = time(NULL);
-    strftime(timestamp, sizeof(timestamp), "%Y%m%d_%H%M%S", localtime(&now));
+    writeBackup(stdout);
+}
 
-    char command[256];
-    snprintf(command, sizeof(command), "mkdir -p %s%s", BACKUP_DIR, timestamp);
-    system(command);
+/**
+ * @brief Brings the cache, indexes and derived data in line with restored table files
+ */
+static void reloadRestoredTables(void) {
+    // The data files were replaced underneath the cache, index and metadata
+    for (int t = 0; t < TABLE_COUNT; t++) {
+        cacheInvalidate((TableId)t);
+    }
 
-    const char *files[] = {"inventory.dat", "orders.dat", "customers.dat", "users.dat"};
-    int num_files = sizeof(files) / sizeof(files[0]);
+    // Backups taken before fixed-point money hold doubles
+    moneyMigrateTables();
 
-    for (int i = 0; i < num_files; i++) {
-        snprintf(command, sizeof(command), "cp data/%s %s%s/", files[i], BACKUP_DIR, timestamp);
-        system(command);
+    for (int t = 0; t < TABLE_COUNT; t++) {
+        indexRebuild((TableId)t);
+        metaReset((TableId)t);
+        tableRebuildDerived((TableId)t);
     }
+}
+
+/**
+ * @brief Replaces every table with its copy in a backup
+ * @param name The backup's name, YYYYMMDD_HHMMSS
+ * @return int 1 on success, 0 if the backup is missing or damaged and nothing was restored
+ *
+ * Nothing may read the tables while this runs.
+ */
+int restoreFromBackup(const char *name) {
+    METRICS_SPAN(METRIC_RESTORE);
 
-    printf("Backup created successfully in %s%s/\n", BACKUP_DIR, timestamp);
+    // Empty the log first so replaying it can never touch the restored files
+    walCheckpoint();
+
+    if (!backupRestore(name)) {
+        return 0;
+    }
+    reloadRestoredTables();
+    return 1;
 }
 
 /**
  * @brief Restores system data from a backup
  */
 void restoreData() {
-    char backup_dir[256];
-    validateStringInput(backup_dir, sizeof(backup_dir), "Enter the backup directory name (YYYYMMDD_HHMMSS): ");
+    char backup_name[256];
+    validateStringInput(backup_name, sizeof(backup_name), "Enter the backup name (YYYYMMDD_HHMMSS): ");
+    if (restoreFromBackup(backup_name)) {
+        printf("Data restored successfully from %s\n", backup_name);
+    } else {
+        printf("Backup %s is missing or damaged, nothing was restored\n", backup_name);
+    }
+}
+
+/**
+ * @brief Restores a backup and replays the archived changes made after it up to a chosen point
+ * @param name The backup's name, YYYYMMDD_HHMMSS
+ * @param untilTime Last change time to replay, 0 for no limit
+ * @param untilOrderId Stop after the change that placed this order, 0 for none
+ * @param changes Output for the number of changes replayed
+ * @return int 1 on success, 0 if anything is missing or damaged and nothing was restored
+ *
+ * Nothing may read the tables while this runs.
+ */
+int restoreFromBackupUntil(const char *name, time_t untilTime, int untilOrderId, long *changes) {
+    METRICS_SPAN(METRIC_RESTORE_TO_POINT);
+    METRICS_SPAN_IDS(untilOrderId, 0);
+
+    // Empty the log first so replaying it can never touch the restored files
+    walCheckpoint();
+
+    if (!backupRestoreUntil(name, (int64_t)untilTime, untilOrderId, changes)) {
+        return 0;
+    }
+    reloadRestoredTables();
+    return 1;
+}
+
+/**
+ * @brief Restores a backup and replays the archived changes made after it up to a chosen point
+ *
+ * The point is a time, such as just before a bad bulk update, or the order
+ * after whose placing to stop.
+ */
+void restoreDataToPoint() {
+    char backup_name[256];
+    char point[64];
+    validateStringInput(backup_name, sizeof(backup_name), "Enter the backup name (YYYYMMDD_HHMMSS): ");
+    printf("1. Replay changes up to a time\n");
+    printf("2. Replay changes up to an order\n");
+    printf("3. Replay all changes\n");
+    printf("Enter your choice: ");
+    int choice = validateIntInput(1, 3);
 
-    char full_backup_path[512];
-    snprintf(full_backup_path, sizeof(full_backup_path), "%s%s/", BACKUP_DIR, backup_dir);
+    time_t untilTime = 0;
+    int untilOrderId = 0;
+    if (choice == 1) {
+        validateStringInput(point, sizeof(point), "Enter the time (YYYY-MM-DD HH:MM:SS): ");
+        untilTime = parseDateTime(point);
+        if (untilTime == (time_t)-1) {
+            printf("Invalid time format. Please use YYYY-MM-DD HH:MM:SS.\n");
+            return;
+        }
+    } else if (choice == 2) {
+        printf("Enter the order ID: ");
+        untilOrderId = validateIntInput(1, INT_MAX);
+    }
 
-    const char *files[] = {"inventory.dat", "orders.dat", "customers.dat", "users.dat"};
-    int num_files = sizeof(files) / sizeof(files[0]);
+    long changes;
+    struct timespec start;
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (!restoreFromBackupUntil(backup_name, untilTime, untilOrderId, &changes)) {
+        printf("Backup %s, the change archive or the chosen point is missing or damaged, nothing was restored\n",
+               backup_name);
+        return;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    printf("Data restored from %s and %ld changes replayed in %.2f seconds\n", backup_name, changes, seconds);
+}
 
-    for (int i = 0; i < num_files; i++) {
-        char command[512];
-        snprintf(command, sizeof(command), "cp %.200s%.50s data/", full_backup_path, files[i]);
-        system(command);
+/**
+ * @brief Prints record, tombstone and compaction figures for every table
+ * @param out Where the table goes
+ */
+void printStorageStats(FILE *out) {
+    METRICS_SPAN(METRIC_STORAGE_STATS);
+    fprintf(out, "\033[1;34m");
+    fprintf(out, "%-12s %-10s %-10s %-12s %-12s %-12s\n", "Table", "Records", "Deleted", "Dead Ratio", "Compact At", "Data Bytes");
+    fprintf(out, "====================================================================================\n");
+    fprintf(out, "\033[0m");
+    for (int t = 0; t < TABLE_COUNT; t++) {
+        TableStats stats;
+        tableGetStats((TableId)t, &stats);
+        fprintf(out, "%-12s %-10ld %-10ld %-11.1f%% %-11.1f%% %-12lld\n", getTableDef((TableId)t)->name,
+                stats.totalRecords, stats.deadRecords, stats.deadRatio * 100, stats.compactionThreshold * 100,
+                stats.dataBytes);
     }
+}
 
-    printf("Data restored successfully from %s\n", full_backup_path);
+/**
+ * @brief Displays record, tombstone and compaction figures for every table
+ */
+void viewStorageStats() {
+    printStorageStats(stdout);
+}
+
+/**
+ * @brief Prints the latency and I/O figures of every operation and saves them to METRICS_FILE
+ * @param out Where the figures go
+ * @return int 1 on success, 0 if the file could not be written
+ */
+int printOperationMetrics(FILE *out) {
+    metricsWrite(out);
+    if (metricsDump()) {
+        fprintf(out, "Metrics saved to %s\n", METRICS_FILE);
+        return 1;
+    }
+    fprintf(out, "Error opening file!\n");
+    return 0;
+}
+
+/**
+ * @brief Prints the latency and I/O figures of every operation and saves them to METRICS_FILE
+ */
+void viewOperationMetrics() {
+    printOperationMetrics(stdout);
+}
+
+/**
+ * @brief Regenerates the order columns, daily totals, order line indexes and hot records
+ * @return int 1 on success, 0 otherwise
+ *
+ * Nothing may read the tables while this runs.
+ */
+int rebuildReports(void) {
+    METRICS_SPAN(METRIC_REBUILD_REPORT_DATA);
+    // Apply everything still in the log so the rebuild sees every order
+    walCheckpoint();
+
+    return columnsRebuild() && rollupsRebuild() && orderLinesRebuildIndex() && hotRebuild(TABLE_INVENTORY) &&
+           hotRebuild(TABLE_CUSTOMERS);
+}
+
+/**
+ * @brief Regenerates the order columns, daily totals and order line indexes
+ */
+void rebuildReportData() {
+    if (rebuildReports()) {
+        printf("Report data rebuilt from %s, %s, %s and %s\n", ORDERS_FILE, ORDER_LINES_FILE, INVENTORY_FILE,
+               CUSTOMERS_FILE);
+    } else {
+        printf("Error opening file!\n");
+    }
 }
 
 /**
@@ -170,48 +426,97 @@ void restoreData() {
  * @return int 0 for failed login, 1 for regular user, 2 for admin
  */
 int loginUser(char *username, char *password) {
-    FILE *file = fopen(USERS_FILE, "rb");
-    if (file == NULL) {
+    METRICS_SPAN(METRIC_LOGIN);
+    long count;
+    const User *users = cacheTable(TABLE_USERS, &count);
+    if (count < 0) {
         printf("Error opening file!\n");
         return 0;
     }
+    ioCountScan(count);
 
-    User user;
-    while (fread(&user, sizeof(User), 1, file)) {
-        if (strcmp(user.username, username) == 0 && strcmp(user.password, password) == 0) {
-            fclose(file);
-            return user.is_admin ? 2 : 1; // 2 for admin, 1 for regular user
+    for (long i = 0; i < count; i++) {
+        if (strcmp(users[i].username, username) == 0 && strcmp(users[i].password, password) == 0) {
+            return users[i].is_admin ? 2 : 1; // 2 for admin, 1 for regular user
         }
     }
 
-    fclose(file);
     return 0; // Login failed
 }
 
 /**
- * @brief Changes the password for a given user
- * @param username The username of the user whose password is to be changed
+ * @brief Creates the default admin user when there is no users file yet
  */
-void changePassword(char *username) {
-    FILE *file = fopen(USERS_FILE, "rb+");
+void ensureDefaultAdmin() {
+    FILE *file = ioFopen(USERS_FILE, "rb");
     if (file == NULL) {
-        printf("Error opening file!\n");
-        return;
+        User admin = {"admin", "0000", 1};
+        tableAppend(TABLE_USERS, &admin);
+    } else {
+        fclose(file);
+    }
+}
+
+/**
+ * @brief Sets a user's password
+ * @param username The user whose password changes
+ * @param password The new password
+ * @return int 1 on success, 0 if there is no such user or the write failed
+ */
+int setUserPassword(const char *username, const char *password) {
+    METRICS_SPAN(METRIC_CHANGE_PASSWORD);
+    long count;
+    const User *users = cacheTable(TABLE_USERS, &count);
+    long slot = -1;
+    for (long i = 0; i < count; i++) {
+        if (strcmp(users[i].username, username) == 0) {
+            slot = i;
+            break;
+        }
+    }
+    if (slot < 0) {
+        return 0;
     }
 
+    // Users have no IDs, so the lock is on the slot; check it still holds this user
     User user;
     int found = 0;
-    while (fread(&user, sizeof(User), 1, file)) {
-        if (strcmp(user.username, username) == 0) {
-            validateStringInput(user.password, MAX_PASSWORD_LENGTH, "Enter new password: ");
-            fseek(file, -sizeof(User), SEEK_CUR);
-            fwrite(&user, sizeof(User), 1, file);
-            found = 1;
-            break;
+    if (!recordLock(TABLE_USERS, slot)) {
+        return 0;
+    }
+    if (tableReadSlot(TABLE_USERS, slot, &user) && strcmp(user.username, username) == 0) {
+        strcpy(user.password, password);
+        found = tableWriteSlot(TABLE_USERS, slot, &user);
+    }
+    recordUnlock(TABLE_USERS, slot);
+    return found;
+}
+
+/**
+ * @brief Tells whether a user account exists
+ */
+static int userExists(const char *username) {
+    long count;
+    const User *users = cacheTable(TABLE_USERS, &count);
+    for (long i = 0; i < count; i++) {
+        if (strcmp(users[i].username, username) == 0) {
+            return 1;
         }
     }
+    return 0;
+}
 
-    fclose(file);
+/**
+ * @brief Changes the password for a given user
+ * @param username The username of the user whose password is to be changed
+ */
+void changePassword(char *username) {
+    int found = 0;
+    if (userExists(username)) {
+        char password[MAX_PASSWORD_LENGTH];
+        validateStringInput(password, MAX_PASSWORD_LENGTH, "Enter new password: ");
+        found = setUserPassword(username, password);
+    }
 
     if (found) {
         printf("Password changed successfully!\n");
@@ -219,4 +524,3 @@ void changePassword(char *username) {
         printf("User not found!\n");
     }
 }
-
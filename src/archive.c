@@ -0,0 +1,181 @@
+/*
+ * =====================================================================================
+ * File: archive.c
+ * Description: The change archive (data/sbms.arc): a permanent, append-only copy
+ *              of every entry the write-ahead log ever held. The log copies its
+ *              entries here at each checkpoint before it is truncated, so the
+ *              archive together with a backup can bring the tables forward to
+ *              any later moment (see walArchiveChanges and backupRestoreUntil).
+ *
+ *              The archive stores the log's bytes without looking into them.
+ *              They are cut into frames of up to 64 KiB, each compressed on its
+ *              own (see compress.c) and protected by a CRC-32. The header holds
+ *              the log positions (LSNs) the archive covers and the length of its
+ *              complete frames; it is only advanced after the frames are synced,
+ *              so a crash mid-append leaves a few bytes past the end that the
+ *              next append overwrites. Appends are serialized by the log lock.
+ *
+ * Author: Chiemezie Agbo
+ * Date: 17-10-2026
+ * Version: 1.0
+ * =====================================================================================
+ */
+
+#define _DEFAULT_SOURCE
+#include "../include/archive.h"
+#include "../include/compress.h"
+#include "../include/common.h"
+#include "../include/utils.h"
+#include "../include/metrics.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#define ARCHIVE_MAGIC 0x52414253u       /* "SBAR" */
+#define ARCHIVE_FRAME_MAGIC 0x4D415246u /* "FRAM" */
+#define ARCHIVE_VERSION 1
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t startLsn; /* First log position the archive holds */
+    uint64_t endLsn;   /* Log position the archive reaches */
+    uint64_t length;   /* Bytes of complete frames after the header */
+} ArchiveHeader;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t rawLength;
+    uint32_t storedLength; /* Equal to rawLength when stored uncompressed */
+    uint32_t checksum;
+} ArchiveFrame;
+
+static int readHeader(int fd, ArchiveHeader *header) {
+    return ioPread(fd, header, sizeof(*header), 0) == (ssize_t)sizeof(*header) && header->magic == ARCHIVE_MAGIC &&
+           header->version == ARCHIVE_VERSION;
+}
+
+static uint32_t frameChecksum(ArchiveFrame frame, const unsigned char *stored) {
+    frame.checksum = 0;
+    return computeCrc32(computeCrc32(0, &frame, sizeof(frame)), stored, frame.storedLength);
+}
+
+/**
+ * @brief Reports the log positions the archive covers
+ * @param startLsn Output for the first position held
+ * @param endLsn Output for the position the archive reaches
+ * @return int 1 if an archive exists, 0 otherwise
+ */
+int archiveRange(uint64_t *startLsn, uint64_t *endLsn) {
+    int fd = ioOpen(ARCHIVE_FILE, O_RDONLY);
+    if (fd < 0) {
+        return 0;
+    }
+    ArchiveHeader header;
+    int ok = readHeader(fd, &header);
+    close(fd);
+    if (ok) {
+        *startLsn = header.startLsn;
+        *endLsn = header.endLsn;
+    }
+    return ok;
+}
+
+/**
+ * @brief Appends log bytes to the archive and syncs them
+ * @param data The log entries to add
+ * @param length Size of data
+ * @param startLsn Log position of data, kept as the start of a new archive
+ * @param endLsn Log position the archive reaches afterwards
+ * @return int 1 on success, 0 otherwise
+ *
+ * The caller must hold the log lock.
+ */
+int archiveAppend(const void *data, size_t length, uint64_t startLsn, uint64_t endLsn) {
+    int fd = ioOpen(ARCHIVE_FILE, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        return 0;
+    }
+
+    ArchiveHeader header;
+    if (!readHeader(fd, &header)) {
+        header = (ArchiveHeader){ARCHIVE_MAGIC, ARCHIVE_VERSION, startLsn, startLsn, 0};
+    }
+
+    size_t bound = compressBound(COMPRESS_MAX_BLOCK);
+    unsigned char *stored = malloc(sizeof(ArchiveFrame) + bound);
+    int ok = stored != NULL;
+    off_t offset = (off_t)sizeof(header) + (off_t)header.length;
+    for (size_t done = 0; ok && done < length;) {
+        const unsigned char *raw = (const unsigned char *)data + done;
+        size_t rawLength = length - done < COMPRESS_MAX_BLOCK ? length - done : COMPRESS_MAX_BLOCK;
+        size_t storedLength = compressBlock(raw, rawLength, stored + sizeof(ArchiveFrame), bound);
+        if (storedLength == 0) {
+            memcpy(stored + sizeof(ArchiveFrame), raw, rawLength);
+            storedLength = rawLength;
+        }
+
+        ArchiveFrame frame = {ARCHIVE_FRAME_MAGIC, (uint32_t)rawLength, (uint32_t)storedLength, 0};
+        frame.checksum = frameChecksum(frame, stored + sizeof(ArchiveFrame));
+        memcpy(stored, &frame, sizeof(frame));
+        ok = ioPwrite(fd, stored, sizeof(frame) + storedLength, offset) == (ssize_t)(sizeof(frame) + storedLength);
+        offset += (off_t)(sizeof(frame) + storedLength);
+        done += rawLength;
+    }
+    free(stored);
+
+    // The frames must be on disk before the header counts them
+    ok = ok && fdatasync(fd) == 0;
+    if (ok) {
+        header.endLsn = endLsn;
+        header.length = (uint64_t)(offset - (off_t)sizeof(header));
+        ok = ioPwrite(fd, &header, sizeof(header), 0) == (ssize_t)sizeof(header) && fdatasync(fd) == 0;
+    }
+    close(fd);
+    return ok;
+}
+
+/**
+ * @brief Passes the archived log bytes, in order, to a callback
+ * @param consume Called once per frame with its uncompressed bytes
+ * @param context Passed to the callback
+ * @return int 1 on success, 0 if there is no archive, a frame is damaged or the callback failed
+ */
+int archiveRead(ArchiveDataFn consume, void *context) {
+    int fd = ioOpen(ARCHIVE_FILE, O_RDONLY);
+    if (fd < 0) {
+        return 0;
+    }
+
+    ArchiveHeader header;
+    size_t bound = compressBound(COMPRESS_MAX_BLOCK);
+    unsigned char *stored = malloc(bound);
+    unsigned char *raw = malloc(COMPRESS_MAX_BLOCK);
+    int ok = stored != NULL && raw != NULL && readHeader(fd, &header);
+
+    off_t offset = sizeof(header);
+    off_t end = (off_t)sizeof(header) + (off_t)(ok ? header.length : 0);
+    while (ok && offset < end) {
+        ArchiveFrame frame;
+        ok = ioPread(fd, &frame, sizeof(frame), offset) == (ssize_t)sizeof(frame) &&
+             frame.magic == ARCHIVE_FRAME_MAGIC && frame.rawLength <= COMPRESS_MAX_BLOCK &&
+             frame.storedLength <= frame.rawLength &&
+             offset + (off_t)(sizeof(frame) + frame.storedLength) <= end &&
+             ioPread(fd, stored, frame.storedLength, offset + (off_t)sizeof(frame)) == (ssize_t)frame.storedLength &&
+             frameChecksum(frame, stored) == frame.checksum;
+        if (ok && frame.storedLength < frame.rawLength) {
+            ok = decompressBlock(stored, frame.storedLength, raw, frame.rawLength);
+        } else if (ok) {
+            memcpy(raw, stored, frame.rawLength);
+        }
+        ok = ok && consume(raw, frame.rawLength, context);
+        offset += (off_t)(sizeof(frame) + frame.storedLength);
+    }
+
+    free(stored);
+    free(raw);
+    close(fd);
+    return ok;
+}
@@ -0,0 +1,1117 @@
+/*
+ * =====================================================================================
+ * File: backup.c
+ * Description: Creates, verifies and restores backups of the table files without
+ *              starting any external programs. Backups live in a content-addressed
+ *              chunk store (see chunkstore.c): every table file is cut into 64 KiB
+ *              blocks and each distinct block is stored once, compressed. A backup
+ *              is a snapshot file under data/backup/store/snapshots/ listing, for
+ *              every table file, its size and the hash of each of its blocks.
+ *              Blocks that did not change since any earlier backup cost nothing
+ *              but their hash, so years of hourly backups fit where a handful of
+ *              full copies used to.
+ *
+ *              Hashing and compression run on every core: blocks are read in
+ *              batches, worker threads hash each block and compress the ones the
+ *              store does not hold yet, and the chunks are then appended in order.
+ *
+ *              Backups are taken online. The write-ahead log is pinned before
+ *              the files are read, so checkpoints neither truncate it nor compact
+ *              a table meanwhile; once the files are read, every change logged
+ *              since the pin is applied to the blocks it touched. A snapshot
+ *              therefore holds all tables exactly as they were at one log
+ *              position, although other terminals kept writing while they were
+ *              read. Writers only wait while the last few log entries are read.
+ *
+ *              Restores reassemble every table file next to the original and
+ *              check each block against its hash before any table file is
+ *              replaced, so a damaged backup is refused instead of half-restored.
+ *              Backup directories made by earlier versions (a copy of every file
+ *              and an optional MANIFEST of block checksums) can still be restored.
+ *
+ * Author: Chiemezie Agbo
+ * Date: 17-10-2026
+ * Version: 1.0
+ * =====================================================================================
+ */
+
+#define _GNU_SOURCE
+#include "../include/backup.h"
+#include "../include/chunkstore.h"
+#include "../include/compress.h"
+#include "../include/common.h"
+#include "../include/table.h"
+#include "../include/wal.h"
+#include "../include/metrics.h"
+#include "../include/utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#define BACKUP_MAGIC 0x4B414253u   /* "SBAK", a backup directory's MANIFEST */
+#define SNAPSHOT_MAGIC 0x4E534253u /* "SBSN" */
+#define BACKUP_VERSION 1
+#define SNAPSHOT_VERSION 2 /* Version 1 snapshots lack the log position */
+#define BACKUP_BATCH_BLOCKS 64
+#define BACKUP_MAX_THREADS 16
+#define BACKUP_NAME_LENGTH 32
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t blockSize;
+    uint32_t fileCount;
+    int64_t created;
+} ManifestHeader;
+
+typedef struct {
+    char name[BACKUP_NAME_LENGTH];
+    int64_t size;
+    uint64_t blockCount;
+} ManifestFile;
+
+/* A file in a backup directory, with one checksum per block */
+typedef struct {
+    ManifestFile file;
+    uint64_t *checksums;
+} ManifestEntry;
+
+typedef struct {
+    int fileCount;
+    ManifestEntry entries[TABLE_COUNT];
+} Manifest;
+
+/* A file in a snapshot, with the hash of the chunk holding each block */
+typedef struct {
+    ManifestFile file;
+    ChunkHash *chunks;
+} SnapshotEntry;
+
+typedef struct {
+    int fileCount;
+    SnapshotEntry entries[TABLE_COUNT];
+    uint64_t lsn; /* Log position the tables are at, 0 if unknown */
+} Snapshot;
+
+/* Blocks hashed and compressed together, one slot of each array per block */
+typedef struct {
+    const ChunkStore *store;
+    int count;
+    unsigned char *blocks;
+    unsigned char *compressed;
+    size_t lengths[BACKUP_BATCH_BLOCKS];
+    ChunkHash hashes[BACKUP_BATCH_BLOCKS];
+    size_t storedLengths[BACKUP_BATCH_BLOCKS];
+    int known[BACKUP_BATCH_BLOCKS];
+} Batch;
+
+typedef struct {
+    Batch *batch;
+    int first;
+    int step;
+} BatchWorker;
+
+/* A change logged while the files were read, kept until they all are */
+typedef struct {
+    TableId table;
+    long slot;
+    size_t dataOffset;
+    size_t length;
+} Change;
+
+typedef struct {
+    Change *changes;
+    size_t count;
+    size_t capacity;
+    unsigned char *data;
+    size_t dataLength;
+    size_t dataCapacity;
+} ChangeLog;
+
+/* The part of a change that falls in one block */
+typedef struct {
+    uint64_t block;
+    size_t change;
+    size_t offset;
+    size_t dataOffset;
+    size_t length;
+} Piece;
+
+static const char *tableFileName(TableId table) {
+    const char *path = getTableDef(table)->dataFile;
+    const char *slash = strrchr(path, '/');
+    return slash != NULL ? slash + 1 : path;
+}
+
+static size_t blockLength(int64_t fileSize, uint64_t block) {
+    int64_t remaining = fileSize - (int64_t)(block * BACKUP_BLOCK_SIZE);
+    return remaining < BACKUP_BLOCK_SIZE ? (size_t)remaining : BACKUP_BLOCK_SIZE;
+}
+
+static uint64_t blockCount(int64_t fileSize) {
+    return ((uint64_t)fileSize + BACKUP_BLOCK_SIZE - 1) / BACKUP_BLOCK_SIZE;
+}
+
+static int readFully(int fd, void *buffer, size_t length, off_t offset) {
+    size_t done = 0;
+    while (done < length) {
+        ssize_t got = ioPread(fd, (char *)buffer + done, length - done, offset + (off_t)done);
+        if (got <= 0) {
+            if (got < 0 && errno == EINTR) {
+                continue;
+            }
+            return 0;
+        }
+        done += (size_t)got;
+    }
+    return 1;
+}
+
+static int writeFully(int fd, const void *buffer, size_t length, off_t offset) {
+    size_t done = 0;
+    while (done < length) {
+        ssize_t put = ioPwrite(fd, (const char *)buffer + done, length - done, offset + (off_t)done);
+        if (put <= 0) {
+            if (put < 0 && errno == EINTR) {
+                continue;
+            }
+            return 0;
+        }
+        done += (size_t)put;
+    }
+    return 1;
+}
+
+/**
+ * @brief Copies a byte range between files inside the kernel where possible
+ * @return int 1 on success, 0 otherwise
+ */
+static int copyRange(int in, off_t inOffset, int out, off_t outOffset, size_t length) {
+    while (length > 0) {
+        ssize_t copied = copy_file_range(in, &inOffset, out, &outOffset, length, 0);
+        if (copied <= 0) {
+            break;
+        }
+        length -= (size_t)copied;
+    }
+
+    // Across filesystems or without kernel support, copy through a buffer
+    unsigned char *buffer = length > 0 ? malloc(BACKUP_BLOCK_SIZE) : NULL;
+    if (length > 0 && buffer == NULL) {
+        return 0;
+    }
+    while (length > 0) {
+        size_t chunk = length < BACKUP_BLOCK_SIZE ? length : BACKUP_BLOCK_SIZE;
+        if (!readFully(in, buffer, chunk, inOffset) || !writeFully(out, buffer, chunk, outOffset)) {
+            free(buffer);
+            return 0;
+        }
+        inOffset += (off_t)chunk;
+        outOffset += (off_t)chunk;
+        length -= chunk;
+    }
+    free(buffer);
+    return 1;
+}
+
+/**
+ * @brief Tells whether a backup name can be used as a file name
+ */
+static int validName(const char *name) {
+    return name[0] != '\0' && name[0] != '.' && strchr(name, '/') == NULL && strlen(name) < 200;
+}
+
+static void freeSnapshot(Snapshot *snapshot) {
+    for (int i = 0; i < snapshot->fileCount; i++) {
+        free(snapshot->entries[i].chunks);
+    }
+    memset(snapshot, 0, sizeof(*snapshot));
+}
+
+static SnapshotEntry *findSnapshotEntry(Snapshot *snapshot, const char *name) {
+    for (int i = 0; i < snapshot->fileCount; i++) {
+        if (strcmp(snapshot->entries[i].file.name, name) == 0) {
+            return &snapshot->entries[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Reads a snapshot from the store
+ * @return int 1 if a valid snapshot was loaded, 0 otherwise
+ */
+static int loadSnapshot(const char *name, Snapshot *snapshot) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s%s.snap", BACKUP_SNAPSHOT_DIR, name);
+    memset(snapshot, 0, sizeof(*snapshot));
+
+    FILE *file = ioFopen(path, "rb");
+    if (file == NULL) {
+        return 0;
+    }
+
+    ManifestHeader header;
+    int ok = ioFread(&header, sizeof(header), 1, file) == 1 && header.magic == SNAPSHOT_MAGIC &&
+             (header.version == 1 || header.version == SNAPSHOT_VERSION) && header.blockSize == BACKUP_BLOCK_SIZE &&
+             header.fileCount <= TABLE_COUNT;
+    if (ok && header.version == SNAPSHOT_VERSION) {
+        ok = ioFread(&snapshot->lsn, sizeof(snapshot->lsn), 1, file) == 1;
+    }
+    for (uint32_t i = 0; ok && i < header.fileCount; i++) {
+        SnapshotEntry *entry = &snapshot->entries[i];
+        ok = ioFread(&entry->file, sizeof(entry->file), 1, file) == 1 && entry->file.size >= 0 &&
+             entry->file.blockCount == blockCount(entry->file.size);
+        if (ok) {
+            entry->file.name[BACKUP_NAME_LENGTH - 1] = '\0';
+            entry->chunks = malloc((entry->file.blockCount + 1) * sizeof(ChunkHash));
+            snapshot->fileCount++;
+            ok = entry->chunks != NULL &&
+                 ioFread(entry->chunks, sizeof(ChunkHash), entry->file.blockCount, file) == entry->file.blockCount;
+        }
+    }
+    fclose(file);
+
+    if (!ok) {
+        freeSnapshot(snapshot);
+    }
+    return ok;
+}
+
+/**
+ * @brief Writes a snapshot into the store
+ *
+ * The snapshot is written last and renamed into place, after every chunk it
+ * names is durable, so a snapshot that exists can always be restored.
+ */
+static int saveSnapshot(const char *name, const Snapshot *snapshot) {
+    char path[512];
+    char tempPath[512];
+    snprintf(path, sizeof(path), "%s%s.snap", BACKUP_SNAPSHOT_DIR, name);
+    tempFileName(tempPath, sizeof(tempPath), path);
+
+    mkdir(BACKUP_SNAPSHOT_DIR, 0755);
+    FILE *file = ioFopen(tempPath, "wb");
+    if (file == NULL) {
+        return 0;
+    }
+
+    ManifestHeader header = {SNAPSHOT_MAGIC, SNAPSHOT_VERSION, BACKUP_BLOCK_SIZE, (uint32_t)snapshot->fileCount,
+                             (int64_t)time(NULL)};
+    int ok = ioFwrite(&header, sizeof(header), 1, file) == 1 &&
+             ioFwrite(&snapshot->lsn, sizeof(snapshot->lsn), 1, file) == 1;
+    for (int i = 0; ok && i < snapshot->fileCount; i++) {
+        const SnapshotEntry *entry = &snapshot->entries[i];
+        ok = ioFwrite(&entry->file, sizeof(entry->file), 1, file) == 1 &&
+             ioFwrite(entry->chunks, sizeof(ChunkHash), entry->file.blockCount, file) == entry->file.blockCount;
+    }
+    ok = fflush(file) == 0 && fsync(fileno(file)) == 0 && ok;
+    ok = fclose(file) == 0 && ok;
+
+    if (!ok || rename(tempPath, path) != 0) {
+        unlink(tempPath);
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief Hashes the blocks of a batch and compresses the ones the store lacks
+ */
+static void *hashBlocks(void *arg) {
+    BatchWorker *worker = arg;
+    Batch *batch = worker->batch;
+    size_t bound = compressBound(BACKUP_BLOCK_SIZE);
+    for (int i = worker->first; i < batch->count; i += worker->step) {
+        const unsigned char *block = batch->blocks + (size_t)i * BACKUP_BLOCK_SIZE;
+        batch->hashes[i] = chunkHash(block, batch->lengths[i]);
+        batch->known[i] = chunkStoreHas(batch->store, &batch->hashes[i]);
+        batch->storedLengths[i] =
+            batch->known[i] ? 0 : compressBlock(block, batch->lengths[i], batch->compressed + (size_t)i * bound, bound);
+    }
+    return NULL;
+}
+
+static int workerCount(void) {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cores < 1) {
+        return 1;
+    }
+    return cores < BACKUP_MAX_THREADS ? (int)cores : BACKUP_MAX_THREADS;
+}
+
+/**
+ * @brief Adds the blocks of a batch to the store, leaving their hashes in the batch
+ * @return int 1 on success, 0 otherwise
+ */
+static int storeBatch(ChunkStore *store, Batch *batch, BackupStats *stats) {
+    pthread_t threads[BACKUP_MAX_THREADS];
+    BatchWorker workers[BACKUP_MAX_THREADS];
+    int started[BACKUP_MAX_THREADS] = {0};
+    int count = workerCount() < batch->count ? workerCount() : batch->count;
+
+    // The store is only read until every worker is done
+    batch->store = store;
+    for (int w = 0; w < count; w++) {
+        workers[w] = (BatchWorker){batch, w, count};
+        started[w] = w > 0 && pthread_create(&threads[w], NULL, hashBlocks, &workers[w]) == 0;
+    }
+    for (int w = 0; w < count; w++) {
+        if (!started[w]) {
+            hashBlocks(&workers[w]);
+        }
+    }
+    for (int w = 0; w < count; w++) {
+        if (started[w]) {
+            pthread_join(threads[w], NULL);
+        }
+    }
+
+    size_t bound = compressBound(BACKUP_BLOCK_SIZE);
+    for (int i = 0; i < batch->count; i++) {
+        // A block may repeat one earlier in the batch
+        if (batch->known[i] || chunkStoreHas(store, &batch->hashes[i])) {
+            continue;
+        }
+        size_t length = batch->lengths[i];
+        size_t storedLength = batch->storedLengths[i];
+        const unsigned char *stored = batch->compressed + (size_t)i * bound;
+        if (storedLength == 0) {
+            stored = batch->blocks + (size_t)i * BACKUP_BLOCK_SIZE;
+            storedLength = length;
+        }
+        if (!chunkStorePut(store, &batch->hashes[i], stored, (uint32_t)storedLength, (uint32_t)length)) {
+            return 0;
+        }
+        stats->newBytes += (long long)length;
+        stats->storedBytes += (long long)storedLength;
+    }
+    return 1;
+}
+
+/**
+ * @brief Stores every block of one table file
+ * @param store The chunk store
+ * @param batch Buffers to read and compress blocks in
+ * @param source The table file
+ * @param entry Output for the file's snapshot entry
+ * @param stats Statistics to add to
+ * @return int 1 on success, 0 otherwise
+ */
+static int backupFile(ChunkStore *store, Batch *batch, const char *source, SnapshotEntry *entry, BackupStats *stats) {
+    int in = ioOpen(source, O_RDONLY);
+    struct stat st;
+    // A table that was never written is kept as an empty file, so restoring empties it
+    int ok = in >= 0 ? fstat(in, &st) == 0 : errno == ENOENT;
+    if (in < 0) {
+        st.st_size = 0;
+    }
+    if (ok) {
+        entry->file.size = st.st_size;
+        entry->file.blockCount = blockCount(st.st_size);
+        entry->chunks = malloc((entry->file.blockCount + 1) * sizeof(ChunkHash));
+        ok = entry->chunks != NULL;
+    }
+
+    for (uint64_t first = 0; ok && first < entry->file.blockCount; first += (uint64_t)batch->count) {
+        uint64_t left = entry->file.blockCount - first;
+        batch->count = left < BACKUP_BATCH_BLOCKS ? (int)left : BACKUP_BATCH_BLOCKS;
+
+        // Only the last block of a file is short, so a batch is one read
+        size_t length = 0;
+        for (int i = 0; i < batch->count; i++) {
+            batch->lengths[i] = blockLength(entry->file.size, first + (uint64_t)i);
+            length += batch->lengths[i];
+        }
+        ok = readFully(in, batch->blocks, length, (off_t)(first * BACKUP_BLOCK_SIZE)) && storeBatch(store, batch, stats);
+        if (ok) {
+            memcpy(&entry->chunks[first], batch->hashes, (size_t)batch->count * sizeof(ChunkHash));
+        }
+    }
+
+    if (ok) {
+        stats->files++;
+        stats->totalBytes += entry->file.size;
+    }
+    if (in >= 0) {
+        close(in);
+    }
+    return ok;
+}
+
+/**
+ * @brief Keeps one logged change until every table file has been read
+ */
+static int collectChange(TableId table, long slot, const void *record, int id, void *context) {
+    ChangeLog *log = context;
+    int tombstone = -abs(id);
+    size_t length = record != NULL ? getTableDef(table)->recordSize : sizeof(tombstone);
+
+    if (log->count == log->capacity) {
+        size_t capacity = log->capacity ? log->capacity * 2 : 256;
+        Change *grown = realloc(log->changes, capacity * sizeof(Change));
+        if (grown == NULL) {
+            return 0;
+        }
+        log->changes = grown;
+        log->capacity = capacity;
+    }
+    if (log->dataLength + length > log->dataCapacity) {
+        size_t capacity = log->dataCapacity ? log->dataCapacity * 2 : 65536;
+        while (capacity < log->dataLength + length) {
+            capacity *= 2;
+        }
+        unsigned char *grown = realloc(log->data, capacity);
+        if (grown == NULL) {
+            return 0;
+        }
+        log->data = grown;
+        log->dataCapacity = capacity;
+    }
+
+    memcpy(log->data + log->dataLength, record != NULL ? record : (const void *)&tombstone, length);
+    log->changes[log->count++] = (Change){table, slot, log->dataLength, length};
+    log->dataLength += length;
+    return 1;
+}
+
+static int comparePieces(const void *a, const void *b) {
+    const Piece *left = a;
+    const Piece *right = b;
+    if (left->block != right->block) {
+        return left->block < right->block ? -1 : 1;
+    }
+    return left->change < right->change ? -1 : left->change > right->change;
+}
+
+/**
+ * @brief Cuts the changes to one table into per-block pieces, in block then log order
+ * @return Piece* The pieces (count in pieceCount), NULL if memory ran out
+ */
+static Piece *splitChanges(const ChangeLog *log, TableId table, size_t *pieceCount, int64_t *end) {
+    size_t recordSize = getTableDef(table)->recordSize;
+    Piece *pieces = malloc((log->count * (recordSize / BACKUP_BLOCK_SIZE + 2) + 1) * sizeof(Piece));
+    *pieceCount = 0;
+    if (pieces == NULL) {
+        return NULL;
+    }
+
+    for (size_t c = 0; c < log->count; c++) {
+        const Change *change = &log->changes[c];
+        if (change->table != table) {
+            continue;
+        }
+        uint64_t offset = (uint64_t)change->slot * recordSize;
+        for (size_t done = 0; done < change->length;) {
+            uint64_t block = (offset + done) / BACKUP_BLOCK_SIZE;
+            size_t inBlock = (size_t)((offset + done) % BACKUP_BLOCK_SIZE);
+            size_t length = change->length - done;
+            if (length > BACKUP_BLOCK_SIZE - inBlock) {
+                length = BACKUP_BLOCK_SIZE - inBlock;
+            }
+            pieces[(*pieceCount)++] = (Piece){block, c, inBlock, change->dataOffset + done, length};
+            done += length;
+        }
+        if ((int64_t)(offset + change->length) > *end) {
+            *end = (int64_t)(offset + change->length);
+        }
+    }
+    qsort(pieces, *pieceCount, sizeof(Piece), comparePieces);
+    return pieces;
+}
+
+/**
+ * @brief Applies the changes logged while the files were read to the snapshot
+ *
+ * Every block a change touched, and every block a table grew by, is rebuilt
+ * from its stored chunk and stored again.
+ */
+static int applyChanges(ChunkStore *store, Batch *batch, const ChangeLog *log, Snapshot *snapshot,
+                        BackupStats *stats) {
+    int ok = 1;
+    for (int t = 0; ok && t < TABLE_COUNT; t++) {
+        size_t pieceCount;
+        int64_t end = 0;
+        Piece *pieces = splitChanges(log, (TableId)t, &pieceCount, &end);
+        if (pieces == NULL || pieceCount == 0) {
+            ok = pieces != NULL;
+            free(pieces);
+            continue;
+        }
+
+        const char *name = tableFileName((TableId)t);
+        SnapshotEntry *entry = findSnapshotEntry(snapshot, name);
+        if (entry == NULL) {
+            // The table file was created after the files were read
+            entry = &snapshot->entries[snapshot->fileCount++];
+            snprintf(entry->file.name, sizeof(entry->file.name), "%s", name);
+            stats->files++;
+        }
+
+        int64_t oldSize = entry->file.size;
+        uint64_t oldCount = entry->file.blockCount;
+        int64_t newSize = end > oldSize ? end : oldSize;
+        uint64_t newCount = blockCount(newSize);
+        ChunkHash *chunks = realloc(entry->chunks, (newCount + 1) * sizeof(ChunkHash));
+        ok = chunks != NULL;
+        if (ok) {
+            entry->chunks = chunks;
+            entry->file.size = newSize;
+            entry->file.blockCount = newCount;
+            stats->totalBytes += newSize - oldSize;
+        }
+
+        // The old last block is rebuilt too when the file grew, since it grew with it
+        uint64_t growFrom = newSize > oldSize ? (oldCount > 0 ? oldCount - 1 : 0) : newCount;
+        uint64_t blocks[BACKUP_BATCH_BLOCKS];
+        size_t p = 0;
+        batch->count = 0;
+        for (uint64_t block = 0; ok && block < newCount; block++) {
+            int touched = p < pieceCount && pieces[p].block == block;
+            if (!touched && block < growFrom) {
+                continue;
+            }
+
+            int i = batch->count++;
+            unsigned char *data = batch->blocks + (size_t)i * BACKUP_BLOCK_SIZE;
+            size_t length = 0;
+            memset(data, 0, BACKUP_BLOCK_SIZE);
+            if (block < oldCount) {
+                ok = chunkStoreGet(store, &entry->chunks[block], data, BACKUP_BLOCK_SIZE, &length);
+            }
+            for (; p < pieceCount && pieces[p].block == block; p++) {
+                memcpy(data + pieces[p].offset, log->data + pieces[p].dataOffset, pieces[p].length);
+            }
+            batch->lengths[i] = blockLength(newSize, block);
+            blocks[i] = block;
+
+            if (ok && (batch->count == BACKUP_BATCH_BLOCKS || block + 1 == newCount || p == pieceCount)) {
+                ok = storeBatch(store, batch, stats);
+                for (int j = 0; ok && j < batch->count; j++) {
+                    entry->chunks[blocks[j]] = batch->hashes[j];
+                }
+                batch->count = 0;
+            }
+        }
+        free(pieces);
+    }
+    stats->changes = (long)log->count;
+    return ok;
+}
+
+/**
+ * @brief Backs up every table file as a new snapshot in the chunk store
+ * @param name The snapshot's name
+ * @param stats Optional output for the amount of data read and added to the store
+ * @return int 1 on success, 0 otherwise
+ *
+ * Other terminals may keep writing meanwhile: the snapshot ends up holding the
+ * tables as they were at the moment the files had all been read.
+ */
+int backupCreate(const char *name, BackupStats *stats) {
+    BackupStats localStats;
+    if (stats == NULL) {
+        stats = &localStats;
+    }
+    memset(stats, 0, sizeof(*stats));
+
+    ChunkStore store;
+    if (!validName(name) || !chunkStoreOpen(&store, 1)) {
+        return 0;
+    }
+
+    Batch *batch = calloc(1, sizeof(Batch));
+    if (batch != NULL) {
+        batch->blocks = malloc((size_t)BACKUP_BATCH_BLOCKS * BACKUP_BLOCK_SIZE);
+        batch->compressed = malloc((size_t)BACKUP_BATCH_BLOCKS * compressBound(BACKUP_BLOCK_SIZE));
+    }
+
+    // Keep every change made while reading in the log, see walCutChanges
+    uint64_t pinLsn;
+    int ok = batch != NULL && batch->blocks != NULL && batch->compressed != NULL && walPin(&pinLsn);
+    if (!ok) {
+        if (batch != NULL) {
+            free(batch->blocks);
+            free(batch->compressed);
+        }
+        free(batch);
+        chunkStoreClose(&store);
+        return 0;
+    }
+
+    Snapshot snapshot;
+    memset(&snapshot, 0, sizeof(snapshot));
+    for (int t = 0; ok && t < TABLE_COUNT; t++) {
+        const char *source = getTableDef((TableId)t)->dataFile;
+        SnapshotEntry *entry = &snapshot.entries[snapshot.fileCount++];
+        snprintf(entry->file.name, sizeof(entry->file.name), "%s", tableFileName((TableId)t));
+        ok = backupFile(&store, batch, source, entry, stats);
+    }
+
+    ChangeLog log;
+    memset(&log, 0, sizeof(log));
+    if (ok) {
+        ok = walCutChanges(&pinLsn, collectChange, &log);
+        snapshot.lsn = pinLsn;
+    } else {
+        walUnpin();
+    }
+    ok = ok && applyChanges(&store, batch, &log, &snapshot, stats);
+
+    ok = ok && chunkStoreSync(&store) && saveSnapshot(name, &snapshot);
+    freeSnapshot(&snapshot);
+    free(log.changes);
+    free(log.data);
+    free(batch->blocks);
+    free(batch->compressed);
+    free(batch);
+    chunkStoreClose(&store);
+    return ok;
+}
+
+static void freeManifest(Manifest *manifest) {
+    for (int i = 0; i < manifest->fileCount; i++) {
+        free(manifest->entries[i].checksums);
+    }
+    memset(manifest, 0, sizeof(*manifest));
+}
+
+/**
+ * @brief Reads the manifest of a backup directory
+ * @return int 1 if a valid manifest was loaded, 0 otherwise
+ */
+static int loadManifest(const char *dir, Manifest *manifest) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s", dir, BACKUP_MANIFEST);
+    memset(manifest, 0, sizeof(*manifest));
+
+    FILE *file = ioFopen(path, "rb");
+    if (file == NULL) {
+        return 0;
+    }
+
+    ManifestHeader header;
+    int ok = ioFread(&header, sizeof(header), 1, file) == 1 && header.magic == BACKUP_MAGIC &&
+             header.version == BACKUP_VERSION && header.blockSize == BACKUP_BLOCK_SIZE &&
+             header.fileCount <= TABLE_COUNT;
+    for (uint32_t i = 0; ok && i < header.fileCount; i++) {
+        ManifestEntry *entry = &manifest->entries[i];
+        ok = ioFread(&entry->file, sizeof(entry->file), 1, file) == 1 && entry->file.size >= 0 &&
+             entry->file.blockCount == blockCount(entry->file.size);
+        if (ok) {
+            entry->file.name[BACKUP_NAME_LENGTH - 1] = '\0';
+            entry->checksums = malloc((entry->file.blockCount + 1) * sizeof(uint64_t));
+            manifest->fileCount++;
+            ok = entry->checksums != NULL &&
+                 ioFread(entry->checksums, sizeof(uint64_t), entry->file.blockCount, file) == entry->file.blockCount;
+        }
+    }
+    fclose(file);
+
+    if (!ok) {
+        freeManifest(manifest);
+    }
+    return ok;
+}
+
+static const ManifestEntry *findManifestEntry(const Manifest *manifest, const char *name) {
+    for (int i = 0; i < manifest->fileCount; i++) {
+        if (strcmp(manifest->entries[i].file.name, name) == 0) {
+            return &manifest->entries[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Reads a backup directory's file and checks it against its manifest entry
+ * @param in The backup file
+ * @param entry The manifest entry
+ * @param out File to copy the verified data to, -1 to only check
+ * @return int 1 if every block matches, 0 otherwise
+ *
+ * A manifest checksum is the first word of the block's chunk hash.
+ */
+static int checkFile(int in, const ManifestEntry *entry, int out) {
+    struct stat st;
+    if (fstat(in, &st) != 0 || st.st_size != entry->file.size) {
+        return 0;
+    }
+
+    unsigned char *buffer = malloc(BACKUP_BLOCK_SIZE);
+    int ok = buffer != NULL;
+    for (uint64_t block = 0; ok && block < entry->file.blockCount; block++) {
+        size_t length = blockLength(entry->file.size, block);
+        off_t offset = (off_t)(block * BACKUP_BLOCK_SIZE);
+        ok = readFully(in, buffer, length, offset) && chunkHash(buffer, length).words[0] == entry->checksums[block] &&
+             (out < 0 || writeFully(out, buffer, length, offset));
+    }
+    free(buffer);
+    return ok;
+}
+
+/**
+ * @brief Reassembles a snapshot's file from the store
+ * @param store The chunk store
+ * @param entry The snapshot entry
+ * @param out File to write the data to, -1 to only check
+ * @return int 1 if every chunk is present and intact, 0 otherwise
+ */
+static int assembleFile(const ChunkStore *store, const SnapshotEntry *entry, int out) {
+    unsigned char *buffer = malloc(BACKUP_BLOCK_SIZE);
+    int ok = buffer != NULL;
+    for (uint64_t block = 0; ok && block < entry->file.blockCount; block++) {
+        size_t length = 0;
+        ok = chunkStoreGet(store, &entry->chunks[block], buffer, BACKUP_BLOCK_SIZE, &length) &&
+             length == blockLength(entry->file.size, block) &&
+             (out < 0 || writeFully(out, buffer, length, (off_t)(block * BACKUP_BLOCK_SIZE)));
+    }
+    free(buffer);
+    return ok;
+}
+
+/**
+ * @brief Checks every block of a backup
+ * @param name The snapshot, or a backup directory under BACKUP_DIR
+ * @return int 1 if the backup is intact, 0 otherwise
+ */
+int backupVerify(const char *name) {
+    if (!validName(name)) {
+        return 0;
+    }
+
+    Snapshot snapshot;
+    if (loadSnapshot(name, &snapshot)) {
+        ChunkStore store;
+        int ok = chunkStoreOpen(&store, 0);
+        for (int i = 0; ok && i < snapshot.fileCount; i++) {
+            ok = assembleFile(&store, &snapshot.entries[i], -1);
+        }
+        chunkStoreClose(&store);
+        freeSnapshot(&snapshot);
+        return ok;
+    }
+
+    char dir[512];
+    Manifest manifest;
+    snprintf(dir, sizeof(dir), "%s%s", BACKUP_DIR, name);
+    if (!loadManifest(dir, &manifest)) {
+        return 0;
+    }
+    int ok = 1;
+    for (int i = 0; ok && i < manifest.fileCount; i++) {
+        char path[768];
+        snprintf(path, sizeof(path), "%s/%s", dir, manifest.entries[i].file.name);
+        int fd = ioOpen(path, O_RDONLY);
+        ok = fd >= 0 && checkFile(fd, &manifest.entries[i], -1);
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+    freeManifest(&manifest);
+    return ok;
+}
+
+/* A table file held in memory while archived changes are replayed onto it */
+typedef struct {
+    int loaded;
+    int changed;
+    unsigned char *records;
+    size_t count;
+    size_t capacity;
+    int *ids;    /* Open-addressing table of record IDs ... */
+    long *slots; /* ... and the slot holding each, -1 once deleted */
+    size_t slotCount;
+    size_t used;
+} ReplayTable;
+
+typedef struct {
+    ReplayTable tables[TABLE_COUNT];
+    const int *staged;
+} Replay;
+
+static size_t findId(const ReplayTable *table, int id) {
+    size_t slot = ((uint32_t)id * 2654435761u) & (table->slotCount - 1);
+    while (table->ids[slot] != 0 && table->ids[slot] != id) {
+        slot = (slot + 1) & (table->slotCount - 1);
+    }
+    return slot;
+}
+
+static int mapId(ReplayTable *table, int id, long slot) {
+    if ((table->used + 1) * 2 > table->slotCount) {
+        ReplayTable grown = *table;
+        grown.slotCount = table->slotCount ? table->slotCount * 2 : 1024;
+        grown.ids = calloc(grown.slotCount, sizeof(int));
+        grown.slots = malloc(grown.slotCount * sizeof(long));
+        if (grown.ids == NULL || grown.slots == NULL) {
+            free(grown.ids);
+            free(grown.slots);
+            return 0;
+        }
+        for (size_t i = 0; i < table->slotCount; i++) {
+            if (table->ids[i] != 0) {
+                size_t at = findId(&grown, table->ids[i]);
+                grown.ids[at] = table->ids[i];
+                grown.slots[at] = table->slots[i];
+            }
+        }
+        free(table->ids);
+        free(table->slots);
+        *table = grown;
+    }
+
+    size_t at = findId(table, id);
+    if (table->ids[at] == 0) {
+        table->ids[at] = id;
+        table->used++;
+    }
+    table->slots[at] = slot;
+    return 1;
+}
+
+/**
+ * @brief Reads a staged table file into memory and maps its record IDs
+ */
+static ReplayTable *loadReplayTable(Replay *replay, TableId table) {
+    ReplayTable *loaded = &replay->tables[table];
+    if (loaded->loaded) {
+        return loaded;
+    }
+
+    const TableDef *def = getTableDef(table);
+    char path[512];
+    snprintf(path, sizeof(path), "%s.restore", def->dataFile);
+    int fd = replay->staged[table] ? ioOpen(path, O_RDONLY) : -1;
+    struct stat st;
+    if (fd >= 0 && fstat(fd, &st) == 0) {
+        loaded->count = (size_t)st.st_size / def->recordSize;
+    }
+    loaded->capacity = loaded->count > 0 ? loaded->count : 64;
+    loaded->records = malloc(loaded->capacity * def->recordSize);
+    int ok = loaded->records != NULL && (replay->staged[table] ? fd >= 0 : 1) &&
+             (fd < 0 || readFully(fd, loaded->records, loaded->count * def->recordSize, 0));
+    if (fd >= 0) {
+        close(fd);
+    }
+
+    for (size_t slot = 0; ok && def->indexFile != NULL && slot < loaded->count; slot++) {
+        int id = recordId(loaded->records + slot * def->recordSize);
+        ok = id <= 0 || mapId(loaded, id, (long)slot);
+    }
+    loaded->loaded = ok;
+    return ok ? loaded : NULL;
+}
+
+/**
+ * @brief Applies one archived change to the table file it belongs to
+ *
+ * Compaction may have moved records since the change was logged, so records
+ * of indexed tables are found by ID; new records go to the end, as they did
+ * when first written. Users have no IDs and are never deleted, so their
+ * slots never move.
+ */
+static int replayArchivedChange(TableId table, long slot, const void *record, int id, void *context) {
+    ReplayTable *loaded = loadReplayTable(context, table);
+    const TableDef *def = getTableDef(table);
+    if (loaded == NULL) {
+        return 0;
+    }
+
+    long target = slot;
+    int key = abs(record != NULL ? recordId(record) : id);
+    if (def->indexFile != NULL) {
+        size_t at = loaded->slotCount > 0 ? findId(loaded, key) : 0;
+        target = loaded->slotCount > 0 && loaded->ids[at] == key ? loaded->slots[at] : -1;
+        if (target < 0 && record != NULL && recordId(record) > 0) {
+            target = (long)loaded->count;
+        }
+        if (target < 0) {
+            return 1; // Deletes a record the backup never saw
+        }
+    }
+
+    if ((size_t)target >= loaded->capacity) {
+        size_t capacity = loaded->capacity * 2 > (size_t)target + 1 ? loaded->capacity * 2 : (size_t)target + 1;
+        unsigned char *grown = realloc(loaded->records, capacity * def->recordSize);
+        if (grown == NULL) {
+            return 0;
+        }
+        loaded->records = grown;
+        loaded->capacity = capacity;
+    }
+    if ((size_t)target >= loaded->count) {
+        memset(loaded->records + loaded->count * def->recordSize, 0,
+               ((size_t)target + 1 - loaded->count) * def->recordSize);
+        loaded->count = (size_t)target + 1;
+    }
+
+    unsigned char *stored = loaded->records + (size_t)target * def->recordSize;
+    if (record != NULL) {
+        memcpy(stored, record, def->recordSize);
+    } else {
+        int tombstone = -key;
+        memcpy(stored, &tombstone, sizeof(tombstone));
+    }
+    loaded->changed = 1;
+
+    if (def->indexFile != NULL) {
+        return mapId(loaded, key, recordId(stored) > 0 ? target : -1);
+    }
+    return 1;
+}
+
+/**
+ * @brief Writes the tables that archived changes touched back to their staged files
+ */
+static int finishArchiveReplay(Replay *replay, int *staged) {
+    int ok = 1;
+    for (int t = 0; t < TABLE_COUNT; t++) {
+        ReplayTable *loaded = &replay->tables[t];
+        if (ok && loaded->changed) {
+            const TableDef *def = getTableDef((TableId)t);
+            char path[512];
+            snprintf(path, sizeof(path), "%s.restore", def->dataFile);
+            int fd = ioOpen(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            staged[t] = staged[t] || fd >= 0;
+            ok = fd >= 0 && writeFully(fd, loaded->records, loaded->count * def->recordSize, 0) &&
+                 fdatasync(fd) == 0;
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+        free(loaded->records);
+        free(loaded->ids);
+        free(loaded->slots);
+    }
+    return ok;
+}
+
+/**
+ * @brief Restores a backup, optionally bringing it forward through the change archive
+ * @param name The snapshot, or a backup directory under BACKUP_DIR
+ * @param forward 1 to replay archived changes, 0 to restore the backup as it is
+ * @param untilTime Replay changes committed up to this time, 0 for no limit
+ * @param untilOrderId Replay changes up to the placing of this order, 0 for no limit
+ * @param changes Optional output for the number of changes replayed
+ * @return int 1 on success, 0 otherwise
+ *
+ * Every file is reassembled and checked next to its table file first, and
+ * archived changes are applied to those copies; the table files are only
+ * replaced once all of them are good. Backup directories made before
+ * manifests existed are copied without checks.
+ */
+static int restoreBackup(const char *name, int forward, int64_t untilTime, int untilOrderId, long *changes) {
+    if (changes != NULL) {
+        *changes = 0;
+    }
+    if (!validName(name)) {
+        return 0;
+    }
+
+    ChunkStore store;
+    Snapshot snapshot;
+    Manifest manifest;
+    char dir[512];
+    snprintf(dir, sizeof(dir), "%s%s", BACKUP_DIR, name);
+    int fromStore = loadSnapshot(name, &snapshot);
+    int checked = !fromStore && loadManifest(dir, &manifest);
+    int staged[TABLE_COUNT] = {0};
+    int stagedCount = 0;
+
+    // Only snapshots know the log position to replay from
+    int ok = (!forward || (fromStore && snapshot.lsn > 0)) && (!fromStore || chunkStoreOpen(&store, 0));
+    for (int t = 0; ok && t < TABLE_COUNT; t++) {
+        const char *fileName = tableFileName((TableId)t);
+        const SnapshotEntry *snapshotEntry = fromStore ? findSnapshotEntry(&snapshot, fileName) : NULL;
+        const ManifestEntry *manifestEntry = checked ? findManifestEntry(&manifest, fileName) : NULL;
+        char source[768];
+        char tempPath[512];
+        snprintf(source, sizeof(source), "%s/%s", dir, fileName);
+        snprintf(tempPath, sizeof(tempPath), "%s.restore", getTableDef((TableId)t)->dataFile);
+        // A table the backup does not have was empty when it was taken, so it is emptied too
+        int missing = fromStore ? snapshotEntry == NULL : checked ? manifestEntry == NULL : access(source, F_OK) != 0;
+
+        int in = fromStore || missing ? -1 : ioOpen(source, O_RDONLY);
+        int out = ioOpen(tempPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        struct stat st;
+        staged[t] = out >= 0;
+        stagedCount += !missing;
+        if (missing) {
+            ok = out >= 0;
+        } else if (fromStore) {
+            ok = out >= 0 && assembleFile(&store, snapshotEntry, out);
+        } else if (manifestEntry != NULL) {
+            ok = in >= 0 && out >= 0 && checkFile(in, manifestEntry, out);
+        } else {
+            ok = in >= 0 && out >= 0 && fstat(in, &st) == 0 && copyRange(in, 0, out, 0, (size_t)st.st_size);
+        }
+        ok = ok && fdatasync(out) == 0;
+        if (out >= 0) {
+            close(out);
+        }
+        if (in >= 0) {
+            close(in);
+        }
+    }
+
+    ok = ok && stagedCount > 0;
+    if (ok && forward) {
+        Replay replay;
+        memset(&replay, 0, sizeof(replay));
+        replay.staged = staged;
+        ok = walArchiveChanges(snapshot.lsn, untilTime, untilOrderId, replayArchivedChange, &replay, changes);
+        ok = finishArchiveReplay(&replay, staged) && ok;
+    }
+
+    for (int t = 0; t < TABLE_COUNT; t++) {
+        if (!staged[t]) {
+            continue;
+        }
+        char tempPath[512];
+        snprintf(tempPath, sizeof(tempPath), "%s.restore", getTableDef((TableId)t)->dataFile);
+        if (!ok || rename(tempPath, getTableDef((TableId)t)->dataFile) != 0) {
+            unlink(tempPath);
+            ok = 0;
+        }
+    }
+
+    if (fromStore) {
+        chunkStoreClose(&store);
+        freeSnapshot(&snapshot);
+    }
+    if (checked) {
+        freeManifest(&manifest);
+    }
+    return ok;
+}
+
+/**
+ * @brief Replaces the table files with the ones in a backup
+ * @param name The snapshot, or a backup directory under BACKUP_DIR
+ * @return int 1 on success, 0 if the backup is missing, damaged or cannot be read
+ */
+int backupRestore(const char *name) {
+    return restoreBackup(name, 0, 0, 0, NULL);
+}
+
+/**
+ * @brief Restores a snapshot and replays the changes archived after it up to a point
+ * @param name The snapshot
+ * @param untilTime Replay the changes committed up to this time, 0 for no limit
+ * @param untilOrderId Replay the changes up to and including the placing of this order, 0 for no limit
+ * @param changes Optional output for the number of changes replayed
+ * @return int 1 on success, 0 if the snapshot or the archive is missing or damaged,
+ *         or the order was not placed after the snapshot
+ *
+ * With neither limit, every change archived so far is replayed.
+ */
+int backupRestoreUntil(const char *name, int64_t untilTime, int untilOrderId, long *changes) {
+    return restoreBackup(name, 1, untilTime, untilOrderId, changes);
+}
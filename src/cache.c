@@ -0,0 +1,278 @@
+/*
+ * =====================================================================================
+ * File: cache.c
+ * Description: Keeps each table's data file memory-mapped so lookups, views and
+ *              reports read records straight from a contiguous in-memory array
+ *              instead of re-reading the file with fread. The mapping is shared
+ *              with the page cache, so in-place writes made by this or any other
+ *              process are visible immediately; the file identity and size are
+ *              checked on every access and the table is remapped when another
+ *              terminal appends to it, truncates it or replaces it. Each mapping is
+ *              reference counted: every thread holds the mapping it was last
+ *              given for a table, and a mapping replaced by a remap is only
+ *              unmapped once no thread holds it any more. Files derived from
+ *              a table that start with a header, like the hot stores, are
+ *              mapped the same way through cacheFile.
+ *
+ * Author: Chiemezie Agbo
+ * Date: 17-10-2026
+ * Version: 1.0
+ * =====================================================================================
+ */
+
+#define _DEFAULT_SOURCE
+#include "../include/cache.h"
+#include "../include/metrics.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+typedef struct {
+    void *map;
+    size_t mapSize;
+    int refs;
+} Mapping;
+
+typedef struct {
+    pthread_mutex_t mutex;
+    Mapping *current;
+    dev_t dev;
+    ino_t ino;
+    off_t size;
+    int valid;
+} CachedTable;
+
+/* Where a cached file lives and how its records are laid out */
+typedef struct {
+    const char *path;
+    size_t headerSize;
+    size_t recordSize;
+} CachedFile;
+
+/* The data file of each table, then the one derived file cacheFile maps per table */
+#define CACHE_SLOTS (2 * TABLE_COUNT)
+
+static CachedTable cachedTables[CACHE_SLOTS];
+static pthread_once_t cacheOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t heldKey;
+
+/* The mapping each thread was last given per slot; it keeps a reference on it */
+static __thread Mapping *heldMappings[CACHE_SLOTS];
+
+/**
+ * @brief Drops a reference to a mapping, unmapping it when it was the last one
+ *
+ * Must be called with the mutex of the mapping's table held.
+ */
+static void dropMapping(Mapping *mapping) {
+    if (mapping != NULL && --mapping->refs == 0) {
+        munmap(mapping->map, mapping->mapSize);
+        free(mapping);
+    }
+}
+
+/**
+ * @brief Releases the mappings held by a thread that exits
+ */
+static void releaseHeld(void *held) {
+    Mapping **mappings = held;
+    for (int t = 0; t < CACHE_SLOTS; t++) {
+        if (mappings[t] != NULL) {
+            pthread_mutex_lock(&cachedTables[t].mutex);
+            dropMapping(mappings[t]);
+            mappings[t] = NULL;
+            pthread_mutex_unlock(&cachedTables[t].mutex);
+        }
+    }
+}
+
+/**
+ * @brief Gives a forked child fresh locks, as the threads holding ours do not exist in it
+ */
+static void resetAfterFork(void) {
+    for (int t = 0; t < CACHE_SLOTS; t++) {
+        pthread_mutex_init(&cachedTables[t].mutex, NULL);
+    }
+}
+
+static void initCache(void) {
+    for (int t = 0; t < CACHE_SLOTS; t++) {
+        pthread_mutex_init(&cachedTables[t].mutex, NULL);
+    }
+    pthread_key_create(&heldKey, releaseHeld);
+    pthread_atfork(NULL, NULL, resetAfterFork);
+}
+
+/**
+ * @brief Makes a mapping the one the calling thread holds for a slot
+ *
+ * Must be called with the slot's mutex held.
+ */
+static void holdMapping(int slot, Mapping *mapping) {
+    if (heldMappings[slot] == mapping) {
+        return;
+    }
+    if (pthread_getspecific(heldKey) == NULL) {
+        pthread_setspecific(heldKey, heldMappings);
+    }
+    if (mapping != NULL) {
+        mapping->refs++;
+    }
+    dropMapping(heldMappings[slot]);
+    heldMappings[slot] = mapping;
+}
+
+/**
+ * @brief Stops handing out a slot's mapping; threads still holding it keep it
+ *
+ * Must be called with the slot's mutex held.
+ */
+static void retireMapping(CachedTable *cached) {
+    dropMapping(cached->current);
+    cached->current = NULL;
+    cached->valid = 0;
+}
+
+/**
+ * @brief Returns how much of a file holds the header and whole records
+ * @return off_t The usable size, -1 if the file is shorter than its header
+ *
+ * A trailing partial record, e.g. one still being written, is left out.
+ */
+static off_t usableSize(const CachedFile *file, off_t size) {
+    off_t records = size - (off_t)file->headerSize;
+    if (records < 0) {
+        return -1;
+    }
+    return size - records % (off_t)file->recordSize;
+}
+
+/**
+ * @brief Maps a file as it is now
+ * @return int 1 on success, 0 if the file cannot be opened or mapped
+ *
+ * Must be called with the slot's mutex held.
+ */
+static int mapFile(const CachedFile *file, CachedTable *cached) {
+    // Map from an open descriptor so the identity we remember is the file we mapped
+    struct stat st;
+    int fd = ioOpen(file->path, O_RDONLY);
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        return 0;
+    }
+
+    off_t usable = usableSize(file, st.st_size);
+    if (usable < 0) {
+        close(fd);
+        return 0;
+    }
+    if (usable > 0) {
+        Mapping *mapping = malloc(sizeof(Mapping));
+        void *map = mapping != NULL ? mmap(NULL, (size_t)usable, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+        if (map == MAP_FAILED) {
+            free(mapping);
+            close(fd);
+            return 0;
+        }
+        mapping->map = map;
+        mapping->mapSize = (size_t)usable;
+        mapping->refs = 1;
+        cached->current = mapping;
+
+        // The mapping stands in for reading the file, so it counts as the bytes read
+        IoCounters mapped = {.bytesRead = (uint64_t)usable};
+        ioCountersAdd(&mapped);
+    }
+    close(fd);
+
+    cached->dev = st.st_dev;
+    cached->ino = st.st_ino;
+    cached->size = usable;
+    cached->valid = 1;
+    return 1;
+}
+
+/**
+ * @brief Drops the mapping held for a table
+ * @param table The table to invalidate
+ *
+ * Threads still reading the old mapping keep it until their next call.
+ */
+void cacheInvalidate(TableId table) {
+    pthread_once(&cacheOnce, initCache);
+    CachedTable *cached = &cachedTables[table];
+    pthread_mutex_lock(&cached->mutex);
+    retireMapping(cached);
+    pthread_mutex_unlock(&cached->mutex);
+}
+
+/**
+ * @brief Returns the mapping of a file for a cache slot, remapping it when it changed
+ * @param count Output for the number of whole records after the header, -1 if unreadable
+ * @return const void* Start of the mapping, NULL if nothing is mapped
+ */
+static const void *mapSlot(int slot, const CachedFile *file, long *count) {
+    pthread_once(&cacheOnce, initCache);
+    CachedTable *cached = &cachedTables[slot];
+
+    struct stat st;
+    int exists = stat(file->path, &st) == 0;
+
+    pthread_mutex_lock(&cached->mutex);
+    off_t usable = exists ? usableSize(file, st.st_size) : -1;
+    if (usable < 0 || !cached->valid || cached->dev != st.st_dev || cached->ino != st.st_ino ||
+        cached->size != usable) {
+        retireMapping(cached);
+        if (usable < 0 || !mapFile(file, cached)) {
+            holdMapping(slot, NULL);
+            pthread_mutex_unlock(&cached->mutex);
+            *count = -1;
+            return NULL;
+        }
+    }
+
+    Mapping *mapping = cached->current;
+    holdMapping(slot, mapping);
+    *count = (long)((cached->size - (off_t)file->headerSize) / (off_t)file->recordSize);
+    pthread_mutex_unlock(&cached->mutex);
+    return mapping != NULL ? mapping->map : NULL;
+}
+
+/**
+ * @brief Returns a table's records as a contiguous in-memory array
+ * @param table The table to load
+ * @param count Output for the number of records, -1 if the file cannot be opened
+ * @return const void* Pointer to the first record, NULL if the table is empty or missing
+ *
+ * The returned pointer stays valid until the calling thread's next call for
+ * the same table; a remap by another thread never unmaps it under the caller.
+ */
+const void *cacheTable(TableId table, long *count) {
+    const TableDef *def = getTableDef(table);
+    CachedFile file = {def->dataFile, 0, def->recordSize};
+    return mapSlot(table, &file, count);
+}
+
+/**
+ * @brief Maps a file derived from a table, such as its hot store
+ * @param table The table the file belongs to; each table has one such file
+ * @param path The file
+ * @param headerSize Size of the header in front of the records
+ * @param recordSize Size of one record
+ * @param count Output for the number of whole records, -1 if the file is missing or shorter than its header
+ * @return const void* Pointer to the header, NULL if the file cannot be mapped
+ *
+ * The pointer stays valid like one returned by cacheTable.
+ */
+const void *cacheFile(TableId table, const char *path, size_t headerSize, size_t recordSize, long *count) {
+    CachedFile file = {path, headerSize, recordSize};
+    return mapSlot(TABLE_COUNT + table, &file, count);
+}
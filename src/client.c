@@ -0,0 +1,838 @@
+/*
+ * =====================================================================================
+ * File: client.c
+ * Description: The menus sbms shows when an sbmsd server is running. The
+ *              server owns the data files then, so this terminal never opens
+ *              them: every menu action is turned into a command of the
+ *              command mode (see command.c) and sent with serverRequest.
+ *
+ *              The menus are the local ones, admin menu included. Actions
+ *              are sent as "table COMMAND...", so the server prints their
+ *              results in the same tables and messages as the local menus
+ *              and this terminal shows that text as it comes back. Prompts
+ *              that check a record before asking for more, such as the
+ *              stock shown while an order is entered, read it as JSON.
+ *
+ * Author: Chiemezie Agbo
+ * Date: 17-10-2026
+ * Version: 1.0
+ * =====================================================================================
+ */
+
+#define _DEFAULT_SOURCE
+#include "../include/client.h"
+#include "../include/admin.h"
+#include "../include/command.h"
+#include "../include/common.h"
+#include "../include/orders.h"
+#include "../include/utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+
+#define MAX_WORDS 48
+#define NUMBER_LENGTH 24
+
+/* The words of one request and the numbers formatted into them */
+typedef struct {
+    const char *words[MAX_WORDS];
+    char numbers[MAX_WORDS][NUMBER_LENGTH];
+    int count;
+} Request;
+
+static void addWord(Request *request, const char *word) {
+    if (request->count < MAX_WORDS) {
+        request->words[request->count++] = word;
+    }
+}
+
+static void addInt(Request *request, int value) {
+    if (request->count < MAX_WORDS) {
+        snprintf(request->numbers[request->count], NUMBER_LENGTH, "%d", value);
+        addWord(request, request->numbers[request->count]);
+    }
+}
+
+static void addAmount(Request *request, double value) {
+    if (request->count < MAX_WORDS) {
+        snprintf(request->numbers[request->count], NUMBER_LENGTH, "%.2f", value);
+        addWord(request, request->numbers[request->count]);
+    }
+}
+
+/**
+ * @brief Finds the value of a field in a JSON reply
+ * @return const char* Start of the value, NULL if the reply has no such field
+ *
+ * Quotes inside string values are escaped, so a key can only match a real field.
+ */
+static const char *jsonField(const char *reply, const char *key) {
+    char pattern[32];
+    snprintf(pattern, sizeof(pattern), "\"%s\":", key);
+    const char *field = reply != NULL ? strstr(reply, pattern) : NULL;
+    return field != NULL ? field + strlen(pattern) : NULL;
+}
+
+/**
+ * @brief Prints a JSON string value without its quotes and escapes
+ * @param value Start of the value, its opening quote
+ */
+static void printJsonString(const char *value) {
+    if (*value++ != '"') {
+        return;
+    }
+    while (*value != '\0' && *value != '"') {
+        if (*value == '\\' && value[1] == 'u') {
+            unsigned code;
+            if (sscanf(value + 2, "%4x", &code) == 1) {
+                putchar((int)code);
+            }
+            value += 6;
+            continue;
+        }
+        if (*value == '\\' && value[1] != '\0') {
+            value++;
+        }
+        putchar(*value++);
+    }
+}
+
+/**
+ * @brief Sends a request to the server
+ * @param table 1 to ask for the result the way the local menus print it
+ * @param reply Output for the reply line, which the caller frees; NULL to drop it
+ * @return int 1 if the command succeeded, 0 if it failed, -1 if the connection was lost
+ */
+static int sendRequest(ServerClient *client, const Request *request, int table, char **reply) {
+    static char line[SERVER_MAX_REQUEST];
+    line[0] = '\0';
+    if (table) {
+        commandAppendWord(line, sizeof(line), "table");
+    }
+    for (int i = 0; i < request->count; i++) {
+        if (!commandAppendWord(line, sizeof(line), request->words[i])) {
+            printf("Request too long!\n");
+            return 0;
+        }
+    }
+
+    size_t length = 0;
+    char *captured = NULL;
+    FILE *out = reply != NULL ? open_memstream(&captured, &length) : NULL;
+    int result = serverRequest(client, line, out);
+    if (out != NULL) {
+        fclose(out);
+    }
+    if (reply != NULL) {
+        *reply = captured;
+    }
+    if (result < 0) {
+        printf("Lost connection to the server.\n");
+    }
+    return result;
+}
+
+/**
+ * @brief Runs a request and shows its result as the local menus would
+ * @return int 1 if the command succeeded, 0 if it failed, -1 if the connection was lost
+ */
+static int runRequest(ServerClient *client, const Request *request) {
+    char *reply = NULL;
+    int result = sendRequest(client, request, 1, &reply);
+    const char *text = jsonField(reply, "text");
+    const char *error = jsonField(reply, "error");
+    if (text != NULL) {
+        printJsonString(text);
+    } else if (error != NULL) {
+        printf("Error: ");
+        printJsonString(error);
+        printf("\n");
+    }
+    free(reply);
+    return result;
+}
+
+/**
+ * @brief Reads one record as JSON, e.g. "item get 5"
+ * @param reply Output for the reply, which the caller frees
+ * @return int 1 if it exists, 0 if not, -1 if the connection was lost
+ */
+static int fetchById(ServerClient *client, const char *noun, int id, char **reply) {
+    Request request = {.count = 0};
+    addWord(&request, noun);
+    addWord(&request, "get");
+    addInt(&request, id);
+    return sendRequest(client, &request, 0, reply);
+}
+
+/* Reads the fields of an item into a request; the strings must outlive it */
+static void readItem(Request *request, char *name, char *description, const char *fresh) {
+    char prompt[64];
+    snprintf(prompt, sizeof(prompt), "Enter %sitem name: ", fresh);
+    validateStringInput(name, MAX_NAME_LENGTH - 1, prompt);
+    snprintf(prompt, sizeof(prompt), "Enter %sitem description: ", fresh);
+    validateStringInput(description, MAX_DESCRIPTION_LENGTH - 1, prompt);
+    printf("Enter %sitem cost: ", fresh);
+    double cost = validateDoubleInput(0, 1000000);
+    printf("Enter %sitem selling price: ", fresh);
+    double price = validateDoubleInput(cost, 1000000);
+    printf("Enter %sitem quantity: ", fresh);
+    int quantity = validateIntInput(0, 1000000);
+
+    addWord(request, "--name");
+    addWord(request, name);
+    addWord(request, "--description");
+    addWord(request, description);
+    addWord(request, "--cost");
+    addAmount(request, cost);
+    addWord(request, "--price");
+    addAmount(request, price);
+    addWord(request, "--quantity");
+    addInt(request, quantity);
+}
+
+static void readCustomer(Request *request, char *name, char *email, char *phone, char *address, const char *fresh) {
+    char prompt[64];
+    snprintf(prompt, sizeof(prompt), "Enter %scustomer name: ", fresh);
+    validateStringInput(name, MAX_NAME_LENGTH - 1, prompt);
+    snprintf(prompt, sizeof(prompt), "Enter %scustomer email: ", fresh);
+    validateStringInput(email, MAX_EMAIL_LENGTH - 1, prompt);
+    snprintf(prompt, sizeof(prompt), "Enter %scustomer phone: ", fresh);
+    validateStringInput(phone, MAX_PHONE_LENGTH - 1, prompt);
+    snprintf(prompt, sizeof(prompt), "Enter %scustomer address: ", fresh);
+    validateStringInput(address, MAX_ADDRESS_LENGTH - 1, prompt);
+
+    addWord(request, "--name");
+    addWord(request, name);
+    addWord(request, "--email");
+    addWord(request, email);
+    addWord(request, "--phone");
+    addWord(request, phone);
+    addWord(request, "--address");
+    addWord(request, address);
+}
+
+/* Sends "noun verb", e.g. "item list" */
+static int requestAll(ServerClient *client, const char *noun, const char *verb) {
+    Request request = {.count = 0};
+    addWord(&request, noun);
+    addWord(&request, verb);
+    return runRequest(client, &request);
+}
+
+/* Reads an ID and sends "noun verb ID" */
+static int requestById(ServerClient *client, const char *noun, const char *verb, const char *prompt) {
+    Request request = {.count = 0};
+    printf("%s", prompt);
+    int id = validateIntInput(1, INT_MAX);
+    addWord(&request, noun);
+    addWord(&request, verb);
+    addInt(&request, id);
+    return runRequest(client, &request);
+}
+
+static int requestSearch(ServerClient *client, const char *noun) {
+    char term[MAX_NAME_LENGTH];
+    Request request = {.count = 0};
+    validateStringInput(term, MAX_NAME_LENGTH - 1, "Enter search term: ");
+    addWord(&request, noun);
+    addWord(&request, "search");
+    addWord(&request, term);
+    return runRequest(client, &request);
+}
+
+/**
+ * @brief Reads an ID and checks that the record exists before its new fields are asked for
+ * @param notFound Shown when it does not
+ * @return int The ID, 0 if there is no such record, -1 if the connection was lost
+ */
+static int readExistingId(ServerClient *client, const char *noun, const char *prompt, const char *notFound) {
+    char *reply;
+    printf("%s", prompt);
+    int id = validateIntInput(1, INT_MAX);
+    int result = fetchById(client, noun, id, &reply);
+    free(reply);
+    if (result == 0) {
+        printf("%s\n", notFound);
+    }
+    return result > 0 ? id : result;
+}
+
+/**
+ * @brief Inventory menu of a terminal connected to the server
+ * @return int 0 if the connection was lost, 1 otherwise
+ */
+static int inventoryMenuRemote(ServerClient *client) {
+    char name[MAX_NAME_LENGTH];
+    char description[MAX_DESCRIPTION_LENGTH];
+    int result = 0;
+    int choice;
+    do {
+        printf("\033[1;33m");
+        printf("╔════════════════════════════╗\n");
+        printf("║    Inventory Management    ║\n");
+        printf("╠════════════════════════════╣\n");
+        printf("║ 1. Add Item                ║\n");
+        printf("║ 2. Update Item             ║\n");
+        printf("║ 3. Delete Item             ║\n");
+        printf("║ 4. View All Items          ║\n");
+        printf("║ 5. Search Item             ║\n");
+        printf("║ 6. Back to Main Menu       ║\n");
+        printf("╚════════════════════════════╝\n");
+        printf("\033[0m");
+        printf("Enter your choice: ");
+        choice = validateIntInput(1, 6);
+
+        Request request = {.count = 0};
+        switch (choice) {
+            case 1:
+                addWord(&request, "item");
+                addWord(&request, "add");
+                readItem(&request, name, description, "");
+                result = runRequest(client, &request);
+                break;
+            case 2: {
+                int id = readExistingId(client, "item", "Enter item ID to update: ", "Item not found!");
+                result = id;
+                if (id > 0) {
+                    addWord(&request, "item");
+                    addWord(&request, "update");
+                    addInt(&request, id);
+                    readItem(&request, name, description, "new ");
+                    result = runRequest(client, &request);
+                }
+                break;
+            }
+            case 3:
+                result = requestById(client, "item", "delete", "Enter item ID to delete: ");
+                break;
+            case 4:
+                result = requestAll(client, "item", "list");
+                break;
+            case 5:
+                result = requestSearch(client, "item");
+                break;
+            default:
+                result = 0;
+        }
+    } while (choice != 6 && result >= 0);
+    return result >= 0;
+}
+
+/**
+ * @brief Reads the ID of an item to order and how many, checking the stock as the local menu does
+ * @param items The lines entered so far; the new one is items[count]
+ * @return int 1 once the line is read, 0 to ask again, -1 if the connection was lost
+ */
+static int readOrderItem(ServerClient *client, OrderItemRequest *items, int count) {
+    char *reply;
+    printf("Enter inventory item ID for item %d: ", count + 1);
+    items[count].itemId = validateIntInput(1, INT_MAX);
+    int result = fetchById(client, "item", items[count].itemId, &reply);
+    const char *quantity = jsonField(reply, "quantity");
+    int available = quantity != NULL ? atoi(quantity) : 0;
+    free(reply);
+    if (result <= 0) {
+        if (result == 0) {
+            printf("Error: Inventory item with ID %d not found. Please try again.\n", items[count].itemId);
+        }
+        return result;
+    }
+
+    // Stock already taken by earlier lines for the same item
+    for (int j = 0; j < count; j++) {
+        if (items[j].itemId == items[count].itemId) {
+            available -= items[j].quantity;
+        }
+    }
+    if (available < 1) {
+        printf("Error: Item %d is out of stock. Please choose another item.\n", items[count].itemId);
+        return 0;
+    }
+
+    printf("Enter quantity for item %d (available: %d): ", count + 1, available);
+    items[count].quantity = validateIntInput(1, available);
+    return 1;
+}
+
+/**
+ * @brief Asks for an order's customer and items and has the server place it
+ * @return int 1 if the order was placed, 0 if not, -1 if the connection was lost
+ */
+static int placeOrderRemote(ServerClient *client) {
+    OrderItemRequest items[MAX_ORDER_LINES];
+    char specs[MAX_ORDER_LINES][NUMBER_LENGTH * 2];
+    char *reply;
+    int customerId;
+    int result;
+
+    do {
+        printf("Enter customer ID: ");
+        customerId = validateIntInput(1, INT_MAX);
+        result = fetchById(client, "customer", customerId, &reply);
+        free(reply);
+        if (result == 0) {
+            printf("Error: Customer with ID %d not found. Please try again.\n", customerId);
+        }
+    } while (result == 0);
+    if (result < 0) {
+        return result;
+    }
+
+    printf("Enter the number of items in this order: ");
+    int numItems = validateIntInput(1, (MAX_WORDS - 4) / 2 < MAX_ORDER_LINES ? (MAX_WORDS - 4) / 2 : MAX_ORDER_LINES);
+    for (int i = 0; i < numItems; i++) {
+        while ((result = readOrderItem(client, items, i)) == 0) {
+        }
+        if (result < 0) {
+            return result;
+        }
+    }
+
+    // The server checks the stock again when it stores the order
+    Request request = {.count = 0};
+    addWord(&request, "order");
+    addWord(&request, "place");
+    addWord(&request, "--customer");
+    addInt(&request, customerId);
+    for (int i = 0; i < numItems; i++) {
+        snprintf(specs[i], sizeof(specs[i]), "%d:%d", items[i].itemId, items[i].quantity);
+        addWord(&request, "--item");
+        addWord(&request, specs[i]);
+    }
+    return runRequest(client, &request);
+}
+
+/**
+ * @brief Shows an order's status and has the server change it
+ * @return int 1 if the status changed, 0 if not, -1 if the connection was lost
+ */
+static int updateOrderStatusRemote(ServerClient *client) {
+    static const char *statuses[] = {"Pending", "Shipped", "Completed"};
+    char *reply;
+    printf("Enter order ID to update: ");
+    int id = validateIntInput(1, INT_MAX);
+    int result = fetchById(client, "order", id, &reply);
+    const char *status = jsonField(reply, "status");
+    if (result > 0 && status != NULL) {
+        printf("Current status: ");
+        printJsonString(status);
+        printf("\n");
+    }
+    free(reply);
+    if (result <= 0) {
+        if (result == 0) {
+            printf("Order not found!\n");
+        }
+        return result;
+    }
+
+    printf("Choose new order status:\n");
+    printf("1. Pending\n");
+    printf("2. Shipped\n");
+    printf("3. Completed\n");
+    Request request = {.count = 0};
+    addWord(&request, "order");
+    addWord(&request, "status");
+    addInt(&request, id);
+    addWord(&request, statuses[validateIntInput(1, 3) - 1]);
+    return runRequest(client, &request);
+}
+
+/**
+ * @brief Order menu of a terminal connected to the server
+ * @return int 0 if the connection was lost, 1 otherwise
+ */
+static int orderMenuRemote(ServerClient *client) {
+    int result = 0;
+    int choice;
+    do {
+        printf("\033[1;33m");
+        printf("╔════════════════════════════╗\n");
+        printf("║     Order Management       ║\n");
+        printf("╠════════════════════════════╣\n");
+        printf("║ 1. Place Order             ║\n");
+        printf("║ 2. Update Order Status     ║\n");
+        printf("║ 3. View All Orders         ║\n");
+        printf("║ 4. Search Order            ║\n");
+        printf("║ 5. Back to Main Menu       ║\n");
+        printf("╚════════════════════════════╝\n");
+        printf("\033[0m");
+        printf("Enter your choice: ");
+        choice = validateIntInput(1, 5);
+
+        switch (choice) {
+            case 1:
+                result = placeOrderRemote(client);
+                break;
+            case 2:
+                result = updateOrderStatusRemote(client);
+                break;
+            case 3:
+                result = requestAll(client, "order", "list");
+                break;
+            case 4:
+                result = requestById(client, "order", "get", "Enter order ID to search: ");
+                break;
+            default:
+                result = 0;
+        }
+    } while (choice != 5 && result >= 0);
+    return result >= 0;
+}
+
+/**
+ * @brief Customer menu of a terminal connected to the server
+ * @return int 0 if the connection was lost, 1 otherwise
+ */
+static int customerMenuRemote(ServerClient *client) {
+    char name[MAX_NAME_LENGTH];
+    char email[MAX_EMAIL_LENGTH];
+    char phone[MAX_PHONE_LENGTH];
+    char address[MAX_ADDRESS_LENGTH];
+    int result = 0;
+    int choice;
+    do {
+        printf("\033[1;33m");
+        printf("╔════════════════════════════╗\n");
+        printf("║    Customer Management     ║\n");
+        printf("╠════════════════════════════╣\n");
+        printf("║ 1. Add Customer            ║\n");
+        printf("║ 2. Update Customer         ║\n");
+        printf("║ 3. Delete Customer         ║\n");
+        printf("║ 4. View All Customers      ║\n");
+        printf("║ 5. Search Customer         ║\n");
+        printf("║ 6. Back to Main Menu       ║\n");
+        printf("╚════════════════════════════╝\n");
+        printf("\033[0m");
+        printf("Enter your choice: ");
+        choice = validateIntInput(1, 6);
+
+        Request request = {.count = 0};
+        switch (choice) {
+            case 1:
+                addWord(&request, "customer");
+                addWord(&request, "add");
+                readCustomer(&request, name, email, phone, address, "");
+                result = runRequest(client, &request);
+                break;
+            case 2: {
+                int id = readExistingId(client, "customer", "Enter customer ID to update: ", "Customer not found!");
+                result = id;
+                if (id > 0) {
+                    addWord(&request, "customer");
+                    addWord(&request, "update");
+                    addInt(&request, id);
+                    readCustomer(&request, name, email, phone, address, "new ");
+                    result = runRequest(client, &request);
+                }
+                break;
+            }
+            case 3:
+                result = requestById(client, "customer", "delete", "Enter customer ID to delete: ");
+                break;
+            case 4:
+                result = requestAll(client, "customer", "list");
+                break;
+            case 5:
+                result = requestSearch(client, "customer");
+                break;
+            default:
+                result = 0;
+        }
+    } while (choice != 6 && result >= 0);
+    return result >= 0;
+}
+
+/* Reads a date and the rest of its line, which validateDateInput leaves behind */
+static void readDate(char *date) {
+    validateDateInput(date);
+    int c;
+    while ((c = getchar()) != '\n' && c != EOF) {
+    }
+}
+
+/* Adds "--from START --to END" to a request; the dates must outlive it */
+static void addRange(Request *request, const char *startDate, const char *endDate) {
+    addWord(request, "--from");
+    addWord(request, startDate);
+    addWord(request, "--to");
+    addWord(request, endDate);
+}
+
+/**
+ * @brief Financial menu of a terminal connected to the server
+ * @return int 0 if the connection was lost, 1 otherwise
+ */
+static int financialMenuRemote(ServerClient *client) {
+    char startDate[11];
+    char endDate[11];
+    int result = 0;
+    int choice;
+    do {
+        printf("\033[1;36m");
+        printf("╔════════════════════════════╗\n");
+        printf("║   Financial Management     ║\n");
+        printf("╠════════════════════════════╣\n");
+        printf("║ 1. Generate Sales Report   ║\n");
+        printf("║ 2. Generate Profit Report  ║\n");
+        printf("║ 3. Generate Inventory Value║\n");
+        printf("║ 4. Product Sales Report    ║\n");
+        printf("║ 5. Back to Main Menu       ║\n");
+        printf("╚════════════════════════════╝\n");
+        printf("\033[0m");
+        printf("Enter your choice: ");
+        choice = validateIntInput(1, 5);
+
+        Request request = {.count = 0};
+        switch (choice) {
+            case 1:
+                readDate(startDate);
+                readDate(endDate);
+                addWord(&request, "report");
+                addWord(&request, "sales");
+                addRange(&request, startDate, endDate);
+                result = runRequest(client, &request);
+                break;
+            case 2:
+                readDate(startDate);
+                printf("Start Date: %s\n", startDate);
+                readDate(endDate);
+                printf("End Date: %s\n", endDate);
+                printf("List individual orders? (1 for Yes, 0 for No): ");
+                addWord(&request, "report");
+                addWord(&request, "profit");
+                addRange(&request, startDate, endDate);
+                if (validateIntInput(0, 1)) {
+                    addWord(&request, "--orders");
+                }
+                result = runRequest(client, &request);
+                break;
+            case 3:
+                result = requestAll(client, "report", "inventory");
+                break;
+            case 4:
+                printf("Enter inventory item ID: ");
+                addWord(&request, "report");
+                addWord(&request, "product");
+                addInt(&request, validateIntInput(1, INT_MAX));
+                readDate(startDate);
+                readDate(endDate);
+                addRange(&request, startDate, endDate);
+                result = runRequest(client, &request);
+                break;
+            default:
+                result = 0;
+        }
+    } while (choice != 5 && result >= 0);
+    return result >= 0;
+}
+
+/**
+ * @brief Asks for a backup and the point to replay its changes to, then has the server restore it
+ * @return int 1 if restored, 0 if not, -1 if the connection was lost
+ */
+static int restoreToPointRemote(ServerClient *client, char *backupName, size_t nameSize) {
+    char point[64];
+    validateStringInput(backupName, nameSize, "Enter the backup name (YYYYMMDD_HHMMSS): ");
+    printf("1. Replay changes up to a time\n");
+    printf("2. Replay changes up to an order\n");
+    printf("3. Replay all changes\n");
+    printf("Enter your choice: ");
+    int choice = validateIntInput(1, 3);
+
+    Request request = {.count = 0};
+    addWord(&request, "backup");
+    addWord(&request, "restore");
+    addWord(&request, backupName);
+    if (choice == 1) {
+        validateStringInput(point, sizeof(point), "Enter the time (YYYY-MM-DD HH:MM:SS): ");
+        if (parseDateTime(point) == (time_t)-1) {
+            printf("Invalid time format. Please use YYYY-MM-DD HH:MM:SS.\n");
+            return 0;
+        }
+        addWord(&request, "--until");
+        addWord(&request, point);
+    } else if (choice == 2) {
+        printf("Enter the order ID: ");
+        addWord(&request, "--order");
+        addInt(&request, validateIntInput(1, INT_MAX));
+    } else {
+        addWord(&request, "--replay");
+    }
+    return runRequest(client, &request);
+}
+
+/**
+ * @brief Admin menu of a terminal connected to the server; the server checks the login is an admin's
+ * @return int 0 if the connection was lost, 1 otherwise
+ */
+static int adminMenuRemote(ServerClient *client) {
+    char username[MAX_USERNAME_LENGTH];
+    char password[MAX_PASSWORD_LENGTH];
+    char backupName[256];
+    int result = 0;
+    int choice;
+    do {
+        printf("\033[1;31m");
+        printf("╔════════════════════════════╗\n");
+        printf("║     Admin Management       ║\n");
+        printf("╠════════════════════════════╣\n");
+        printf("║ 1. Add User                ║\n");
+        printf("║ 2. View Users              ║\n");
+        printf("║ 3. Change User Password    ║\n");
+        printf("║ 4. Backup Data             ║\n");
+        printf("║ 5. Restore Data            ║\n");
+        printf("║ 6. Point-in-Time Restore   ║\n");
+        printf("║ 7. Storage Statistics      ║\n");
+        printf("║ 8. Operation Metrics       ║\n");
+        printf("║ 9. Rebuild Report Data     ║\n");
+        printf("║ 10. Back to Main Menu      ║\n");
+        printf("╚════════════════════════════╝\n");
+        printf("\033[0m");
+        printf("Enter your choice: ");
+        choice = validateIntInput(1, 10);
+
+        Request request = {.count = 0};
+        switch (choice) {
+            case 1:
+                validateStringInput(username, MAX_USERNAME_LENGTH - 1, "Enter username: ");
+                validateStringInput(password, MAX_PASSWORD_LENGTH - 1, "Enter password: ");
+                printf("Is this user an admin? (1 for Yes, 0 for No): ");
+                addWord(&request, "user");
+                addWord(&request, "add");
+                addWord(&request, username);
+                addWord(&request, password);
+                if (validateIntInput(0, 1)) {
+                    addWord(&request, "--admin");
+                }
+                result = runRequest(client, &request);
+                break;
+            case 2:
+                result = requestAll(client, "user", "list");
+                break;
+            case 3:
+                validateStringInput(username, MAX_USERNAME_LENGTH - 1, "Enter username to change password: ");
+                validateStringInput(password, MAX_PASSWORD_LENGTH - 1, "Enter new password: ");
+                addWord(&request, "user");
+                addWord(&request, "password");
+                addWord(&request, username);
+                addWord(&request, password);
+                result = runRequest(client, &request);
+                break;
+            case 4:
+                result = requestAll(client, "backup", "create");
+                break;
+            case 5:
+                validateStringInput(backupName, sizeof(backupName) - 1, "Enter the backup name (YYYYMMDD_HHMMSS): ");
+                addWord(&request, "backup");
+                addWord(&request, "restore");
+                addWord(&request, backupName);
+                result = runRequest(client, &request);
+                break;
+            case 6:
+                result = restoreToPointRemote(client, backupName, sizeof(backupName) - 1);
+                break;
+            case 7:
+                result = requestAll(client, "stats", "storage");
+                break;
+            case 8:
+                result = requestAll(client, "stats", "metrics");
+                break;
+            case 9:
+                addWord(&request, "rebuild");
+                result = runRequest(client, &request);
+                break;
+            default:
+                result = 0;
+        }
+    } while (choice != 10 && result >= 0);
+    return result >= 0;
+}
+
+/**
+ * @brief Logs in through the server and runs the menus until the user logs out
+ * @param client A connection from serverConnect()
+ * @return int 1 after a logout, 0 if the connection was lost
+ */
+int clientSession(ServerClient *client) {
+    char username[MAX_USERNAME_LENGTH];
+    char password[MAX_PASSWORD_LENGTH];
+    char *reply = NULL;
+    printf("Connected to the sbmsd server.\n");
+
+    int result = 0;
+    while (result == 0) {
+        Request login = {.count = 0};
+        validateStringInput(username, MAX_USERNAME_LENGTH - 1, "Enter username: ");
+        validateStringInput(password, MAX_PASSWORD_LENGTH - 1, "Enter password: ");
+        addWord(&login, "login");
+        addWord(&login, username);
+        addWord(&login, password);
+        free(reply);
+        result = sendRequest(client, &login, 0, &reply);
+        if (result == 0) {
+            printf("Invalid username or password. Please try again.\n");
+        }
+    }
+    const char *admin = jsonField(reply, "admin");
+    int isAdmin = admin != NULL && strncmp(admin, "true", 4) == 0;
+    free(reply);
+
+    int connected = result > 0;
+    int choice = 0;
+    while (connected && choice != 7) {
+        printf("\033[1;33m");
+        printf("╔════════════════════════════╗\n");
+        printf("║   MENU (sbmsd is running)  ║\n");
+        printf("╠════════════════════════════╣\n");
+        if (isAdmin) {
+            printf("║ 1. Admin                   ║\n");
+        }
+        printf("║ 2. Inventory Management    ║\n");
+        printf("║ 3. Order Management        ║\n");
+        printf("║ 4. Customer Management     ║\n");
+        printf("║ 5. Financial Management    ║\n");
+        printf("║ 6. Change Password         ║\n");
+        printf("║ 7. Logout                  ║\n");
+        printf("╚════════════════════════════╝\n");
+        printf("\033[0m");
+        printf("Enter your choice: ");
+        choice = validateIntInput(1, 7);
+
+        switch (choice) {
+            case 1:
+                if (isAdmin) {
+                    connected = adminMenuRemote(client);
+                } else {
+                    printf("Access denied. Admin privileges required.\n");
+                }
+                break;
+            case 2:
+                connected = inventoryMenuRemote(client);
+                break;
+            case 3:
+                connected = orderMenuRemote(client);
+                break;
+            case 4:
+                connected = customerMenuRemote(client);
+                break;
+            case 5:
+                connected = financialMenuRemote(client);
+                break;
+            case 6: {
+                Request request = {.count = 0};
+                validateStringInput(password, MAX_PASSWORD_LENGTH - 1, "Enter new password: ");
+                addWord(&request, "password");
+                addWord(&request, password);
+                connected = runRequest(client, &request) >= 0;
+                break;
+            }
+            default:
+                printf("Thank you for using SBMS. Goodbye!\n");
+        }
+    }
+    return connected;
+}
@@ -0,0 +1,777 @@
+/*
+ * =====================================================================================
+ * File: columns.c
+ * Description: Keeps a columnar copy of the orders table for the financial
+ *              reports. Each order field the reports use is stored in its own
+ *              contiguous array file (e.g. data/orders.cols.date), so a report
+ *              that needs three fields reads only those bytes instead of whole
+ *              Order records.
+ *
+ *              The rows are split into segments of consecutive orders placed in
+ *              the same month. data/orders.cols holds the number of rows the
+ *              columns describe followed by a zone map for every segment (its
+ *              date range, order count and sums), which lets a date-range
+ *              report skip segments outside the range and take the totals of
+ *              segments inside it without touching their rows.
+ *
+ *              The columns are patched whenever the write-ahead log applies an
+ *              order write and are rebuilt from data/orders.dat when their row
+ *              count no longer matches it (or after compaction and restores),
+ *              reading the orders with a parallel scan (scan.c).
+ *
+ * Author: Chiemezie Agbo
+ * Date: 17-10-2026
+ * Version: 1.0
+ * =====================================================================================
+ */
+
+#define _DEFAULT_SOURCE
+#include "../include/columns.h"
+#include "../include/money.h"
+#include "../include/table.h"
+#include "../include/scan.h"
+#include "../include/metrics.h"
+#include "../include/utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define COLUMNS_MAGIC 0x534C4F43u /* "COLS" */
+#define COLUMNS_VERSION 3
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    int64_t rows;
+    int64_t segmentCount;
+} ColumnsHeader;
+
+typedef struct {
+    const char *name;
+    size_t width;
+} ColumnDef;
+
+typedef struct {
+    void *map;
+    size_t mapSize;
+    dev_t dev;
+    ino_t ino;
+} MappedColumn;
+
+static const ColumnDef columnDefs[ORDER_COLUMN_COUNT] = {
+    [ORDER_COLUMN_ID] = {"id", sizeof(int32_t)},
+    [ORDER_COLUMN_CUSTOMER] = {"customer", sizeof(int32_t)},
+    [ORDER_COLUMN_DATE] = {"date", sizeof(int64_t)},
+    [ORDER_COLUMN_AMOUNT] = {"amount", sizeof(Money)},
+    [ORDER_COLUMN_PROFIT] = {"profit", sizeof(Money)},
+    [ORDER_COLUMN_STATUS] = {"status", sizeof(uint8_t)},
+};
+
+/* Every thread maps the columns for itself, so a report is never unmapped by another thread's columnsLoad */
+static __thread MappedColumn mappedColumns[ORDER_COLUMN_COUNT];
+static __thread OrderSegment *loadedSegments = NULL;
+static pthread_once_t mappingsOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t mappingsKey;
+
+/* Files and zone maps kept open while the log applies a batch of order writes */
+static struct {
+    int active;
+    int opened;
+    int headerFd;
+    int fds[ORDER_COLUMN_COUNT];
+    int haveHeader;
+    ColumnsHeader header;
+    long segmentIndex;
+    OrderSegment segment;
+} batch = {0, 0, -1, {-1, -1, -1, -1, -1, -1}, 0, {0}, -1, {0}};
+
+static void columnFile(int column, char *path, size_t size) {
+    snprintf(path, size, "%s.%s", ORDERS_COLUMNS_FILE, columnDefs[column].name);
+}
+
+static off_t segmentOffset(long segment) {
+    return (off_t)sizeof(ColumnsHeader) + (off_t)segment * (off_t)sizeof(OrderSegment);
+}
+
+/**
+ * @brief Maps an order status string to the code stored in the status column
+ * @param status The status text, e.g. "Pending"
+ * @return uint8_t The status code
+ */
+uint8_t orderStatusCode(const char *status) {
+    if (strcmp(status, "Pending") == 0) {
+        return ORDER_STATUS_PENDING;
+    }
+    if (strcmp(status, "Shipped") == 0) {
+        return ORDER_STATUS_SHIPPED;
+    }
+    if (strcmp(status, "Completed") == 0) {
+        return ORDER_STATUS_COMPLETED;
+    }
+    return ORDER_STATUS_OTHER;
+}
+
+/**
+ * @brief Returns the month an order date falls in as year * 12 + month
+ */
+static int32_t orderMonth(int64_t orderDate) {
+    time_t date = (time_t)orderDate;
+    struct tm tm;
+    if (localtime_r(&date, &tm) == NULL) {
+        return 0;
+    }
+    return (int32_t)(tm.tm_year * 12 + tm.tm_mon);
+}
+
+/**
+ * @brief orderMonth for scan workers, through the worker's day cache
+ */
+static int32_t cachedOrderMonth(ScanDayCache *cache, int64_t orderDate) {
+    struct tm tm;
+    if (!scanLocalDate(cache, (time_t)orderDate, &tm)) {
+        return 0;
+    }
+    return (int32_t)(tm.tm_year * 12 + tm.tm_mon);
+}
+
+/**
+ * @brief Writes one order's value for a column into a buffer
+ */
+static void encodeColumn(int column, const Order *order, void *out) {
+    int32_t i32;
+    int64_t i64;
+    uint8_t code;
+    switch (column) {
+        case ORDER_COLUMN_ID:
+            i32 = order->id;
+            memcpy(out, &i32, sizeof(i32));
+            break;
+        case ORDER_COLUMN_CUSTOMER:
+            i32 = order->customerId;
+            memcpy(out, &i32, sizeof(i32));
+            break;
+        case ORDER_COLUMN_DATE:
+            i64 = (int64_t)order->orderDate;
+            memcpy(out, &i64, sizeof(i64));
+            break;
+        case ORDER_COLUMN_AMOUNT:
+            memcpy(out, &order->totalAmount, sizeof(Money));
+            break;
+        case ORDER_COLUMN_PROFIT:
+            memcpy(out, &order->profit, sizeof(Money));
+            break;
+        case ORDER_COLUMN_STATUS:
+            code = order->id > 0 ? orderStatusCode(order->status) : ORDER_STATUS_DELETED;
+            memcpy(out, &code, sizeof(code));
+            break;
+    }
+}
+
+static void segmentInit(OrderSegment *segment, int64_t firstRow, int32_t month) {
+    memset(segment, 0, sizeof(*segment));
+    segment->firstRow = firstRow;
+    segment->month = month;
+    segment->minDate = INT64_MAX;
+    segment->maxDate = INT64_MIN;
+}
+
+/**
+ * @brief Adds the next row of a segment to its zone map
+ */
+static void segmentAdd(OrderSegment *segment, int64_t orderDate, Money totalAmount, Money profit, uint8_t status) {
+    segment->rowCount++;
+    if (status == ORDER_STATUS_DELETED) {
+        return;
+    }
+    segment->liveCount++;
+    segment->totalAmount += totalAmount;
+    segment->profit += profit;
+    if (orderDate < segment->minDate) {
+        segment->minDate = orderDate;
+    }
+    if (orderDate > segment->maxDate) {
+        segment->maxDate = orderDate;
+    }
+}
+
+/**
+ * @brief Tells whether the next order starts a new segment
+ */
+static int startsSegment(const OrderSegment *last, int32_t month) {
+    return last == NULL || last->rowCount >= ORDER_SEGMENT_ROWS || last->month != month;
+}
+
+static int readHeaderFd(int fd, ColumnsHeader *header) {
+    return ioPread(fd, header, sizeof(*header), 0) == (ssize_t)sizeof(*header) &&
+           header->magic == COLUMNS_MAGIC && header->version == COLUMNS_VERSION &&
+           header->rows >= 0 && header->segmentCount >= 0;
+}
+
+/**
+ * @brief Reads the header and zone maps of the columns
+ * @return OrderSegment* The zone maps (caller frees), NULL if missing or invalid
+ */
+static OrderSegment *readSegments(ColumnsHeader *header) {
+    int fd = ioOpen(ORDERS_COLUMNS_FILE, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+    if (!readHeaderFd(fd, header)) {
+        close(fd);
+        return NULL;
+    }
+
+    size_t count = (size_t)header->segmentCount;
+    OrderSegment *segments = calloc(count + 1, sizeof(OrderSegment));
+    if (segments == NULL) {
+        close(fd);
+        return NULL;
+    }
+    ssize_t wanted = (ssize_t)(count * sizeof(OrderSegment));
+    if (ioPread(fd, segments, (size_t)wanted, segmentOffset(0)) != wanted) {
+        free(segments);
+        segments = NULL;
+    }
+    close(fd);
+    return segments;
+}
+
+/**
+ * @brief Opens the column files for the current batch on its first order write
+ * @return int 1 if the columns exist, 0 if they are missing and must be rebuilt
+ */
+static int openBatchFiles(void) {
+    if (batch.opened) {
+        return batch.headerFd >= 0;
+    }
+    batch.opened = 1;
+    for (int column = 0; column < ORDER_COLUMN_COUNT; column++) {
+        batch.fds[column] = -1;
+    }
+    batch.headerFd = ioOpen(ORDERS_COLUMNS_FILE, O_RDWR);
+    if (batch.headerFd < 0) {
+        return 0;
+    }
+    for (int column = 0; column < ORDER_COLUMN_COUNT; column++) {
+        char path[256];
+        columnFile(column, path, sizeof(path));
+        batch.fds[column] = ioOpen(path, O_RDWR | O_CREAT, 0644);
+    }
+    return 1;
+}
+
+/**
+ * @brief Reads the header of the columns, from memory after the first time in a batch
+ */
+static int loadHeader(ColumnsHeader *header) {
+    if (!batch.haveHeader) {
+        batch.haveHeader = readHeaderFd(batch.headerFd, &batch.header);
+    }
+    *header = batch.header;
+    return batch.haveHeader;
+}
+
+static int writeHeader(int64_t rows, int64_t segmentCount) {
+    ColumnsHeader header = {COLUMNS_MAGIC, COLUMNS_VERSION, rows, segmentCount};
+    batch.header = header;
+    batch.haveHeader = ioPwrite(batch.headerFd, &header, sizeof(header), 0) == (ssize_t)sizeof(header);
+    return batch.haveHeader;
+}
+
+/**
+ * @brief Reads one zone map; the last one written in the batch is kept in memory
+ */
+static int loadSegment(long index, OrderSegment *segment) {
+    if (index == batch.segmentIndex) {
+        *segment = batch.segment;
+        return 1;
+    }
+    return ioPread(batch.headerFd, segment, sizeof(*segment), segmentOffset(index)) == (ssize_t)sizeof(*segment);
+}
+
+static int writeSegment(long index, const OrderSegment *segment) {
+    if (ioPwrite(batch.headerFd, segment, sizeof(*segment), segmentOffset(index)) != (ssize_t)sizeof(*segment)) {
+        batch.segmentIndex = -1;
+        return 0;
+    }
+    batch.segmentIndex = index;
+    batch.segment = *segment;
+    return 1;
+}
+
+/**
+ * @brief Finds the segment covering a row by reading only the zone maps it needs
+ * @param count Number of segments
+ * @param slot The row
+ * @param segment Output for the segment's zone map
+ * @return long The segment's index, -1 if no segment covers the row
+ */
+static long findSegment(long count, long slot, OrderSegment *segment) {
+    // Most writes go to the newest orders, so the last segment is tried first
+    if (count == 0 || !loadSegment(count - 1, segment)) {
+        return -1;
+    }
+    if (segment->firstRow <= slot) {
+        return slot < segment->firstRow + segment->rowCount ? count - 1 : -1;
+    }
+
+    long low = 0;
+    long high = count - 2;
+    while (low <= high) {
+        long middle = low + (high - low) / 2;
+        if (!loadSegment(middle, segment)) {
+            return -1;
+        }
+        if (slot < segment->firstRow) {
+            high = middle - 1;
+        } else if (slot >= segment->firstRow + segment->rowCount) {
+            low = middle + 1;
+        } else {
+            return middle;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Reads a run of values from a column file
+ */
+static int readColumnRange(int column, int64_t firstRow, int32_t rows, void *out) {
+    size_t width = columnDefs[column].width;
+    ssize_t wanted = (ssize_t)((size_t)rows * width);
+    return batch.fds[column] >= 0 &&
+           ioPread(batch.fds[column], out, (size_t)wanted, (off_t)firstRow * (off_t)width) == wanted;
+}
+
+/**
+ * @brief Recomputes a segment's zone map from the column files
+ * @return int 1 on success, 0 otherwise
+ */
+static int recomputeSegment(OrderSegment *segment) {
+    int32_t rows = segment->rowCount;
+    int64_t *dates = malloc((size_t)rows * sizeof(int64_t) + 1);
+    Money *amounts = malloc((size_t)rows * sizeof(Money) + 1);
+    Money *profits = malloc((size_t)rows * sizeof(Money) + 1);
+    uint8_t *statuses = malloc((size_t)rows + 1);
+    uint8_t *live = malloc((size_t)rows + 1);
+
+    int ok = dates != NULL && amounts != NULL && profits != NULL && statuses != NULL && live != NULL &&
+             readColumnRange(ORDER_COLUMN_DATE, segment->firstRow, rows, dates) &&
+             readColumnRange(ORDER_COLUMN_AMOUNT, segment->firstRow, rows, amounts) &&
+             readColumnRange(ORDER_COLUMN_PROFIT, segment->firstRow, rows, profits) &&
+             readColumnRange(ORDER_COLUMN_STATUS, segment->firstRow, rows, statuses);
+    if (ok) {
+        segmentInit(segment, segment->firstRow, segment->month);
+        for (int32_t i = 0; i < rows; i++) {
+            segmentAdd(segment, dates[i], 0, 0, statuses[i]);
+            live[i] = statuses[i] != ORDER_STATUS_DELETED;
+        }
+        // The sums take the whole column slice at once
+        segment->totalAmount = moneySumSelected(amounts, live, rows);
+        segment->profit = moneySumSelected(profits, live, rows);
+    }
+
+    free(dates);
+    free(amounts);
+    free(profits);
+    free(statuses);
+    free(live);
+    return ok;
+}
+
+/**
+ * @brief Returns the number of whole records in data/orders.dat without mapping it
+ */
+static long orderRowCount(void) {
+    struct stat st;
+    if (stat(ORDERS_FILE, &st) != 0) {
+        return -1;
+    }
+    return (long)(st.st_size / (off_t)sizeof(Order));
+}
+
+/* Every column of every order, and the month each was placed in, filled by a parallel scan */
+typedef struct {
+    unsigned char *values[ORDER_COLUMN_COUNT];
+    int32_t *months;
+} DecodedOrders;
+
+static void decodeOrders(void *state, const void *records, long firstSlot, long count, void *arg) {
+    ScanDayCache *dayCache = state;
+    DecodedOrders *decoded = arg;
+    const Order *orders = records;
+    for (long i = 0; i < count; i++) {
+        long row = firstSlot + i;
+        for (int column = 0; column < ORDER_COLUMN_COUNT; column++) {
+            encodeColumn(column, &orders[i], decoded->values[column] + (size_t)row * columnDefs[column].width);
+        }
+        decoded->months[row] = cachedOrderMonth(dayCache, (int64_t)orders[i].orderDate);
+    }
+}
+
+static void freeDecoded(DecodedOrders *decoded) {
+    for (int column = 0; column < ORDER_COLUMN_COUNT; column++) {
+        free(decoded->values[column]);
+    }
+    free(decoded->months);
+}
+
+/**
+ * @brief Rebuilds every column file and the zone maps from data/orders.dat
+ * @return int 1 on success, 0 otherwise
+ *
+ * The orders are split into columns by a parallel scan, each partition
+ * filling its own rows; the files and the segments are then written in one
+ * pass over the columns, as segments depend on the rows before them.
+ */
+int columnsRebuild(void) {
+    TableScan scan;
+    if (!scanOpen(TABLE_ORDERS, &scan)) {
+        return 0;
+    }
+    long count = scan.records;
+
+    DecodedOrders decoded;
+    int ok = (decoded.months = malloc((size_t)count * sizeof(int32_t) + 1)) != NULL;
+    for (int column = 0; column < ORDER_COLUMN_COUNT; column++) {
+        decoded.values[column] = malloc((size_t)count * columnDefs[column].width + 1);
+        ok = decoded.values[column] != NULL && ok;
+    }
+    ScanDayCache dayCaches[SCAN_MAX_THREADS];
+    int partitionCount;
+    ok = ok && scanRun(&scan, decodeOrders, &decoded, dayCaches, sizeof(dayCaches[0]), &partitionCount);
+    scanClose(&scan);
+
+    for (int column = 0; column < ORDER_COLUMN_COUNT && ok; column++) {
+        char path[256], tempFile[280];
+        columnFile(column, path, sizeof(path));
+        tempFileName(tempFile, sizeof(tempFile), path);
+
+        FILE *out = ioFopen(tempFile, "wb");
+        if (out == NULL) {
+            freeDecoded(&decoded);
+            return 0;
+        }
+        ok = ioFwrite(decoded.values[column], columnDefs[column].width, (size_t)count, out) == (size_t)count;
+        ok = fclose(out) == 0 && ok;
+        ok = ok && rename(tempFile, path) == 0;
+    }
+    if (!ok) {
+        freeDecoded(&decoded);
+        return 0;
+    }
+
+    char tempFile[280];
+    tempFileName(tempFile, sizeof(tempFile), ORDERS_COLUMNS_FILE);
+    FILE *out = ioFopen(tempFile, "wb");
+    if (out == NULL) {
+        freeDecoded(&decoded);
+        return 0;
+    }
+
+    ColumnsHeader header = {COLUMNS_MAGIC, COLUMNS_VERSION, count, 0};
+    ioFwrite(&header, sizeof(header), 1, out);
+
+    const int64_t *dates = (const int64_t *)decoded.values[ORDER_COLUMN_DATE];
+    const Money *amounts = (const Money *)decoded.values[ORDER_COLUMN_AMOUNT];
+    const Money *profits = (const Money *)decoded.values[ORDER_COLUMN_PROFIT];
+    const uint8_t *statuses = decoded.values[ORDER_COLUMN_STATUS];
+    OrderSegment segment;
+    for (long i = 0; i < count; i++) {
+        if (startsSegment(header.segmentCount > 0 ? &segment : NULL, decoded.months[i])) {
+            if (header.segmentCount > 0) {
+                ok = ioFwrite(&segment, sizeof(segment), 1, out) == 1 && ok;
+            }
+            segmentInit(&segment, i, decoded.months[i]);
+            header.segmentCount++;
+        }
+        segmentAdd(&segment, dates[i], amounts[i], profits[i], statuses[i]);
+    }
+    if (header.segmentCount > 0) {
+        ok = ioFwrite(&segment, sizeof(segment), 1, out) == 1 && ok;
+    }
+    freeDecoded(&decoded);
+
+    // The header is rewritten with the final segment count before the file goes live
+    ok = fseek(out, 0, SEEK_SET) == 0 && ioFwrite(&header, sizeof(header), 1, out) == 1 && ok;
+    ok = fclose(out) == 0 && ok;
+    if (!ok || rename(tempFile, ORDERS_COLUMNS_FILE) != 0) {
+        remove(tempFile);
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief Starts a batch of order writes applied by the log
+ *
+ * The column files are opened on the batch's first order write and stay open,
+ * with the header and the last zone map written, until columnsEndBatch.
+ * Must be called with the log locked, like columnsApplyWrite.
+ */
+void columnsBeginBatch(void) {
+    batch.active = 1;
+    batch.opened = 0;
+    batch.haveHeader = 0;
+    batch.segmentIndex = -1;
+}
+
+/**
+ * @brief Ends a batch of order writes and closes the column files
+ */
+void columnsEndBatch(void) {
+    if (batch.opened) {
+        if (batch.headerFd >= 0) {
+            close(batch.headerFd);
+        }
+        for (int column = 0; column < ORDER_COLUMN_COUNT; column++) {
+            if (batch.fds[column] >= 0) {
+                close(batch.fds[column]);
+            }
+        }
+    }
+    batch.active = 0;
+    batch.opened = 0;
+    batch.headerFd = -1;
+}
+
+static int applyWrite(long slot, const Order *order) {
+    ColumnsHeader header;
+    if (!openBatchFiles() || !loadHeader(&header) || slot > header.rows) {
+        return 1;
+    }
+
+    int ok = 1;
+    for (int column = 0; column < ORDER_COLUMN_COUNT; column++) {
+        unsigned char value[sizeof(int64_t)];
+        size_t width = columnDefs[column].width;
+        encodeColumn(column, order, value);
+        ok = batch.fds[column] >= 0 &&
+             ioPwrite(batch.fds[column], value, width, (off_t)slot * (off_t)width) == (ssize_t)width && ok;
+    }
+
+    // The segment written just before a crash may not be in the header yet
+    long count = (long)header.segmentCount;
+    OrderSegment segment;
+    if (slot == header.rows && loadSegment(count, &segment) && segment.firstRow == slot && segment.rowCount > 0) {
+        count++;
+    }
+
+    long index = findSegment(count, slot, &segment);
+    if (index >= 0) {
+        ok = ok && recomputeSegment(&segment) && writeSegment(index, &segment);
+        count = index + 1 > (long)header.segmentCount ? index + 1 : (long)header.segmentCount;
+    } else if (slot < header.rows) {
+        // Rows without a segment: let the next load rebuild everything
+        writeHeader(-1, 0);
+        return ok;
+    } else {
+        int32_t month = orderMonth((int64_t)order->orderDate);
+        int haveLast = count > 0 && loadSegment(count - 1, &segment);
+        if (count > 0 && !haveLast) {
+            writeHeader(-1, 0);
+            return ok;
+        }
+        if (startsSegment(haveLast ? &segment : NULL, month)) {
+            segmentInit(&segment, slot, month);
+            count++;
+        }
+        uint8_t status;
+        encodeColumn(ORDER_COLUMN_STATUS, order, &status);
+        segmentAdd(&segment, (int64_t)order->orderDate, order->totalAmount, order->profit, status);
+        ok = ok && writeSegment(count - 1, &segment);
+    }
+
+    if (ok && (slot == header.rows || count != header.segmentCount)) {
+        ok = writeHeader(slot == header.rows ? header.rows + 1 : header.rows, count);
+    }
+    return ok;
+}
+
+/**
+ * @brief Writes an order into the columns after the log applied it to the table
+ * @param slot The slot the order was written to
+ * @param order The order as it is now stored, a tombstone included
+ * @return int 1 on success, 0 otherwise
+ *
+ * Writes past the end the columns know about are skipped; the row count then
+ * no longer matches and the next load rebuilds the columns. A write to a row
+ * some segment already covers recomputes that segment from the columns, so
+ * replaying the log after a crash leaves the zone maps correct. Only the zone
+ * maps on the way to the row's segment are read.
+ */
+int columnsApplyWrite(long slot, const Order *order) {
+    int ownBatch = !batch.active;
+    if (ownBatch) {
+        columnsBeginBatch();
+    }
+    int ok = applyWrite(slot, order);
+    if (ownBatch) {
+        columnsEndBatch();
+    }
+    return ok;
+}
+
+/**
+ * @brief Flushes the column files to disk; called by the log's checkpoint
+ */
+void columnsSync(void) {
+    for (int column = -1; column < ORDER_COLUMN_COUNT; column++) {
+        char path[256];
+        if (column < 0) {
+            snprintf(path, sizeof(path), "%s", ORDERS_COLUMNS_FILE);
+        } else {
+            columnFile(column, path, sizeof(path));
+        }
+        int fd = ioOpen(path, O_RDONLY);
+        if (fd >= 0) {
+            fsync(fd);
+            close(fd);
+        }
+    }
+}
+
+static void unmapColumn(int column) {
+    MappedColumn *mapped = &mappedColumns[column];
+    if (mapped->map != NULL) {
+        munmap(mapped->map, mapped->mapSize);
+    }
+    memset(mapped, 0, sizeof(*mapped));
+}
+
+/**
+ * @brief Unmaps the columns and frees the zone maps of a thread that exits
+ */
+static void releaseMappings(void *unused) {
+    (void)unused;
+    for (int column = 0; column < ORDER_COLUMN_COUNT; column++) {
+        unmapColumn(column);
+    }
+    free(loadedSegments);
+    loadedSegments = NULL;
+}
+
+static void initMappings(void) {
+    pthread_key_create(&mappingsKey, releaseMappings);
+}
+
+/**
+ * @brief Maps the first rows of a column file
+ * @return const void* The column array, NULL on failure
+ */
+static const void *mapColumn(int column, long rows) {
+    MappedColumn *mapped = &mappedColumns[column];
+    size_t needed = (size_t)rows * columnDefs[column].width;
+    char path[256];
+    columnFile(column, path, sizeof(path));
+
+    struct stat st;
+    if (stat(path, &st) != 0 || (size_t)st.st_size < needed) {
+        unmapColumn(column);
+        return NULL;
+    }
+    if (mapped->map != NULL && mapped->dev == st.st_dev && mapped->ino == st.st_ino && mapped->mapSize >= needed) {
+        return mapped->map;
+    }
+
+    unmapColumn(column);
+    int fd = ioOpen(path, O_RDONLY);
+    if (fd < 0 || fstat(fd, &st) != 0 || (size_t)st.st_size < needed) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        return NULL;
+    }
+
+    void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return NULL;
+    }
+
+    mapped->map = map;
+    mapped->mapSize = (size_t)st.st_size;
+    mapped->dev = st.st_dev;
+    mapped->ino = st.st_ino;
+    return map;
+}
+
+/**
+ * @brief Reads the zone maps and checks they describe the given number of rows
+ * @return int 1 if the stored columns are current, 0 otherwise
+ */
+static int loadSegments(long count, OrderColumns *columns) {
+    ColumnsHeader header;
+    OrderSegment *segments = readSegments(&header);
+    if (segments == NULL) {
+        return 0;
+    }
+
+    int64_t covered = 0;
+    for (int64_t i = 0; i < header.segmentCount; i++) {
+        covered += segments[i].rowCount;
+    }
+    if (header.rows != count || covered != count) {
+        free(segments);
+        return 0;
+    }
+
+    free(loadedSegments);
+    loadedSegments = segments;
+    columns->segments = segments;
+    columns->segmentCount = (long)header.segmentCount;
+    return 1;
+}
+
+/**
+ * @brief Loads the requested order columns as contiguous arrays
+ * @param columnMask ORDER_COLUMN_MASK() of every column needed
+ * @param columns Output for the column arrays, zone maps and row count
+ * @return int 1 on success, 0 if data/orders.dat cannot be opened
+ *
+ * The arrays stay valid until the calling thread's next call.
+ */
+int columnsLoad(unsigned columnMask, OrderColumns *columns) {
+    memset(columns, 0, sizeof(*columns));
+    pthread_once(&mappingsOnce, initMappings);
+    if (pthread_getspecific(mappingsKey) == NULL) {
+        pthread_setspecific(mappingsKey, mappedColumns);
+    }
+    long count = orderRowCount();
+    if (count < 0) {
+        return 0;
+    }
+
+    if (!loadSegments(count, columns) && (!columnsRebuild() || !loadSegments(count, columns))) {
+        return 0;
+    }
+
+    const void *arrays[ORDER_COLUMN_COUNT] = {NULL};
+    for (int column = 0; column < ORDER_COLUMN_COUNT && count > 0; column++) {
+        if (!(columnMask & ORDER_COLUMN_MASK(column))) {
+            continue;
+        }
+        arrays[column] = mapColumn(column, count);
+        if (arrays[column] == NULL) {
+            // A column file went missing underneath us
+            if (!columnsRebuild() || (arrays[column] = mapColumn(column, count)) == NULL) {
+                return 0;
+            }
+        }
+    }
+
+    columns->count = count;
+    columns->id = arrays[ORDER_COLUMN_ID];
+    columns->customerId = arrays[ORDER_COLUMN_CUSTOMER];
+    columns->orderDate = arrays[ORDER_COLUMN_DATE];
+    columns->totalAmount = arrays[ORDER_COLUMN_AMOUNT];
+    columns->profit = arrays[ORDER_COLUMN_PROFIT];
+    columns->status = arrays[ORDER_COLUMN_STATUS];
+    return 1;
+}
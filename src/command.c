@@ -0,0 +1,1413 @@
+/*
+ * =====================================================================================
+ * File: command.c
+ * Description: Headless command mode. When sbms is started with arguments it
+ *              logs in once, runs the command given on the command line (or,
+ *              with "-", one command per line read from stdin) and prints one
+ *              JSON object per command instead of showing the menus:
+ *
+ *                  sbms -u admin -p 0000 order place --customer 7 --item 3:2
+ *                  {"ok":true,"order":{"id":41,"customerId":7,...}}
+ *
+ *              Credentials can also come from SBMS_USER and SBMS_PASSWORD. A
+ *              script runs in one process, so the log, the ID indexes and the
+ *              table caches stay open across all of its commands. When an sbmsd
+ *              server is running, sbms only passes the commands on to it. A failed
+ *              command prints {"ok":false,"error":"..."} and the script goes
+ *              on; the exit status is 1 if any command failed.
+ *
+ *              "table COMMAND..." runs a command but prints its result the
+ *              way the menus show it, wrapped in {"ok":true,"text":"..."};
+ *              the menus of a terminal connected to sbmsd are built on it.
+ *              The user, backup, statistics and rebuild commands are the
+ *              admin menu's and need an admin login.
+ *
+ * Author: Chiemezie Agbo
+ * Date: 17-10-2026
+ * Version: 1.0
+ * =====================================================================================
+ */
+
+#define _DEFAULT_SOURCE
+#include "../include/command.h"
+#include "../include/common.h"
+#include "../include/admin.h"
+#include "../include/table.h"
+#include "../include/inventory.h"
+#include "../include/customers.h"
+#include "../include/orders.h"
+#include "../include/hotstore.h"
+#include "../include/financial.h"
+#include "../include/metrics.h"
+#include "../include/money.h"
+#include "../include/wal.h"
+#include "../include/server.h"
+#include "../include/utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <limits.h>
+#include <time.h>
+
+#define MAX_AMOUNT 1000000
+#define MAX_QUANTITY 1000000
+
+typedef int (*CommandHandler)(const CommandSession *session, int argc, char *argv[], FILE *out);
+
+/* Flags of a command */
+#define COMMAND_ADMIN 1     // Only admins may run it
+#define COMMAND_EXCLUSIVE 2 // Replaces files other commands read, so a server runs it alone
+
+typedef struct {
+    const char *noun;
+    const char *verb;
+    CommandHandler handler;
+    const char *usage;
+    int flags;
+} CommandDef;
+
+static const char *orderStatuses[] = {"Pending", "Shipped", "Completed"};
+
+/* The user logged in by commandMain; scripts and the command line run as them */
+static CommandSession localSession;
+
+
+static void jsonString(FILE *out, const char *text, size_t width) {
+    fputc('"', out);
+    for (size_t i = 0; i < width && text[i] != '\0'; i++) {
+        unsigned char c = (unsigned char)text[i];
+        if (c == '"' || c == '\\') {
+            fprintf(out, "\\%c", c);
+        } else if (c < 0x20) {
+            fprintf(out, "\\u%04x", c);
+        } else {
+            fputc(c, out);
+        }
+    }
+    fputc('"', out);
+}
+
+/* Prints cents as a decimal number without going through a double */
+static void jsonMoney(FILE *out, Money amount) {
+    unsigned long long magnitude = amount < 0 ? 0ULL - (unsigned long long)amount : (unsigned long long)amount;
+    fprintf(out, "%s%llu.%02llu", amount < 0 ? "-" : "", magnitude / MONEY_SCALE, magnitude % MONEY_SCALE);
+}
+
+static void jsonItem(FILE *out, const InventoryItem *item) {
+    fprintf(out, "{\"id\":%d,\"name\":", item->id);
+    jsonString(out, item->name, MAX_NAME_LENGTH);
+    fprintf(out, ",\"description\":");
+    jsonString(out, item->description, MAX_DESCRIPTION_LENGTH);
+    fprintf(out, ",\"cost\":");
+    jsonMoney(out, item->cost);
+    fprintf(out, ",\"price\":");
+    jsonMoney(out, item->price);
+    fprintf(out, ",\"quantity\":%d}", item->quantity);
+}
+
+static void jsonCustomer(FILE *out, const Customer *customer) {
+    fprintf(out, "{\"id\":%d,\"name\":", customer->id);
+    jsonString(out, customer->name, MAX_NAME_LENGTH);
+    fprintf(out, ",\"email\":");
+    jsonString(out, customer->email, MAX_EMAIL_LENGTH);
+    fprintf(out, ",\"phone\":");
+    jsonString(out, customer->phone, MAX_PHONE_LENGTH);
+    fprintf(out, ",\"address\":");
+    jsonString(out, customer->address, MAX_ADDRESS_LENGTH);
+    fprintf(out, "}");
+}
+
+static void jsonOrder(FILE *out, const Order *order) {
+    fprintf(out, "{\"id\":%d,\"customerId\":%d,\"orderDate\":%lld,\"totalAmount\":", order->id, order->customerId,
+            (long long)order->orderDate);
+    jsonMoney(out, order->totalAmount);
+    fprintf(out, ",\"status\":");
+    jsonString(out, order->status, sizeof(order->status));
+    fprintf(out, ",\"profit\":");
+    jsonMoney(out, order->profit);
+    fprintf(out, "}");
+}
+
+/**
+ * @brief Prints a failed result
+ * @return int Always 0, so handlers can return fail(...)
+ */
+static int fail(FILE *out, const char *message) {
+    fprintf(out, "{\"ok\":false,\"error\":");
+    jsonString(out, message, strlen(message));
+    fprintf(out, "}\n");
+    return 0;
+}
+
+/**
+ * @brief Prints the result of a command that only reports success
+ * @param message What the menus print, for a table result
+ * @return int Always 1
+ */
+static int succeed(const CommandSession *session, FILE *out, const char *message) {
+    if (session->table) {
+        fprintf(out, "%s\n", message);
+    } else {
+        fprintf(out, "{\"ok\":true}\n");
+    }
+    return 1;
+}
+
+/* Context of the visitors that print a JSON array, one element per call */
+typedef struct {
+    FILE *out;
+    const char *open; // Everything up to the array's first element, printed with it
+    int printed;
+} JsonList;
+
+static void jsonSeparator(JsonList *list) {
+    fprintf(list->out, "%s", list->printed++ ? "," : list->open);
+}
+
+/**
+ * @brief Ends a JSON array printed by visitors
+ * @param ok Whether the records could be read; if not, only the failure is printed
+ * @return int ok
+ */
+static int jsonListEnd(JsonList *list, int ok) {
+    if (!ok) {
+        return fail(list->out, "read failed");
+    }
+    fprintf(list->out, "%s]}\n", list->printed ? "" : list->open);
+    return 1;
+}
+
+
+/**
+ * @brief Finds the value following an option such as --name
+ * @return const char* The value, or NULL if the option is not given
+ */
+static const char *option(int argc, char *argv[], const char *name) {
+    for (int i = 0; i + 1 < argc; i++) {
+        if (strcmp(argv[i], name) == 0) {
+            return argv[i + 1];
+        }
+    }
+    return NULL;
+}
+
+/* Tells whether a flag such as --admin, which takes no value, is given */
+static int flag(int argc, char *argv[], const char *name) {
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], name) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int parseInt(const char *text, int min, int max, int *value) {
+    char *end;
+    long parsed;
+    if (text == NULL || *text == '\0') {
+        return 0;
+    }
+    parsed = strtol(text, &end, 10);
+    if (*end != '\0' || parsed < min || parsed > max) {
+        return 0;
+    }
+    *value = (int)parsed;
+    return 1;
+}
+
+static int parseMoney(const char *text, Money *value) {
+    char *end;
+    double parsed;
+    if (text == NULL || *text == '\0') {
+        return 0;
+    }
+    parsed = strtod(text, &end);
+    if (*end != '\0' || !(parsed >= 0 && parsed <= MAX_AMOUNT)) {
+        return 0;
+    }
+    *value = moneyFromDouble(parsed);
+    return 1;
+}
+
+/* Copies an option into a fixed-width field; missing options leave it alone */
+static int copyOption(int argc, char *argv[], const char *name, char *field, size_t width) {
+    const char *value = option(argc, argv, name);
+    if (value == NULL) {
+        return 1;
+    }
+    if (strlen(value) >= width) {
+        return 0;
+    }
+    strcpy(field, value);
+    return 1;
+}
+
+static int validDate(const char *text) {
+    int year, month, day;
+    char extra;
+    return text != NULL && sscanf(text, "%4d-%2d-%2d%c", &year, &month, &day, &extra) == 3 && month >= 1 &&
+           month <= 12 && day >= 1 && day <= 31;
+}
+
+static int readId(int argc, char *argv[], int *id, FILE *out) {
+    if (argc < 1 || !parseInt(argv[0], 1, INT_MAX, id)) {
+        return fail(out, "invalid ID");
+    }
+    return 1;
+}
+
+
+/* Applies the item options shared by "item add" and "item update" */
+static int readItemOptions(int argc, char *argv[], InventoryItem *item, FILE *out) {
+    const char *cost = option(argc, argv, "--cost");
+    const char *price = option(argc, argv, "--price");
+    const char *quantity = option(argc, argv, "--quantity");
+
+    if (!copyOption(argc, argv, "--name", item->name, MAX_NAME_LENGTH) ||
+        !copyOption(argc, argv, "--description", item->description, MAX_DESCRIPTION_LENGTH)) {
+        return fail(out, "text too long");
+    }
+    if ((cost != NULL && !parseMoney(cost, &item->cost)) || (price != NULL && !parseMoney(price, &item->price))) {
+        return fail(out, "invalid amount");
+    }
+    if (quantity != NULL && !parseInt(quantity, 0, MAX_QUANTITY, &item->quantity)) {
+        return fail(out, "invalid quantity");
+    }
+    if (item->price < item->cost) {
+        return fail(out, "price is below cost");
+    }
+    return 1;
+}
+
+/* Prints an item, a customer or an order as the result of a command */
+static int printItemResult(const CommandSession *session, FILE *out, const InventoryItem *item) {
+    if (session->table) {
+        printInventoryHeader(out);
+        printInventoryRow(out, item);
+    } else {
+        fprintf(out, "{\"ok\":true,\"item\":");
+        jsonItem(out, item);
+        fprintf(out, "}\n");
+    }
+    return 1;
+}
+
+static int printCustomerResult(const CommandSession *session, FILE *out, const Customer *customer) {
+    if (session->table) {
+        printCustomerHeader(out);
+        printCustomerRow(out, customer);
+    } else {
+        fprintf(out, "{\"ok\":true,\"customer\":");
+        jsonCustomer(out, customer);
+        fprintf(out, "}\n");
+    }
+    return 1;
+}
+
+static int printOrderResult(const CommandSession *session, FILE *out, const Order *order) {
+    if (session->table) {
+        printOrderHeader(out);
+        printOrderRow(out, order);
+    } else {
+        fprintf(out, "{\"ok\":true,\"order\":");
+        jsonOrder(out, order);
+        fprintf(out, "}\n");
+    }
+    return 1;
+}
+
+/* Context of the editors that apply a command's options to a stored record */
+typedef struct {
+    int argc;
+    char **argv;
+    FILE *out;
+    int refused; // Set when the options were invalid; the failure is already printed
+} OptionEdit;
+
+static int applyItemOptions(InventoryItem *item, void *context) {
+    OptionEdit *edit = context;
+    edit->refused = !readItemOptions(edit->argc, edit->argv, item, edit->out);
+    return !edit->refused;
+}
+
+/**
+ * @brief Prints the failure of an edit*() call
+ * @param result What it returned, 0 or -1
+ * @return int Always 0
+ */
+static int editFailed(const OptionEdit *edit, int result, const char *notFound) {
+    if (result < 0) {
+        return fail(edit->out, "write failed");
+    }
+    return edit->refused ? 0 : fail(edit->out, notFound);
+}
+
+static int itemAdd(const CommandSession *session, int argc, char *argv[], FILE *out) {
+    InventoryItem item;
+    memset(&item, 0, sizeof(item));
+    if (option(argc, argv, "--name") == NULL || option(argc, argv, "--cost") == NULL ||
+        option(argc, argv, "--price") == NULL || option(argc, argv, "--quantity") == NULL) {
+        return fail(out, "missing option");
+    }
+    if (!readItemOptions(argc, argv, &item, out)) {
+        return 0;
+    }
+
+    if (!createInventoryItem(&item)) {
+        return fail(out, "write failed");
+    }
+    if (session->table) {
+        fprintf(out, "Item added successfully with ID: %d!\n", item.id);
+        return 1;
+    }
+    return printItemResult(session, out, &item);
+}
+
+static int itemGet(const CommandSession *session, int argc, char *argv[], FILE *out) {
+    InventoryItem item;
+    int id;
+    if (!readId(argc, argv, &id, out)) {
+        return 0;
+    }
+    if (!getInventoryItemById(id, &item)) {
+        return fail(out, "item not found");
+    }
+    return printItemResult(session, out, &item);
+}
+
+static int itemUpdate(const CommandSession *session, int argc, char *argv[], FILE *out) {
+    InventoryItem item;
+    int id;
+    if (!readId(argc, argv, &id, out)) {
+        return 0;
+    }
+    OptionEdit edit = {argc, argv, out, 0};
+    int result = editInventoryItem(id, &item, applyItemOptions, &edit);
+    if (result <= 0) {
+        return editFailed(&edit, result, "item not found");
+    }
+    if (session->table) {
+        return succeed(session, out, "Item updated successfully!");
+    }
+    return printItemResult(session, out, &item);
+}
+
+/* Prints the result of deleting a record through removeInventoryItem or removeCustomer */
+static int deleted(const CommandSession *session, const char *noun, int id, int removed, FILE *out) {
+    if (!removed) {
+        return fail(out, "not found");
+    }
+    if (session->table) {
+        fprintf(out, "%s deleted successfully!\n", noun);
+    } else {
+        fprintf(out, "{\"ok\":true,\"id\":%d}\n", id);
+    }
+    return 1;
+}
+
+static int itemDelete(const CommandSession *session, int argc, char *argv[], FILE *out) {
+    int id;
+    if (!readId(argc, argv, &id, out)) {
+        return 0;
+    }
+    return deleted(session, "Item", id, removeInventoryItem(id), out);
+}
+
+static void printItemVisitor(const InventoryItem *item, void *context) {
+    printInventoryRow(context, item);
+}
+
+static void jsonItemVisitor(const InventoryItem *item, void *context) {
+    jsonSeparator(context);
+    jsonItem(((JsonList *)context)->out, item);
+}
+
+static int itemList(const CommandSession *session, int argc, char *argv[], FILE *out) {
+    (void)argc;
+    (void)argv;
+    if (session->table) {
+        printInventoryHeader(out);
+        return listInventoryItems(printItemVisitor, out) || fail(out, "read failed");
+    }
+    JsonList list = {out, "{\"ok\":true,\"items\":[", 0};
+    return jsonListEnd(&list, listInventoryItems(jsonItemVisitor, &list));
+}
+
+static int itemSearch(const CommandSession *session, int argc, char *argv[], FILE *out) {
+    long found;
+    if (argc < 1) {
+        return fail(out, "missing search term");
+    }
+    if (session->table) {
+        printInventoryHeader(out);
+        if (!findInventoryItems(argv[0], printItemVisitor, out, &found)) {
+            return fail(out, "search failed");
+        }
+        if (found == 0) {
+            fprintf(out, "No items found matching the search term.\n");
+        }
+        return 1;
+    }
+    JsonList list = {out, "{\"ok\":true,\"items\":[", 0};
+    return jsonListEnd(&list, findInventoryItems(argv[0], jsonItemVisitor, &list, &found));
+}
+
+static int readCustomerOptions(int argc, char *argv[], Customer *customer, FILE *out) {
+    if (!copyOption(argc, argv, "--name", customer->name, MAX_NAME_LENGTH) ||
+        !copyOption(argc, argv, "--email", customer->email, MAX_EMAIL_LENGTH) ||
+        !copyOption(argc, argv, "--phone", customer->phone, MAX_PHONE_LENGTH) ||
+        !copyOption(argc, argv, "--address", customer->address, MAX_ADDRESS_LENGTH)) {
+        return fail(out, "text too long");
+    }
+    return 1;
+}
+
+static int applyCustomerOptions(Customer *customer, void *context) {
+    OptionEdit *edit = context;
+    edit->refused = !readCustomerOptions(edit->argc, edit->argv, customer, edit->out);
+    return !edit->refused;
+}
+
+static int customerAdd(const CommandSession *session, int argc, char *argv[], FILE *out) {
+    Customer customer;
+    memset(&customer, 0, sizeof(customer));
+    if (option(argc, argv, "--name") == NULL) {
+        return fail(out, "missing option");
+    }
+    if (!readCustomerOptions(argc, argv, &customer, out)) {
+        return 0;
+    }
+
+    if (!createCustomer(&customer)) {
+        return fail(out, "write failed");
+    }
+    if (session->table) {
+        fprintf(out, "Customer added successfully with ID: %d!\n", customer.id);
+        return 1;
+    }
+    return printCustomerResult(session, out, &customer);
+}
+
+static int customerGet(const CommandSession *session, int argc, char *argv[], FILE *out) {
+    Customer customer;
+    int id;
+    if (!readId(argc, argv, &id, out)) {
+        return 0;
+    }
+    if (!getCustomerById(id, &customer)) {
+        return fail(out, "customer not found");
+    }
+    return printCustomerResult(session, out, &customer);
+}
+
+static int customerUpdate(const CommandSession *session, int argc, char *argv[], FILE *out) {
+    Customer customer;
+    int id;
+    if (!readId(argc, argv, &id, out)) {
+        return 0;
+    }
+    OptionEdit edit = {argc, argv, out, 0};
+    int result = editCustomer(id, &customer, applyCustomerOptions, &edit);
+    if (result <= 0) {
+        return editFailed(&edit, result, "customer not found");
+    }
+    if (session->table) {
+        return succeed(session, out, "Customer updated successfully!");
+    }
+    return printCustomerResult(session, out, &customer);
+}
+
+static int customerDelete(const CommandSession *session, int argc, char *argv[], FILE *out) {
+    int id;
+    if (!readId(argc, argv, &id, out)) {
+        return 0;
+    }
+    return deleted(session, "Customer", id, removeCustomer(id), out);
+}
+
+static void printCustomerVisitor(const Customer *customer, void *context) {
+    printCustomerRow(context, customer);
+}
+
+static void jsonCustomerVisitor(const Customer *customer, void *context) {
+    jsonSeparator(context);
+    jsonCustomer(((JsonList *)context)->out, customer);
+}
+
+static int customerList(const CommandSession *session, int argc, char *argv[], FILE *out) {
+    (void)argc;
+    (void)argv;
+    if (session->table) {
+        printCustomerHeader(out);
+        return listCustomers(printCustomerVisitor, out) || fail(out, "read failed");
+    }
+    JsonList list = {out, "{\"ok\":true,\"customers\":[", 0};
+    return jsonListEnd(&list, listCustomers(jsonCustomerVisitor, &list));
+}
+
+static int customerSearch(const CommandSession *session, int argc, char *argv[], FILE *out) {
+    long found;
+    if (argc < 1) {
+        return fail(out, "missing search term");
+    }
+    if (session->table) {
+        printCustomerHeader(out);
+        if (!findCustomers(argv[0], printCustomerVisitor, out, &found)) {
+            return fail(out, "search failed");
+        }
+        if (found == 0) {
+            fprintf(out, "No customers found matching the search term.\n");
+        }
+        return 1;
+    }
+    JsonList list = {out, "{\"ok\":true,\"customers\":[", 0};
+    return jsonListEnd(&list, findCustomers(argv[0], jsonCustomerVisitor, &list, &found));
+}
+
+static int orderPlace(const CommandSession *session, int argc, char *argv[], FILE *out) {
+    OrderItemRequest items[MAX_ORDER_LINES];
+    int itemCount = 0;
+    Order order;
+    memset(&order, 0, sizeof(order));
+
+    if (!parseInt(option(argc, argv, "--customer"), 1, INT_MAX, &order.customerId)) {
+        return fail(out, "invalid customer ID");
+    }
+
+    // Each --item is ID:QUANTITY, or just ID for one unit
+    for (int i = 0; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--item") != 0) {
+            continue;
+        }
+        if (itemCount == MAX_ORDER_LINES) {
+            return fail(out, "too many items");
+        }
+        char spec[32];
+        if (strlen(argv[i + 1]) >= sizeof(spec)) {
+            return fail(out, "invalid item");
+        }
+        strcpy(spec, argv[i + 1]);
+        char *colon = strchr(spec, ':');
+        items[itemCount].quantity = 1;
+        if (colon != NULL) {
+            *colon = '\0';
+            if (!parseInt(colon + 1, 1, MAX_QUANTITY, &items[itemCount].quantity)) {
+                return fail(out, "invalid quantity");
+            }
+        }
+        if (!parseInt(spec, 1, INT_MAX, &items[itemCount].itemId)) {
+            return fail(out, "invalid item");
+        }
+        itemCount++;
+    }
+    if (itemCount == 0) {
+        return fail(out, "no items");
+    }
+
+    int failedItem;
+    switch (submitOrder(&order, items, itemCount, &failedItem)) {
+        case ORDER_PLACED:
+            break;
+        case ORDER_UNKNOWN_CUSTOMER:
+            return fail(out, "customer not found");
+        case ORDER_UNKNOWN_ITEM:
+            fprintf(out, "{\"ok\":false,\"error\":\"item not found\",\"itemId\":%d}\n", items[failedItem].itemId);
+            return 0;
+        case ORDER_OUT_OF_STOCK:
+            fprintf(out, "{\"ok\":false,\"error\":\"out of stock\",\"itemId\":%d}\n", items[failedItem].itemId);
+            return 0;
+        case ORDER_INVALID:
+            return fail(out, "invalid order");
+        default:
+            return fail(out, "write failed");
+    }
+
+    if (session->table) {
+        CustomerHot customer;
+        if (!hotGetById(TABLE_CUSTOMERS, order.customerId, &customer)) {
+            customer.namePrefix[0] = '\0';
+        }
+        fprintf(out, "Order placed successfully for customer %s (ID: %d)!\n", customer.namePrefix, order.customerId);
+        fprintf(out, "Order ID: %d\n", order.id);
+        fprintf(out, "Total amount: $%.2f\n", moneyToDouble(order.totalAmount));
+        return 1;
+    }
+    return printOrderResult(session, out, &order);
+}
+
+static int orderGet(const CommandSession *session, int argc, char *argv[], FILE *out) {
+    Order order;
+    int id;
+    if (!readId(argc, argv, &id, out)) {
+        return 0;
+    }
+    if (session->table) {
+        return writeOrder(out, id) || fail(out, "order not found");
+    }
+    if (!getOrderById(id, &order)) {
+        return fail(out, "order not found");
+    }
+    return printOrderResult(session, out, &order);
+}
+
+static int orderStatus(const CommandSession *session, int argc, char *argv[], FILE *out) {
+    Order order;
+    int id;
+    if (argc < 2 || !parseInt(argv[0], 1, INT_MAX, &id)) {
+        return fail(out, "usage: order status ID STATUS");
+    }
+
+    const char *status = NULL;
+    for (size_t i = 0; i < sizeof(orderStatuses) / sizeof(orderStatuses[0]); i++) {
+        if (strcasecmp(argv[1], orderStatuses[i]) == 0) {
+            status = orderStatuses[i];
+        }
+    }
+    if (status == NULL) {
+        return fail(out, "invalid status");
+    }
+    int result = setOrderStatus(id, status, &order);
+    if (result <= 0) {
+        return fail(out, result < 0 ? "write failed" : "order not found");
+    }
+    if (session->table) {
+        return succeed(session, out, "Order status updated successfully!");
+    }
+    return printOrderResult(session, out, &order);
+}
+
+static void printOrderVisitor(const Order *order, void *context) {
+    printOrderRow(context, order);
+}
+
+static void jsonOrderVisitor(const Order *order, void *context) {
+    jsonSeparator(context);
+    jsonOrder(((JsonList *)context)->out, order);
+}
+
+static int orderList(const CommandSession *session, int argc, char *argv[], FILE *out) {
+    (void)argc;
+    (void)argv;
+    if (session->table) {
+        printOrderHeader(out);
+        return listOrders(printOrderVisitor, out) || fail(out, "read failed");
+    }
+    JsonList list = {out, "{\"ok\":true,\"orders\":[", 0};
+    return jsonListEnd(&list, listOrders(jsonOrderVisitor, &list));
+}
+
+static int readRange(int argc, char *argv[], const char **from, const char **to, FILE *out) {
+    *from = option(argc, argv, "--from");
+    *to = option(argc, argv, "--to");
+    if (!validDate(*from) || !validDate(*to)) {
+        return fail(out, "dates must be YYYY-MM-DD");
+    }
+    return 1;
+}
+
+static int reportSales(const CommandSession *session, int argc, char *argv[], FILE *out) {
+    const char *from, *to;
+    SalesReport report;
+    if (!readRange(argc, argv, &from, &to, out)) {
+        return 0;
+    }
+    if (session->table) {
+        return writeSalesReport(out, from, to, &report);
+    }
+    if (!computeSalesReport(from, to, &report)) {
+        return fail(out, "read failed");
+    }
+    fprintf(out, "{\"ok\":true,\"orders\":%d,\"revenue\":", report.orderCount);
+    jsonMoney(out, report.totalSales);
+    fprintf(out, ",\"average\":%.2f,\"pending\":%lld,\"shipped\":%lld,\"completed\":%lld}\n",
+            report.averageOrderValue, report.pendingCount, report.shippedCount, report.completedCount);
+    return 1;
+}
+
+/* Prints each order of a profit report as an element of a JSON array */
+static void jsonProfitRow(const ProfitReportLine *line, void *context) {
+    JsonList *list = context;
+    jsonSeparator(list);
+    fprintf(list->out, "{\"id\":%d,\"orderDate\":%lld,\"revenue\":", line->orderId, (long long)line->orderDate);
+    jsonMoney(list->out, line->revenue);
+    fprintf(list->out, ",\"cost\":");
+    jsonMoney(list->out, line->cost);
+    fprintf(list->out, ",\"profit\":");
+    jsonMoney(list->out, line->profit);
+    fprintf(list->out, "}");
+}
+
+static int reportProfit(const CommandSession *session, int argc, char *argv[], FILE *out) {
+    const char *from, *to;
+    ProfitReport report;
+    int listOrders = flag(argc, argv, "--orders");
+    if (!readRange(argc, argv, &from, &to, out)) {
+        return 0;
+    }
+    if (session->table) {
+        return listOrders ? writeProfitReport(out, from, to, &report) : writeProfitSummary(out, from, to, &report);
+    }
+
+    // The listed orders are collected first, so a failed scan prints nothing but the error
+    char *rows = NULL;
+    size_t rowsLength = 0;
+    JsonList list = {NULL, "", 0};
+    int ok;
+    if (listOrders) {
+        list.out = open_memstream(&rows, &rowsLength);
+        if (list.out == NULL) {
+            return fail(out, "out of memory");
+        }
+        ok = computeProfitReport(from, to, &report, jsonProfitRow, &list);
+        fclose(list.out);
+    } else {
+        ok = computeProfitSummary(from, to, &report);
+    }
+    if (!ok) {
+        free(rows);
+        return fail(out, "read failed");
+    }
+
+    fprintf(out, "{\"ok\":true,");
+    if (listOrders) {
+        fprintf(out, "\"rows\":[%s],", rows);
+        free(rows);
+    }
+    fprintf(out, "\"orders\":%lld,\"revenue\":", report.orderCount);
+    jsonMoney(out, report.totalRevenue);
+    fprintf(out, ",\"cost\":");
+    jsonMoney(out, report.totalCost);
+    fprintf(out, ",\"profit\":");
+    jsonMoney(out, report.totalProfit);
+    fprintf(out, ",\"margin\":%.2f}\n", report.profitMargin);
+    return 1;
+}
+
+static int reportInventory(const CommandSession *session, int argc, char *argv[], FILE *out) {
+    (void)argc;
+    (void)argv;
+    InventoryValueReport report;
+    if (session->table) {
+        return writeInventoryValue(out, &report);
+    }
+    if (!computeInventoryValue(&report, NULL, NULL)) {
+        return fail(out, "read failed");
+    }
+    fprintf(out, "{\"ok\":true,\"units\":%lld,\"cost\":", report.totalItems);
+    jsonMoney(out, report.totalCost);
+    fprintf(out, ",\"value\":");
+    jsonMoney(out, report.totalValue);
+    fprintf(out, ",\"profit\":");
+    jsonMoney(out, report.potentialProfit);
+    fprintf(out, ",\"margin\":%.2f}\n", report.profitMargin);
+    return 1;
+}
+
+static int reportProduct(const CommandSession *session, int argc, char *argv[], FILE *out) {
+    const char *from, *to;
+    InventoryItem item;
+    ProductReport report;
+    int id;
+    if (!readId(argc, argv, &id, out) || !readRange(argc, argv, &from, &to, out)) {
+        return 0;
+    }
+    if (!getInventoryItemById(id, &item)) {
+        return fail(out, "item not found");
+    }
+    if (session->table) {
+        return writeProductReport(out, id, from, to, &report);
+    }
+    if (!computeProductReport(&item, from, to, &report)) {
+        return fail(out, "read failed");
+    }
+    fprintf(out, "{\"ok\":true,\"itemId\":%d,\"lines\":%d,\"unitsSold\":%d,\"revenue\":", item.id, report.lineCount,
+            report.unitsSold);
+    jsonMoney(out, report.revenue);
+    fprintf(out, ",\"cost\":");
+    jsonMoney(out, report.cost);
+    fprintf(out, ",\"profit\":");
+    jsonMoney(out, report.profit);
+    fprintf(out, ",\"unitsInStock\":%d,\"sellThrough\":%.2f,\"turnover\":%.2f}\n", report.unitsInStock,
+            report.sellThrough, report.turnover);
+    return 1;
+}
+
+static int userAdd(const CommandSession *session, int argc, char *argv[], FILE *out) {
+    User user;
+    memset(&user, 0, sizeof(user));
+    if (argc < 2 || strlen(argv[0]) >= MAX_USERNAME_LENGTH || strlen(argv[1]) >= MAX_PASSWORD_LENGTH) {
+        return fail(out, "usage: user add NAME PASSWORD [--admin]");
+    }
+    strcpy(user.username, argv[0]);
+    strcpy(user.password, argv[1]);
+    user.is_admin = flag(argc - 2, argv + 2, "--admin");
+    if (!createUser(&user)) {
+        return fail(out, "write failed");
+    }
+    return succeed(session, out, "User added successfully!");
+}
+
+static void jsonUserVisitor(const User *user, void *context) {
+    JsonList *list = context;
+    jsonSeparator(list);
+    fprintf(list->out, "{\"username\":");
+    jsonString(list->out, user->username, MAX_USERNAME_LENGTH);
+    fprintf(list->out, ",\"admin\":%s}", user->is_admin ? "true" : "false");
+}
+
+static int userList(const CommandSession *session, int argc, char *argv[], FILE *out) {
+    (void)argc;
+    (void)argv;
+    if (session->table) {
+        return printUsers(out);
+    }
+    JsonList list = {out, "{\"ok\":true,\"users\":[", 0};
+    return jsonListEnd(&list, listUsers(jsonUserVisitor, &list));
+}
+
+static int changeUserPassword(const CommandSession *session, const char *username, const char *password,
+                              FILE *out) {
+    if (strlen(password) >= MAX_PASSWORD_LENGTH) {
+        return fail(out, "password too long");
+    }
+    if (!setUserPassword(username, password)) {
+        return fail(out, "user not found");
+    }
+    return succeed(session, out, "Password changed successfully!");
+}
+
+static int userPassword(const CommandSession *session, int argc, char *argv[], FILE *out) {
+    if (argc < 2) {
+        return fail(out, "usage: user password NAME PASSWORD");
+    }
+    return changeUserPassword(session, argv[0], argv[1], out);
+}
+
+/* Changes the password of the user who runs the command */
+static int password(const CommandSession *session, int argc, char *argv[], FILE *out) {
+    if (argc < 1) {
+        return fail(out, "usage: password NEW_PASSWORD");
+    }
+    if (session->username[0] == '\0') {
+        return fail(out, "login required");
+    }
+    return changeUserPassword(session, session->username, argv[0], out);
+}
+
+static int backupCreateCommand(const CommandSession *session, int argc, char *argv[], FILE *out) {
+    (void)argc;
+    (void)argv;
+    if (session->table) {
+        return writeBackup(out);
+    }
+    char name[20];
+    BackupStats stats;
+    if (!createBackup(name, sizeof(name), &stats)) {
+        return fail(out, "backup failed");
+    }
+    fprintf(out, "{\"ok\":true,\"backup\":\"%s\",\"files\":%d,\"bytes\":%lld,\"newBytes\":%lld,\"storedBytes\":%lld,"
+            "\"changes\":%ld}\n", name, stats.files, stats.totalBytes, stats.newBytes, stats.storedBytes,
+            stats.changes);
+    return 1;
+}
+
+/* Restores a backup; --until, --order or --replay also replay the archived changes made after it */
+static int backupRestoreCommand(const CommandSession *session, int argc, char *argv[], FILE *out) {
+    if (argc < 1) {
+        return fail(out, "usage: backup restore NAME [--until TIME | --order ID | --replay]");
+    }
+    const char *name = argv[0];
+    const char *until = option(argc, argv, "--until");
+    const char *order = option(argc, argv, "--order");
+    time_t untilTime = 0;
+    int untilOrderId = 0;
+    if (until != NULL && (untilTime = parseDateTime(until)) == (time_t)-1) {
+        return fail(out, "time must be YYYY-MM-DD HH:MM:SS");
+    }
+    if (order != NULL && !parseInt(order, 1, INT_MAX, &untilOrderId)) {
+        return fail(out, "invalid order ID");
+    }
+
+    if (until == NULL && order == NULL && !flag(argc, argv, "--replay")) {
+        if (!restoreFromBackup(name)) {
+            return fail(out, "backup is missing or damaged, nothing was restored");
+        }
+        if (session->table) {
+            fprintf(out, "Data restored successfully from %s\n", name);
+            return 1;
+        }
+        fprintf(out, "{\"ok\":true,\"backup\":");
+        jsonString(out, name, strlen(name));
+        fprintf(out, ",\"changes\":0}\n");
+        return 1;
+    }
+
+    long changes;
+    struct timespec start;
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (!restoreFromBackupUntil(name, untilTime, untilOrderId, &changes)) {
+        return fail(out, "backup, change archive or point is missing or damaged, nothing was restored");
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    if (session->table) {
+        double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+        fprintf(out, "Data restored from %s and %ld changes replayed in %.2f seconds\n", name, changes, seconds);
+        return 1;
+    }
+    fprintf(out, "{\"ok\":true,\"backup\":");
+    jsonString(out, name, strlen(name));
+    fprintf(out, ",\"changes\":%ld}\n", changes);
+    return 1;
+}
+
+static int statsStorage(const CommandSession *session, int argc, char *argv[], FILE *out) {
+    (void)argc;
+    (void)argv;
+    if (session->table) {
+        printStorageStats(out);
+        return 1;
+    }
+    fprintf(out, "{\"ok\":true,\"tables\":[");
+    for (int t = 0; t < TABLE_COUNT; t++) {
+        TableStats stats;
+        tableGetStats((TableId)t, &stats);
+        fprintf(out, "%s{\"name\":\"%s\",\"records\":%ld,\"deleted\":%ld,\"deadRatio\":%.4f,\"compactAt\":%.4f,"
+                "\"bytes\":%lld}", t > 0 ? "," : "", getTableDef((TableId)t)->name, stats.totalRecords,
+                stats.deadRecords, stats.deadRatio, stats.compactionThreshold, stats.dataBytes);
+    }
+    fprintf(out, "]}\n");
+    return 1;
+}
+
+static int statsMetrics(const CommandSession *session, int argc, char *argv[], FILE *out) {
+    (void)argc;
+    (void)argv;
+    if (session->table) {
+        return printOperationMetrics(out);
+    }
+    char *text = NULL;
+    size_t length = 0;
+    FILE *metrics = open_memstream(&text, &length);
+    if (metrics == NULL) {
+        return fail(out, "out of memory");
+    }
+    metricsWrite(metrics);
+    fclose(metrics);
+    fprintf(out, "{\"ok\":true,\"metrics\":");
+    jsonString(out, text, length);
+    fprintf(out, "}\n");
+    free(text);
+    return 1;
+}
+
+static int rebuild(const CommandSession *session, int argc, char *argv[], FILE *out) {
+    (void)argc;
+    (void)argv;
+    if (!rebuildReports()) {
+        return fail(out, "rebuild failed");
+    }
+    if (session->table) {
+        fprintf(out, "Report data rebuilt from %s, %s, %s and %s\n", ORDERS_FILE, ORDER_LINES_FILE, INVENTORY_FILE,
+                CUSTOMERS_FILE);
+        return 1;
+    }
+    return succeed(session, out, NULL);
+}
+
+static int checkpoint(const CommandSession *session, int argc, char *argv[], FILE *out) {
+    (void)argc;
+    (void)argv;
+    if (!walCheckpoint()) {
+        return fail(out, "checkpoint failed");
+    }
+    return succeed(session, out, "Checkpoint done");
+}
+
+static int table(const CommandSession *session, int argc, char *argv[], FILE *out);
+static int help(const CommandSession *session, int argc, char *argv[], FILE *out);
+
+static const CommandDef commands[] = {
+    {"item", "add", itemAdd, "item add --name N [--description D] --cost C --price P --quantity Q", 0},
+    {"item", "get", itemGet, "item get ID", 0},
+    {"item", "update", itemUpdate, "item update ID [--name N] [--description D] [--cost C] [--price P] [--quantity Q]", 0},
+    {"item", "delete", itemDelete, "item delete ID", 0},
+    {"item", "list", itemList, "item list", 0},
+    {"item", "search", itemSearch, "item search TERM", 0},
+    {"customer", "add", customerAdd, "customer add --name N [--email E] [--phone P] [--address A]", 0},
+    {"customer", "get", customerGet, "customer get ID", 0},
+    {"customer", "update", customerUpdate, "customer update ID [--name N] [--email E] [--phone P] [--address A]", 0},
+    {"customer", "delete", customerDelete, "customer delete ID", 0},
+    {"customer", "list", customerList, "customer list", 0},
+    {"customer", "search", customerSearch, "customer search TERM", 0},
+    {"order", "place", orderPlace, "order place --customer ID --item ID[:QUANTITY] [--item ...]", 0},
+    {"order", "get", orderGet, "order get ID", 0},
+    {"order", "status", orderStatus, "order status ID Pending|Shipped|Completed", 0},
+    {"order", "list", orderList, "order list", 0},
+    {"report", "sales", reportSales, "report sales --from YYYY-MM-DD --to YYYY-MM-DD", 0},
+    {"report", "profit", reportProfit, "report profit --from YYYY-MM-DD --to YYYY-MM-DD [--orders]", 0},
+    {"report", "inventory", reportInventory, "report inventory", 0},
+    {"report", "product", reportProduct, "report product ID --from YYYY-MM-DD --to YYYY-MM-DD", 0},
+    {"password", NULL, password, "password NEW_PASSWORD", 0},
+    {"user", "add", userAdd, "user add NAME PASSWORD [--admin]", COMMAND_ADMIN},
+    {"user", "list", userList, "user list", COMMAND_ADMIN},
+    {"user", "password", userPassword, "user password NAME PASSWORD", COMMAND_ADMIN},
+    {"backup", "create", backupCreateCommand, "backup create", COMMAND_ADMIN},
+    {"backup", "restore", backupRestoreCommand,
+     "backup restore NAME [--until \"YYYY-MM-DD HH:MM:SS\" | --order ID | --replay]", COMMAND_ADMIN | COMMAND_EXCLUSIVE},
+    {"stats", "storage", statsStorage, "stats storage", COMMAND_ADMIN},
+    {"stats", "metrics", statsMetrics, "stats metrics", COMMAND_ADMIN},
+    {"rebuild", NULL, rebuild, "rebuild", COMMAND_ADMIN | COMMAND_EXCLUSIVE},
+    {"checkpoint", NULL, checkpoint, "checkpoint", COMMAND_EXCLUSIVE},
+    {"table", NULL, table, "table COMMAND... (the result as the menus show it)", 0},
+    {"help", NULL, help, "help", 0},
+};
+
+static int help(const CommandSession *session, int argc, char *argv[], FILE *out) {
+    (void)argc;
+    (void)argv;
+    if (session->table) {
+        for (size_t i = 0; i < sizeof(commands) / sizeof(commands[0]); i++) {
+            fprintf(out, "%s\n", commands[i].usage);
+        }
+        return 1;
+    }
+    fprintf(out, "{\"ok\":true,\"commands\":[");
+    for (size_t i = 0; i < sizeof(commands) / sizeof(commands[0]); i++) {
+        fprintf(out, i > 0 ? "," : "");
+        jsonString(out, commands[i].usage, strlen(commands[i].usage));
+    }
+    fprintf(out, "]}\n");
+    return 1;
+}
+
+/**
+ * @brief Finds the command a list of words names
+ * @param words Output for the number of words naming it, 1 or 2
+ * @return const CommandDef* The command, NULL if there is none
+ */
+static const CommandDef *findCommand(int argc, char *argv[], int *words) {
+    for (size_t i = 0; i < sizeof(commands) / sizeof(commands[0]) && argc > 0; i++) {
+        const CommandDef *def = &commands[i];
+        if (strcmp(argv[0], def->noun) != 0) {
+            continue;
+        }
+        if (def->verb == NULL) {
+            *words = 1;
+            return def;
+        }
+        if (argc > 1 && strcmp(argv[1], def->verb) == 0) {
+            *words = 2;
+            return def;
+        }
+    }
+    return NULL;
+}
+
+/* Runs a command in table form and sends the text back as one line of JSON */
+static int table(const CommandSession *session, int argc, char *argv[], FILE *out) {
+    CommandSession tableSession = *session;
+    tableSession.table = 1;
+
+    char *text = NULL;
+    size_t length = 0;
+    FILE *capture = open_memstream(&text, &length);
+    if (capture == NULL) {
+        return fail(out, "out of memory");
+    }
+    int ok = commandRunAs(&tableSession, argc, argv, capture);
+    fclose(capture);
+
+    if (!ok && length > 0 && text[0] == '{') {
+        fputs(text, out); // Already a JSON failure
+    } else {
+        fprintf(out, "{\"ok\":%s,\"text\":", ok ? "true" : "false");
+        jsonString(out, text, length);
+        fprintf(out, "}\n");
+    }
+    free(text);
+    return ok;
+}
+
+
+/**
+ * @brief Runs one command for a user and prints its result
+ * @param session Who runs the command and how the result is printed
+ * @param argc Number of words, the command's name included
+ * @param argv The words, e.g. {"item", "get", "5"}
+ * @param out Where the result goes, one line of JSON unless session->table is set
+ * @return int 1 if the command succeeded, 0 otherwise
+ */
+int commandRunAs(const CommandSession *session, int argc, char *argv[], FILE *out) {
+    if (argc < 1) {
+        return fail(out, "missing command");
+    }
+    int words;
+    const CommandDef *def = findCommand(argc, argv, &words);
+    if (def == NULL) {
+        return fail(out, "unknown command, try help");
+    }
+    if ((def->flags & COMMAND_ADMIN) && session->role != 2) {
+        return fail(out, "admin login required");
+    }
+    return def->handler(session, argc - words, argv + words, out);
+}
+
+/**
+ * @brief Runs one command as the user commandMain logged in and prints its result as a line of JSON
+ * @param argc Number of words, the command's name included
+ * @param argv The words, e.g. {"item", "get", "5"}
+ * @param out Where the result goes
+ * @return int 1 if the command succeeded, 0 otherwise
+ */
+int commandRun(int argc, char *argv[], FILE *out) {
+    return commandRunAs(&localSession, argc, argv, out);
+}
+
+/**
+ * @brief Tells whether a command replaces files that other commands read while they run
+ * @param argc Number of words, the command's name included
+ * @param argv The words, e.g. {"backup", "restore", "20261017_120000"}
+ * @return int 1 if no other command may run alongside it, 0 otherwise
+ */
+int commandExclusive(int argc, char *argv[]) {
+    int words;
+    const CommandDef *def = findCommand(argc, argv, &words);
+    if (def != NULL && def->handler == table) {
+        def = findCommand(argc - words, argv + words, &words);
+    }
+    return def != NULL && (def->flags & COMMAND_EXCLUSIVE);
+}
+
+/**
+ * @brief Splits a script line into words, in place
+ * @param line The line to split
+ * @param argv Output for the words, pointing into line
+ * @param maxArgs Capacity of argv
+ * @return int The number of words, -1 on an unterminated quote or too many words
+ *
+ * Words are separated by blanks; double quotes group blanks into a word and
+ * a backslash inside quotes escapes the next character. '#' starts a comment.
+ */
+int commandSplitLine(char *line, char *argv[], int maxArgs) {
+    int argc = 0;
+    char *p = line;
+    while (1) {
+        while (isspace((unsigned char)*p)) {
+            p++;
+        }
+        if (*p == '\0' || *p == '#') {
+            return argc;
+        }
+        if (argc == maxArgs) {
+            return -1;
+        }
+
+        char *word = p;
+        char *end = p;
+        int quoted = 0;
+        while (*p != '\0' && (quoted || !isspace((unsigned char)*p))) {
+            if (*p == '"') {
+                quoted = !quoted;
+                p++;
+                continue;
+            }
+            if (*p == '\\' && quoted && p[1] != '\0') {
+                p++;
+            }
+            *end++ = *p++;
+        }
+        if (quoted) {
+            return -1;
+        }
+
+        char next = *p;
+        *end = '\0';
+        argv[argc++] = word;
+        if (next == '\0') {
+            return argc;
+        }
+        p++;
+    }
+}
+
+/**
+ * @brief Runs one line of a command script
+ * @param line The line; it is modified while being split into words
+ * @param out Where the result goes
+ * @return int 1 if the command succeeded or the line is blank, 0 otherwise
+ */
+int commandRunLine(char *line, FILE *out) {
+    char *argv[COMMAND_MAX_ARGS];
+    int argc = commandSplitLine(line, argv, COMMAND_MAX_ARGS);
+    if (argc < 0) {
+        return fail(out, "cannot parse line");
+    }
+    if (argc == 0) {
+        return 1;
+    }
+    return commandRun(argc, argv, out);
+}
+
+/**
+ * @brief Runs commands read one per line until the end of the input
+ * @param in The script
+ * @param out Where the results go, one line per command
+ * @return int 1 if every command succeeded, 0 otherwise
+ */
+int commandRunScript(FILE *in, FILE *out) {
+    char *line = NULL;
+    size_t capacity = 0;
+    int ok = 1;
+    while (getline(&line, &capacity, in) >= 0) {
+        ok = commandRunLine(line, out) && ok;
+        fflush(out); // A driver on the other end of a pipe waits for each result
+    }
+    free(line);
+    return ok;
+}
+
+/**
+ * @brief Appends a word to a request line, quoted so the server splits it back the same way
+ * @param line The line so far, NUL-terminated
+ * @param size Capacity of line
+ * @param word The word to add
+ * @return int 1 on success, 0 if the line is full
+ */
+int commandAppendWord(char *line, size_t size, const char *word) {
+    size_t length = strlen(line);
+    if (length > 0 && length + 1 < size) {
+        line[length++] = ' ';
+    }
+    if (length + 1 < size) {
+        line[length++] = '"';
+    }
+    for (; *word != '\0' && length + 2 < size; word++) {
+        if (*word == '"' || *word == '\\') {
+            line[length++] = '\\';
+        }
+        line[length++] = *word;
+    }
+    if (length + 1 >= size) {
+        return 0;
+    }
+    line[length++] = '"';
+    line[length] = '\0';
+    return 1;
+}
+
+/**
+ * @brief Sends the command line or the script on stdin to a running sbmsd
+ * @return int 1 if every command succeeded, 0 otherwise
+ */
+static int runRemote(ServerClient *client, const char *username, const char *password, int argc, char *argv[]) {
+    static char request[SERVER_MAX_REQUEST];
+    request[0] = '\0';
+    if (!commandAppendWord(request, sizeof(request), "login") ||
+        !commandAppendWord(request, sizeof(request), username) ||
+        !commandAppendWord(request, sizeof(request), password) || serverRequest(client, request, NULL) != 1) {
+        return fail(stdout, "invalid username or password");
+    }
+
+    if (argc < 1 || strcmp(argv[0], "-") != 0) {
+        request[0] = '\0';
+        for (int i = 0; i < argc; i++) {
+            if (!commandAppendWord(request, sizeof(request), argv[i])) {
+                return fail(stdout, "command too long");
+            }
+        }
+        if (argc == 0) {
+            return fail(stdout, "missing command");
+        }
+        int result = serverRequest(client, request, stdout);
+        return result < 0 ? fail(stdout, "lost connection to server") : result;
+    }
+
+    char *line = NULL;
+    size_t capacity = 0;
+    ssize_t length;
+    int ok = 1;
+    while ((length = getline(&line, &capacity, stdin)) >= 0) {
+        if (length > 0 && line[length - 1] == '\n') {
+            line[--length] = '\0';
+        }
+
+        // Blank lines get no reply, so they are not sent at all
+        char *words[COMMAND_MAX_ARGS];
+        strncpy(request, line, sizeof(request) - 1);
+        request[sizeof(request) - 1] = '\0';
+        if (commandSplitLine(request, words, COMMAND_MAX_ARGS) == 0) {
+            continue;
+        }
+
+        int result = serverRequest(client, line, stdout);
+        fflush(stdout);
+        if (result < 0) {
+            ok = fail(stdout, "lost connection to server");
+            break;
+        }
+        ok = result && ok;
+    }
+    free(line);
+    return ok;
+}
+
+/**
+ * @brief Entry point for "sbms [-u USER] [-p PASSWORD] COMMAND..." and "sbms ... -"
+ * @return int The process exit status: 0 if every command succeeded, 1 otherwise
+ *
+ * When an sbmsd is listening on SBMS_SOCKET (default SERVER_SOCKET_FILE) the
+ * commands are sent to it; otherwise they run in this process.
+ */
+int commandMain(int argc, char *argv[]) {
+    char username[MAX_USERNAME_LENGTH] = "";
+    char password[MAX_PASSWORD_LENGTH] = "";
+    const char *userValue = getenv("SBMS_USER");
+    const char *passwordValue = getenv("SBMS_PASSWORD");
+    const char *socketPath = getenv("SBMS_SOCKET");
+
+    int first = 1;
+    while (first + 1 < argc && (strcmp(argv[first], "-u") == 0 || strcmp(argv[first], "-p") == 0)) {
+        if (argv[first][1] == 'u') {
+            userValue = argv[first + 1];
+        } else {
+            passwordValue = argv[first + 1];
+        }
+        first += 2;
+    }
+
+    if (userValue == NULL || passwordValue == NULL || strlen(userValue) >= sizeof(username) ||
+        strlen(passwordValue) >= sizeof(password)) {
+        fail(stdout, "login required: use -u and -p, or SBMS_USER and SBMS_PASSWORD");
+        return 1;
+    }
+    strcpy(username, userValue);
+    strcpy(password, passwordValue);
+
+    ServerClient client;
+    if (serverConnect(socketPath != NULL ? socketPath : SERVER_SOCKET_FILE, &client)) {
+        int ok = runRemote(&client, username, password, argc - first, argv + first);
+        serverDisconnect(&client);
+        return ok ? 0 : 1;
+    }
+
+    initializeSystem();
+    ensureDefaultAdmin();
+    localSession.role = loginUser(username, password);
+    if (localSession.role == 0) {
+        fail(stdout, "invalid username or password");
+        return 1;
+    }
+    strcpy(localSession.username, username);
+
+    int ok;
+    if (first < argc && strcmp(argv[first], "-") == 0) {
+        ok = commandRunScript(stdin, stdout);
+    } else {
+        ok = commandRun(argc - first, argv + first, stdout);
+    }
+    walCheckpoint();
+    return ok ? 0 : 1;
+}
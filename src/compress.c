@@ -0,0 +1,210 @@
+/*
+ * =====================================================================================
+ * File: compress.c
+ * Description: A small, fast LZ77 block compressor for backup chunks, with no
+ *              outside dependencies. A block is coded as a series of sequences:
+ *              a token byte holding the literal count (high nibble) and the
+ *              match length minus four (low nibble), extra length bytes when a
+ *              nibble is 15, the literals, and a 16-bit little-endian match
+ *              offset. The last sequence holds literals only. Matches are found
+ *              through a hash table of 4-byte prefixes, so compression needs no
+ *              allocation and a single pass.
+ *
+ *              Table records are fixed-width and padded with zeros, which this
+ *              scheme compresses several times over; data that does not shrink
+ *              is reported as such and stored as it is.
+ *
+ * Author: Chiemezie Agbo
+ * Date: 17-10-2026
+ * Version: 1.0
+ * =====================================================================================
+ */
+
+#include "../include/compress.h"
+#include <stdint.h>
+#include <string.h>
+
+#define MIN_MATCH 4
+#define HASH_BITS 14
+#define LAST_LITERALS 8 /* Matches never start this close to the end */
+
+static uint32_t read32(const unsigned char *p) {
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static uint32_t hashPrefix(uint32_t sequence) {
+    return (sequence * 2654435761u) >> (32 - HASH_BITS);
+}
+
+/**
+ * @brief Writes the extra bytes of a length that did not fit in its nibble
+ */
+static size_t putLength(unsigned char *out, size_t length) {
+    size_t n = 0;
+    while (length >= 255) {
+        out[n++] = 255;
+        length -= 255;
+    }
+    out[n++] = (unsigned char)length;
+    return n;
+}
+
+/**
+ * @brief Appends one sequence, failing if it would not fit
+ * @return size_t The new output position, 0 if the output is full
+ */
+static size_t putSequence(unsigned char *out, size_t op, size_t capacity, const unsigned char *literals,
+                          size_t literalCount, size_t offset, size_t matchLength) {
+    // Worst case: token, both lengths spelled out in 255s, literals and offset
+    size_t worst = 1 + literalCount / 255 + 1 + literalCount + 2 + matchLength / 255 + 1;
+    if (op + worst > capacity) {
+        return 0;
+    }
+
+    size_t matchCode = matchLength >= MIN_MATCH ? matchLength - MIN_MATCH : 0;
+    unsigned char *token = &out[op++];
+    *token = (unsigned char)(((literalCount < 15 ? literalCount : 15) << 4) | (matchCode < 15 ? matchCode : 15));
+    if (literalCount >= 15) {
+        op += putLength(out + op, literalCount - 15);
+    }
+    memcpy(out + op, literals, literalCount);
+    op += literalCount;
+
+    if (matchLength >= MIN_MATCH) {
+        out[op++] = (unsigned char)(offset & 0xFF);
+        out[op++] = (unsigned char)(offset >> 8);
+        if (matchCode >= 15) {
+            op += putLength(out + op, matchCode - 15);
+        }
+    }
+    return op;
+}
+
+/**
+ * @brief Returns an output size that any block of the given length fits in
+ */
+size_t compressBound(size_t length) {
+    return length + length / 255 + 16;
+}
+
+/**
+ * @brief Compresses one block
+ * @param in The data, at most COMPRESS_MAX_BLOCK bytes
+ * @param length Size of the data
+ * @param out Output buffer
+ * @param capacity Size of the output buffer
+ * @return size_t Compressed size, 0 if the data does not get smaller
+ */
+size_t compressBlock(const unsigned char *in, size_t length, unsigned char *out, size_t capacity) {
+    uint16_t table[1 << HASH_BITS];
+    if (length > COMPRESS_MAX_BLOCK) {
+        return 0;
+    }
+    if (capacity > length) {
+        capacity = length; // Anything larger is not worth storing compressed
+    }
+    memset(table, 0, sizeof(table));
+
+    size_t ip = 0;
+    size_t anchor = 0;
+    size_t op = 0;
+    while (ip + MIN_MATCH + LAST_LITERALS <= length) {
+        uint32_t sequence = read32(in + ip);
+        uint32_t h = hashPrefix(sequence);
+        size_t candidate = table[h];
+        table[h] = (uint16_t)ip;
+
+        if (candidate < ip && read32(in + candidate) == sequence) {
+            size_t matchLength = MIN_MATCH;
+            while (ip + matchLength < length && in[candidate + matchLength] == in[ip + matchLength]) {
+                matchLength++;
+            }
+            op = putSequence(out, op, capacity, in + anchor, ip - anchor, ip - candidate, matchLength);
+            if (op == 0) {
+                return 0;
+            }
+            ip += matchLength;
+            anchor = ip;
+            continue;
+        }
+
+        // Step faster through data that keeps failing to match
+        ip += 1 + ((ip - anchor) >> 6);
+    }
+
+    op = putSequence(out, op, capacity, in + anchor, length - anchor, 0, 0);
+    return op < length ? op : 0;
+}
+
+/**
+ * @brief Reads a length continued in 255-valued bytes
+ * @return int 1 on success, 0 if the input ends first
+ */
+static int getLength(const unsigned char *in, size_t length, size_t *ip, size_t *value) {
+    unsigned char byte;
+    do {
+        if (*ip >= length) {
+            return 0;
+        }
+        byte = in[(*ip)++];
+        *value += byte;
+    } while (byte == 255);
+    return 1;
+}
+
+/**
+ * @brief Expands a block produced by compressBlock
+ * @param in The compressed data
+ * @param length Size of the compressed data
+ * @param out Output buffer of rawLength bytes
+ * @param rawLength Exact size of the original block
+ * @return int 1 if the block decoded to exactly rawLength bytes, 0 if it is damaged
+ */
+int decompressBlock(const unsigned char *in, size_t length, unsigned char *out, size_t rawLength) {
+    size_t ip = 0;
+    size_t op = 0;
+    for (;;) {
+        // Every block ends with a sequence of literals only
+        if (ip >= length) {
+            return 0;
+        }
+        unsigned char token = in[ip++];
+        size_t literalCount = token >> 4;
+        if (literalCount == 15 && !getLength(in, length, &ip, &literalCount)) {
+            return 0;
+        }
+        if (literalCount > length - ip || literalCount > rawLength - op) {
+            return 0;
+        }
+        memcpy(out + op, in + ip, literalCount);
+        ip += literalCount;
+        op += literalCount;
+
+        if (ip == length) {
+            break; // The last sequence has no match
+        }
+        if (length - ip < 2) {
+            return 0;
+        }
+        size_t offset = in[ip] | ((size_t)in[ip + 1] << 8);
+        ip += 2;
+        size_t matchLength = token & 15;
+        if (matchLength == 15 && !getLength(in, length, &ip, &matchLength)) {
+            return 0;
+        }
+        matchLength += MIN_MATCH;
+        if (offset == 0 || offset > op || matchLength > rawLength - op) {
+            return 0;
+        }
+
+        // Byte by byte, since a match may overlap the bytes it produces
+        const unsigned char *match = out + op - offset;
+        for (size_t i = 0; i < matchLength; i++) {
+            out[op + i] = match[i];
+        }
+        op += matchLength;
+    }
+    return op == rawLength;
+}
@@ -14,6 +14,12 @@
  */
 
 #include "../include/customers.h"
+#include "../include/table.h"
+#include "../include/meta.h"
+#include "../include/lock.h"
+#include "../include/cache.h"
+#include "../include/search.h"
+#include "../include/metrics.h"
 #include "../include/utils.h"
 #include <stdio.h>
 #include <stdlib.h>
@@ -27,18 +33,8 @@
  * @return int The generated unique ID
  */
 int generateUniqueCustomerId() {
-    static int lastId = 0;
-    FILE *file = fopen(CUSTOMERS_FILE, "rb");
-    if (file != NULL) {
-        Customer customer;
-        while (fread(&customer, sizeof(Customer), 1, file)) {
-            if (customer.id > lastId) {
-                lastId = customer.id;
-            }
-        }
-        fclose(file);
-    }
-    return ++lastId;
+    METRICS_SPAN(METRIC_NEW_CUSTOMER_ID);
+    return metaAllocateId(TABLE_CUSTOMERS);
 }
 
 /**
@@ -101,6 +97,18 @@ void customerMenu() {
     } while (1);
 }
 
+/**
+ * @brief Stores a new customer under a newly allocated ID
+ * @param customer The customer to store; its ID is set
+ * @return int 1 on success, 0 otherwise
+ */
+int createCustomer(Customer *customer) {
+    customer->id = generateUniqueCustomerId();
+    METRICS_SPAN(METRIC_ADD_CUSTOMER);
+    METRICS_SPAN_IDS(customer->id, 0);
+    return tableAppend(TABLE_CUSTOMERS, customer) >= 0;
+}
+
 /**
  * @brief Adds a new customer to the system
  * @param customer Pointer to the Customer struct to be added
@@ -111,8 +119,6 @@ void addCustomer(Customer *customer) {
         customer = &newCustomer;
     }
 
-    customer->id = generateUniqueCustomerId();
-    
     // Clear the buffer before taking input
     clearInputBuffer();
 
@@ -121,44 +127,52 @@ void addCustomer(Customer *customer) {
     validateStringInput(customer->phone, MAX_PHONE_LENGTH, "Enter customer phone: ");
     validateStringInput(customer->address, MAX_ADDRESS_LENGTH, "Enter customer address: ");
 
-    FILE *file = fopen(CUSTOMERS_FILE, "ab");
-    if (file == NULL) {
-        printf("Error opening file!\n");
-        return;
+    if (createCustomer(customer)) {
+        printf("Customer added successfully with ID: %d!\n", customer->id);
     }
+}
 
-    fwrite(customer, sizeof(Customer), 1, file);
-    fclose(file);
+/**
+ * @brief Changes a stored customer
+ * @param id The customer's ID
+ * @param customer Output for the customer as stored afterwards
+ * @param edit Called with the stored customer under its lock; returns 0 to leave it unchanged
+ * @param context Passed on to edit
+ * @return int 1 if changed, 0 if there is no such customer or edit declined, -1 if it cannot be locked or written
+ */
+int editCustomer(int id, Customer *customer, CustomerEditor edit, void *context) {
+    METRICS_SPAN(METRIC_UPDATE_CUSTOMER);
+    METRICS_SPAN_IDS(id, 0);
 
-    printf("Customer added successfully with ID: %d!\n", customer->id);
+    // Find the slot under the record lock, the customer may have moved or gone since it was shown
+    if (!recordLock(TABLE_CUSTOMERS, id)) {
+        return -1;
+    }
+    long slot;
+    int result = 0;
+    if (tableGetById(TABLE_CUSTOMERS, id, customer, &slot) && edit(customer, context)) {
+        result = tableWriteSlot(TABLE_CUSTOMERS, slot, customer) ? 1 : -1;
+    }
+    recordUnlock(TABLE_CUSTOMERS, id);
+    return result;
 }
 
+/* Replaces every field of a customer with the ones entered in the menu */
+static int replaceCustomer(Customer *customer, void *context) {
+    *customer = *(const Customer *)context;
+    return 1;
+}
 
 /**
  * @brief Updates an existing customer's information
  * @param customer Pointer to the Customer struct with updated information
  */
 void updateCustomer(Customer *customer) {
-    FILE *file = fopen(CUSTOMERS_FILE, "rb+");
-    if (file == NULL) {
-        printf("Error opening file!\n");
-        return;
-    }
-
-    Customer tempCustomer;
-    int found = 0;
+    Customer stored;
 
-    // Locate the specific customer in the file
-    while (fread(&tempCustomer, sizeof(Customer), 1, file)) {
-        if (tempCustomer.id == customer->id) {
-            found = 1;
-            break;
-        }
-    }
-
-    if (!found) {
+    // Locate the specific customer through the ID index
+    if (!tableGetById(TABLE_CUSTOMERS, customer->id, &stored, NULL)) {
         printf("Customer not found in the file!\n");
-        fclose(file);
         return;
     }
 
@@ -168,73 +182,120 @@ void updateCustomer(Customer *customer) {
     validateStringInput(customer->phone, MAX_PHONE_LENGTH, "Enter new customer phone: ");
     validateStringInput(customer->address, MAX_ADDRESS_LENGTH, "Enter new customer address: ");
 
-    // Move file pointer back to the position of the found customer
-    fseek(file, -sizeof(Customer), SEEK_CUR);
-
-    // Write the updated customer details back to the file
-    fwrite(customer, sizeof(Customer), 1, file);
-
-    fclose(file);
-
-    printf("Customer updated successfully!\n");
+    int result = editCustomer(customer->id, &stored, replaceCustomer, customer);
+    if (result > 0) {
+        printf("Customer updated successfully!\n");
+    } else if (result < 0) {
+        printf("Error opening file!\n");
+    } else {
+        printf("Customer not found in the file!\n");
+    }
 }
  
+/**
+ * @brief Deletes a customer
+ * @param id The customer's ID
+ * @return int 1 if deleted, 0 if there is no such customer
+ */
+int removeCustomer(int id) {
+    METRICS_SPAN(METRIC_DELETE_CUSTOMER);
+    METRICS_SPAN_IDS(id, 0);
+    return tableDeleteById(TABLE_CUSTOMERS, id);
+}
 
 /**
  * @brief Deletes a customer from the system
  * @param id The ID of the customer to be deleted
  */
 void deleteCustomer(int id) {
-    FILE *file = fopen(CUSTOMERS_FILE, "rb");
-    FILE *tempFile = fopen("data/temp_customers.dat", "wb");
-    if (file == NULL || tempFile == NULL) {
-        printf("Error opening file!\n");
-        return;
+    if (removeCustomer(id)) {
+        printf("Customer deleted successfully!\n");
+    } else {
+        printf("Customer not found!\n");
     }
+}
 
-    Customer customer;
-    int found = 0;
-    while (fread(&customer, sizeof(Customer), 1, file)) {
-        if (customer.id != id) {
-            fwrite(&customer, sizeof(Customer), 1, tempFile);
-        } else {
-            found = 1;
-        }
-    }
+/**
+ * @brief Prints the column headings of the customer tables
+ * @param out Where the headings go
+ */
+void printCustomerHeader(FILE *out) {
+    fprintf(out, "\033[1;34m");
+    fprintf(out, "%-5s %-20s %-30s %-15s %-30s\n", "ID", "Name", "Email", "Phone", "Address");
+    fprintf(out, "====================================================================================\n");
+    fprintf(out, "\033[0m");
+}
 
-    fclose(file);
-    fclose(tempFile);
+/**
+ * @brief Prints one customer as a row under printCustomerHeader()
+ * @param out Where the row goes
+ * @param customer The customer to print
+ */
+void printCustomerRow(FILE *out, const Customer *customer) {
+    fprintf(out, "%-5d %-20s %-30s %-15s %-30s\n", customer->id, customer->name, customer->email, customer->phone,
+            customer->address);
+}
 
-    remove(CUSTOMERS_FILE);
-    rename("data/temp_customers.dat", CUSTOMERS_FILE);
+/**
+ * @brief Calls a function with every customer that is not deleted
+ * @param visit Called with each customer in storage order
+ * @param context Passed on to visit
+ * @return int 1 on success, 0 if the customers cannot be read
+ */
+int listCustomers(CustomerVisitor visit, void *context) {
+    METRICS_SPAN(METRIC_VIEW_CUSTOMERS);
+    long count;
+    const Customer *customers = cacheTable(TABLE_CUSTOMERS, &count);
+    if (count < 0) {
+        return 0;
+    }
+    ioCountScan(count);
 
-    if (found) {
-        printf("Customer deleted successfully!\n");
-    } else {
-        printf("Customer not found!\n");
+    for (long i = 0; i < count; i++) {
+        if (customers[i].id > 0) {
+            visit(&customers[i], context);
+        }
     }
+    return 1;
+}
+
+static void printCustomerVisitor(const Customer *customer, void *context) {
+    printCustomerRow(context, customer);
 }
 
 /**
  * @brief Displays all customers in the system
  */
 void viewAllCustomers() {
-    FILE *file = fopen(CUSTOMERS_FILE, "rb");
-    if (file == NULL) {
+    printCustomerHeader(stdout);
+    if (!listCustomers(printCustomerVisitor, stdout)) {
         printf("Error opening file!\n");
-        return;
     }
+}
 
-    Customer customer;
-    printf("\033[1;34m");
-    printf("%-5s %-20s %-30s %-15s %-30s\n", "ID", "Name", "Email", "Phone", "Address");
-    printf("====================================================================================\n");
-    printf("\033[0m");
-    while (fread(&customer, sizeof(Customer), 1, file)) {
-        printf("%-5d %-20s %-30s %-15s %-30s\n", customer.id, customer.name, customer.email, customer.phone, customer.address);
+/**
+ * @brief Calls a function with every customer whose details contain a term
+ * @param term The text to look for
+ * @param visit Called with each matching customer
+ * @param context Passed on to visit
+ * @param found Output for the number of matching customers
+ * @return int 1 on success, 0 if the customers cannot be read
+ */
+int findCustomers(const char *term, CustomerVisitor visit, void *context, long *found) {
+    METRICS_SPAN(METRIC_SEARCH_CUSTOMERS);
+    long *slots;
+    if (!searchTable(TABLE_CUSTOMERS, term, &slots, found)) {
+        return 0;
     }
+    long total;
+    const Customer *customers = cacheTable(TABLE_CUSTOMERS, &total);
 
-    fclose(file);
+    // The index only returns live records that contain the term
+    for (long i = 0; i < *found; i++) {
+        visit(&customers[slots[i]], context);
+    }
+    free(slots);
+    return 1;
 }
 
 /**
@@ -245,28 +306,11 @@ void searchCustomer() {
     printf("Enter search term: ");
     scanf("%s", searchTerm);
 
-    FILE *file = fopen(CUSTOMERS_FILE, "rb");
-    if (file == NULL) {
+    long count;
+    printCustomerHeader(stdout);
+    if (!findCustomers(searchTerm, printCustomerVisitor, stdout, &count)) {
         printf("Error opening file!\n");
-        return;
-    }
-
-    Customer customer;
-    int found = 0;
-    printf("\033[1;34m");
-    printf("%-5s %-20s %-30s %-15s %-30s\n", "ID", "Name", "Email", "Phone", "Address");
-    printf("====================================================================================\n");
-    printf("\033[0m");
-    while (fread(&customer, sizeof(Customer), 1, file)) {
-        if (strstr(customer.name, searchTerm) || strstr(customer.email, searchTerm)) {
-            printf("%-5d %-20s %-30s %-15s %-30s\n", customer.id, customer.name, customer.email, customer.phone, customer.address);
-            found = 1;
-        }
-    }
-
-    fclose(file);
-
-    if (!found) {
+    } else if (count == 0) {
         printf("No customers found matching the search term.\n");
     }
 }
@@ -278,21 +322,8 @@ void searchCustomer() {
  * @return int 1 if customer found, 0 otherwise
  */
 int getCustomerById(int id, Customer *customer) {
-    FILE *file = fopen(CUSTOMERS_FILE, "rb");
-    if (file == NULL) {
-        printf("Error opening file!\n");
-        return 0;
-    }
-
-    int found = 0;
-    while (fread(customer, sizeof(Customer), 1, file)) {
-        if (customer->id == id) {
-            found = 1;
-            break;
-        }
-    }
-
-    fclose(file);
-    return found;
+    METRICS_SPAN(METRIC_GET_CUSTOMER);
+    METRICS_SPAN_IDS(id, 0);
+    return tableGetById(TABLE_CUSTOMERS, id, customer, NULL);
 }
 
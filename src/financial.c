@@ -12,13 +12,22 @@
  * =====================================================================================
  */
 
+#define _DEFAULT_SOURCE
 #include "../include/financial.h"
 #include "../include/orders.h"
 #include "../include/inventory.h"
+#include "../include/cache.h"
+#include "../include/columns.h"
+#include "../include/rollups.h"
+#include "../include/orderlines.h"
+#include "../include/hotstore.h"
+#include "../include/money.h"
+#include "../include/metrics.h"
 #include "../include/utils.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
 
 #define ORDERS_FILE "data/orders.dat"
 #define INVENTORY_FILE "data/inventory.dat"
@@ -38,11 +47,12 @@ void financialMenu()
         printf("║ 1. Generate Sales Report   ║\n");
         printf("║ 2. Generate Profit Report  ║\n");
         printf("║ 3. Generate Inventory Value║\n");
-        printf("║ 4. Back to Main Menu       ║\n");
+        printf("║ 4. Product Sales Report    ║\n");
+        printf("║ 5. Back to Main Menu       ║\n");
         printf("╚════════════════════════════╝\n");
         printf("\033[0m");
         printf("Enter your choice: ");
-        choice = validateIntInput(1, 4);
+        choice = validateIntInput(1, 5);
 
         switch (choice)
         {
@@ -70,8 +80,17 @@ void financialMenu()
             printf("End Date: %s\n", endDate);
             while (getchar() != '\n')
                 ; 
+            printf("List individual orders? (1 for Yes, 0 for No): ");
+            int listOrders = validateIntInput(0, 1);
             ProfitReport report;
-            generateProfitReport(startDate, endDate, &report);
+            if (listOrders)
+            {
+                generateProfitReport(startDate, endDate, &report);
+            }
+            else
+            {
+                generateProfitSummary(startDate, endDate, &report);
+            }
         }
         break;
         case 3:
@@ -81,11 +100,100 @@ void financialMenu()
         }
         break;
         case 4:
+        {
+            char startDate[11], endDate[11];
+            printf("Enter inventory item ID: ");
+            int itemId = validateIntInput(1, INT_MAX);
+            validateDateInput(startDate);
+            while (getchar() != '\n')
+                ;
+            validateDateInput(endDate);
+            while (getchar() != '\n')
+                ;
+            ProductReport report;
+            generateProductReport(itemId, startDate, endDate, &report);
+        }
+        break;
+        case 5:
             return;
         }
     } while (1);
 }
 
+/**
+ * @brief Returns the last second of the day a date string names
+ */
+static time_t endOfDay(const char *date)
+{
+    time_t start = parseDate(date);
+    struct tm tm;
+    localtime_r(&start, &tm);
+    tm.tm_mday += 1;
+    tm.tm_hour = tm.tm_min = tm.tm_sec = 0;
+    tm.tm_isdst = -1;
+    return mktime(&tm) - 1;
+}
+
+/**
+ * @brief Computes the sales totals for a given date range
+ * @param startDate The start date of the report period
+ * @param endDate The end date of the report period
+ * @param report Pointer to the SalesReport struct to fill
+ * @return int 1 on success, 0 if the daily totals cannot be read
+ */
+int computeSalesReport(const char *startDate, const char *endDate, SalesReport *report)
+{
+    METRICS_SPAN(METRIC_SALES_REPORT);
+    METRICS_SPAN_RANGE(startDate, endDate);
+    // Answered from the daily totals, one small record per day in the range
+    DailyRollup total;
+    if (!rollupsSum(rollupDayFromDate(startDate), rollupDayFromDate(endDate), &total))
+    {
+        return 0;
+    }
+
+    report->totalSales = total.revenue;
+    report->orderCount = (int)total.orderCount;
+    report->averageOrderValue = 0;
+    report->pendingCount = total.statusCounts[ORDER_STATUS_PENDING];
+    report->shippedCount = total.statusCounts[ORDER_STATUS_SHIPPED];
+    report->completedCount = total.statusCounts[ORDER_STATUS_COMPLETED];
+
+    if (report->orderCount > 0)
+    {
+        report->averageOrderValue = moneyToDouble(report->totalSales) / report->orderCount;
+    }
+    return 1;
+}
+
+/**
+ * @brief Computes and prints a sales report for a given date range
+ * @param out Where the report goes
+ * @param startDate The start date of the report period
+ * @param endDate The end date of the report period
+ * @param report Pointer to the SalesReport struct to store the generated report
+ * @return int 1 on success, 0 otherwise
+ */
+int writeSalesReport(FILE *out, const char *startDate, const char *endDate, SalesReport *report)
+{
+    if (!computeSalesReport(startDate, endDate, report))
+    {
+        fprintf(out, "Error opening file!\n");
+        return 0;
+    }
+
+    fprintf(out, "\033[1;34m");
+    fprintf(out, "Sales Report from %s to %s\n", startDate, endDate);
+    fprintf(out, "====================================================================================\n");
+    fprintf(out, "Total Sales: $%.2f\n", moneyToDouble(report->totalSales));
+    fprintf(out, "Total Orders: %d\n", report->orderCount);
+    fprintf(out, "Average Order Value: $%.2f\n", report->averageOrderValue);
+    fprintf(out, "Pending: %lld  Shipped: %lld  Completed: %lld\n", report->pendingCount, report->shippedCount,
+            report->completedCount);
+    fprintf(out, "\033[0m");
+    return 1;
+}
+
 /**
  * @brief Generates a sales report for a given date range
  * @param startDate The start date of the report period
@@ -94,44 +202,142 @@ void financialMenu()
  */
 void generateSalesReport(const char *startDate, const char *endDate, SalesReport *report)
 {
-    FILE *file = fopen(ORDERS_FILE, "rb");
-    if (file == NULL)
+    writeSalesReport(stdout, startDate, endDate, report);
+}
+
+/**
+ * @brief Computes the profit totals for a given date range, order by order
+ * @param startDate The start date of the report period
+ * @param endDate The end date of the report period
+ * @param report Pointer to the ProfitReport struct to fill
+ * @param row Called with every order in the range, or NULL for the totals only
+ * @param context Passed on to row
+ * @return int 1 on success, 0 if the order columns cannot be read
+ */
+int computeProfitReport(const char *startDate, const char *endDate, ProfitReport *report, ProfitReportRow row,
+                        void *context)
+{
+    METRICS_SPAN(METRIC_PROFIT_REPORT);
+    METRICS_SPAN_RANGE(startDate, endDate);
+    // Customer IDs and the status text are never needed here, so they stay on disk
+    OrderColumns columns;
+    if (!columnsLoad(ORDER_COLUMN_MASK(ORDER_COLUMN_ID) | ORDER_COLUMN_MASK(ORDER_COLUMN_DATE) |
+                     ORDER_COLUMN_MASK(ORDER_COLUMN_AMOUNT) | ORDER_COLUMN_MASK(ORDER_COLUMN_PROFIT) |
+                     ORDER_COLUMN_MASK(ORDER_COLUMN_STATUS), &columns))
     {
-        printf("Error opening file!\n");
-        return;
+        return 0;
     }
 
-    report->totalSales = 0;
-    report->orderCount = 0;
-    report->averageOrderValue = 0;
+    memset(report, 0, sizeof(*report));
 
-    Order order;
-    time_t start = parseDate(startDate);
-    time_t end = parseDate(endDate);
+    // Both dates are whole days, like the totals of the sales and profit summaries
+    int64_t start = (int64_t)parseDate(startDate);
+    int64_t end = (int64_t)endOfDay(endDate);
+
+    uint8_t *selected = malloc((size_t)columns.count + 1);
+    if (selected == NULL)
+    {
+        return 0;
+    }
 
-    while (fread(&order, sizeof(Order), 1, file))
+    for (long s = 0; s < columns.segmentCount; s++)
     {
-        if (order.orderDate >= start && order.orderDate <= end)
+        const OrderSegment *segment = &columns.segments[s];
+        if (segment->liveCount == 0 || segment->maxDate < start || segment->minDate > end)
         {
-            report->totalSales += order.totalAmount;
-            report->orderCount++;
+            continue;
         }
+
+        // Every live order of a segment inside the range counts, and its zone map already holds their sums
+        int covered = segment->minDate >= start && segment->maxDate <= end;
+        if (covered && row == NULL)
+        {
+            report->orderCount += segment->liveCount;
+            report->totalRevenue += segment->totalAmount;
+            report->totalProfit += segment->profit;
+            continue;
+        }
+
+        long first = (long)segment->firstRow;
+        long last = first + segment->rowCount;
+        ioCountScan(segment->rowCount);
+        for (long i = first; i < last; i++)
+        {
+            selected[i - first] = (covered || (columns.orderDate[i] >= start && columns.orderDate[i] <= end)) &&
+                                  columns.status[i] != ORDER_STATUS_DELETED;
+            if (selected[i - first])
+            {
+                report->orderCount++;
+                if (row != NULL)
+                {
+                    ProfitReportLine line = {columns.id[i], columns.orderDate[i], columns.totalAmount[i],
+                                             columns.totalAmount[i] - columns.profit[i], columns.profit[i]};
+                    row(&line, context);
+                }
+            }
+        }
+
+        if (covered)
+        {
+            report->totalRevenue += segment->totalAmount;
+            report->totalProfit += segment->profit;
+            continue;
+        }
+        // Whole column slices are summed at once; the totals are exact in any order
+        report->totalRevenue += moneySumSelected(columns.totalAmount + first, selected, segment->rowCount);
+        report->totalProfit += moneySumSelected(columns.profit + first, selected, segment->rowCount);
+    }
+    free(selected);
+    report->totalCost = report->totalRevenue - report->totalProfit;
+
+    if (report->totalRevenue > 0)
+    {
+        report->profitMargin = ((double)report->totalProfit / (double)report->totalRevenue) * 100;
     }
+    return 1;
+}
 
-    fclose(file);
+static void printProfitReportRow(const ProfitReportLine *line, void *context)
+{
+    char date[20];
+    struct tm tm;
+    time_t orderDate = (time_t)line->orderDate;
+    strftime(date, sizeof(date), "%Y-%m-%d %H:%M:%S", localtime_r(&orderDate, &tm));
+    fprintf(context, "%-5d %-15s $%-14.2f $%-14.2f $%-14.2f\n", line->orderId, date, moneyToDouble(line->revenue),
+            moneyToDouble(line->cost), moneyToDouble(line->profit));
+}
 
-    if (report->orderCount > 0)
+/**
+ * @brief Computes and prints a profit report listing every order in a date range
+ * @param out Where the report goes
+ * @param startDate The start date of the report period
+ * @param endDate The end date of the report period
+ * @param report Pointer to the ProfitReport struct to store the generated report
+ * @return int 1 on success, 0 otherwise
+ */
+int writeProfitReport(FILE *out, const char *startDate, const char *endDate, ProfitReport *report)
+{
+    fprintf(out, "\033[1;34m");
+    fprintf(out, "Profit Report from %s to %s\n", startDate, endDate);
+    fprintf(out, "====================================================================================\n");
+    fprintf(out, "%-5s %-15s %-20s %-15s %-15s\n", "ID", "Order Date", "Revenue", "Cost", "Profit");
+    fprintf(out, "====================================================================================\n");
+    fprintf(out, "\033[0m");
+
+    if (!computeProfitReport(startDate, endDate, report, printProfitReportRow, out))
     {
-        report->averageOrderValue = report->totalSales / report->orderCount;
+        fprintf(out, "Error opening file!\n");
+        return 0;
     }
 
-    printf("\033[1;34m");
-    printf("Sales Report from %s to %s\n", startDate, endDate);
-    printf("====================================================================================\n");
-    printf("Total Sales: $%.2f\n", report->totalSales);
-    printf("Total Orders: %d\n", report->orderCount);
-    printf("Average Order Value: $%.2f\n", report->averageOrderValue);
-    printf("\033[0m");
+    fprintf(out, "\033[1;32m");
+    fprintf(out, "====================================================================================\n");
+    fprintf(out, "Total Revenue: $%.2f\n", moneyToDouble(report->totalRevenue));
+    fprintf(out, "Total Cost: $%.2f\n", moneyToDouble(report->totalCost));
+    fprintf(out, "Total Profit: $%.2f\n", moneyToDouble(report->totalProfit));
+    fprintf(out, "Profit Margin: %.2f%%\n", report->profitMargin);
+    fprintf(out, "\033[0m");
+    return 1;
 }
 
 /**
@@ -142,108 +348,268 @@ void generateSalesReport(const char *startDate, const char *endDate, SalesReport
  */
 void generateProfitReport(const char *startDate, const char *endDate, ProfitReport *report)
 {
-    FILE *file = fopen(ORDERS_FILE, "rb");
-    if (file == NULL)
+    writeProfitReport(stdout, startDate, endDate, report);
+}
+
+/**
+ * @brief Computes the profit totals for a given date range without visiting any order
+ * @param startDate The start date of the report period
+ * @param endDate The end date of the report period
+ * @param report Pointer to the ProfitReport struct to fill
+ * @return int 1 on success, 0 if the daily totals cannot be read
+ */
+int computeProfitSummary(const char *startDate, const char *endDate, ProfitReport *report)
+{
+    METRICS_SPAN(METRIC_PROFIT_SUMMARY);
+    METRICS_SPAN_RANGE(startDate, endDate);
+    DailyRollup total;
+    if (!rollupsSum(rollupDayFromDate(startDate), rollupDayFromDate(endDate), &total))
     {
-        printf("Error opening file!\n");
-        return;
+        return 0;
     }
 
-    report->totalRevenue = 0;
-    report->totalCost = 0;
-    report->totalProfit = 0;
+    report->orderCount = total.orderCount;
+    report->totalRevenue = total.revenue;
+    report->totalCost = total.cost;
+    report->totalProfit = total.profit;
     report->profitMargin = 0;
+    if (report->totalRevenue > 0)
+    {
+        report->profitMargin = ((double)report->totalProfit / (double)report->totalRevenue) * 100;
+    }
+    return 1;
+}
 
-    Order order;
-    time_t start = parseDate(startDate);
-    time_t end = parseDate(endDate);
+/**
+ * @brief Computes and prints a profit summary for a given date range
+ * @param out Where the summary goes
+ * @param startDate The start date of the report period
+ * @param endDate The end date of the report period
+ * @param report Pointer to the ProfitReport struct to store the generated report
+ * @return int 1 on success, 0 otherwise
+ */
+int writeProfitSummary(FILE *out, const char *startDate, const char *endDate, ProfitReport *report)
+{
+    if (!computeProfitSummary(startDate, endDate, report))
+    {
+        fprintf(out, "Error opening file!\n");
+        return 0;
+    }
+
+    fprintf(out, "\033[1;32m");
+    fprintf(out, "Profit Summary from %s to %s\n", startDate, endDate);
+    fprintf(out, "====================================================================================\n");
+    fprintf(out, "Total Orders: %lld\n", report->orderCount);
+    fprintf(out, "Total Revenue: $%.2f\n", moneyToDouble(report->totalRevenue));
+    fprintf(out, "Total Cost: $%.2f\n", moneyToDouble(report->totalCost));
+    fprintf(out, "Total Profit: $%.2f\n", moneyToDouble(report->totalProfit));
+    fprintf(out, "Profit Margin: %.2f%%\n", report->profitMargin);
+    fprintf(out, "\033[0m");
+    return 1;
+}
+
+/**
+ * @brief Generates a profit summary for a given date range without listing orders
+ * @param startDate The start date of the report period
+ * @param endDate The end date of the report period
+ * @param report Pointer to the ProfitReport struct to store the generated report
+ */
+void generateProfitSummary(const char *startDate, const char *endDate, ProfitReport *report)
+{
+    writeProfitSummary(stdout, startDate, endDate, report);
+}
 
-    printf("\033[1;34m");
-    printf("Profit Report from %s to %s\n", startDate, endDate);
-    printf("====================================================================================\n");
-    printf("%-5s %-15s %-20s %-15s %-15s\n", "ID", "Order Date", "Revenue", "Cost", "Profit");
-    printf("====================================================================================\n");
-    printf("\033[0m");
+/**
+ * @brief Computes the value of the stock on hand
+ * @param report Pointer to the InventoryValueReport struct to fill
+ * @param row Called with every live item as it is counted, or NULL
+ * @param context Passed on to row
+ * @return int 1 on success, 0 if the inventory cannot be read
+ */
+int computeInventoryValue(InventoryValueReport *report, InventoryValueRow row, void *context)
+{
+    METRICS_SPAN(METRIC_INVENTORY_VALUE);
+    // Only the hot fields are needed, so skip the descriptions in the data file
+    long count;
+    const InventoryHot *items = hotTable(TABLE_INVENTORY, &count);
+    if (count < 0)
+    {
+        return 0;
+    }
 
-    while (fread(&order, sizeof(Order), 1, file))
+    memset(report, 0, sizeof(*report));
+    for (long i = 0; i < count; i++)
     {
-        if (order.orderDate >= start && order.orderDate <= end)
+        const InventoryHot *item = &items[i];
+        if (item->id <= 0)
+        {
+            continue; // Deleted
+        }
+        if (row != NULL)
         {
-            char date[20];
-            strftime(date, sizeof(date), "%Y-%m-%d %H:%M:%S", localtime(&order.orderDate));
-            double orderCost = order.totalAmount - order.profit;
-            printf("%-5d %-15s $%-14.2f $%-14.2f $%-14.2f\n", order.id, date, order.totalAmount, orderCost, order.profit);
-            report->totalRevenue += order.totalAmount;
-            report->totalCost += orderCost;
-            report->totalProfit += order.profit;
+            row(item, context);
         }
+        report->totalItems += item->quantity;
+        report->totalCost += item->cost * item->quantity;
+        report->totalValue += item->price * item->quantity;
     }
 
-    fclose(file);
-
-    if (report->totalRevenue > 0)
+    report->potentialProfit = report->totalValue - report->totalCost;
+    if (report->totalValue > 0)
     {
-        report->profitMargin = (report->totalProfit / report->totalRevenue) * 100;
+        report->profitMargin = ((double)report->potentialProfit / (double)report->totalValue) * 100;
     }
+    return 1;
+}
 
-    printf("\033[1;32m");
-    printf("====================================================================================\n");
-    printf("Total Revenue: $%.2f\n", report->totalRevenue);
-    printf("Total Cost: $%.2f\n", report->totalCost);
-    printf("Total Profit: $%.2f\n", report->totalProfit);
-    printf("Profit Margin: %.2f%%\n", report->profitMargin);
-    printf("\033[0m");
+static void printInventoryValueRow(const InventoryHot *item, void *context)
+{
+    // The hot prefix covers the 30-character column; longer names are cut to it
+    fprintf(context, "%-5d %-30.30s %-10d $%-14.2f $%-14.2f $%-14.2f\n", item->id, item->namePrefix, item->quantity,
+            moneyToDouble(item->cost), moneyToDouble(item->price), moneyToDouble(item->price * item->quantity));
 }
 
 /**
- * @brief Generates an inventory value report
+ * @brief Computes and prints the value of every item and of the whole stock
+ * @param out Where the report goes
  * @param report Pointer to the InventoryValueReport struct to store the generated report
+ * @return int 1 on success, 0 otherwise
  */
-void generateInventoryValue(InventoryValueReport *report)
+int writeInventoryValue(FILE *out, InventoryValueReport *report)
 {
-    FILE *file = fopen(INVENTORY_FILE, "rb");
-    if (file == NULL)
+    fprintf(out, "\033[1;34m");
+    fprintf(out, "Inventory Value Report\n");
+    fprintf(out, "====================================================================================\n");
+    fprintf(out, "%-5s %-30s %-10s %-15s %-15s %-15s\n", "ID", "Name", "Quantity", "Cost", "Price", "Total Value");
+    fprintf(out, "====================================================================================\n");
+    fprintf(out, "\033[0m");
+
+    if (!computeInventoryValue(report, printInventoryValueRow, out))
     {
-        printf("Error opening inventory file!\n");
-        return;
+        fprintf(out, "Error opening inventory file!\n");
+        return 0;
     }
 
-    report->totalItems = 0;
-    report->totalCost = 0;
-    report->totalValue = 0;
+    fprintf(out, "\033[1;32m");
+    fprintf(out, "====================================================================================\n");
+    fprintf(out, "Total Items: %lld\n", report->totalItems);
+    fprintf(out, "Total Cost: $%.2f\n", moneyToDouble(report->totalCost));
+    fprintf(out, "Total Value: $%.2f\n", moneyToDouble(report->totalValue));
+    fprintf(out, "Potential Profit: $%.2f\n", moneyToDouble(report->potentialProfit));
+    fprintf(out, "Potential Profit Margin: %.2f%%\n", report->profitMargin);
+    fprintf(out, "\033[0m");
+    return 1;
+}
 
-    InventoryItem item;
-    printf("\033[1;34m");
-    printf("Inventory Value Report\n");
-    printf("====================================================================================\n");
-    printf("%-5s %-30s %-10s %-15s %-15s %-15s\n", "ID", "Name", "Quantity", "Cost", "Price", "Total Value");
-    printf("====================================================================================\n");
-    printf("\033[0m");
+/**
+ * @brief Generates an inventory value report
+ * @param report Pointer to the InventoryValueReport struct to store the generated report
+ */
+void generateInventoryValue(InventoryValueReport *report)
+{
+    writeInventoryValue(stdout, report);
+}
+
+/**
+ * @brief Computes the sales of one product over a date range
+ * @param item The inventory item to report on, as looked up by the caller
+ * @param startDate The start date of the report period
+ * @param endDate The end date of the report period
+ * @param report Pointer to the ProductReport struct to fill
+ * @return int 1 on success, 0 if the order lines cannot be read
+ *
+ * Only the order lines of this item are visited, through the item's line chain.
+ */
+int computeProductReport(const InventoryItem *item, const char *startDate, const char *endDate, ProductReport *report)
+{
+    METRICS_SPAN(METRIC_PRODUCT_REPORT);
+    METRICS_SPAN_IDS(item->id, 0);
+    METRICS_SPAN_RANGE(startDate, endDate);
+    memset(report, 0, sizeof(*report));
 
-    while (fread(&item, sizeof(InventoryItem), 1, file))
+    OrderLine *lines;
+    long lineCount;
+    if (!orderLinesForItem(item->id, &lines, &lineCount))
     {
-        double itemTotalCost = item.cost * item.quantity;
-        double itemTotalValue = item.price * item.quantity;
+        return 0;
+    }
 
-        printf("%-5d %-30s %-10d $%-14.2f $%-14.2f $%-14.2f\n",
-               item.id, item.name, item.quantity, item.cost, item.price, itemTotalValue);
+    time_t start = parseDate(startDate);
+    time_t end = endOfDay(endDate);
+    for (long i = 0; i < lineCount; i++)
+    {
+        const OrderLine *line = &lines[i];
+        if (line->orderDate >= start && line->orderDate <= end)
+        {
+            report->lineCount++;
+            report->unitsSold += line->quantity;
+            report->revenue += line->unitPrice * line->quantity;
+            report->cost += line->unitCost * line->quantity;
+        }
+    }
+    free(lines);
 
-        report->totalItems += item.quantity;
-        report->totalCost += itemTotalCost;
-        report->totalValue += itemTotalValue;
+    report->profit = report->revenue - report->cost;
+    report->unitsInStock = item->quantity;
+    if (report->unitsSold + report->unitsInStock > 0)
+    {
+        report->sellThrough = (double)report->unitsSold / (report->unitsSold + report->unitsInStock) * 100;
+    }
+    // Cost of the units sold over the cost of the stock on hand
+    if (item->quantity > 0 && item->cost > 0)
+    {
+        report->turnover = (double)report->cost / (double)(item->quantity * item->cost);
     }
+    return 1;
+}
 
-    fclose(file);
+/**
+ * @brief Computes and prints the sales of one product over a date range
+ * @param out Where the report goes
+ * @param itemId The inventory item to report on
+ * @param startDate The start date of the report period
+ * @param endDate The end date of the report period
+ * @param report Pointer to the ProductReport struct to store the generated report
+ * @return int 1 on success, 0 otherwise
+ */
+int writeProductReport(FILE *out, int itemId, const char *startDate, const char *endDate, ProductReport *report)
+{
+    memset(report, 0, sizeof(*report));
+    InventoryItem item;
+    if (!getInventoryItemById(itemId, &item))
+    {
+        fprintf(out, "Inventory item not found!\n");
+        return 0;
+    }
+    if (!computeProductReport(&item, startDate, endDate, report))
+    {
+        fprintf(out, "Error opening file!\n");
+        return 0;
+    }
 
-    double potentialProfit = report->totalValue - report->totalCost;
-    double profitMargin = (report->totalValue > 0) ? (potentialProfit / report->totalValue) * 100 : 0;
+    fprintf(out, "\033[1;34m");
+    fprintf(out, "Product Sales Report for %s (ID: %d) from %s to %s\n", item.name, item.id, startDate, endDate);
+    fprintf(out, "====================================================================================\n");
+    fprintf(out, "Order Lines: %d\n", report->lineCount);
+    fprintf(out, "Units Sold: %d\n", report->unitsSold);
+    fprintf(out, "Revenue: $%.2f\n", moneyToDouble(report->revenue));
+    fprintf(out, "Cost: $%.2f\n", moneyToDouble(report->cost));
+    fprintf(out, "Profit: $%.2f\n", moneyToDouble(report->profit));
+    fprintf(out, "Units In Stock: %d\n", report->unitsInStock);
+    fprintf(out, "Sell-Through: %.2f%%\n", report->sellThrough);
+    fprintf(out, "Inventory Turnover: %.2f\n", report->turnover);
+    fprintf(out, "\033[0m");
+    return 1;
+}
 
-    printf("\033[1;32m");
-    printf("====================================================================================\n");
-    printf("Total Items: %d\n", report->totalItems);
-    printf("Total Cost: $%.2f\n", report->totalCost);
-    printf("Total Value: $%.2f\n", report->totalValue);
-    printf("Potential Profit: $%.2f\n", potentialProfit);
-    printf("Potential Profit Margin: %.2f%%\n", profitMargin);
-    printf("\033[0m");
+/**
+ * @brief Generates a sales report for one product over a date range
+ * @param itemId The inventory item to report on
+ * @param startDate The start date of the report period
+ * @param endDate The end date of the report period
+ * @param report Pointer to the ProductReport struct to store the generated report
+ */
+void generateProductReport(int itemId, const char *startDate, const char *endDate, ProductReport *report)
+{
+    writeProductReport(stdout, itemId, startDate, endDate, report);
 }
@@ -0,0 +1,273 @@
+/*
+ * =====================================================================================
+ * File: hotstore.c
+ * Description: Compact copies of the inventory and customer tables holding only
+ *              the fields that scans and lookups need: ID, quantity, cost and
+ *              price of an item (data/inventory.hot), ID, phone and the start of
+ *              the name of a customer (data/customers.hot). A hot record is a
+ *              fifth of the size of the full one, so valuation reports and
+ *              customer checks no longer drag descriptions, emails and addresses through
+ *              the cache. The full records in the data files stay the cold store
+ *              and are only read when a description or an address is shown.
+ *
+ *              Hot record N mirrors slot N of the data file. Every write the
+ *              write-ahead log applies is copied over, tombstones included. The
+ *              header remembers how many slots the file mirrors; when that no
+ *              longer matches the data file (a first run on existing data, a
+ *              restore or a compaction) the hot file is rebuilt from it, which
+ *              is also how data from before the split is migrated.
+ *
+ * Author: Chiemezie Agbo
+ * Date: 17-10-2026
+ * Version: 1.0
+ * =====================================================================================
+ */
+
+#define _DEFAULT_SOURCE
+#include "../include/hotstore.h"
+#include "../include/cache.h"
+#include "../include/index.h"
+#include "../include/metrics.h"
+#include "../include/utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define HOT_MAGIC 0x52544F48u /* "HOTR" */
+#define HOT_VERSION 2
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    int64_t rows;
+} HotHeader;
+
+typedef struct {
+    const char *hotFile;
+    size_t hotSize;
+} HotDef;
+
+static const HotDef hotDefs[TABLE_COUNT] = {
+    [TABLE_INVENTORY] = {INVENTORY_HOT_FILE, sizeof(InventoryHot)},
+    [TABLE_CUSTOMERS] = {CUSTOMERS_HOT_FILE, sizeof(CustomerHot)},
+};
+
+static off_t hotOffset(const HotDef *hot, long slot) {
+    return (off_t)sizeof(HotHeader) + (off_t)slot * (off_t)hot->hotSize;
+}
+
+/* Copies as much of a string as fits, leaving the rest of the zeroed field NUL */
+static void copyPrefix(char *prefix, size_t prefixSize, const char *text, size_t textSize) {
+    size_t length = strnlen(text, prefixSize - 1 < textSize ? prefixSize - 1 : textSize);
+    memcpy(prefix, text, length);
+}
+
+/**
+ * @brief Copies the hot fields of a full record
+ */
+static void project(TableId table, const void *record, void *hot) {
+    if (table == TABLE_INVENTORY) {
+        const InventoryItem *item = record;
+        InventoryHot *out = hot;
+        memset(out, 0, sizeof(*out));
+        out->id = item->id;
+        out->quantity = item->quantity;
+        out->cost = item->cost;
+        out->price = item->price;
+        copyPrefix(out->namePrefix, HOT_NAME_PREFIX, item->name, MAX_NAME_LENGTH);
+    } else if (table == TABLE_CUSTOMERS) {
+        const Customer *customer = record;
+        CustomerHot *out = hot;
+        memset(out, 0, sizeof(*out));
+        out->id = customer->id;
+        copyPrefix(out->namePrefix, HOT_NAME_PREFIX, customer->name, MAX_NAME_LENGTH);
+        copyPrefix(out->phone, MAX_PHONE_LENGTH, customer->phone, MAX_PHONE_LENGTH);
+    }
+}
+
+static int readHeader(int fd, HotHeader *header) {
+    return ioPread(fd, header, sizeof(*header), 0) == (ssize_t)sizeof(*header) &&
+           header->magic == HOT_MAGIC && header->version == HOT_VERSION;
+}
+
+static int writeHeader(int fd, int64_t rows) {
+    HotHeader header = {HOT_MAGIC, HOT_VERSION, rows};
+    return ioPwrite(fd, &header, sizeof(header), 0) == (ssize_t)sizeof(header);
+}
+
+/**
+ * @brief Copies a write the log applied to the data file into the hot file
+ * @param table TABLE_INVENTORY or TABLE_CUSTOMERS
+ * @param slot The slot that was written
+ * @param record The full record as it is now stored, a tombstone included
+ * @return int 1 on success, 0 otherwise
+ *
+ * Writing the same record twice leaves the same bytes, so replaying the log
+ * is harmless. A slot past the end of the hot file marks it stale instead.
+ */
+int hotApplyWrite(TableId table, long slot, const void *record) {
+    const HotDef *hot = &hotDefs[table];
+    if (hot->hotFile == NULL) {
+        return 1;
+    }
+
+    int fd = ioOpen(hot->hotFile, O_RDWR);
+    if (fd < 0) {
+        return 1; // Built on first use
+    }
+
+    HotHeader header;
+    int ok = 1;
+    if (!readHeader(fd, &header) || header.rows < 0) {
+        // Already stale, the next read rebuilds the file
+    } else if (slot > header.rows) {
+        ok = writeHeader(fd, -1);
+    } else {
+        char buffer[sizeof(InventoryHot) > sizeof(CustomerHot) ? sizeof(InventoryHot) : sizeof(CustomerHot)];
+        project(table, record, buffer);
+        ok = ioPwrite(fd, buffer, hot->hotSize, hotOffset(hot, slot)) == (ssize_t)hot->hotSize;
+        if (ok && slot == header.rows) {
+            ok = writeHeader(fd, header.rows + 1);
+        }
+    }
+    close(fd);
+    return ok;
+}
+
+/**
+ * @brief Rebuilds a hot file from the table's data file
+ * @param table TABLE_INVENTORY or TABLE_CUSTOMERS
+ * @return int 1 on success, 0 otherwise
+ */
+int hotRebuild(TableId table) {
+    const HotDef *hot = &hotDefs[table];
+    const TableDef *def = getTableDef(table);
+    if (hot->hotFile == NULL) {
+        return 0;
+    }
+
+    long count;
+    const char *records = cacheTable(table, &count);
+    if (count < 0) {
+        count = 0;
+    }
+
+    char *rows = malloc((size_t)count * hot->hotSize + 1);
+    if (rows == NULL) {
+        return 0;
+    }
+    for (long i = 0; i < count; i++) {
+        project(table, records + (size_t)i * def->recordSize, rows + (size_t)i * hot->hotSize);
+    }
+
+    char tempFile[256];
+    tempFileName(tempFile, sizeof(tempFile), hot->hotFile);
+    int fd = ioOpen(tempFile, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        free(rows);
+        return 0;
+    }
+
+    ssize_t wanted = (ssize_t)((size_t)count * hot->hotSize);
+    int ok = writeHeader(fd, count) && (count == 0 || ioPwrite(fd, rows, (size_t)wanted, hotOffset(hot, 0)) == wanted);
+    free(rows);
+    ok = fsync(fd) == 0 && ok;
+    ok = close(fd) == 0 && ok;
+    if (!ok || rename(tempFile, hot->hotFile) != 0) {
+        remove(tempFile);
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief Returns a table's hot records, rebuilding the hot file when it is missing or stale
+ * @param table TABLE_INVENTORY or TABLE_CUSTOMERS
+ * @param count Output for the number of records, -1 if the table cannot be read
+ * @return const void* Pointer to the first InventoryHot or CustomerHot, NULL if there are none
+ *
+ * The hot file is mapped through the table cache, so the returned pointer
+ * stays valid until the calling thread's next call for the same table.
+ * Deleted records are included with a negative ID, like in the data file.
+ */
+const void *hotTable(TableId table, long *count) {
+    const HotDef *hot = &hotDefs[table];
+    const TableDef *def = getTableDef(table);
+    *count = -1;
+
+    struct stat st;
+    if (hot->hotFile == NULL || stat(def->dataFile, &st) != 0) {
+        return NULL;
+    }
+    int64_t rows = (int64_t)(st.st_size / (off_t)def->recordSize);
+
+    for (int attempt = 0; attempt < 2; attempt++) {
+        long mapped;
+        const HotHeader *header = cacheFile(table, hot->hotFile, sizeof(HotHeader), hot->hotSize, &mapped);
+        if (header != NULL && header->magic == HOT_MAGIC && header->version == HOT_VERSION && header->rows == rows &&
+            mapped >= rows) {
+            *count = (long)rows;
+            ioCountScan(*count);
+            return rows > 0 ? (const char *)header + sizeof(HotHeader) : NULL;
+        }
+        if (attempt == 0 && !hotRebuild(table)) {
+            return NULL;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Looks up a hot record by ID through the table's ID index
+ * @param table TABLE_INVENTORY or TABLE_CUSTOMERS
+ * @param id The ID to look up
+ * @param hot Output for the InventoryHot or CustomerHot record
+ * @return int 1 if found, 0 otherwise
+ */
+int hotGetById(TableId table, int id, void *hot) {
+    const HotDef *def = &hotDefs[table];
+    if (def->hotFile == NULL) {
+        return 0;
+    }
+
+    long slot = indexLookup(table, id);
+    if (slot >= 0) {
+        int fd = ioOpen(def->hotFile, O_RDONLY);
+        HotHeader header;
+        if (fd >= 0 && readHeader(fd, &header) && slot < header.rows &&
+            ioPread(fd, hot, def->hotSize, hotOffset(def, slot)) == (ssize_t)def->hotSize &&
+            recordId(hot) == id) {
+            close(fd);
+            ioCountScan(1);
+            return 1;
+        }
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+
+    // Missing or stale hot file, or a stale index: go through the full record
+    char record[sizeof(InventoryItem) > sizeof(Customer) ? sizeof(InventoryItem) : sizeof(Customer)];
+    if (!tableGetById(table, id, record, NULL)) {
+        return 0;
+    }
+    project(table, record, hot);
+    return 1;
+}
+
+/**
+ * @brief Flushes the hot files to disk; called by the log's checkpoint
+ */
+void hotSync(void) {
+    for (int t = 0; t < TABLE_COUNT; t++) {
+        int fd = hotDefs[t].hotFile != NULL ? ioOpen(hotDefs[t].hotFile, O_RDONLY) : -1;
+        if (fd >= 0) {
+            fsync(fd);
+            close(fd);
+        }
+    }
+}
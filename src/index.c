@@ -0,0 +1,232 @@
+/*
+ * =====================================================================================
+ * File: index.c
+ * Description: Maintains a persistent primary-key index for each table. The index
+ *              is a sidecar file (e.g. data/inventory.idx) holding a small header
+ *              followed by a direct-address array where entry N stores the slot of
+ *              record N plus one (0 means "no such record"). A point lookup is a
+ *              single pread regardless of table size. The header remembers the
+ *              data file size the index was built against so a stale index is
+ *              detected and rebuilt from the data file automatically.
+ *
+ * Author: Chiemezie Agbo
+ * Date: 17-10-2026
+ * Version: 1.0
+ * =====================================================================================
+ */
+
+#define _DEFAULT_SOURCE
+#include "../include/index.h"
+#include "../include/cache.h"
+#include "../include/metrics.h"
+#include "../include/utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define INDEX_MAGIC 0x58494253u /* "SBIX" */
+
+typedef struct {
+    uint32_t magic;
+    uint32_t recordSize;
+    int64_t dataSize;
+} IndexHeader;
+
+/**
+ * @brief Returns the size of the whole records in a table's data file
+ */
+static int64_t dataFileSize(const TableDef *def) {
+    struct stat st;
+    if (stat(def->dataFile, &st) != 0) {
+        return 0;
+    }
+    return (int64_t)(st.st_size - st.st_size % (off_t)def->recordSize);
+}
+
+/**
+ * @brief Returns the byte offset of an ID's entry in the index file
+ */
+static off_t entryOffset(int id) {
+    return (off_t)sizeof(IndexHeader) + (off_t)id * (off_t)sizeof(int32_t);
+}
+
+/**
+ * @brief Opens an index and checks that it matches its data file
+ * @return int File descriptor of a fresh index, -1 if missing or stale
+ */
+static int openFreshIndex(const TableDef *def, int flags) {
+    int fd = ioOpen(def->indexFile, flags);
+    if (fd < 0) {
+        return -1;
+    }
+
+    IndexHeader header;
+    if (ioPread(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header) ||
+        header.magic != INDEX_MAGIC ||
+        header.recordSize != (uint32_t)def->recordSize ||
+        header.dataSize != dataFileSize(def)) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * @brief Rebuilds a table's index from its data file
+ * @param table The table whose index should be rebuilt
+ * @return int 1 on success, 0 otherwise
+ */
+int indexRebuild(TableId table) {
+    const TableDef *def = getTableDef(table);
+    if (def->indexFile == NULL) {
+        return 0;
+    }
+    IndexHeader header = {INDEX_MAGIC, (uint32_t)def->recordSize, 0};
+    int32_t *entries = NULL;
+    long capacity = 0;
+
+    long count;
+    const char *records = cacheTable(table, &count);
+    for (long slot = 0; slot < count; slot++) {
+        int id = recordId(records + (size_t)slot * def->recordSize);
+        if (id <= 0) {
+            continue;
+        }
+        if (id >= capacity) {
+            long newCapacity = capacity ? capacity : 1024;
+            while (newCapacity <= id) {
+                newCapacity *= 2;
+            }
+            int32_t *grown = realloc(entries, newCapacity * sizeof(int32_t));
+            if (grown == NULL) {
+                free(entries);
+                return 0;
+            }
+            memset(grown + capacity, 0, (newCapacity - capacity) * sizeof(int32_t));
+            entries = grown;
+            capacity = newCapacity;
+        }
+        entries[id] = (int32_t)(slot + 1);
+    }
+    if (count > 0) {
+        header.dataSize = (int64_t)count * (int64_t)def->recordSize;
+    }
+
+    char tempFile[256];
+    tempFileName(tempFile, sizeof(tempFile), def->indexFile);
+    FILE *out = ioFopen(tempFile, "wb");
+    if (out == NULL) {
+        free(entries);
+        return 0;
+    }
+
+    // A short write must never replace the live index
+    int ok = ioFwrite(&header, sizeof(header), 1, out) == 1 &&
+             (capacity == 0 || ioFwrite(entries, sizeof(int32_t), capacity, out) == (size_t)capacity);
+    ok = fflush(out) == 0 && fsync(fileno(out)) == 0 && ok;
+    ok = fclose(out) == 0 && ok;
+    free(entries);
+
+    if (!ok || rename(tempFile, def->indexFile) != 0) {
+        unlink(tempFile);
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief Looks up the slot holding a record
+ * @param table The table to search
+ * @param id The record ID
+ * @return long The record slot, -1 if there is no record with that ID
+ */
+long indexLookup(TableId table, int id) {
+    const TableDef *def = getTableDef(table);
+    if (id <= 0 || def->indexFile == NULL) {
+        return -1;
+    }
+
+    int fd = openFreshIndex(def, O_RDONLY);
+    if (fd < 0) {
+        if (!indexRebuild(table) || (fd = openFreshIndex(def, O_RDONLY)) < 0) {
+            return -1;
+        }
+    }
+
+    int32_t entry = 0;
+    ssize_t n = ioPread(fd, &entry, sizeof(entry), entryOffset(id));
+    close(fd);
+
+    if (n != (ssize_t)sizeof(entry) || entry <= 0) {
+        return -1;
+    }
+    return (long)entry - 1;
+}
+
+/**
+ * @brief Removes a record from the index after it was tombstoned
+ * @param table The table the record belonged to
+ * @param id The record ID
+ * @return int 1 on success, 0 otherwise
+ */
+int indexRemove(TableId table, int id) {
+    const TableDef *def = getTableDef(table);
+    if (def->indexFile == NULL || id <= 0) {
+        return 1;
+    }
+
+    int fd = openFreshIndex(def, O_RDWR);
+    if (fd < 0) {
+        return indexRebuild(table);
+    }
+
+    int32_t entry = 0;
+    int ok = 1;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && entryOffset(id) < st.st_size) {
+        ok = ioPwrite(fd, &entry, sizeof(entry), entryOffset(id)) == (ssize_t)sizeof(entry);
+    }
+    close(fd);
+    return ok;
+}
+
+/**
+ * @brief Records a freshly appended record in the index
+ * @param table The table the record was appended to
+ * @param id The record ID
+ * @param slot The slot the record was written to
+ * @return int 1 on success, 0 otherwise
+ *
+ * The index is only patched in place when it was current up to the append;
+ * otherwise it is rebuilt, which picks up the new record as well.
+ */
+int indexAppend(TableId table, int id, long slot) {
+    const TableDef *def = getTableDef(table);
+    if (def->indexFile == NULL) {
+        return 1;
+    }
+    int fd = ioOpen(def->indexFile, O_RDWR);
+    IndexHeader header;
+
+    if (fd < 0 ||
+        ioPread(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header) ||
+        header.magic != INDEX_MAGIC ||
+        header.recordSize != (uint32_t)def->recordSize ||
+        header.dataSize != (int64_t)slot * (int64_t)def->recordSize) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        return indexRebuild(table);
+    }
+
+    int32_t entry = (int32_t)(slot + 1);
+    header.dataSize = (int64_t)(slot + 1) * (int64_t)def->recordSize;
+    int ok = id <= 0 || ioPwrite(fd, &entry, sizeof(entry), entryOffset(id)) == (ssize_t)sizeof(entry);
+    ok = ok && ioPwrite(fd, &header, sizeof(header), 0) == (ssize_t)sizeof(header);
+    close(fd);
+    return ok;
+}
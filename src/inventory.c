@@ -13,6 +13,13 @@
  */
 
 #include "../include/inventory.h"
+#include "../include/table.h"
+#include "../include/meta.h"
+#include "../include/lock.h"
+#include "../include/cache.h"
+#include "../include/search.h"
+#include "../include/money.h"
+#include "../include/metrics.h"
 #include "../include/utils.h"
 #include <stdio.h>
 #include <stdlib.h>
@@ -64,31 +71,67 @@ void inventoryMenu() {
     } while (1);
 }
 
+/**
+ * @brief Stores a new inventory item under a newly allocated ID
+ * @param item The item to store; its ID is set
+ * @return int 1 on success, 0 otherwise
+ */
+int createInventoryItem(InventoryItem *item) {
+    item->id = generateUniqueInventoryId();
+    METRICS_SPAN(METRIC_ADD_ITEM);
+    METRICS_SPAN_IDS(item->id, 0);
+    return tableAppend(TABLE_INVENTORY, item) >= 0;
+}
+
 /**
  * @brief Adds a new inventory item to the system
  */
 void addInventoryItem() {
     InventoryItem item;
-    item.id = generateUniqueInventoryId();
     validateStringInput(item.name, MAX_NAME_LENGTH, "Enter item name: ");
     validateStringInput(item.description, MAX_DESCRIPTION_LENGTH, "Enter item description: ");
     printf("Enter item cost: ");
-    item.cost = validateDoubleInput(0, 1000000);
+    item.cost = moneyFromDouble(validateDoubleInput(0, 1000000));
     printf("Enter item selling price: ");
-    item.price = validateDoubleInput(item.cost, 1000000);
+    item.price = moneyFromDouble(validateDoubleInput(moneyToDouble(item.cost), 1000000));
     printf("Enter item quantity: ");
     item.quantity = validateIntInput(0, 1000000);
 
-    FILE *file = fopen(INVENTORY_FILE, "ab");
-    if (file == NULL) {
-        printf("Error opening file!\n");
-        return;
+    if (createInventoryItem(&item)) {
+        printf("Item added successfully!\n");
     }
+}
 
-    fwrite(&item, sizeof(InventoryItem), 1, file);
-    fclose(file);
+/**
+ * @brief Changes a stored inventory item
+ * @param id The item's ID
+ * @param item Output for the item as stored afterwards
+ * @param edit Called with the stored item under its lock; returns 0 to leave it unchanged
+ * @param context Passed on to edit
+ * @return int 1 if changed, 0 if there is no such item or edit declined, -1 if it cannot be locked or written
+ *
+ * The item is read, edited and written under its lock, so a stock change by
+ * another terminal in the meantime is never overwritten.
+ */
+int editInventoryItem(int id, InventoryItem *item, InventoryEditor edit, void *context) {
+    METRICS_SPAN(METRIC_UPDATE_ITEM);
+    METRICS_SPAN_IDS(id, 0);
+    if (!recordLock(TABLE_INVENTORY, id)) {
+        return -1;
+    }
+    long slot;
+    int result = 0;
+    if (tableGetById(TABLE_INVENTORY, id, item, &slot) && edit(item, context)) {
+        result = tableWriteSlot(TABLE_INVENTORY, slot, item) ? 1 : -1;
+    }
+    recordUnlock(TABLE_INVENTORY, id);
+    return result;
+}
 
-    printf("Item added successfully!\n");
+/* Replaces every field of an item with the ones entered in the menu */
+static int replaceItem(InventoryItem *item, void *context) {
+    *item = *(const InventoryItem *)context;
+    return 1;
 }
 
 /**
@@ -104,17 +147,30 @@ void updateInventoryItem() {
         validateStringInput(item.name, MAX_NAME_LENGTH, "Enter new item name: ");
         validateStringInput(item.description, MAX_DESCRIPTION_LENGTH, "Enter new item description: ");
         printf("Enter new item cost: ");
-        item.cost = validateDoubleInput(0, 1000000);
+        item.cost = moneyFromDouble(validateDoubleInput(0, 1000000));
         printf("Enter new item selling price: ");
-        item.price = validateDoubleInput(item.cost, 1000000);
+        item.price = moneyFromDouble(validateDoubleInput(moneyToDouble(item.cost), 1000000));
         printf("Enter new item quantity: ");
         item.quantity = validateIntInput(0, 1000000);
 
-        updateInventoryItemById(&item);
-        printf("Item updated successfully!\n");
-    } else {
-        printf("Item not found!\n");
+        InventoryItem stored;
+        if (editInventoryItem(id, &stored, replaceItem, &item) > 0) {
+            printf("Item updated successfully!\n");
+            return;
+        }
     }
+    printf("Item not found!\n");
+}
+
+/**
+ * @brief Deletes an inventory item
+ * @param id The item's ID
+ * @return int 1 if deleted, 0 if there is no such item
+ */
+int removeInventoryItem(int id) {
+    METRICS_SPAN(METRIC_DELETE_ITEM);
+    METRICS_SPAN_IDS(id, 0);
+    return tableDeleteById(TABLE_INVENTORY, id);
 }
 
 /**
@@ -125,56 +181,94 @@ void deleteInventoryItem() {
     printf("Enter item ID to delete: ");
     id = validateIntInput(1, INT_MAX);
 
-    FILE *file = fopen(INVENTORY_FILE, "rb");
-    FILE *tempFile = fopen("data/temp_inventory.dat", "wb");
-    if (file == NULL || tempFile == NULL) {
-        printf("Error opening file!\n");
-        return;
+    if (removeInventoryItem(id)) {
+        printf("Item deleted successfully!\n");
+    } else {
+        printf("Item not found!\n");
     }
+}
 
-    InventoryItem item;
-    int found = 0;
-    while (fread(&item, sizeof(InventoryItem), 1, file)) {
-        if (item.id != id) {
-            fwrite(&item, sizeof(InventoryItem), 1, tempFile);
-        } else {
-            found = 1;
-        }
-    }
+/**
+ * @brief Prints the column headings of the inventory tables
+ * @param out Where the headings go
+ */
+void printInventoryHeader(FILE *out) {
+    fprintf(out, "\033[1;34m");
+    fprintf(out, "%-5s %-20s %-30s %-10s %-10s %-10s\n", "ID", "Name", "Description", "Cost", "Price", "Quantity");
+    fprintf(out, "====================================================================================\n");
+    fprintf(out, "\033[0m");
+}
 
-    fclose(file);
-    fclose(tempFile);
+/**
+ * @brief Prints one inventory item as a row under printInventoryHeader()
+ * @param out Where the row goes
+ * @param item The item to print
+ */
+void printInventoryRow(FILE *out, const InventoryItem *item) {
+    fprintf(out, "%-5d %-20s %-30s $%-9.2f $%-9.2f %-10d\n", item->id, item->name, item->description,
+            moneyToDouble(item->cost), moneyToDouble(item->price), item->quantity);
+}
 
-    remove(INVENTORY_FILE);
-    rename("data/temp_inventory.dat", INVENTORY_FILE);
+/**
+ * @brief Calls a function with every inventory item that is not deleted
+ * @param visit Called with each item in storage order
+ * @param context Passed on to visit
+ * @return int 1 on success, 0 if the inventory cannot be read
+ */
+int listInventoryItems(InventoryVisitor visit, void *context) {
+    METRICS_SPAN(METRIC_VIEW_ITEMS);
+    long count;
+    const InventoryItem *items = cacheTable(TABLE_INVENTORY, &count);
+    if (count < 0) {
+        return 0;
+    }
+    ioCountScan(count);
 
-    if (found) {
-        printf("Item deleted successfully!\n");
-    } else {
-        printf("Item not found!\n");
+    for (long i = 0; i < count; i++) {
+        if (items[i].id > 0) {
+            visit(&items[i], context);
+        }
     }
+    return 1;
+}
+
+static void printItemVisitor(const InventoryItem *item, void *context) {
+    printInventoryRow(context, item);
 }
 
 /**
  * @brief Displays all inventory items in the system
  */
 void viewAllInventoryItems() {
-    FILE *file = fopen(INVENTORY_FILE, "rb");
-    if (file == NULL) {
+    printInventoryHeader(stdout);
+    if (!listInventoryItems(printItemVisitor, stdout)) {
         printf("Error opening file!\n");
-        return;
     }
+}
 
-    InventoryItem item;
-    printf("\033[1;34m");
-    printf("%-5s %-20s %-30s %-10s %-10s %-10s\n", "ID", "Name", "Description", "Cost", "Price", "Quantity");
-    printf("====================================================================================\n");
-    printf("\033[0m");
-    while (fread(&item, sizeof(InventoryItem), 1, file)) {
-        printf("%-5d %-20s %-30s $%-9.2f $%-9.2f %-10d\n", item.id, item.name, item.description, item.cost, item.price, item.quantity);
+/**
+ * @brief Calls a function with every inventory item whose name or description contains a term
+ * @param term The text to look for
+ * @param visit Called with each matching item
+ * @param context Passed on to visit
+ * @param found Output for the number of matching items
+ * @return int 1 on success, 0 if the inventory cannot be read
+ */
+int findInventoryItems(const char *term, InventoryVisitor visit, void *context, long *found) {
+    METRICS_SPAN(METRIC_SEARCH_ITEMS);
+    long *slots;
+    if (!searchTable(TABLE_INVENTORY, term, &slots, found)) {
+        return 0;
     }
+    long total;
+    const InventoryItem *items = cacheTable(TABLE_INVENTORY, &total);
 
-    fclose(file);
+    // The index only returns live records that contain the term
+    for (long i = 0; i < *found; i++) {
+        visit(&items[slots[i]], context);
+    }
+    free(slots);
+    return 1;
 }
 
 /**
@@ -184,28 +278,11 @@ void searchInventoryItem() {
     char searchTerm[MAX_NAME_LENGTH];
     validateStringInput(searchTerm, MAX_NAME_LENGTH, "Enter search term: ");
 
-    FILE *file = fopen(INVENTORY_FILE, "rb");
-    if (file == NULL) {
+    long count;
+    printInventoryHeader(stdout);
+    if (!findInventoryItems(searchTerm, printItemVisitor, stdout, &count)) {
         printf("Error opening file!\n");
-        return;
-    }
-
-    InventoryItem item;
-    int found = 0;
-    printf("\033[1;34m");
-    printf("%-5s %-20s %-30s %-10s %-10s %-10s\n", "ID", "Name", "Description", "Cost", "Price", "Quantity");
-    printf("====================================================================================\n");
-    printf("\033[0m");
-    while (fread(&item, sizeof(InventoryItem), 1, file)) {
-        if (strstr(item.name, searchTerm) || strstr(item.description, searchTerm)) {
-            printf("%-5d %-20s %-30s $%-9.2f $%-9.2f %-10d\n", item.id, item.name, item.description, item.cost, item.price, item.quantity);
-            found = 1;
-        }
-    }
-
-    fclose(file);
-
-    if (!found) {
+    } else if (count == 0) {
         printf("No items found matching the search term.\n");
     }
 }
@@ -217,22 +294,9 @@ void searchInventoryItem() {
  * @return int 1 if item found, 0 otherwise
  */
 int getInventoryItemById(int id, InventoryItem *item) {
-    FILE *file = fopen(INVENTORY_FILE, "rb");
-    if (file == NULL) {
-        printf("Error opening file!\n");
-        return 0;
-    }
-
-    int found = 0;
-    while (fread(item, sizeof(InventoryItem), 1, file)) {
-        if (item->id == id) {
-            found = 1;
-            break;
-        }
-    }
-
-    fclose(file);
-    return found;
+    METRICS_SPAN(METRIC_GET_ITEM);
+    METRICS_SPAN_IDS(id, 0);
+    return tableGetById(TABLE_INVENTORY, id, item, NULL);
 }
 
 /**
@@ -240,40 +304,25 @@ int getInventoryItemById(int id, InventoryItem *item) {
  * @return int The generated unique ID
  */
 int generateUniqueInventoryId() {
-    static int lastId = 0;
-    FILE *file = fopen(INVENTORY_FILE, "rb");
-    if (file != NULL) {
-        InventoryItem item;
-        while (fread(&item, sizeof(InventoryItem), 1, file)) {
-            if (item.id > lastId) {
-                lastId = item.id;
-            }
-        }
-        fclose(file);
-    }
-    return ++lastId;
+    METRICS_SPAN(METRIC_NEW_ITEM_ID);
+    return metaAllocateId(TABLE_INVENTORY);
 }
 
 /**
  * @brief Updates an inventory item by its ID
  * @param item Pointer to the InventoryItem struct with updated information
+ *
+ * The item is locked while its slot is looked up and written, so the write
+ * cannot land between another terminal's stock check and its decrement.
  */
 void updateInventoryItemById(InventoryItem *item) {
-    FILE *file = fopen(INVENTORY_FILE, "rb+");
-    if (file == NULL) {
+    METRICS_SPAN(METRIC_UPDATE_ITEM_BY_ID);
+    METRICS_SPAN_IDS(item->id, 0);
+    if (!recordLock(TABLE_INVENTORY, item->id)) {
         printf("Error opening file!\n");
         return;
     }
-
-    InventoryItem temp;
-    while (fread(&temp, sizeof(InventoryItem), 1, file)) {
-        if (temp.id == item->id) {
-            fseek(file, -sizeof(InventoryItem), SEEK_CUR);
-            fwrite(item, sizeof(InventoryItem), 1, file);
-            break;
-        }
-    }
-
-    fclose(file);
+    tableUpdateById(TABLE_INVENTORY, item);
+    recordUnlock(TABLE_INVENTORY, item->id);
 }
 
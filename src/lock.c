@@ -0,0 +1,179 @@
+/*
+ * =====================================================================================
+ * File: lock.c
+ * Description: Record-level locks that make read-modify-write updates safe when
+ *              several terminals (or sbmsd and a terminal) change the same data.
+ *              Each table has a lock file (e.g. data/inventory.lck) and a record
+ *              is locked by taking an fcntl write lock on its own byte range in
+ *              that file, so updates to different records never wait for each
+ *              other. The range is keyed by record ID rather than slot because
+ *              compaction moves records between slots; the users table has no
+ *              IDs and is keyed by slot.
+ *
+ *              The locks live in a separate file because fcntl locks belong to
+ *              the process and are all dropped when it closes any descriptor of
+ *              the locked file, which the cache and the log do for the data
+ *              files all the time. The lock files stay open for the life of the
+ *              process. fcntl locks do not exclude threads of the same process,
+ *              so a list of held records does that here.
+ *
+ * Author: Chiemezie Agbo
+ * Date: 17-10-2026
+ * Version: 1.0
+ * =====================================================================================
+ */
+
+#define _DEFAULT_SOURCE
+#include "../include/lock.h"
+#include "../include/metrics.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+
+typedef struct HeldRecord {
+    TableId table;
+    long key;
+    struct HeldRecord *next;
+} HeldRecord;
+
+static struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t released;
+    HeldRecord *held;
+    int fds[TABLE_COUNT];
+    int initialized;
+} locks = {PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, NULL, {0}, 0};
+
+/**
+ * @brief Forgets the records held by the parent in a forked child
+ *
+ * The child does not own its parent's fcntl locks, and the threads that
+ * would release the list entries do not exist in it.
+ */
+static void resetAfterFork(void) {
+    pthread_mutex_init(&locks.mutex, NULL);
+    pthread_cond_init(&locks.released, NULL);
+    while (locks.held != NULL) {
+        HeldRecord *next = locks.held->next;
+        free(locks.held);
+        locks.held = next;
+    }
+}
+
+/**
+ * @brief Returns the lock file descriptor of a table, opening it on first use
+ * @return int The descriptor, -1 if the lock file cannot be opened
+ *
+ * Must be called with locks.mutex held.
+ */
+static int lockFd(TableId table) {
+    if (!locks.initialized) {
+        for (int t = 0; t < TABLE_COUNT; t++) {
+            locks.fds[t] = -1;
+        }
+        pthread_atfork(NULL, NULL, resetAfterFork);
+        locks.initialized = 1;
+    }
+    if (locks.fds[table] < 0) {
+        locks.fds[table] = ioOpen(getTableDef(table)->lockFile, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    }
+    return locks.fds[table];
+}
+
+static int isHeld(TableId table, long key) {
+    for (HeldRecord *record = locks.held; record != NULL; record = record->next) {
+        if (record->table == table && record->key == key) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void forget(TableId table, long key) {
+    pthread_mutex_lock(&locks.mutex);
+    for (HeldRecord **link = &locks.held; *link != NULL; link = &(*link)->next) {
+        if ((*link)->table == table && (*link)->key == key) {
+            HeldRecord *record = *link;
+            *link = record->next;
+            free(record);
+            break;
+        }
+    }
+    pthread_cond_broadcast(&locks.released);
+    pthread_mutex_unlock(&locks.mutex);
+}
+
+static int lockRange(int fd, TableId table, long key, short type) {
+    size_t recordSize = getTableDef(table)->recordSize;
+    struct flock fl;
+    memset(&fl, 0, sizeof(fl));
+    fl.l_type = type;
+    fl.l_whence = SEEK_SET;
+    fl.l_start = (off_t)key * (off_t)recordSize;
+    fl.l_len = (off_t)recordSize;
+    while (fcntl(fd, type == F_UNLCK ? F_SETLK : F_SETLKW, &fl) == -1) {
+        if (errno != EINTR) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * @brief Locks one record against updates from other processes and threads
+ * @param table The table the record belongs to
+ * @param key The record ID, or the slot for the users table
+ * @return int 1 once the lock is held, 0 if it could not be taken
+ *
+ * Blocks while another holder has the record. Callers holding several
+ * records must lock them in ascending key order.
+ */
+int recordLock(TableId table, long key) {
+    HeldRecord *record = malloc(sizeof(*record));
+    if (record == NULL) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&locks.mutex);
+    while (isHeld(table, key)) {
+        pthread_cond_wait(&locks.released, &locks.mutex);
+    }
+    int fd = lockFd(table);
+    if (fd < 0) {
+        pthread_mutex_unlock(&locks.mutex);
+        free(record);
+        return 0;
+    }
+    record->table = table;
+    record->key = key;
+    record->next = locks.held;
+    locks.held = record;
+    pthread_mutex_unlock(&locks.mutex);
+
+    // Wait for other processes without blocking this process's other records
+    if (!lockRange(fd, table, key, F_WRLCK)) {
+        forget(table, key);
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief Releases a record locked with recordLock
+ * @param table The table the record belongs to
+ * @param key The key the record was locked with
+ */
+void recordUnlock(TableId table, long key) {
+    pthread_mutex_lock(&locks.mutex);
+    int fd = locks.initialized ? locks.fds[table] : -1;
+    pthread_mutex_unlock(&locks.mutex);
+
+    if (fd >= 0) {
+        lockRange(fd, table, key, F_UNLCK);
+    }
+    forget(table, key);
+}
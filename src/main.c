@@ -4,7 +4,9 @@
  * Description: Contains the main entry point for the Small Business Management 
  *              System (SBMS), enabling users to manage inventory, orders, 
  *              customers, finances, and system settings. It includes an admin 
- *              interface for managing users and settings.
+ *              interface for managing users and settings. While an sbmsd
+ *              server is running, the menus send their actions to it instead
+ *              of opening the data files (see client.c).
  *
  * Author: Chiemezie Agbo
  * Date: 20-12-2024
@@ -24,9 +26,14 @@
 #include "../include/orders.h"
 #include "../include/customers.h"
 #include "../include/financial.h"
+#include "../include/table.h"
+#include "../include/wal.h"
 #include "../include/utils.h"
-
-#define USERS_FILE "data/users.dat"
+#include "../include/command.h"
+#include "../include/metrics.h"
+#include "../include/slowlog.h"
+#include "../include/server.h"
+#include "../include/client.h"
 
 #define CLEAR_SCREEN() printf("\033[H\033[J")
 
@@ -83,9 +90,28 @@ void displayLoadingAnimation() {
 
 /**
  * @brief The main function of the application
+ * @param argc Number of command line arguments
+ * @param argv Command line arguments; any at all select the headless command mode
  * @return int 0 on successful execution
  */
-int main(void) {
+int main(int argc, char *argv[]) {
+    // Before the log starts its thread, so SIGUSR1 stays blocked everywhere else
+    metricsStartSignalDump();
+    slowLogStart();
+
+    if (argc > 1) {
+        return commandMain(argc, argv);
+    }
+
+    // A running sbmsd owns the data files, so the menus only talk to it
+    const char *socketPath = getenv("SBMS_SOCKET");
+    ServerClient client;
+    if (serverConnect(socketPath != NULL ? socketPath : SERVER_SOCKET_FILE, &client)) {
+        int ok = clientSession(&client);
+        serverDisconnect(&client);
+        return ok ? 0 : 1;
+    }
+
     initializeSystem();
     
     char username[MAX_USERNAME_LENGTH];
@@ -93,17 +119,7 @@ int main(void) {
     int login_status = 0;
 
     // Create default admin user if it doesn't exist
-    FILE *file = fopen(USERS_FILE, "rb");
-    if (file == NULL) {
-        file = fopen(USERS_FILE, "wb");
-        if (file != NULL) {
-            User admin = {"admin", "0000", 1};
-            fwrite(&admin, sizeof(User), 1, file);
-            fclose(file);
-        }
-    } else {
-        fclose(file);
-    }
+    ensureDefaultAdmin();
 
     while (login_status == 0) {
         validateStringInput(username, MAX_USERNAME_LENGTH, "Enter username: ");
@@ -151,12 +167,14 @@ int main(void) {
                 changePassword(username);
                 break;
             case 7:
+                walCheckpoint();
                 printf("Thank you for using SBMS. Goodbye!\n");
                 break;
             default:
                 printf("Invalid choice. Please try again.\n");
         }
         if (choice != 7) {
+            walCompact();
             printf("Press Enter to continue...");
             getchar();
             getchar();
@@ -0,0 +1,301 @@
+/*
+ * =====================================================================================
+ * File: match.c
+ * Description: Substring matching over the fixed-width text fields of records
+ *              (char[MAX_NAME_LENGTH], char[MAX_DESCRIPTION_LENGTH], ...). Instead
+ *              of strstr's byte-at-a-time search, a field is compared 16 (SSE2)
+ *              or 32 (AVX2) positions at a time against the first and the last
+ *              byte of the term, and only positions where both agree are checked
+ *              with memcmp. Because the fields have a fixed width, whole vectors
+ *              can be loaded up to the end of the field without running off the
+ *              record. The AVX2 kernel is picked at run time when the CPU has
+ *              it; other machines use the SSE2 or the plain C kernel.
+ *
+ * Author: Chiemezie Agbo
+ * Date: 17-10-2026
+ * Version: 1.0
+ * =====================================================================================
+ */
+
+#include "../include/match.h"
+#include <string.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define MATCH_X86 1
+#endif
+
+/* Scans a block of records; one implementation per instruction set */
+typedef long (*MatchKernel)(const char *records, long count, size_t recordSize, const MatchField *fields,
+                            int fieldCount, const char *needle, size_t needleLength, unsigned char *hits);
+
+/* The middle of a candidate, whose first and last bytes already matched */
+static inline int middleMatches(const char *text, const char *needle, size_t needleLength) {
+    for (size_t i = 1; i + 1 < needleLength; i++) {
+        if (text[i] != needle[i]) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * @brief Checks the candidate positions flagged in a bit mask
+ * @return int 1 if the term starts at one of them, 0 otherwise
+ */
+static inline int checkCandidates(unsigned mask, const char *text, const char *needle, size_t needleLength) {
+    while (mask != 0) {
+        if (middleMatches(text + __builtin_ctz(mask), needle, needleLength)) {
+            return 1;
+        }
+        mask &= mask - 1;
+    }
+    return 0;
+}
+
+static int scalarField(const char *field, size_t width, const char *needle, size_t needleLength) {
+    char first = needle[0], last = needle[needleLength - 1];
+    for (size_t i = 0; i + needleLength <= width && field[i] != '\0'; i++) {
+        // The term holds no NUL, so a candidate running past the text fails here
+        if (field[i] == first && field[i + needleLength - 1] == last &&
+            middleMatches(field + i, needle, needleLength)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static long scalarKernel(const char *records, long count, size_t recordSize, const MatchField *fields,
+                         int fieldCount, const char *needle, size_t needleLength, unsigned char *hits) {
+    long flagged = 0;
+    for (long r = 0; r < count; r++, records += recordSize) {
+        int hit = 0;
+        for (int f = 0; f < fieldCount && !hit; f++) {
+            hit = scalarField(records + fields[f].offset, fields[f].width, needle, needleLength);
+        }
+        hits[r] = (unsigned char)hit;
+        flagged += hit;
+    }
+    return flagged;
+}
+
+#ifdef MATCH_X86
+/**
+ * @brief Tests 16 start positions at once
+ * @param skip Positions at the front already tested by an earlier, overlapping block
+ * @return int 1 on a match, 0 on none, -1 if the text ends within the block
+ */
+static inline int sse2Block(const char *text, size_t needleLength, __m128i first, __m128i last,
+                            const char *needle, unsigned skip) {
+    __m128i head = _mm_loadu_si128((const __m128i *)text);
+    __m128i tail = _mm_loadu_si128((const __m128i *)(text + needleLength - 1));
+    unsigned mask = (unsigned)_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(head, first), _mm_cmpeq_epi8(tail, last)));
+    unsigned end = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(head, _mm_setzero_si128()));
+    mask &= ~0u << skip;
+    if (end != 0) {
+        // Only positions before the NUL can start a match
+        return checkCandidates(mask & ((end & -end) - 1), text, needle, needleLength) ? 1 : -1;
+    }
+    return checkCandidates(mask, text, needle, needleLength);
+}
+
+static inline int sse2Field(const char *field, size_t width, const char *needle, size_t needleLength,
+                            __m128i first, __m128i last) {
+    if (width < needleLength + 15) {
+        return scalarField(field, width, needle, needleLength);
+    }
+
+    // Both loads of a block stay inside the field; the last block overlaps the one before it
+    size_t starts = width - needleLength + 1;
+    size_t i = 0;
+    for (; i + 16 <= starts; i += 16) {
+        int result = sse2Block(field + i, needleLength, first, last, needle, 0);
+        if (result != 0) {
+            return result > 0;
+        }
+    }
+    if (i < starts) {
+        size_t from = starts - 16;
+        return sse2Block(field + from, needleLength, first, last, needle, (unsigned)(i - from)) > 0;
+    }
+    return 0;
+}
+
+static long sse2Kernel(const char *records, long count, size_t recordSize, const MatchField *fields,
+                       int fieldCount, const char *needle, size_t needleLength, unsigned char *hits) {
+    const __m128i first = _mm_set1_epi8(needle[0]);
+    const __m128i last = _mm_set1_epi8(needle[needleLength - 1]);
+    long flagged = 0;
+    for (long r = 0; r < count; r++, records += recordSize) {
+        int hit = 0;
+        for (int f = 0; f < fieldCount && !hit; f++) {
+            hit = sse2Field(records + fields[f].offset, fields[f].width, needle, needleLength, first, last);
+        }
+        hits[r] = (unsigned char)hit;
+        flagged += hit;
+    }
+    return flagged;
+}
+
+__attribute__((target("avx2")))
+static inline int avx2Block(const char *text, size_t needleLength, __m256i first, __m256i last,
+                            const char *needle, unsigned skip) {
+    __m256i head = _mm256_loadu_si256((const __m256i *)text);
+    __m256i tail = _mm256_loadu_si256((const __m256i *)(text + needleLength - 1));
+    unsigned mask = (unsigned)_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(head, first), _mm256_cmpeq_epi8(tail, last)));
+    unsigned end = (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(head, _mm256_setzero_si256()));
+    mask &= ~0u << skip;
+    if (end != 0) {
+        return checkCandidates(mask & ((end & -end) - 1), text, needle, needleLength) ? 1 : -1;
+    }
+    return checkCandidates(mask, text, needle, needleLength);
+}
+
+__attribute__((target("avx2")))
+static inline int avx2Field(const char *field, size_t width, const char *needle, size_t needleLength,
+                            __m256i first, __m256i last) {
+    if (width < needleLength + 31) {
+        return sse2Field(field, width, needle, needleLength, _mm256_castsi256_si128(first), _mm256_castsi256_si128(last));
+    }
+
+    size_t starts = width - needleLength + 1;
+    size_t i = 0;
+    for (; i + 32 <= starts; i += 32) {
+        int result = avx2Block(field + i, needleLength, first, last, needle, 0);
+        if (result != 0) {
+            return result > 0;
+        }
+    }
+    if (i < starts) {
+        size_t from = starts - 32;
+        return avx2Block(field + from, needleLength, first, last, needle, (unsigned)(i - from)) > 0;
+    }
+    return 0;
+}
+
+__attribute__((target("avx2")))
+static long avx2Kernel(const char *records, long count, size_t recordSize, const MatchField *fields,
+                       int fieldCount, const char *needle, size_t needleLength, unsigned char *hits) {
+    const __m256i first = _mm256_set1_epi8(needle[0]);
+    const __m256i last = _mm256_set1_epi8(needle[needleLength - 1]);
+    long flagged = 0;
+    for (long r = 0; r < count; r++, records += recordSize) {
+        int hit = 0;
+        for (int f = 0; f < fieldCount && !hit; f++) {
+            hit = avx2Field(records + fields[f].offset, fields[f].width, needle, needleLength, first, last);
+        }
+        hits[r] = (unsigned char)hit;
+        flagged += hit;
+    }
+    return flagged;
+}
+#endif
+
+typedef struct {
+    const char *name;
+    MatchKernel kernel;
+} MatchKernelDef;
+
+/* Fastest first */
+static const MatchKernelDef kernels[] = {
+#ifdef MATCH_X86
+    {"avx2", avx2Kernel},
+    {"sse2", sse2Kernel},
+#endif
+    {"scalar", scalarKernel},
+};
+
+static const MatchKernelDef *selected;
+
+static int kernelSupported(const MatchKernelDef *def) {
+#ifdef MATCH_X86
+    if (def->kernel == avx2Kernel) {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+    }
+#endif
+    (void)def;
+    return 1;
+}
+
+static MatchKernel selectKernel(void) {
+    if (selected == NULL) {
+        const MatchKernelDef *def = kernels;
+        while (!kernelSupported(def)) {
+            def++;
+        }
+        selected = def;
+    }
+    return selected->kernel;
+}
+
+/**
+ * @brief Returns the name of the kernel in use
+ */
+const char *matchKernelName(void) {
+    selectKernel();
+    return selected->name;
+}
+
+/**
+ * @brief Forces a kernel, so benchmarks and tests can compare them
+ * @param name "avx2", "sse2" or "scalar"; NULL goes back to the fastest one
+ * @return int 1 if the kernel exists and this CPU can run it, 0 otherwise
+ */
+int matchSetKernel(const char *name) {
+    if (name == NULL) {
+        selected = NULL;
+        return 1;
+    }
+    for (size_t i = 0; i < sizeof(kernels) / sizeof(kernels[0]); i++) {
+        if (strcmp(kernels[i].name, name) == 0 && kernelSupported(&kernels[i])) {
+            selected = &kernels[i];
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Tells whether a fixed-width, NUL-terminated field contains a term
+ * @param field The field; all width bytes must be readable
+ * @param width The size of the field
+ * @param needle The term to look for
+ * @param needleLength The length of the term
+ * @return int 1 if the text before the field's NUL contains the term, 0 otherwise
+ *
+ * Gives the same answer as strstr(field, needle) != NULL.
+ */
+int fieldContains(const char *field, size_t width, const char *needle, size_t needleLength) {
+    if (needleLength == 0) {
+        return 1;
+    }
+    MatchField whole = {0, width};
+    unsigned char hit;
+    return (int)selectKernel()(field, 1, width, &whole, 1, needle, needleLength, &hit);
+}
+
+/**
+ * @brief Flags the records of a block where any of the given fields contains a term
+ * @param records The first record of the block
+ * @param count The number of records in the block
+ * @param recordSize The size of one record
+ * @param fields The text fields to search
+ * @param fieldCount The number of fields
+ * @param needle The NUL-terminated term to look for
+ * @param hits Output, one flag per record: 1 on a match, 0 otherwise
+ * @return long The number of records flagged
+ *
+ * The term's first and last bytes are broadcast once for the whole block.
+ * A record's later fields are skipped once one matches. Deleted records are
+ * not skipped; callers check IDs themselves.
+ */
+long matchRecords(const void *records, long count, size_t recordSize, const MatchField *fields, int fieldCount,
+                  const char *needle, unsigned char *hits) {
+    size_t needleLength = strlen(needle);
+    if (needleLength == 0) {
+        memset(hits, 1, (size_t)count);
+        return count;
+    }
+    return selectKernel()(records, count, recordSize, fields, fieldCount, needle, needleLength, hits);
+}
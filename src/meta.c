@@ -0,0 +1,215 @@
+/*
+ * =====================================================================================
+ * File: meta.c
+ * Description: Reads and writes the small per-table metadata files
+ *              (e.g. data/inventory.meta). The metadata holds the next ID to hand
+ *              out for the table and how many tombstoned records it contains, so
+ *              inserts never scan the table for the highest ID and compaction can
+ *              tell when it is worth rewriting the data file.
+ *
+ *              Every read-modify-write of a metadata file happens under an fcntl
+ *              write lock on that file (plus a mutex for threads of the same
+ *              process), so concurrent terminals never receive the same ID.
+ *
+ * Author: Chiemezie Agbo
+ * Date: 17-10-2026
+ * Version: 1.0
+ * =====================================================================================
+ */
+
+#define _DEFAULT_SOURCE
+#include "../include/meta.h"
+#include "../include/cache.h"
+#include "../include/metrics.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#define META_MAGIC 0x4154454Du /* "META" */
+#define META_VERSION 2
+
+static pthread_mutex_t metaMutex = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * @brief Returns one more than the highest ID ever stored in a table
+ *
+ * Tombstones keep their negated ID, so deleted IDs are never handed out again.
+ */
+static int32_t scanNextId(TableId table) {
+    const TableDef *def = getTableDef(table);
+    long count;
+    const char *records = cacheTable(table, &count);
+
+    int32_t maxId = 0;
+    for (long slot = 0; slot < count; slot++) {
+        int id = abs(recordId(records + (size_t)slot * def->recordSize));
+        if (id > maxId) {
+            maxId = id;
+        }
+    }
+    return maxId + 1;
+}
+
+static int lockMetaFile(int fd, short type) {
+    struct flock fl;
+    memset(&fl, 0, sizeof(fl));
+    fl.l_type = type;
+    fl.l_whence = SEEK_SET;
+    while (fcntl(fd, F_SETLKW, &fl) == -1) {
+        if (errno != EINTR) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void defaultMeta(TableMeta *meta) {
+    memset(meta, 0, sizeof(*meta));
+    meta->magic = META_MAGIC;
+    meta->version = META_VERSION;
+}
+
+static int readMetaFd(int fd, TableMeta *meta) {
+    TableMeta stored;
+    defaultMeta(meta);
+    if (ioPread(fd, &stored, sizeof(stored), 0) != (ssize_t)sizeof(stored) ||
+        stored.magic != META_MAGIC || stored.version != META_VERSION) {
+        return 0;
+    }
+    *meta = stored;
+    return 1;
+}
+
+/**
+ * @brief Opens and locks a table's metadata file for a read-modify-write
+ * @return int File descriptor, -1 on failure
+ */
+static int beginUpdate(TableId table, TableMeta *meta) {
+    pthread_mutex_lock(&metaMutex);
+    int fd = ioOpen(getTableDef(table)->metaFile, O_RDWR | O_CREAT, 0644);
+    if (fd < 0 || !lockMetaFile(fd, F_WRLCK)) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        pthread_mutex_unlock(&metaMutex);
+        return -1;
+    }
+    readMetaFd(fd, meta);
+    return fd;
+}
+
+static int endUpdate(int fd, const TableMeta *meta) {
+    int ok = ioPwrite(fd, meta, sizeof(*meta), 0) == (ssize_t)sizeof(*meta);
+    lockMetaFile(fd, F_UNLCK);
+    close(fd);
+    pthread_mutex_unlock(&metaMutex);
+    return ok;
+}
+
+/**
+ * @brief Reads a table's metadata
+ * @param table The table
+ * @param meta Output for the metadata
+ * @return int 1 if the metadata file was read, 0 if defaults were returned
+ */
+int metaRead(TableId table, TableMeta *meta) {
+    int fd = ioOpen(getTableDef(table)->metaFile, O_RDONLY);
+    if (fd < 0) {
+        defaultMeta(meta);
+        return 0;
+    }
+
+    int ok = readMetaFd(fd, meta);
+    close(fd);
+    return ok;
+}
+
+/**
+ * @brief Sets the number of tombstoned records recorded for a table
+ * @param table The table
+ * @param deadCount The number of dead records
+ * @return int 1 on success, 0 otherwise
+ */
+int metaSetDead(TableId table, int64_t deadCount) {
+    TableMeta meta;
+    int fd = beginUpdate(table, &meta);
+    if (fd < 0) {
+        return 0;
+    }
+
+    meta.deadCount = deadCount;
+    return endUpdate(fd, &meta);
+}
+
+/**
+ * @brief Adjusts the number of tombstoned records recorded for a table
+ * @param table The table
+ * @param delta The change in dead records
+ * @return int 1 on success, 0 otherwise
+ */
+int metaAddDead(TableId table, int64_t delta) {
+    TableMeta meta;
+    int fd = beginUpdate(table, &meta);
+    if (fd < 0) {
+        return 0;
+    }
+
+    meta.deadCount += delta;
+    if (meta.deadCount < 0) {
+        meta.deadCount = 0;
+    }
+    return endUpdate(fd, &meta);
+}
+
+/**
+ * @brief Hands out the next unused ID for a table
+ * @param table The table
+ * @return int The new ID, 0 on failure
+ *
+ * The counter is seeded from the table the first time, after that an
+ * allocation is a single locked read and write of the metadata file.
+ */
+int metaAllocateId(TableId table) {
+    TableMeta meta;
+    int fd = beginUpdate(table, &meta);
+    if (fd < 0) {
+        return 0;
+    }
+
+    if (meta.nextId <= 0) {
+        meta.nextId = scanNextId(table);
+    }
+    int id = (int)meta.nextId++;
+    return endUpdate(fd, &meta) ? id : 0;
+}
+
+/**
+ * @brief Re-derives a table's metadata from its data file
+ * @param table The table
+ * @return int 1 on success, 0 otherwise
+ *
+ * Used after the data file was replaced, e.g. by a restore.
+ */
+int metaReset(TableId table) {
+    const TableDef *def = getTableDef(table);
+    TableMeta meta;
+    int fd = beginUpdate(table, &meta);
+    if (fd < 0) {
+        return 0;
+    }
+
+    long count;
+    const char *records = cacheTable(table, &count);
+    meta.deadCount = 0;
+    for (long slot = 0; slot < count; slot++) {
+        if (recordId(records + (size_t)slot * def->recordSize) <= 0) {
+            meta.deadCount++;
+        }
+    }
+    meta.nextId = def->indexFile != NULL ? scanNextId(table) : 0;
+    return endUpdate(fd, &meta);
+}
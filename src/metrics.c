@@ -0,0 +1,476 @@
+/*
+ * =====================================================================================
+ * File: metrics.c
+ * Description: Per-operation latency histograms and I/O accounting. Every public
+ *              operation in inventory.c, orders.c, customers.c, financial.c and
+ *              admin.c opens a span (METRICS_SPAN) that, when the operation
+ *              returns, adds its wall time and the I/O it did to the totals of
+ *              that operation. Operations that prompt start their span once the
+ *              input has been read, so typing time is not counted.
+ *
+ *              The storage modules read and write through the io* wrappers
+ *              below, which count file opens and bytes in per-thread counters;
+ *              scans of the memory-mapped tables and derived files count the
+ *              records they visit. A span records the difference between the
+ *              counters at its start and end, so background threads (the log
+ *              checkpoint) are never charged to an operation, while the work of
+ *              a nested operation is included in its caller's.
+ *
+ *              Latencies go into HDR-style histograms: exact below 32 ns, then
+ *              16 linear sub-buckets per power of two, so any quantile is within
+ *              1/16 of the true value. Updates are relaxed atomic adds and take
+ *              no lock.
+ *
+ *              metricsWrite prints everything in the Prometheus text format. The
+ *              admin menu shows it and saves it to data/metrics.prom, which
+ *              sbms and sbmsd also rewrite whenever they receive SIGUSR1.
+ *              Calls slower than a threshold are also handed to the slow-
+ *              operation log (slowlog.c).
+ *
+ * Author: Chiemezie Agbo
+ * Date: 17-10-2026
+ * Version: 1.0
+ * =====================================================================================
+ */
+
+#define _DEFAULT_SOURCE
+#include "../include/metrics.h"
+#include "../include/slowlog.h"
+#include "../include/common.h"
+#include "../include/utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <signal.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+
+#define SUB_BUCKET_BITS 4
+#define SUB_BUCKETS (1 << SUB_BUCKET_BITS)
+#define MAX_EXPONENT 44 /* 2^45 ns is almost ten hours */
+#define BUCKET_COUNT ((MAX_EXPONENT - SUB_BUCKET_BITS + 2) * SUB_BUCKETS)
+
+typedef struct {
+    _Atomic uint64_t count;
+    _Atomic uint64_t totalNs;
+    _Atomic uint64_t maxNs;
+    _Atomic uint64_t recordsScanned;
+    _Atomic uint64_t bytesRead;
+    _Atomic uint64_t bytesWritten;
+    _Atomic uint64_t fileOpens;
+    _Atomic uint64_t buckets[BUCKET_COUNT];
+} OpStats;
+
+static const char *opNames[METRIC_COUNT] = {
+    [METRIC_ADD_ITEM] = "add_item",
+    [METRIC_UPDATE_ITEM] = "update_item",
+    [METRIC_DELETE_ITEM] = "delete_item",
+    [METRIC_VIEW_ITEMS] = "view_items",
+    [METRIC_SEARCH_ITEMS] = "search_items",
+    [METRIC_GET_ITEM] = "get_item",
+    [METRIC_NEW_ITEM_ID] = "new_item_id",
+    [METRIC_UPDATE_ITEM_BY_ID] = "update_item_by_id",
+    [METRIC_PLACE_ORDER] = "place_order",
+    [METRIC_PLACE_ORDER_BATCH] = "place_order_batch",
+    [METRIC_COMMIT_ORDER] = "commit_order",
+    [METRIC_UPDATE_ORDER_STATUS] = "update_order_status",
+    [METRIC_VIEW_ORDERS] = "view_orders",
+    [METRIC_SEARCH_ORDER] = "search_order",
+    [METRIC_GET_ORDER] = "get_order",
+    [METRIC_NEW_ORDER_ID] = "new_order_id",
+    [METRIC_ADD_CUSTOMER] = "add_customer",
+    [METRIC_UPDATE_CUSTOMER] = "update_customer",
+    [METRIC_DELETE_CUSTOMER] = "delete_customer",
+    [METRIC_VIEW_CUSTOMERS] = "view_customers",
+    [METRIC_SEARCH_CUSTOMERS] = "search_customers",
+    [METRIC_GET_CUSTOMER] = "get_customer",
+    [METRIC_NEW_CUSTOMER_ID] = "new_customer_id",
+    [METRIC_SALES_REPORT] = "sales_report",
+    [METRIC_PROFIT_REPORT] = "profit_report",
+    [METRIC_PROFIT_SUMMARY] = "profit_summary",
+    [METRIC_INVENTORY_VALUE] = "inventory_value",
+    [METRIC_PRODUCT_REPORT] = "product_report",
+    [METRIC_ADD_USER] = "add_user",
+    [METRIC_VIEW_USERS] = "view_users",
+    [METRIC_CHANGE_PASSWORD] = "change_password",
+    [METRIC_LOGIN] = "login",
+    [METRIC_BACKUP] = "backup",
+    [METRIC_RESTORE] = "restore",
+    [METRIC_RESTORE_TO_POINT] = "restore_to_point",
+    [METRIC_STORAGE_STATS] = "storage_stats",
+    [METRIC_REBUILD_REPORT_DATA] = "rebuild_report_data",
+};
+
+static OpStats opStats[METRIC_COUNT];
+static _Thread_local IoCounters ioCounters;
+
+static uint64_t nowNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static int bucketIndex(uint64_t ns) {
+    if (ns < 2 * SUB_BUCKETS) {
+        return (int)ns;
+    }
+    int exponent = 63 - __builtin_clzll(ns);
+    if (exponent > MAX_EXPONENT) {
+        return BUCKET_COUNT - 1;
+    }
+    int shift = exponent - SUB_BUCKET_BITS;
+    return (shift + 1) * SUB_BUCKETS + (int)((ns >> shift) - SUB_BUCKETS);
+}
+
+/* The largest latency that falls into a bucket */
+static uint64_t bucketLimit(int index) {
+    if (index < 2 * SUB_BUCKETS) {
+        return (uint64_t)index;
+    }
+    int shift = index / SUB_BUCKETS - 1;
+    uint64_t mantissa = (uint64_t)(SUB_BUCKETS + index % SUB_BUCKETS);
+    return ((mantissa + 1) << shift) - 1;
+}
+
+/**
+ * @brief Starts timing one call of an operation
+ * @param op The operation
+ * @return MetricSpan The span to pass to metricsEnd
+ */
+MetricSpan metricsBegin(MetricOp op) {
+    MetricSpan span = {op, nowNs(), ioCounters, {0, 0}, NULL, NULL};
+    return span;
+}
+
+/**
+ * @brief Adds a finished call to its operation's histogram and totals
+ * @param span The span returned by metricsBegin on this thread
+ */
+void metricsEnd(MetricSpan *span) {
+    IoCounters io = {
+        ioCounters.recordsScanned - span->io.recordsScanned,
+        ioCounters.bytesRead - span->io.bytesRead,
+        ioCounters.bytesWritten - span->io.bytesWritten,
+        ioCounters.fileOpens - span->io.fileOpens,
+    };
+    uint64_t nanoseconds = nowNs() - span->startNs;
+    metricsRecord(span->op, nanoseconds, &io);
+    slowLogNote(span, nanoseconds, &io);
+}
+
+/**
+ * @brief Adds one call of an operation
+ * @param op The operation
+ * @param nanoseconds How long the call took
+ * @param io The I/O the call did
+ */
+void metricsRecord(MetricOp op, uint64_t nanoseconds, const IoCounters *io) {
+    OpStats *stats = &opStats[op];
+    atomic_fetch_add_explicit(&stats->count, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&stats->totalNs, nanoseconds, memory_order_relaxed);
+    atomic_fetch_add_explicit(&stats->buckets[bucketIndex(nanoseconds)], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&stats->recordsScanned, io->recordsScanned, memory_order_relaxed);
+    atomic_fetch_add_explicit(&stats->bytesRead, io->bytesRead, memory_order_relaxed);
+    atomic_fetch_add_explicit(&stats->bytesWritten, io->bytesWritten, memory_order_relaxed);
+    atomic_fetch_add_explicit(&stats->fileOpens, io->fileOpens, memory_order_relaxed);
+
+    uint64_t max = atomic_load_explicit(&stats->maxNs, memory_order_relaxed);
+    while (nanoseconds > max &&
+           !atomic_compare_exchange_weak_explicit(&stats->maxNs, &max, nanoseconds, memory_order_relaxed,
+                                                  memory_order_relaxed)) {
+    }
+}
+
+/**
+ * @brief Returns the name an operation is reported under, e.g. "place_order"
+ */
+const char *metricsName(MetricOp op) {
+    return opNames[op];
+}
+
+/**
+ * @brief Reads the totals of an operation
+ * @param op The operation
+ * @param totals Output for the number of calls, their time and their I/O
+ */
+void metricsGet(MetricOp op, MetricTotals *totals) {
+    OpStats *stats = &opStats[op];
+    totals->count = atomic_load_explicit(&stats->count, memory_order_relaxed);
+    totals->totalNs = atomic_load_explicit(&stats->totalNs, memory_order_relaxed);
+    totals->maxNs = atomic_load_explicit(&stats->maxNs, memory_order_relaxed);
+    totals->io.recordsScanned = atomic_load_explicit(&stats->recordsScanned, memory_order_relaxed);
+    totals->io.bytesRead = atomic_load_explicit(&stats->bytesRead, memory_order_relaxed);
+    totals->io.bytesWritten = atomic_load_explicit(&stats->bytesWritten, memory_order_relaxed);
+    totals->io.fileOpens = atomic_load_explicit(&stats->fileOpens, memory_order_relaxed);
+}
+
+/**
+ * @brief Returns a latency quantile of an operation from its histogram
+ * @param op The operation
+ * @param quantile Between 0 and 1, e.g. 0.99
+ * @return uint64_t Nanoseconds, at most 1/16 above the exact value; 0 if never called
+ */
+uint64_t metricsQuantile(MetricOp op, double quantile) {
+    OpStats *stats = &opStats[op];
+    uint64_t counts[BUCKET_COUNT];
+    uint64_t total = 0;
+    for (int i = 0; i < BUCKET_COUNT; i++) {
+        counts[i] = atomic_load_explicit(&stats->buckets[i], memory_order_relaxed);
+        total += counts[i];
+    }
+    if (total == 0) {
+        return 0;
+    }
+
+    // Nearest rank: the smallest latency that at least this share of the calls did not exceed
+    uint64_t rank = (uint64_t)(quantile * (double)total + 0.999999);
+    rank = rank < 1 ? 1 : rank > total ? total : rank;
+    uint64_t seen = 0;
+    for (int i = 0; i < BUCKET_COUNT; i++) {
+        seen += counts[i];
+        if (seen >= rank) {
+            uint64_t max = atomic_load_explicit(&stats->maxNs, memory_order_relaxed);
+            uint64_t limit = bucketLimit(i);
+            return limit < max ? limit : max;
+        }
+    }
+    return bucketLimit(BUCKET_COUNT - 1);
+}
+
+/**
+ * @brief Clears every histogram and total
+ */
+void metricsReset(void) {
+    for (int op = 0; op < METRIC_COUNT; op++) {
+        OpStats *stats = &opStats[op];
+        atomic_store_explicit(&stats->count, 0, memory_order_relaxed);
+        atomic_store_explicit(&stats->totalNs, 0, memory_order_relaxed);
+        atomic_store_explicit(&stats->maxNs, 0, memory_order_relaxed);
+        atomic_store_explicit(&stats->recordsScanned, 0, memory_order_relaxed);
+        atomic_store_explicit(&stats->bytesRead, 0, memory_order_relaxed);
+        atomic_store_explicit(&stats->bytesWritten, 0, memory_order_relaxed);
+        atomic_store_explicit(&stats->fileOpens, 0, memory_order_relaxed);
+        for (int i = 0; i < BUCKET_COUNT; i++) {
+            atomic_store_explicit(&stats->buckets[i], 0, memory_order_relaxed);
+        }
+    }
+}
+
+static void writeCounter(FILE *out, const char *name, const char *help, size_t field) {
+    fprintf(out, "# HELP sbms_operation_%s %s\n# TYPE sbms_operation_%s counter\n", name, help, name);
+    for (int op = 0; op < METRIC_COUNT; op++) {
+        MetricTotals totals;
+        metricsGet((MetricOp)op, &totals);
+        if (totals.count > 0) {
+            uint64_t value;
+            memcpy(&value, (const char *)&totals.io + field, sizeof(value));
+            fprintf(out, "sbms_operation_%s{op=\"%s\"} %llu\n", name, opNames[op], (unsigned long long)value);
+        }
+    }
+}
+
+/**
+ * @brief Prints the metrics of every operation called so far in the Prometheus text format
+ * @param out Where to print
+ * @return int 1 on success, 0 if writing failed
+ *
+ * Latencies are a summary (quantiles, sum and count) plus the maximum; the
+ * I/O totals are counters. Operations never called are left out.
+ */
+int metricsWrite(FILE *out) {
+    static const double quantiles[] = {0.5, 0.9, 0.99, 0.999};
+
+    fprintf(out, "# HELP sbms_operation_duration_seconds Wall time of each call of an operation\n");
+    fprintf(out, "# TYPE sbms_operation_duration_seconds summary\n");
+    for (int op = 0; op < METRIC_COUNT; op++) {
+        MetricTotals totals;
+        metricsGet((MetricOp)op, &totals);
+        if (totals.count == 0) {
+            continue;
+        }
+        for (size_t q = 0; q < sizeof(quantiles) / sizeof(quantiles[0]); q++) {
+            fprintf(out, "sbms_operation_duration_seconds{op=\"%s\",quantile=\"%g\"} %.9f\n", opNames[op],
+                    quantiles[q], (double)metricsQuantile((MetricOp)op, quantiles[q]) / 1e9);
+        }
+        fprintf(out, "sbms_operation_duration_seconds_sum{op=\"%s\"} %.9f\n", opNames[op],
+                (double)totals.totalNs / 1e9);
+        fprintf(out, "sbms_operation_duration_seconds_count{op=\"%s\"} %llu\n", opNames[op],
+                (unsigned long long)totals.count);
+    }
+
+    fprintf(out, "# HELP sbms_operation_duration_max_seconds Slowest call of an operation\n");
+    fprintf(out, "# TYPE sbms_operation_duration_max_seconds gauge\n");
+    for (int op = 0; op < METRIC_COUNT; op++) {
+        MetricTotals totals;
+        metricsGet((MetricOp)op, &totals);
+        if (totals.count > 0) {
+            fprintf(out, "sbms_operation_duration_max_seconds{op=\"%s\"} %.9f\n", opNames[op],
+                    (double)totals.maxNs / 1e9);
+        }
+    }
+
+    writeCounter(out, "records_scanned_total", "Records visited by an operation",
+                 offsetof(IoCounters, recordsScanned));
+    writeCounter(out, "read_bytes_total", "Bytes an operation read from files", offsetof(IoCounters, bytesRead));
+    writeCounter(out, "written_bytes_total", "Bytes an operation wrote to files",
+                 offsetof(IoCounters, bytesWritten));
+    writeCounter(out, "file_opens_total", "Files an operation opened", offsetof(IoCounters, fileOpens));
+    return fflush(out) == 0 && !ferror(out);
+}
+
+/**
+ * @brief Replaces METRICS_FILE with the current metrics
+ * @return int 1 on success, 0 otherwise
+ */
+int metricsDump(void) {
+    char tempFile[256];
+    tempFileName(tempFile, sizeof(tempFile), METRICS_FILE);
+    FILE *file = fopen(tempFile, "w");
+    if (file == NULL) {
+        return 0;
+    }
+    int ok = metricsWrite(file);
+    ok = fclose(file) == 0 && ok;
+    if (!ok || rename(tempFile, METRICS_FILE) != 0) {
+        unlink(tempFile);
+        return 0;
+    }
+    return 1;
+}
+
+static void *signalThread(void *arg) {
+    const sigset_t *signals = arg;
+    for (;;) {
+        int received;
+        if (sigwait(signals, &received) == 0) {
+            metricsDump();
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Makes SIGUSR1 rewrite METRICS_FILE
+ * @return int 1 on success, 0 otherwise
+ *
+ * SIGUSR1 is blocked and taken by a thread of its own, so it never
+ * interrupts an operation. Call this before any other thread is started;
+ * threads created afterwards inherit the blocked signal.
+ */
+int metricsStartSignalDump(void) {
+    static sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGUSR1);
+    if (pthread_sigmask(SIG_BLOCK, &signals, NULL) != 0) {
+        return 0;
+    }
+
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, signalThread, &signals) != 0) {
+        return 0;
+    }
+    pthread_detach(thread);
+    return 1;
+}
+
+/**
+ * @brief Counts records visited by a scan of a table or a derived file
+ * @param records Number of records
+ */
+void ioCountScan(long records) {
+    ioCounters.recordsScanned += (uint64_t)records;
+}
+
+/**
+ * @brief Reads the calling thread's I/O counters
+ * @param counters Output for the counters
+ */
+void ioCountersGet(IoCounters *counters) {
+    *counters = ioCounters;
+}
+
+/**
+ * @brief Charges I/O done on a helper thread to the calling thread
+ * @param counters The helper's work, e.g. the difference of two ioCountersGet calls
+ */
+void ioCountersAdd(const IoCounters *counters) {
+    ioCounters.recordsScanned += counters->recordsScanned;
+    ioCounters.bytesRead += counters->bytesRead;
+    ioCounters.bytesWritten += counters->bytesWritten;
+    ioCounters.fileOpens += counters->fileOpens;
+}
+
+/**
+ * @brief open(2), counted as a file open
+ */
+int ioOpen(const char *path, int flags, ...) {
+    mode_t mode = 0;
+    if (flags & O_CREAT) {
+        va_list args;
+        va_start(args, flags);
+        mode = (mode_t)va_arg(args, int);
+        va_end(args);
+    }
+    int fd = open(path, flags, mode);
+    ioCounters.fileOpens += fd >= 0;
+    return fd;
+}
+
+/**
+ * @brief fopen(3), counted as a file open
+ */
+FILE *ioFopen(const char *path, const char *mode) {
+    FILE *file = fopen(path, mode);
+    ioCounters.fileOpens += file != NULL;
+    return file;
+}
+
+/**
+ * @brief pread(2), counting the bytes read
+ */
+ssize_t ioPread(int fd, void *buffer, size_t length, off_t offset) {
+    ssize_t n = pread(fd, buffer, length, offset);
+    ioCounters.bytesRead += n > 0 ? (uint64_t)n : 0;
+    return n;
+}
+
+/**
+ * @brief pwrite(2), counting the bytes written
+ */
+ssize_t ioPwrite(int fd, const void *buffer, size_t length, off_t offset) {
+    ssize_t n = pwrite(fd, buffer, length, offset);
+    ioCounters.bytesWritten += n > 0 ? (uint64_t)n : 0;
+    return n;
+}
+
+/**
+ * @brief write(2), counting the bytes written
+ */
+ssize_t ioWrite(int fd, const void *buffer, size_t length) {
+    ssize_t n = write(fd, buffer, length);
+    ioCounters.bytesWritten += n > 0 ? (uint64_t)n : 0;
+    return n;
+}
+
+/**
+ * @brief fread(3), counting the bytes read
+ */
+size_t ioFread(void *buffer, size_t size, size_t count, FILE *file) {
+    size_t n = fread(buffer, size, count, file);
+    ioCounters.bytesRead += (uint64_t)(n * size);
+    return n;
+}
+
+/**
+ * @brief fwrite(3), counting the bytes written
+ */
+size_t ioFwrite(const void *buffer, size_t size, size_t count, FILE *file) {
+    size_t n = fwrite(buffer, size, count, file);
+    ioCounters.bytesWritten += (uint64_t)(n * size);
+    return n;
+}
@@ -0,0 +1,265 @@
+/*
+ * =====================================================================================
+ * File: money.c
+ * Description: Fixed-point money. Costs, prices and order totals are stored as
+ *              whole cents in 64-bit integers, so sums are exact and come out the
+ *              same whatever order they are added in. That also lets the report
+ *              and valuation loops add many amounts per instruction: the summing
+ *              kernels here use AVX2 when the CPU has it and plain C otherwise,
+ *              with identical results.
+ *
+ *              Older data files hold these amounts as doubles. moneyMigrate()
+ *              converts them in place the first time this version runs, and
+ *              after a restore from an old backup. A double of a non-zero amount
+ *              has its exponent bits set and reads as a huge integer, while any
+ *              real amount in cents is far smaller, so each field tells which
+ *              format it is in and a migration interrupted by a crash simply
+ *              runs again.
+ *
+ * Author: Chiemezie Agbo
+ * Date: 17-10-2026
+ * Version: 1.0
+ * =====================================================================================
+ */
+
+#define _DEFAULT_SOURCE
+#include "../include/money.h"
+#include "../include/table.h"
+#include "../include/cache.h"
+#include "../include/wal.h"
+#include "../include/metrics.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define MONEY_X86 1
+#endif
+
+/* No amount in cents reaches this; every non-zero double does */
+#define MONEY_DOUBLE_BITS ((int64_t)1 << 52)
+
+/**
+ * @brief Converts an amount in dollars to cents, rounding to the nearest cent
+ */
+Money moneyFromDouble(double amount) {
+    return (Money)llround(amount * MONEY_SCALE);
+}
+
+/**
+ * @brief Converts an amount in cents to dollars for printing
+ */
+double moneyToDouble(Money amount) {
+    return (double)amount / MONEY_SCALE;
+}
+
+static Money scalarSum(const Money *values, long count) {
+    Money total = 0;
+    for (long i = 0; i < count; i++) {
+        total += values[i];
+    }
+    return total;
+}
+
+static Money scalarSumSelected(const Money *values, const uint8_t *selected, long count) {
+    Money total = 0;
+    for (long i = 0; i < count; i++) {
+        total += values[i] & -(Money)(selected[i] != 0);
+    }
+    return total;
+}
+
+#ifdef MONEY_X86
+__attribute__((target("avx2")))
+static Money avx2Sum(const Money *values, long count) {
+    __m256i a = _mm256_setzero_si256(), b = _mm256_setzero_si256();
+    long i = 0;
+    for (; i + 8 <= count; i += 8) {
+        a = _mm256_add_epi64(a, _mm256_loadu_si256((const __m256i *)(values + i)));
+        b = _mm256_add_epi64(b, _mm256_loadu_si256((const __m256i *)(values + i + 4)));
+    }
+
+    int64_t lanes[4];
+    _mm256_storeu_si256((__m256i *)lanes, _mm256_add_epi64(a, b));
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] + scalarSum(values + i, count - i);
+}
+
+__attribute__((target("avx2")))
+static Money avx2SumSelected(const Money *values, const uint8_t *selected, long count) {
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i total = zero;
+    long i = 0;
+    for (; i + 4 <= count; i += 4) {
+        int32_t flags;
+        memcpy(&flags, selected + i, sizeof(flags));
+        // Widen the four flags to 64-bit lanes and turn them into all-ones masks
+        __m256i wide = _mm256_cvtepu8_epi64(_mm_cvtsi32_si128(flags));
+        __m256i mask = _mm256_xor_si256(_mm256_cmpeq_epi64(wide, zero), _mm256_set1_epi64x(-1));
+        total = _mm256_add_epi64(total, _mm256_and_si256(mask, _mm256_loadu_si256((const __m256i *)(values + i))));
+    }
+
+    int64_t lanes[4];
+    _mm256_storeu_si256((__m256i *)lanes, total);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] + scalarSumSelected(values + i, selected + i, count - i);
+}
+
+static int hasAvx2(void) {
+    static int supported = -1;
+    if (supported < 0) {
+        __builtin_cpu_init();
+        supported = __builtin_cpu_supports("avx2") != 0;
+    }
+    return supported;
+}
+#endif
+
+/**
+ * @brief Adds up an array of amounts
+ * @param values The amounts
+ * @param count The number of amounts
+ * @return Money The exact total
+ */
+Money moneySum(const Money *values, long count) {
+#ifdef MONEY_X86
+    if (hasAvx2()) {
+        return avx2Sum(values, count);
+    }
+#endif
+    return scalarSum(values, count);
+}
+
+/**
+ * @brief Adds up the amounts whose flag is set, without branching on the flags
+ * @param values The amounts
+ * @param selected One flag per amount, non-zero to include it
+ * @param count The number of amounts
+ * @return Money The exact total of the selected amounts
+ */
+Money moneySumSelected(const Money *values, const uint8_t *selected, long count) {
+#ifdef MONEY_X86
+    if (hasAvx2()) {
+        return avx2SumSelected(values, selected, count);
+    }
+#endif
+    return scalarSumSelected(values, selected, count);
+}
+
+typedef struct {
+    TableId table;
+    size_t fields[2];
+} MoneyFields;
+
+static const MoneyFields moneyFields[] = {
+    {TABLE_INVENTORY, {offsetof(InventoryItem, cost), offsetof(InventoryItem, price)}},
+    {TABLE_ORDERS, {offsetof(Order, totalAmount), offsetof(Order, profit)}},
+    {TABLE_ORDER_LINES, {offsetof(OrderLine, unitPrice), offsetof(OrderLine, unitCost)}},
+};
+
+/**
+ * @brief Converts the amounts of one table that are still stored as doubles
+ * @return long The number of records changed, -1 on failure
+ */
+static long migrateTable(const MoneyFields *money) {
+    const TableDef *def = getTableDef(money->table);
+    long count;
+    const char *records = cacheTable(money->table, &count);
+    if (count <= 0) {
+        return 0; // Missing or empty: nothing to convert
+    }
+
+    int fd = ioOpen(def->dataFile, O_WRONLY);
+    if (fd < 0) {
+        return -1;
+    }
+
+    char *record = malloc(def->recordSize);
+    long changed = 0;
+    for (long slot = 0; record != NULL && slot < count; slot++) {
+        memcpy(record, records + (size_t)slot * def->recordSize, def->recordSize);
+        int dirty = 0;
+        for (int f = 0; f < 2; f++) {
+            int64_t bits;
+            memcpy(&bits, record + money->fields[f], sizeof(bits));
+            if (bits >= MONEY_DOUBLE_BITS || bits <= -MONEY_DOUBLE_BITS) {
+                double amount;
+                memcpy(&amount, &bits, sizeof(amount));
+                Money cents = moneyFromDouble(amount);
+                memcpy(record + money->fields[f], &cents, sizeof(cents));
+                dirty = 1;
+            }
+        }
+        if (dirty) {
+            off_t offset = (off_t)slot * (off_t)def->recordSize;
+            if (ioPwrite(fd, record, def->recordSize, offset) != (ssize_t)def->recordSize) {
+                break;
+            }
+            changed++;
+        }
+    }
+
+    int ok = record != NULL && fsync(fd) == 0;
+    free(record);
+    close(fd);
+    return ok ? changed : -1;
+}
+
+/**
+ * @brief Converts every amount still stored as a double to cents
+ * @return int 1 on success, 0 otherwise
+ *
+ * Tables that changed get their derived files (order columns, daily totals,
+ * hot records) rebuilt, since those were built from the old values.
+ */
+int moneyMigrateTables(void) {
+    // The log may hold old-format images; apply and empty it first
+    walCheckpoint();
+
+    int ok = 1;
+    for (size_t i = 0; i < sizeof(moneyFields) / sizeof(moneyFields[0]); i++) {
+        long changed = migrateTable(&moneyFields[i]);
+        if (changed < 0) {
+            printf("Error opening file!\n");
+            ok = 0;
+        } else if (changed > 0) {
+            cacheInvalidate(moneyFields[i].table);
+            tableRebuildDerived(moneyFields[i].table);
+        }
+    }
+    return ok;
+}
+
+/**
+ * @brief Converts the data files to cents unless DATA_FORMAT_FILE says it was done
+ * @return int 1 if the data is in the current format, 0 otherwise
+ */
+int moneyMigrate(void) {
+    uint32_t format = 0;
+    FILE *file = ioFopen(DATA_FORMAT_FILE, "rb");
+    if (file != NULL) {
+        if (ioFread(&format, sizeof(format), 1, file) != 1) {
+            format = 0;
+        }
+        fclose(file);
+    }
+    if (format >= DATA_FORMAT_MONEY) {
+        return 1;
+    }
+
+    if (!moneyMigrateTables()) {
+        return 0;
+    }
+
+    format = DATA_FORMAT_MONEY;
+    file = ioFopen(DATA_FORMAT_FILE, "wb");
+    if (file == NULL) {
+        printf("Error opening file!\n");
+        return 0;
+    }
+    int ok = ioFwrite(&format, sizeof(format), 1, file) == 1;
+    return fclose(file) == 0 && ok;
+}
@@ -0,0 +1,386 @@
+/*
+ * =====================================================================================
+ * File: orderlines.c
+ * Description: Indexes the order line table (data/order_lines.dat), which keeps
+ *              the item, quantity, unit price and unit cost of every line of
+ *              every order. Two direct-address sidecar files give the lines of an
+ *              order (data/order_lines.oidx: first slot and count, as an order's
+ *              lines are appended together) and the newest line of an item
+ *              (data/order_lines.iidx). data/order_lines.links chains each line to
+ *              the previous line of the same item, so a per-product query only
+ *              visits that product's lines.
+ *
+ *              The indexes are extended whenever the write-ahead log applies a
+ *              line and are rebuilt from the data file when the number of lines
+ *              they cover no longer matches it.
+ *
+ * Author: Chiemezie Agbo
+ * Date: 17-10-2026
+ * Version: 1.0
+ * =====================================================================================
+ */
+
+#define _DEFAULT_SOURCE
+#include "../include/orderlines.h"
+#include "../include/table.h"
+#include "../include/cache.h"
+#include "../include/metrics.h"
+#include "../include/utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#define LINKS_MAGIC 0x4B4E494Cu /* "LINK" */
+#define LINKS_VERSION 1
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    int64_t rows;
+} LinksHeader;
+
+/* Slots are stored plus one so that zero-filled holes mean "none" */
+typedef struct {
+    int32_t firstSlot;
+    int32_t count; /* -1 when the order's lines are not contiguous */
+} OrderLinesEntry;
+
+static off_t linkOffset(long slot) {
+    return (off_t)sizeof(LinksHeader) + (off_t)slot * (off_t)sizeof(int32_t);
+}
+
+static int readAt(int fd, void *data, size_t length, off_t offset) {
+    ssize_t n = ioPread(fd, data, length, offset);
+    if (n != (ssize_t)length) {
+        memset(data, 0, length); // Past the end or a hole
+        return 0;
+    }
+    return 1;
+}
+
+static int writeAt(int fd, const void *data, size_t length, off_t offset) {
+    return ioPwrite(fd, data, length, offset) == (ssize_t)length;
+}
+
+static int readHeader(int fd, LinksHeader *header) {
+    return ioPread(fd, header, sizeof(*header), 0) == (ssize_t)sizeof(*header) &&
+           header->magic == LINKS_MAGIC && header->version == LINKS_VERSION;
+}
+
+static int writeHeader(int fd, int64_t rows) {
+    LinksHeader header = {LINKS_MAGIC, LINKS_VERSION, rows};
+    return writeAt(fd, &header, sizeof(header), 0);
+}
+
+/**
+ * @brief Adds a freshly appended line to the order and item indexes
+ * @return int 1 on success, 0 if the indexes should be rebuilt instead
+ */
+static int indexLine(int linksFd, long slot, const OrderLine *line) {
+    int32_t previous = 0;
+    if (line->id > 0 && line->itemId > 0) {
+        int fd = ioOpen(ORDER_LINES_BY_ITEM_FILE, O_RDWR | O_CREAT, 0644);
+        if (fd < 0) {
+            return 0;
+        }
+        off_t offset = (off_t)line->itemId * (off_t)sizeof(int32_t);
+        readAt(fd, &previous, sizeof(previous), offset);
+        int32_t head = (int32_t)(slot + 1);
+        int ok = previous - 1 < slot && writeAt(fd, &head, sizeof(head), offset);
+        close(fd);
+        if (!ok) {
+            return 0;
+        }
+    }
+    if (!writeAt(linksFd, &previous, sizeof(previous), linkOffset(slot))) {
+        return 0;
+    }
+
+    if (line->id > 0 && line->orderId > 0) {
+        int fd = ioOpen(ORDER_LINES_BY_ORDER_FILE, O_RDWR | O_CREAT, 0644);
+        if (fd < 0) {
+            return 0;
+        }
+        OrderLinesEntry entry;
+        off_t offset = (off_t)line->orderId * (off_t)sizeof(entry);
+        readAt(fd, &entry, sizeof(entry), offset);
+        if (entry.firstSlot == 0) {
+            entry.firstSlot = (int32_t)(slot + 1);
+            entry.count = 1;
+        } else if (entry.count >= 0 && entry.firstSlot - 1 + entry.count == slot) {
+            entry.count++;
+        } else {
+            entry.count = -1;
+        }
+        int ok = writeAt(fd, &entry, sizeof(entry), offset);
+        close(fd);
+        return ok;
+    }
+    return 1;
+}
+
+/**
+ * @brief Updates the indexes after the log applied a line write
+ * @param slot The slot the line was written to
+ * @param before The line previously stored in the slot, NULL for an append
+ * @param after The line as it is now stored
+ * @return int 1 on success, 0 otherwise
+ *
+ * Rewriting a line in place keeps it indexed as long as its order and item
+ * stay the same; anything else marks the indexes stale so the next query
+ * rebuilds them.
+ */
+int orderLinesApplyWrite(long slot, const OrderLine *before, const OrderLine *after) {
+    int fd = ioOpen(ORDER_LINES_LINKS_FILE, O_RDWR);
+    if (fd < 0) {
+        return 1;
+    }
+
+    LinksHeader header;
+    int ok = 1;
+    if (!readHeader(fd, &header) || header.rows < 0) {
+        // Already stale, the next query rebuilds the indexes
+    } else if (slot < header.rows) {
+        if (before == NULL || before->orderId != after->orderId || before->itemId != after->itemId) {
+            ok = writeHeader(fd, -1);
+        }
+    } else if (slot > header.rows || !indexLine(fd, slot, after)) {
+        ok = writeHeader(fd, -1);
+    } else {
+        ok = writeHeader(fd, header.rows + 1);
+    }
+    close(fd);
+    return ok;
+}
+
+static int writeArray(const char *path, const void *data, size_t length) {
+    char tempFile[256];
+    tempFileName(tempFile, sizeof(tempFile), path);
+    FILE *out = ioFopen(tempFile, "wb");
+    if (out == NULL) {
+        return 0;
+    }
+    int ok = length == 0 || ioFwrite(data, length, 1, out) == 1;
+    ok = fclose(out) == 0 && ok;
+    if (!ok || rename(tempFile, path) != 0) {
+        remove(tempFile);
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief Rebuilds the order, item and link files from data/order_lines.dat
+ * @return int 1 on success, 0 otherwise
+ */
+int orderLinesRebuildIndex(void) {
+    long count;
+    const OrderLine *lines = cacheTable(TABLE_ORDER_LINES, &count);
+    if (count < 0) {
+        count = 0;
+    }
+
+    int maxOrderId = 0, maxItemId = 0;
+    for (long slot = 0; slot < count; slot++) {
+        if (lines[slot].id > 0 && lines[slot].orderId > maxOrderId) {
+            maxOrderId = lines[slot].orderId;
+        }
+        if (lines[slot].id > 0 && lines[slot].itemId > maxItemId) {
+            maxItemId = lines[slot].itemId;
+        }
+    }
+
+    LinksHeader *links = calloc(1, sizeof(LinksHeader) + (size_t)count * sizeof(int32_t));
+    OrderLinesEntry *byOrder = calloc((size_t)maxOrderId + 1, sizeof(OrderLinesEntry));
+    int32_t *byItem = calloc((size_t)maxItemId + 1, sizeof(int32_t));
+    int ok = links != NULL && byOrder != NULL && byItem != NULL;
+
+    int32_t *prev = (int32_t *)(links + 1);
+    for (long slot = 0; ok && slot < count; slot++) {
+        const OrderLine *line = &lines[slot];
+        if (line->id <= 0) {
+            continue;
+        }
+        if (line->itemId > 0) {
+            prev[slot] = byItem[line->itemId];
+            byItem[line->itemId] = (int32_t)(slot + 1);
+        }
+        if (line->orderId > 0) {
+            OrderLinesEntry *entry = &byOrder[line->orderId];
+            if (entry->firstSlot == 0) {
+                entry->firstSlot = (int32_t)(slot + 1);
+                entry->count = 1;
+            } else if (entry->count >= 0 && entry->firstSlot - 1 + entry->count == slot) {
+                entry->count++;
+            } else {
+                entry->count = -1;
+            }
+        }
+    }
+
+    if (ok) {
+        links->magic = LINKS_MAGIC;
+        links->version = LINKS_VERSION;
+        links->rows = count;
+        // The link file carries the row count, so it goes last
+        ok = writeArray(ORDER_LINES_BY_ORDER_FILE, byOrder, ((size_t)maxOrderId + 1) * sizeof(OrderLinesEntry)) &&
+             writeArray(ORDER_LINES_BY_ITEM_FILE, byItem, ((size_t)maxItemId + 1) * sizeof(int32_t)) &&
+             writeArray(ORDER_LINES_LINKS_FILE, links, sizeof(LinksHeader) + (size_t)count * sizeof(int32_t));
+    }
+
+    free(links);
+    free(byOrder);
+    free(byItem);
+    return ok;
+}
+
+/**
+ * @brief Flushes the index files to disk; called by the log's checkpoint
+ */
+void orderLinesSync(void) {
+    const char *files[] = {ORDER_LINES_LINKS_FILE, ORDER_LINES_BY_ORDER_FILE, ORDER_LINES_BY_ITEM_FILE};
+    for (size_t i = 0; i < sizeof(files) / sizeof(files[0]); i++) {
+        int fd = ioOpen(files[i], O_RDONLY);
+        if (fd >= 0) {
+            fsync(fd);
+            close(fd);
+        }
+    }
+}
+
+/**
+ * @brief Makes sure the indexes cover every line of the data file
+ * @return int File descriptor of the link file, -1 on failure
+ */
+static int openFreshLinks(long count) {
+    LinksHeader header;
+    int fd = ioOpen(ORDER_LINES_LINKS_FILE, O_RDONLY);
+    if (fd >= 0 && readHeader(fd, &header) && header.rows == count) {
+        return fd;
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+    if (!orderLinesRebuildIndex()) {
+        return -1;
+    }
+    return ioOpen(ORDER_LINES_LINKS_FILE, O_RDONLY);
+}
+
+static int appendLine(OrderLine **lines, long *count, long *capacity, const OrderLine *line) {
+    if (*count == *capacity) {
+        long newCapacity = *capacity ? *capacity * 2 : 16;
+        OrderLine *grown = realloc(*lines, (size_t)newCapacity * sizeof(OrderLine));
+        if (grown == NULL) {
+            return 0;
+        }
+        *lines = grown;
+        *capacity = newCapacity;
+    }
+    (*lines)[(*count)++] = *line;
+    return 1;
+}
+
+/**
+ * @brief Collects the lines of an order
+ * @param orderId The order ID
+ * @param lines Output for a newly allocated array of lines (caller frees)
+ * @param count Output for the number of lines
+ * @return int 1 on success, 0 otherwise
+ */
+int orderLinesForOrder(int orderId, OrderLine **lines, long *count) {
+    *lines = NULL;
+    *count = 0;
+    long total;
+    const OrderLine *records = cacheTable(TABLE_ORDER_LINES, &total);
+    if (total <= 0 || orderId <= 0) {
+        return total >= 0;
+    }
+
+    int linksFd = openFreshLinks(total);
+    if (linksFd < 0) {
+        return 0;
+    }
+    close(linksFd);
+    records = cacheTable(TABLE_ORDER_LINES, &total);
+
+    OrderLinesEntry entry = {0, 0};
+    int fd = ioOpen(ORDER_LINES_BY_ORDER_FILE, O_RDONLY);
+    if (fd >= 0) {
+        readAt(fd, &entry, sizeof(entry), (off_t)orderId * (off_t)sizeof(entry));
+        close(fd);
+    }
+
+    long first = entry.firstSlot - 1, last = first + entry.count;
+    if (entry.count < 0) {
+        first = 0; // Scattered lines: fall back to a scan
+        last = total;
+    }
+
+    long capacity = 0;
+    ioCountScan(first >= 0 && first < total ? (last < total ? last : total) - first : 0);
+    for (long slot = first; slot >= 0 && slot < last && slot < total; slot++) {
+        if (records[slot].id > 0 && records[slot].orderId == orderId &&
+            !appendLine(lines, count, &capacity, &records[slot])) {
+            free(*lines);
+            *lines = NULL;
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * @brief Collects the lines that sold an item, newest first
+ * @param itemId The inventory item ID
+ * @param lines Output for a newly allocated array of lines (caller frees)
+ * @param count Output for the number of lines
+ * @return int 1 on success, 0 otherwise
+ */
+int orderLinesForItem(int itemId, OrderLine **lines, long *count) {
+    *lines = NULL;
+    *count = 0;
+    long total;
+    const OrderLine *records = cacheTable(TABLE_ORDER_LINES, &total);
+    if (total <= 0 || itemId <= 0) {
+        return total >= 0;
+    }
+
+    int linksFd = openFreshLinks(total);
+    if (linksFd < 0) {
+        return 0;
+    }
+    records = cacheTable(TABLE_ORDER_LINES, &total);
+
+    int32_t head = 0;
+    int fd = ioOpen(ORDER_LINES_BY_ITEM_FILE, O_RDONLY);
+    if (fd >= 0) {
+        readAt(fd, &head, sizeof(head), (off_t)itemId * (off_t)sizeof(int32_t));
+        close(fd);
+    }
+
+    long capacity = 0;
+    long visited = 0;
+    int ok = 1;
+    // Links always point backwards, so the walk ends even if the file is damaged
+    for (long slot = (long)head - 1; ok && slot >= 0 && slot < total; visited++) {
+        if (records[slot].id > 0 && records[slot].itemId == itemId) {
+            ok = appendLine(lines, count, &capacity, &records[slot]);
+        }
+        int32_t previous = 0;
+        readAt(linksFd, &previous, sizeof(previous), linkOffset(slot));
+        slot = previous - 1 < slot ? (long)previous - 1 : -1;
+    }
+    close(linksFd);
+    ioCountScan(visited);
+
+    if (!ok) {
+        free(*lines);
+        *lines = NULL;
+        *count = 0;
+    }
+    return ok;
+}
@@ -12,10 +12,20 @@
  * =====================================================================================
  */
 
+#define _DEFAULT_SOURCE
 #include <limits.h>
 #include "../include/orders.h"
 #include "../include/customers.h"
 #include "../include/inventory.h"
+#include "../include/table.h"
+#include "../include/meta.h"
+#include "../include/lock.h"
+#include "../include/cache.h"
+#include "../include/wal.h"
+#include "../include/orderlines.h"
+#include "../include/hotstore.h"
+#include "../include/money.h"
+#include "../include/metrics.h"
 #include "../include/utils.h"
 #include <stdio.h>
 #include <stdlib.h>
@@ -67,84 +77,288 @@ void orderMenu() {
     } while (1);
 }
 
+/**
+ * @brief Places an order for the items asked for, timed as one order placing
+ * @param order The order; the customer must be set, the rest is filled in
+ * @param items The items and quantities ordered
+ * @param itemCount Number of items
+ * @param failedItem Output for the index of the item that stopped the order, -1 if none
+ * @return OrderResult ORDER_PLACED or why the order was not placed
+ */
+OrderResult submitOrder(Order *order, const OrderItemRequest *items, int itemCount, int *failedItem) {
+    METRICS_SPAN(METRIC_PLACE_ORDER);
+    METRICS_SPAN_IDS(0, order->customerId);
+    OrderResult result = placeOrderBatch(order, items, itemCount, failedItem);
+    if (result == ORDER_PLACED) {
+        METRICS_SPAN_IDS(order->id, order->customerId);
+    }
+    return result;
+}
+
 /**
  * @brief Places a new order in the system
  * @param order Pointer to the Order struct to be added
+ *
+ * Items are checked against the hot inventory records while the basket is
+ * entered; placeOrderBatch() then checks them again and stores everything
+ * in one go.
  */
 void placeOrder(Order *order) {
-    Customer customer;
+    CustomerHot customer;
 
     // Get customer ID and validate
     do {
         printf("Enter customer ID: ");
         order->customerId = validateIntInput(1, INT_MAX);
 
-        if (!getCustomerById(order->customerId, &customer)) {
+        if (!hotGetById(TABLE_CUSTOMERS, order->customerId, &customer)) {
             printf("Error: Customer with ID %d not found. Please try again.\n", order->customerId);
         } else {
             break;
         }
     } while (1);
 
-    order->id = generateUniqueOrderId();
-    order->orderDate = time(NULL);
-    order->totalAmount = 0;
-    order->profit = 0;
-    strcpy(order->status, "Pending");
-
     int numItems;
     printf("Enter the number of items in this order: ");
-    numItems = validateIntInput(1, 100);
+    numItems = validateIntInput(1, MAX_ORDER_LINES);
+    OrderItemRequest items[MAX_ORDER_LINES];
 
     for (int i = 0; i < numItems; i++) {
-        int inventoryId, quantity;
-        InventoryItem item;
+        InventoryHot item;
 
         do {
             printf("Enter inventory item ID for item %d: ", i + 1);
-            inventoryId = validateIntInput(1, INT_MAX);
+            items[i].itemId = validateIntInput(1, INT_MAX);
 
-            if (!getInventoryItemById(inventoryId, &item)) {
-                printf("Error: Inventory item with ID %d not found. Please try again.\n", inventoryId);
+            if (!hotGetById(TABLE_INVENTORY, items[i].itemId, &item)) {
+                printf("Error: Inventory item with ID %d not found. Please try again.\n", items[i].itemId);
             } else {
                 break;
             }
         } while (1);
 
-        do {
-            printf("Enter quantity for item %d: ", i + 1);
-            quantity = validateIntInput(1, item.quantity);
-
-            if (quantity > item.quantity) {
-                printf("Error: Not enough stock. Available quantity: %d. Please try again.\n", item.quantity);
-            } else {
-                break;
+        // Stock already taken by earlier lines for the same item
+        int available = item.quantity;
+        for (int j = 0; j < i; j++) {
+            if (items[j].itemId == item.id) {
+                available -= items[j].quantity;
             }
-        } while (1);
+        }
+        if (available < 1) {
+            printf("Error: Item %d is out of stock. Please choose another item.\n", item.id);
+            i--;
+            continue;
+        }
 
-        // Update inventory
-        item.quantity -= quantity;
-        updateInventoryItemById(&item);
+        printf("Enter quantity for item %d (available: %d): ", i + 1, available);
+        items[i].quantity = validateIntInput(1, available);
+    }
+
+    int failedItem;
+    switch (submitOrder(order, items, numItems, &failedItem)) {
+        case ORDER_PLACED:
+            break;
+        case ORDER_UNKNOWN_CUSTOMER:
+            printf("Error: Customer with ID %d not found.\n", order->customerId);
+            return;
+        case ORDER_UNKNOWN_ITEM:
+            printf("Error: Inventory item with ID %d not found.\n", items[failedItem].itemId);
+            return;
+        case ORDER_OUT_OF_STOCK:
+            printf("Error: Not enough stock for item %d.\n", items[failedItem].itemId);
+            return;
+        default:
+            printf("Error opening file!\n");
+            return;
+    }
+
+    printf("Order placed successfully for customer %s (ID: %d)!\n", customer.namePrefix, customer.id);
+    printf("Order ID: %d\n", order->id);
+    printf("Total amount: $%.2f\n", moneyToDouble(order->totalAmount));
+}
+
+/**
+ * @brief Adds an order and its lines to a log transaction
+ */
+static void logOrder(WalTxn *txn, const Order *order, OrderLine *lines, int lineCount) {
+    walLogWrite(txn, TABLE_ORDERS, WAL_APPEND_SLOT, order);
+    for (int i = 0; i < lineCount; i++) {
+        lines[i].id = metaAllocateId(TABLE_ORDER_LINES);
+        lines[i].orderId = order->id;
+        walLogWrite(txn, TABLE_ORDER_LINES, WAL_APPEND_SLOT, &lines[i]);
+    }
+}
 
-        // Update order total and profit
-        double itemRevenue = item.price * quantity;
-        double itemCost = item.cost * quantity;
+/**
+ * @brief Checks and writes a basket whose items are already locked
+ */
+static OrderResult placeLockedBatch(Order *order, const OrderItemRequest *items, int itemCount, int *failedItem) {
+    InventoryItem stock[MAX_ORDER_LINES];
+    long slots[MAX_ORDER_LINES];
+    OrderLine lines[MAX_ORDER_LINES];
+    CustomerHot customer;
+    int distinct = 0;
+
+    if (!hotGetById(TABLE_CUSTOMERS, order->customerId, &customer)) {
+        return ORDER_UNKNOWN_CUSTOMER;
+    }
+
+    order->orderDate = time(NULL);
+    order->totalAmount = 0;
+    order->profit = 0;
+    strcpy(order->status, "Pending");
+
+    for (int i = 0; i < itemCount; i++) {
+        int j = 0;
+        while (j < distinct && stock[j].id != items[i].itemId) {
+            j++;
+        }
+
+        OrderResult rejected = ORDER_PLACED;
+        if (items[i].quantity < 1) {
+            rejected = ORDER_INVALID;
+        } else if (j == distinct && !tableGetById(TABLE_INVENTORY, items[i].itemId, &stock[j], &slots[j])) {
+            rejected = ORDER_UNKNOWN_ITEM;
+        } else if (stock[j].quantity < items[i].quantity) {
+            rejected = ORDER_OUT_OF_STOCK;
+        }
+        if (rejected != ORDER_PLACED) {
+            if (failedItem != NULL) {
+                *failedItem = i;
+            }
+            return rejected;
+        }
+        if (j == distinct) {
+            distinct++;
+        }
+
+        stock[j].quantity -= items[i].quantity;
+        Money itemRevenue = stock[j].price * items[i].quantity;
+        Money itemCost = stock[j].cost * items[i].quantity;
         order->totalAmount += itemRevenue;
-        order->profit += (itemRevenue - itemCost);
+        order->profit += itemRevenue - itemCost;
+
+        OrderLine line = {0, 0, stock[j].id, items[i].quantity, stock[j].price, stock[j].cost, order->orderDate};
+        lines[i] = line;
     }
 
-    FILE *file = fopen(ORDERS_FILE, "ab");
-    if (file == NULL) {
-        printf("Error opening file!\n");
-        return;
+    // IDs are only taken once the basket is known to be good
+    order->id = generateUniqueOrderId();
+
+    WalTxn txn;
+    walBegin(&txn);
+    for (int j = 0; j < distinct; j++) {
+        walLogWrite(&txn, TABLE_INVENTORY, slots[j], &stock[j]);
     }
+    logOrder(&txn, order, lines, itemCount);
+    int ok = walCommit(&txn);
+    walEnd(&txn);
+    return ok ? ORDER_PLACED : ORDER_WRITE_FAILED;
+}
 
-    fwrite(order, sizeof(Order), 1, file);
-    fclose(file);
+static int compareIds(const void *a, const void *b) {
+    int left = *(const int *)a;
+    int right = *(const int *)b;
+    return (left > right) - (left < right);
+}
 
-    printf("Order placed successfully for customer %s (ID: %d)!\n", customer.name, customer.id);
-    printf("Order ID: %d\n", order->id);
-    printf("Total amount: $%.2f\n", order->totalAmount);
+/**
+ * @brief Places an order for a whole basket of items as one atomic write
+ * @param order The order; customerId must be set, everything else is filled in here
+ * @param items The items and quantities ordered; an item may appear more than once
+ * @param itemCount Number of entries in items, 1 to MAX_ORDER_LINES
+ * @param failedItem Optional output for the index of the entry that was rejected, -1 if none
+ * @return OrderResult ORDER_PLACED on success, the reason otherwise
+ *
+ * Each distinct item is looked up once through the inventory index and
+ * checked against the combined quantity of its entries. Nothing is written
+ * unless the whole basket can be filled; then the stock decrements, the
+ * order and its lines go to the log in a single transaction, so a crash
+ * leaves either all of them or none.
+ *
+ * The distinct items are record-locked in ascending ID order for the whole
+ * check-and-write, so two terminals selling the same item cannot both pass
+ * the stock check, while orders for other items go ahead in parallel.
+ */
+OrderResult placeOrderBatch(Order *order, const OrderItemRequest *items, int itemCount, int *failedItem) {
+    METRICS_SPAN(METRIC_PLACE_ORDER_BATCH);
+    int ids[MAX_ORDER_LINES];
+    int locked = 0;
+
+    if (failedItem != NULL) {
+        *failedItem = -1;
+    }
+    if (itemCount < 1 || itemCount > MAX_ORDER_LINES) {
+        return ORDER_INVALID;
+    }
+
+    for (int i = 0; i < itemCount; i++) {
+        ids[i] = items[i].itemId;
+    }
+    qsort(ids, itemCount, sizeof(ids[0]), compareIds);
+
+    OrderResult result = ORDER_WRITE_FAILED;
+    int ok = 1;
+    for (int i = 0; i < itemCount && ok; i++) {
+        if (i == 0 || ids[i] != ids[i - 1]) {
+            ok = recordLock(TABLE_INVENTORY, ids[i]);
+            if (ok) {
+                ids[locked++] = ids[i];
+            }
+        }
+    }
+    if (ok) {
+        result = placeLockedBatch(order, items, itemCount, failedItem);
+    }
+    METRICS_SPAN_IDS(result == ORDER_PLACED ? order->id : 0, order->customerId);
+
+    while (locked > 0) {
+        recordUnlock(TABLE_INVENTORY, ids[--locked]);
+    }
+    return result;
+}
+
+/**
+ * @brief Stores an order together with its lines in a single log transaction
+ * @param order The order to append
+ * @param lines The order's lines; their IDs are assigned here
+ * @param lineCount Number of lines
+ * @return int 1 on success, 0 otherwise
+ */
+int commitOrder(const Order *order, OrderLine *lines, int lineCount) {
+    METRICS_SPAN(METRIC_COMMIT_ORDER);
+    METRICS_SPAN_IDS(order->id, order->customerId);
+    WalTxn txn;
+    walBegin(&txn);
+    logOrder(&txn, order, lines, lineCount);
+    int ok = walCommit(&txn);
+    walEnd(&txn);
+    return ok;
+}
+
+/**
+ * @brief Changes the status of an order
+ * @param id The order's ID
+ * @param status The new status, e.g. "Shipped"
+ * @param order Output for the order as stored afterwards
+ * @return int 1 if changed, 0 if there is no such order, -1 if it cannot be locked or written
+ *
+ * The order is re-read under its lock so only the status changes.
+ */
+int setOrderStatus(int id, const char *status, Order *order) {
+    METRICS_SPAN(METRIC_UPDATE_ORDER_STATUS);
+    METRICS_SPAN_IDS(id, 0);
+    if (!recordLock(TABLE_ORDERS, id)) {
+        return -1;
+    }
+    long slot;
+    int result = 0;
+    if (tableGetById(TABLE_ORDERS, id, order, &slot)) {
+        snprintf(order->status, sizeof(order->status), "%s", status);
+        result = tableWriteSlot(TABLE_ORDERS, slot, order) ? 1 : -1;
+    }
+    recordUnlock(TABLE_ORDERS, id);
+    return result;
 }
 
 /**
@@ -155,73 +369,132 @@ void updateOrderStatus() {
     printf("Enter order ID to update: ");
     id = validateIntInput(1, INT_MAX);
 
-    FILE *file = fopen(ORDERS_FILE, "rb+");
-    if (file == NULL) {
+    Order order;
+    int result = 0;
+    if (tableGetById(TABLE_ORDERS, id, &order, NULL)) {
+        printf("Current status: %s\n", order.status);
+        printf("Choose new order status:\n");
+        printf("1. Pending\n");
+        printf("2. Shipped\n");
+        printf("3. Completed\n");
+        int statusChoice = validateIntInput(1, 3);
+        const char *statuses[] = {"Pending", "Shipped", "Completed"};
+        result = setOrderStatus(id, statuses[statusChoice - 1], &order);
+    }
+
+    if (result > 0) {
+        printf("Order status updated successfully!\n");
+    } else if (result < 0) {
         printf("Error opening file!\n");
-        return;
+    } else {
+        printf("Order not found!\n");
     }
+}
 
-    Order order;
-    int found = 0;
-    while (fread(&order, sizeof(Order), 1, file)) {
-        if (order.id == id) {
-            printf("Current status: %s\n", order.status);
-            printf("Choose new order status:\n");
-            printf("1. Pending\n");
-            printf("2. Shipped\n");
-            printf("3. Completed\n");
-            int statusChoice = validateIntInput(1, 3);
-
-            switch (statusChoice) {
-                case 1:
-                    strcpy(order.status, "Pending");
-                    break;
-                case 2:
-                    strcpy(order.status, "Shipped");
-                    break;
-                case 3:
-                    strcpy(order.status, "Completed");
-                    break;
-            }
+/**
+ * @brief Prints the column headings of the order tables
+ * @param out Where the headings go
+ */
+void printOrderHeader(FILE *out) {
+    fprintf(out, "\033[1;34m");
+    fprintf(out, "%-5s %-15s %-20s %-15s %-10s %-10s\n", "ID", "Customer ID", "Order Date", "Total Amount", "Status", "Profit");
+    fprintf(out, "==============================================================================\n");
+    fprintf(out, "\033[0m");
+}
 
-            fseek(file, -sizeof(Order), SEEK_CUR);
-            fwrite(&order, sizeof(Order), 1, file);
-            found = 1;
-            break;
-        }
+/**
+ * @brief Prints one order as a row under printOrderHeader()
+ * @param out Where the row goes
+ * @param order The order to print
+ */
+void printOrderRow(FILE *out, const Order *order) {
+    char date[20];
+    struct tm tm;
+    strftime(date, sizeof(date), "%Y-%m-%d %H:%M:%S", localtime_r(&order->orderDate, &tm));
+    fprintf(out, "%-5d %-15d %-20s $%-14.2f %-10s $%-9.2f\n", order->id, order->customerId, date,
+            moneyToDouble(order->totalAmount), order->status, moneyToDouble(order->profit));
+}
+
+/**
+ * @brief Prints the lines of an order with their own headings
+ * @param out Where the lines go
+ * @param lines The order's lines
+ * @param lineCount Number of lines; nothing is printed for none
+ */
+void printOrderLines(FILE *out, const OrderLine *lines, long lineCount) {
+    if (lineCount <= 0) {
+        return;
     }
+    fprintf(out, "\033[1;34m");
+    fprintf(out, "%-10s %-10s %-15s %-15s\n", "Item ID", "Quantity", "Unit Price", "Unit Cost");
+    fprintf(out, "\033[0m");
+    for (long i = 0; i < lineCount; i++) {
+        fprintf(out, "%-10d %-10d $%-14.2f $%-14.2f\n", lines[i].itemId, lines[i].quantity,
+                moneyToDouble(lines[i].unitPrice), moneyToDouble(lines[i].unitCost));
+    }
+}
 
-    fclose(file);
+/**
+ * @brief Calls a function with every order that is not deleted
+ * @param visit Called with each order in storage order
+ * @param context Passed on to visit
+ * @return int 1 on success, 0 if the orders cannot be read
+ */
+int listOrders(OrderVisitor visit, void *context) {
+    METRICS_SPAN(METRIC_VIEW_ORDERS);
+    long count;
+    const Order *orders = cacheTable(TABLE_ORDERS, &count);
+    if (count < 0) {
+        return 0;
+    }
+    ioCountScan(count);
 
-    if (found) {
-        printf("Order status updated successfully!\n");
-    } else {
-        printf("Order not found!\n");
+    for (long i = 0; i < count; i++) {
+        if (orders[i].id > 0) {
+            visit(&orders[i], context);
+        }
     }
+    return 1;
+}
+
+static void printOrderVisitor(const Order *order, void *context) {
+    printOrderRow(context, order);
 }
 
 /**
  * @brief Displays all orders in the system
  */
 void viewAllOrders() {
-    FILE *file = fopen(ORDERS_FILE, "rb");
-    if (file == NULL) {
+    printOrderHeader(stdout);
+    if (!listOrders(printOrderVisitor, stdout)) {
         printf("Error opening file!\n");
-        return;
     }
+}
+
+/**
+ * @brief Prints an order with its lines the way the order menu shows it
+ * @param out Where the order goes
+ * @param id The order's ID
+ * @return int 1 if printed, 0 if there is no such order
+ */
+int writeOrder(FILE *out, int id) {
+    METRICS_SPAN(METRIC_SEARCH_ORDER);
+    METRICS_SPAN_IDS(id, 0);
 
     Order order;
-    printf("\033[1;34m");
-    printf("%-5s %-15s %-20s %-15s %-10s %-10s\n", "ID", "Customer ID", "Order Date", "Total Amount", "Status", "Profit");
-    printf("==============================================================================\n");
-    printf("\033[0m");
-    while (fread(&order, sizeof(Order), 1, file)) {
-        char date[20];
-        strftime(date, sizeof(date), "%Y-%m-%d %H:%M:%S", localtime(&order.orderDate));
-        printf("%-5d %-15d %-20s $%-14.2f %-10s $%-9.2f\n", order.id, order.customerId, date, order.totalAmount, order.status, order.profit);
+    if (!tableGetById(TABLE_ORDERS, id, &order, NULL)) {
+        return 0;
     }
-
-    fclose(file);
+    printOrderHeader(out);
+    printOrderRow(out, &order);
+
+    OrderLine *lines;
+    long lineCount;
+    if (orderLinesForOrder(order.id, &lines, &lineCount)) {
+        printOrderLines(out, lines, lineCount);
+        free(lines);
+    }
+    return 1;
 }
 
 /**
@@ -231,32 +504,7 @@ void searchOrder() {
     int id;
     printf("Enter order ID to search: ");
     id = validateIntInput(1, INT_MAX);
-
-    FILE *file = fopen(ORDERS_FILE, "rb");
-    if (file == NULL) {
-        printf("Error opening file!\n");
-        return;
-    }
-
-    Order order;
-    int found = 0;
-    while (fread(&order, sizeof(Order), 1, file)) {
-        if (order.id == id) {
-            printf("\033[1;34m");
-            printf("%-5s %-15s %-20s %-15s %-10s %-10s\n", "ID", "Customer ID", "Order Date", "Total Amount", "Status", "Profit");
-            printf("==============================================================================\n");
-            printf("\033[0m");
-            char date[20];
-            strftime(date, sizeof(date), "%Y-%m-%d %H:%M:%S", localtime(&order.orderDate));
-            printf("%-5d %-15d %-20s $%-14.2f %-10s $%-9.2f\n", order.id, order.customerId, date, order.totalAmount, order.status, order.profit);
-            found = 1;
-            break;
-        }
-    }
-
-    fclose(file);
-
-    if (!found) {
+    if (!writeOrder(stdout, id)) {
         printf("Order not found!\n");
     }
 }
@@ -266,18 +514,8 @@ void searchOrder() {
  * @return int The generated unique ID
  */
 int generateUniqueOrderId() {
-    static int lastId = 0;
-    FILE *file = fopen(ORDERS_FILE, "rb");
-    if (file != NULL) {
-        Order order;
-        while (fread(&order, sizeof(Order), 1, file)) {
-            if (order.id > lastId) {
-                lastId = order.id;
-            }
-        }
-        fclose(file);
-    }
-    return ++lastId;
+    METRICS_SPAN(METRIC_NEW_ORDER_ID);
+    return metaAllocateId(TABLE_ORDERS);
 }
 
 /**
@@ -287,21 +525,8 @@ int generateUniqueOrderId() {
  * @return int 1 if order found, 0 otherwise
  */
 int getOrderById(int id, Order *order) {
-    FILE *file = fopen(ORDERS_FILE, "rb");
-    if (file == NULL) {
-        printf("Error opening file!\n");
-        return 0;
-    }
-
-    int found = 0;
-    while (fread(order, sizeof(Order), 1, file)) {
-        if (order->id == id) {
-            found = 1;
-            break;
-        }
-    }
-
-    fclose(file);
-    return found;
+    METRICS_SPAN(METRIC_GET_ORDER);
+    METRICS_SPAN_IDS(id, 0);
+    return tableGetById(TABLE_ORDERS, id, order, NULL);
 }
 
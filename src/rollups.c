@@ -0,0 +1,383 @@
+/*
+ * =====================================================================================
+ * File: rollups.c
+ * Description: Maintains per-day totals of the orders table in data/rollups.dat
+ *              (order count, revenue, cost, profit and how many orders are in
+ *              each status). The file is direct-addressed by day number, so the
+ *              totals of any date range are a single read of one small record
+ *              per day, however many orders those days hold.
+ *
+ *              Every order write applied by the write-ahead log adjusts the day
+ *              it left and the day it landed on. The header remembers how many
+ *              order slots the totals reflect; when that no longer matches
+ *              data/orders.dat (or after compaction, restores and interrupted
+ *              log applies) the totals are rebuilt from the orders, which a
+ *              parallel scan (scan.c) sums a partition per thread.
+ *
+ * Author: Chiemezie Agbo
+ * Date: 17-10-2026
+ * Version: 1.0
+ * =====================================================================================
+ */
+
+#define _XOPEN_SOURCE 700
+#define _DEFAULT_SOURCE
+#include "../include/rollups.h"
+#include "../include/columns.h"
+#include "../include/table.h"
+#include "../include/scan.h"
+#include "../include/metrics.h"
+#include "../include/utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define ROLLUPS_MAGIC 0x4C4C4F52u /* "ROLL" */
+#define ROLLUPS_VERSION 2
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    int64_t rows;
+} RollupsHeader;
+
+static off_t dayOffset(long day) {
+    return (off_t)sizeof(RollupsHeader) + (off_t)day * (off_t)sizeof(DailyRollup);
+}
+
+/**
+ * @brief Returns the number of days between 1970-01-01 and a civil date
+ */
+static long daysFromCivil(long year, long month, long day) {
+    year -= month <= 2;
+    long era = (year >= 0 ? year : year - 399) / 400;
+    long yearOfEra = year - era * 400;
+    long dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    long dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + dayOfEra - 719468;
+}
+
+/**
+ * @brief Returns the local day number a timestamp falls on
+ * @param timestamp The time to convert
+ * @return long Days since 1970-01-01, dates before that count as day 0
+ */
+long rollupDay(time_t timestamp) {
+    struct tm tm;
+    if (localtime_r(&timestamp, &tm) == NULL) {
+        return 0;
+    }
+    long day = daysFromCivil(tm.tm_year + 1900L, tm.tm_mon + 1L, tm.tm_mday);
+    return day < 0 ? 0 : day;
+}
+
+/**
+ * @brief rollupDay for scan workers, through the worker's day cache
+ */
+static long cachedRollupDay(ScanDayCache *cache, time_t timestamp) {
+    struct tm tm;
+    if (!scanLocalDate(cache, timestamp, &tm)) {
+        return 0;
+    }
+    long day = daysFromCivil(tm.tm_year + 1900L, tm.tm_mon + 1L, tm.tm_mday);
+    return day < 0 ? 0 : day;
+}
+
+/**
+ * @brief Returns the day number of a date string
+ * @param date Date in YYYY-MM-DD format
+ * @return long Days since 1970-01-01, -1 if the date cannot be parsed
+ */
+long rollupDayFromDate(const char *date) {
+    struct tm tm;
+    memset(&tm, 0, sizeof(tm));
+    if (strptime(date, "%Y-%m-%d", &tm) == NULL) {
+        return -1;
+    }
+    long day = daysFromCivil(tm.tm_year + 1900L, tm.tm_mon + 1L, tm.tm_mday);
+    return day < 0 ? 0 : day;
+}
+
+/**
+ * @brief Adds (sign 1) or removes (sign -1) an order from a day's totals
+ */
+static void rollupAdd(DailyRollup *rollup, const Order *order, int sign) {
+    uint8_t status = orderStatusCode(order->status);
+    rollup->orderCount += sign;
+    rollup->revenue += sign * order->totalAmount;
+    rollup->cost += sign * (order->totalAmount - order->profit);
+    rollup->profit += sign * order->profit;
+    if (status < ROLLUP_STATUS_KINDS) {
+        rollup->statusCounts[status] += sign;
+    }
+}
+
+static int readHeader(int fd, RollupsHeader *header) {
+    return ioPread(fd, header, sizeof(*header), 0) == (ssize_t)sizeof(*header) &&
+           header->magic == ROLLUPS_MAGIC && header->version == ROLLUPS_VERSION;
+}
+
+static int writeHeader(int fd, int64_t rows) {
+    RollupsHeader header = {ROLLUPS_MAGIC, ROLLUPS_VERSION, rows};
+    return ioPwrite(fd, &header, sizeof(header), 0) == (ssize_t)sizeof(header);
+}
+
+/**
+ * @brief Moves one order between day totals
+ * @return int 1 on success, 0 otherwise
+ */
+static int adjustDay(int fd, const Order *order, int sign) {
+    if (order == NULL || order->id <= 0) {
+        return 1; // Deleted orders are not counted
+    }
+
+    DailyRollup rollup;
+    off_t offset = dayOffset(rollupDay(order->orderDate));
+    ssize_t n = ioPread(fd, &rollup, sizeof(rollup), offset);
+    if (n != (ssize_t)sizeof(rollup)) {
+        memset(&rollup, 0, sizeof(rollup)); // Past the end or a hole: nothing yet
+    }
+    rollupAdd(&rollup, order, sign);
+    return ioPwrite(fd, &rollup, sizeof(rollup), offset) == (ssize_t)sizeof(rollup);
+}
+
+/**
+ * @brief Updates the day totals after the log applied an order write
+ * @param slot The slot the order was written to
+ * @param before The order previously stored in the slot, NULL for an append
+ * @param after The order as it is now stored, a tombstone included
+ * @return int 1 on success, 0 otherwise
+ *
+ * A write the totals cannot account for (a slot past their end, or a slot
+ * they cover whose previous contents are gone) marks them stale instead, so
+ * the next report rebuilds them.
+ */
+int rollupsApplyWrite(long slot, const Order *before, const Order *after) {
+    int fd = ioOpen(ROLLUPS_FILE, O_RDWR);
+    if (fd < 0) {
+        return 1;
+    }
+
+    RollupsHeader header;
+    int ok = 1;
+    if (!readHeader(fd, &header) || header.rows < 0) {
+        // Already stale, the next report rebuilds the totals
+    } else if (slot > header.rows || (slot < header.rows && before == NULL)) {
+        ok = writeHeader(fd, -1);
+    } else {
+        ok = adjustDay(fd, before, -1) && adjustDay(fd, after, 1);
+        if (ok && slot == header.rows) {
+            ok = writeHeader(fd, header.rows + 1);
+        }
+    }
+    close(fd);
+    return ok;
+}
+
+/* Day totals of one scan partition, over the days its orders fall on so far */
+typedef struct {
+    long firstDay;
+    long dayCount;
+    long capacity;
+    DailyRollup *days;
+    int failed;
+    ScanDayCache dayCache;
+} RollupsPartial;
+
+/**
+ * @brief Returns a partition's totals for a day, widening its range of days as needed
+ * @return DailyRollup* The day's totals, NULL if out of memory
+ */
+static DailyRollup *partialDay(RollupsPartial *partial, long day) {
+    if (partial->dayCount > 0 && day >= partial->firstDay && day < partial->firstDay + partial->dayCount) {
+        return &partial->days[day - partial->firstDay];
+    }
+
+    long firstDay = partial->dayCount == 0 || day < partial->firstDay ? day : partial->firstDay;
+    long lastDay = partial->dayCount == 0 || day >= partial->firstDay + partial->dayCount
+                       ? day
+                       : partial->firstDay + partial->dayCount - 1;
+    long dayCount = lastDay - firstDay + 1;
+    if (dayCount > partial->capacity) {
+        // Doubled, since orders mostly arrive one day after another
+        long capacity = dayCount > 2 * partial->capacity ? dayCount : 2 * partial->capacity;
+        DailyRollup *days = realloc(partial->days, (size_t)capacity * sizeof(DailyRollup));
+        if (days == NULL) {
+            return NULL;
+        }
+        partial->days = days;
+        partial->capacity = capacity;
+    }
+
+    // Existing totals move up when the range grows downwards; new days start at zero
+    long shift = partial->dayCount > 0 ? partial->firstDay - firstDay : 0;
+    memmove(partial->days + shift, partial->days, (size_t)partial->dayCount * sizeof(DailyRollup));
+    memset(partial->days, 0, (size_t)shift * sizeof(DailyRollup));
+    memset(partial->days + shift + partial->dayCount, 0,
+           (size_t)(dayCount - shift - partial->dayCount) * sizeof(DailyRollup));
+    partial->firstDay = firstDay;
+    partial->dayCount = dayCount;
+    return &partial->days[day - firstDay];
+}
+
+static void sumOrders(void *state, const void *records, long firstSlot, long count, void *arg) {
+    RollupsPartial *partial = state;
+    const Order *orders = records;
+    (void)firstSlot;
+    (void)arg;
+    for (long i = 0; i < count && !partial->failed; i++) {
+        if (orders[i].id <= 0) {
+            continue;
+        }
+        DailyRollup *day = partialDay(partial, cachedRollupDay(&partial->dayCache, orders[i].orderDate));
+        if (day == NULL) {
+            partial->failed = 1;
+        } else {
+            rollupAdd(day, &orders[i], 1);
+        }
+    }
+}
+
+static void addRollup(DailyRollup *total, const DailyRollup *day) {
+    total->orderCount += day->orderCount;
+    total->revenue += day->revenue;
+    total->cost += day->cost;
+    total->profit += day->profit;
+    for (int s = 0; s < ROLLUP_STATUS_KINDS; s++) {
+        total->statusCounts[s] += day->statusCounts[s];
+    }
+}
+
+/**
+ * @brief Rebuilds the day totals from data/orders.dat
+ * @return int 1 on success, 0 otherwise
+ *
+ * The orders are read by a parallel scan; each partition sums its own days
+ * and the partitions are then added up day by day. All totals are whole
+ * numbers, so the result does not depend on the number of threads.
+ */
+int rollupsRebuild(void) {
+    TableScan scan;
+    if (!scanOpen(TABLE_ORDERS, &scan)) {
+        return 0;
+    }
+    RollupsPartial partials[SCAN_MAX_THREADS];
+    int partitionCount;
+    int ok = scanRun(&scan, sumOrders, NULL, partials, sizeof(partials[0]), &partitionCount);
+    long count = scan.records;
+    scanClose(&scan);
+
+    long firstDay = -1, lastDay = -1;
+    for (int p = 0; p < partitionCount; p++) {
+        ok = ok && !partials[p].failed;
+        if (partials[p].dayCount > 0) {
+            long last = partials[p].firstDay + partials[p].dayCount - 1;
+            firstDay = firstDay < 0 || partials[p].firstDay < firstDay ? partials[p].firstDay : firstDay;
+            lastDay = last > lastDay ? last : lastDay;
+        }
+    }
+
+    DailyRollup *days = NULL;
+    long dayCount = firstDay < 0 ? 0 : lastDay - firstDay + 1;
+    if (ok && dayCount > 0 && (days = calloc((size_t)dayCount, sizeof(DailyRollup))) == NULL) {
+        ok = 0;
+    }
+    for (int p = 0; p < partitionCount; p++) {
+        for (long d = 0; ok && d < partials[p].dayCount; d++) {
+            addRollup(&days[partials[p].firstDay - firstDay + d], &partials[p].days[d]);
+        }
+        free(partials[p].days);
+    }
+    if (!ok) {
+        free(days);
+        return 0;
+    }
+
+    char tempFile[256];
+    tempFileName(tempFile, sizeof(tempFile), ROLLUPS_FILE);
+    int fd = ioOpen(tempFile, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        free(days);
+        return 0;
+    }
+
+    // Days before the first order are left as a hole and read back as zeros
+    ssize_t wanted = (ssize_t)((size_t)dayCount * sizeof(DailyRollup));
+    ok = writeHeader(fd, count) &&
+         (dayCount == 0 || ioPwrite(fd, days, (size_t)wanted, dayOffset(firstDay)) == wanted);
+    free(days);
+    ok = close(fd) == 0 && ok;
+    if (!ok || rename(tempFile, ROLLUPS_FILE) != 0) {
+        remove(tempFile);
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief Flushes the day totals to disk; called by the log's checkpoint
+ */
+void rollupsSync(void) {
+    int fd = ioOpen(ROLLUPS_FILE, O_RDONLY);
+    if (fd >= 0) {
+        fsync(fd);
+        close(fd);
+    }
+}
+
+/**
+ * @brief Adds up the day totals of an inclusive range of days
+ * @param firstDay The first day number
+ * @param lastDay The last day number
+ * @param total Output for the combined totals
+ * @return int 1 on success, 0 if data/orders.dat cannot be opened
+ */
+int rollupsSum(long firstDay, long lastDay, DailyRollup *total) {
+    memset(total, 0, sizeof(*total));
+    struct stat st;
+    if (stat(ORDERS_FILE, &st) != 0) {
+        return 0;
+    }
+    int64_t rows = (int64_t)(st.st_size / (off_t)sizeof(Order));
+
+    RollupsHeader header;
+    int fd = ioOpen(ROLLUPS_FILE, O_RDONLY);
+    if (fd < 0 || !readHeader(fd, &header) || header.rows != rows) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        if (!rollupsRebuild() || (fd = ioOpen(ROLLUPS_FILE, O_RDONLY)) < 0) {
+            return 0;
+        }
+    }
+
+    if (firstDay < 0) {
+        firstDay = 0;
+    }
+    if (lastDay < firstDay) {
+        close(fd);
+        return 1;
+    }
+
+    long dayCount = lastDay - firstDay + 1;
+    DailyRollup *days = calloc((size_t)dayCount, sizeof(DailyRollup));
+    if (days == NULL) {
+        close(fd);
+        return 0;
+    }
+
+    // Days past the end of the file read short and stay zero
+    ssize_t n = ioPread(fd, days, (size_t)dayCount * sizeof(DailyRollup), dayOffset(firstDay));
+    close(fd);
+    long available = n > 0 ? (long)(n / (ssize_t)sizeof(DailyRollup)) : 0;
+    ioCountScan(available);
+
+    for (long d = 0; d < available; d++) {
+        addRollup(total, &days[d]);
+    }
+    free(days);
+    return 1;
+}
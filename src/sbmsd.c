@@ -0,0 +1,59 @@
+/*
+ * =====================================================================================
+ * File: sbmsd.c
+ * Description: Entry point of the sbmsd server, which owns the data files and
+ *              serves sbms clients over a Unix domain socket (see server.c).
+ *
+ *              Usage: bin/sbmsd [-s socket] [-w workers]
+ *
+ *              SIGUSR1 makes it write its operation metrics to data/metrics.prom.
+ *              Operations slower than SBMS_SLOW_MS go to data/slowops.log.
+ *
+ * Author: Chiemezie Agbo
+ * Date: 17-10-2026
+ * Version: 1.0
+ * =====================================================================================
+ */
+
+#include "../include/server.h"
+#include "../include/admin.h"
+#include "../include/metrics.h"
+#include "../include/slowlog.h"
+#include "../include/utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief The main function of the server
+ * @return int 0 after a clean shutdown, 1 otherwise
+ */
+int main(int argc, char *argv[]) {
+    const char *socketPath = getenv("SBMS_SOCKET");
+    int workers = SERVER_DEFAULT_WORKERS;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            socketPath = argv[++i];
+        } else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc) {
+            workers = atoi(argv[++i]);
+        } else {
+            printf("Usage: %s [-s socket] [-w workers]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (workers < 1 || workers > SERVER_MAX_WORKERS) {
+        printf("Worker count must be between 1 and %d\n", SERVER_MAX_WORKERS);
+        return 1;
+    }
+
+    // Before any other thread starts, so only the metrics thread takes SIGUSR1
+    metricsStartSignalDump();
+    slowLogStart();
+    initializeSystem();
+    ensureDefaultAdmin();
+
+    printf("sbmsd listening on %s with %d workers\n", socketPath != NULL ? socketPath : SERVER_SOCKET_FILE, workers);
+    fflush(stdout);
+    return serverRun(socketPath != NULL ? socketPath : SERVER_SOCKET_FILE, workers) ? 0 : 1;
+}
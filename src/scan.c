@@ -0,0 +1,242 @@
+/*
+ * =====================================================================================
+ * File: scan.c
+ * Description: Parallel full scans of a table's data file. The records are split
+ *              into as many record-aligned ranges as there are threads (one per
+ *              core, up to SCAN_MAX_THREADS, and at least
+ *              SCAN_MIN_PARTITION_RECORDS records each). Every worker reads its
+ *              range with pread in runs of SCAN_CHUNK_BYTES and hands each run
+ *              to a visitor together with its own partial state, so workers
+ *              share nothing while they aggregate. The partials come back in
+ *              file order and the caller merges them; as long as the merge is
+ *              exact (sums of whole cents, counts) the result is the same as a
+ *              single pass over the file, whatever the number of threads.
+ *
+ *              The first range is scanned on the calling thread. I/O done on the
+ *              other workers is charged to the caller's metrics counters once
+ *              they finish.
+ *
+ *              localtime_r takes a process-wide lock in the C library, which
+ *              would serialize workers that convert every order date, so
+ *              visitors go through scanLocalDate and only convert again when a
+ *              timestamp falls outside the day they saw last.
+ *
+ * Author: Chiemezie Agbo
+ * Date: 17-10-2026
+ * Version: 1.0
+ * =====================================================================================
+ */
+
+#define _DEFAULT_SOURCE
+#include "../include/scan.h"
+#include "../include/metrics.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+typedef struct {
+    const TableScan *scan;
+    ScanVisitor visit;
+    void *arg;
+    void *partial;
+    long first;
+    long last;
+    int ok;
+    IoCounters io; /* Work done, if the worker ran on a thread of its own */
+} ScanWorker;
+
+static int configuredThreads = 0;
+
+/**
+ * @brief Returns the number of threads a scan uses at most
+ * @return int The count set by scanSetThreadCount, otherwise the number of cores up to SCAN_MAX_THREADS
+ */
+int scanThreadCount(void) {
+    if (configuredThreads > 0) {
+        return configuredThreads;
+    }
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cores < 1) {
+        return 1;
+    }
+    return cores < SCAN_MAX_THREADS ? (int)cores : SCAN_MAX_THREADS;
+}
+
+/**
+ * @brief Sets the number of threads scans use
+ * @param threads 1 to SCAN_MAX_THREADS; 0 goes back to one per core
+ */
+void scanSetThreadCount(int threads) {
+    configuredThreads = threads < 0 ? 0 : threads > SCAN_MAX_THREADS ? SCAN_MAX_THREADS : threads;
+}
+
+/**
+ * @brief Opens a table's data file for scanning
+ * @param table The table
+ * @param scan Output for the open scan; close it with scanClose
+ * @return int 1 on success (a missing file scans as empty), 0 otherwise
+ */
+int scanOpen(TableId table, TableScan *scan) {
+    const TableDef *def = getTableDef(table);
+    scan->table = table;
+    scan->recordSize = def->recordSize;
+    scan->records = 0;
+    scan->fd = ioOpen(def->dataFile, O_RDONLY);
+    if (scan->fd < 0) {
+        return errno == ENOENT;
+    }
+
+    struct stat st;
+    if (fstat(scan->fd, &st) != 0) {
+        scanClose(scan);
+        return 0;
+    }
+    // A record still being appended is left out, as by the table cache
+    scan->records = (long)(st.st_size / (off_t)scan->recordSize);
+    return 1;
+}
+
+/**
+ * @brief Closes a scan opened by scanOpen
+ */
+void scanClose(TableScan *scan) {
+    if (scan->fd >= 0) {
+        close(scan->fd);
+        scan->fd = -1;
+    }
+}
+
+static void *scanPartition(void *arg) {
+    ScanWorker *worker = arg;
+    const TableScan *scan = worker->scan;
+    IoCounters before;
+    ioCountersGet(&before);
+
+    long chunk = (long)(SCAN_CHUNK_BYTES / scan->recordSize);
+    chunk = chunk < 1 ? 1 : chunk;
+    chunk = chunk < worker->last - worker->first ? chunk : worker->last - worker->first;
+    unsigned char *buffer = malloc((size_t)chunk * scan->recordSize + 1);
+    worker->ok = buffer != NULL;
+
+    for (long slot = worker->first; worker->ok && slot < worker->last; slot += chunk) {
+        long count = worker->last - slot < chunk ? worker->last - slot : chunk;
+        ssize_t wanted = (ssize_t)((size_t)count * scan->recordSize);
+        // The file only shrinks when it is compacted or restored, which replaces it
+        worker->ok = ioPread(scan->fd, buffer, (size_t)wanted, (off_t)slot * (off_t)scan->recordSize) == wanted;
+        if (worker->ok) {
+            ioCountScan(count);
+            worker->visit(worker->partial, buffer, slot, count, worker->arg);
+        }
+    }
+    free(buffer);
+
+    IoCounters after;
+    ioCountersGet(&after);
+    worker->io.recordsScanned = after.recordsScanned - before.recordsScanned;
+    worker->io.bytesRead = after.bytesRead - before.bytesRead;
+    worker->io.bytesWritten = after.bytesWritten - before.bytesWritten;
+    worker->io.fileOpens = after.fileOpens - before.fileOpens;
+    return NULL;
+}
+
+/**
+ * @brief Visits every record of an open scan on several threads
+ * @param scan The scan
+ * @param visit Called for each run of records read, with the state of the partition it belongs to
+ * @param arg Passed to every visit call
+ * @param partials SCAN_MAX_THREADS blocks of partialSize bytes; zero-filled here, then one per partition
+ * @param partialSize Size of one partition's state
+ * @param partitions Output for the number of partitions used, in file order, at least 1
+ * @return int 1 if every record was read, 0 otherwise
+ *
+ * Visits of one partition come in slot order on one thread; different
+ * partitions run at the same time and must only touch their own state or
+ * disjoint parts of shared output.
+ */
+int scanRun(const TableScan *scan, ScanVisitor visit, void *arg, void *partials, size_t partialSize,
+            int *partitions) {
+    long byRecords = scan->records / SCAN_MIN_PARTITION_RECORDS;
+    int count = scanThreadCount();
+    if (byRecords < count) {
+        count = byRecords > 1 ? (int)byRecords : 1;
+    }
+    *partitions = count;
+    memset(partials, 0, (size_t)count * partialSize);
+
+    pthread_t threads[SCAN_MAX_THREADS];
+    ScanWorker workers[SCAN_MAX_THREADS];
+    int started[SCAN_MAX_THREADS] = {0};
+    for (int w = 0; w < count; w++) {
+        workers[w] = (ScanWorker){scan, visit, arg, (char *)partials + (size_t)w * partialSize,
+                                  scan->records * w / count, scan->records * (w + 1) / count, 0, {0, 0, 0, 0}};
+        started[w] = w > 0 && pthread_create(&threads[w], NULL, scanPartition, &workers[w]) == 0;
+    }
+
+    int ok = 1;
+    for (int w = 0; w < count; w++) {
+        if (!started[w]) {
+            scanPartition(&workers[w]);
+        }
+    }
+    for (int w = 0; w < count; w++) {
+        if (started[w]) {
+            pthread_join(threads[w], NULL);
+            ioCountersAdd(&workers[w].io);
+        }
+        ok = workers[w].ok && ok;
+    }
+    return ok;
+}
+
+static int sameDate(const struct tm *a, const struct tm *b) {
+    return a->tm_year == b->tm_year && a->tm_mon == b->tm_mon && a->tm_mday == b->tm_mday;
+}
+
+/**
+ * @brief Converts a timestamp to its local date, like localtime_r
+ * @param cache The calling worker's cache, zero-filled before its first use
+ * @param timestamp The time to convert
+ * @param date Output; only the year, month and day fields are meaningful
+ * @return int 1 on success, 0 if the time cannot be converted
+ *
+ * The first conversion on a day also works out where that day starts and
+ * ends, so further timestamps from the same day are answered without the C
+ * library. Local dates never go backwards, so a timestamp between two that
+ * fall on the same day always falls on that day too, DST changes included.
+ */
+int scanLocalDate(ScanDayCache *cache, time_t timestamp, struct tm *date) {
+    if (timestamp >= cache->start && timestamp < cache->end) {
+        *date = cache->date;
+        return 1;
+    }
+    if (localtime_r(&timestamp, date) == NULL) {
+        return 0;
+    }
+
+    struct tm first = *date;
+    first.tm_hour = first.tm_min = first.tm_sec = 0;
+    first.tm_isdst = -1;
+    struct tm next = first;
+    next.tm_mday += 1;
+    time_t start = mktime(&first);
+    time_t end = mktime(&next);
+
+    // A midnight that does not exist may be moved to either side of the gap, so check both ends
+    struct tm startDate;
+    struct tm lastDate;
+    time_t last = end - 1;
+    cache->start = cache->end = 0;
+    if (start != (time_t)-1 && end != (time_t)-1 && start <= timestamp && timestamp < end &&
+        localtime_r(&start, &startDate) != NULL && localtime_r(&last, &lastDate) != NULL &&
+        sameDate(&startDate, date) && sameDate(&lastDate, date)) {
+        cache->start = start;
+        cache->end = end;
+        cache->date = *date;
+    }
+    return 1;
+}
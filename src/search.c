@@ -0,0 +1,502 @@
+/*
+ * =====================================================================================
+ * File: search.c
+ * Description: Trigram index behind the inventory and customer substring search.
+ *              Every three-byte sequence of a searchable field is hashed into one
+ *              of SEARCH_BUCKETS posting lists of record slots. A search looks up
+ *              the lists of the term's trigrams, intersects them and checks only
+ *              the surviving records with the kernels in match.c, so collisions and stale
+ *              entries can never produce a wrong result.
+ *
+ *              The base file (e.g. data/inventory.tri) holds the posting lists
+ *              of a full build. Slots written since then are appended to a delta
+ *              file (e.g. data/inventory.trd) and always checked directly; once
+ *              the delta grows past a fraction of the table the base is rebuilt
+ *              and the delta emptied.
+ *
+ * Author: Chiemezie Agbo
+ * Date: 17-10-2026
+ * Version: 1.0
+ * =====================================================================================
+ */
+
+#define _DEFAULT_SOURCE
+#include "../include/search.h"
+#include "../include/cache.h"
+#include "../include/match.h"
+#include "../include/metrics.h"
+#include "../include/utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define SEARCH_MAGIC 0x49525453u /* "STRI" */
+#define SEARCH_VERSION 1
+#define SEARCH_MIN_DELTA 1024
+#define SEARCH_MAX_FIELDS 2
+#define SEARCH_MAX_TRIGRAMS (MAX_DESCRIPTION_LENGTH + MAX_EMAIL_LENGTH)
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    int64_t rows;
+    int64_t postingCount;
+} SearchHeader;
+
+typedef struct {
+    const char *baseFile;
+    const char *deltaFile;
+    const MatchField *fields;
+    int fieldCount;
+} SearchDef;
+
+static const MatchField inventoryFields[] = {
+    {offsetof(InventoryItem, name), MAX_NAME_LENGTH},
+    {offsetof(InventoryItem, description), MAX_DESCRIPTION_LENGTH},
+};
+
+static const MatchField customerFields[] = {
+    {offsetof(Customer, name), MAX_NAME_LENGTH},
+    {offsetof(Customer, email), MAX_EMAIL_LENGTH},
+};
+
+static const SearchDef searchDefs[TABLE_COUNT] = {
+    [TABLE_INVENTORY] = {INVENTORY_SEARCH_FILE, INVENTORY_SEARCH_DELTA_FILE, inventoryFields, 2},
+    [TABLE_CUSTOMERS] = {CUSTOMERS_SEARCH_FILE, CUSTOMERS_SEARCH_DELTA_FILE, customerFields, 2},
+};
+
+/* Bucket N's postings are entries directory[N] up to directory[N + 1] */
+static off_t directoryOffset(uint32_t bucket) {
+    return (off_t)sizeof(SearchHeader) + (off_t)bucket * (off_t)sizeof(uint32_t);
+}
+
+static off_t postingsOffset(uint32_t first) {
+    return directoryOffset(SEARCH_BUCKETS + 1) + (off_t)first * (off_t)sizeof(int32_t);
+}
+
+static uint32_t trigramBucket(const unsigned char *text) {
+    uint32_t hash = ((uint32_t)text[0] << 16) | ((uint32_t)text[1] << 8) | text[2];
+    hash *= 2654435761u;
+    return hash >> 16;
+}
+
+static int compareBuckets(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Collects the distinct trigram buckets of some strings
+ * @return int Number of buckets stored in buckets
+ */
+static int textBuckets(const char **texts, int textCount, uint32_t *buckets, int capacity) {
+    int count = 0;
+    for (int t = 0; t < textCount; t++) {
+        size_t length = strnlen(texts[t], MAX_DESCRIPTION_LENGTH);
+        for (size_t i = 0; i + 3 <= length && count < capacity; i++) {
+            buckets[count++] = trigramBucket((const unsigned char *)texts[t] + i);
+        }
+    }
+    qsort(buckets, (size_t)count, sizeof(uint32_t), compareBuckets);
+
+    int distinct = 0;
+    for (int i = 0; i < count; i++) {
+        if (distinct == 0 || buckets[distinct - 1] != buckets[i]) {
+            buckets[distinct++] = buckets[i];
+        }
+    }
+    return distinct;
+}
+
+static int recordBuckets(const SearchDef *search, const char *record, uint32_t *buckets) {
+    const char *fields[SEARCH_MAX_FIELDS];
+    for (int i = 0; i < search->fieldCount; i++) {
+        fields[i] = record + search->fields[i].offset;
+    }
+    return textBuckets(fields, search->fieldCount, buckets, SEARCH_MAX_TRIGRAMS);
+}
+
+/**
+ * @brief Rebuilds a table's trigram base file and empties its delta
+ * @param table TABLE_INVENTORY or TABLE_CUSTOMERS
+ * @return int 1 on success, 0 otherwise
+ */
+int searchIndexRebuild(TableId table) {
+    const SearchDef *search = &searchDefs[table];
+    const TableDef *def = getTableDef(table);
+    if (search->baseFile == NULL) {
+        return 0;
+    }
+
+    long count;
+    const char *records = cacheTable(table, &count);
+    if (count < 0) {
+        count = 0;
+    }
+
+    // Two passes: size every posting list, then fill them in slot order
+    uint32_t *directory = calloc(SEARCH_BUCKETS + 1, sizeof(uint32_t));
+    uint32_t *buckets = malloc(SEARCH_MAX_TRIGRAMS * sizeof(uint32_t));
+    if (directory == NULL || buckets == NULL) {
+        free(directory);
+        free(buckets);
+        return 0;
+    }
+
+    for (long slot = 0; slot < count; slot++) {
+        const char *record = records + (size_t)slot * def->recordSize;
+        if (recordId(record) <= 0) {
+            continue;
+        }
+        int n = recordBuckets(search, record, buckets);
+        for (int i = 0; i < n; i++) {
+            directory[buckets[i] + 1]++;
+        }
+    }
+    for (uint32_t b = 0; b < SEARCH_BUCKETS; b++) {
+        directory[b + 1] += directory[b];
+    }
+
+    uint32_t total = directory[SEARCH_BUCKETS];
+    int32_t *postings = malloc((size_t)total * sizeof(int32_t) + 1);
+    uint32_t *next = malloc(SEARCH_BUCKETS * sizeof(uint32_t));
+    int ok = postings != NULL && next != NULL;
+    if (ok) {
+        memcpy(next, directory, SEARCH_BUCKETS * sizeof(uint32_t));
+        for (long slot = 0; slot < count; slot++) {
+            const char *record = records + (size_t)slot * def->recordSize;
+            if (recordId(record) <= 0) {
+                continue;
+            }
+            int n = recordBuckets(search, record, buckets);
+            for (int i = 0; i < n; i++) {
+                postings[next[buckets[i]]++] = (int32_t)slot;
+            }
+        }
+    }
+
+    char tempFile[256];
+    tempFileName(tempFile, sizeof(tempFile), search->baseFile);
+    FILE *out = ok ? ioFopen(tempFile, "wb") : NULL;
+    if (out != NULL) {
+        SearchHeader header = {SEARCH_MAGIC, SEARCH_VERSION, count, total};
+        ok = ioFwrite(&header, sizeof(header), 1, out) == 1 &&
+             ioFwrite(directory, sizeof(uint32_t), SEARCH_BUCKETS + 1, out) == SEARCH_BUCKETS + 1 &&
+             ioFwrite(postings, sizeof(int32_t), total, out) == total;
+        ok = fclose(out) == 0 && ok;
+        ok = ok && rename(tempFile, search->baseFile) == 0;
+        if (!ok) {
+            remove(tempFile);
+        }
+    } else {
+        ok = 0;
+    }
+
+    free(directory);
+    free(buckets);
+    free(postings);
+    free(next);
+
+    // Everything in the delta is part of the new base now
+    if (ok) {
+        int fd = ioOpen(search->deltaFile, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        ok = fd >= 0;
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+    return ok;
+}
+
+static int readBaseHeader(const SearchDef *search, SearchHeader *header) {
+    int fd = ioOpen(search->baseFile, O_RDONLY);
+    if (fd < 0) {
+        return 0;
+    }
+    int ok = ioPread(fd, header, sizeof(*header), 0) == (ssize_t)sizeof(*header) &&
+             header->magic == SEARCH_MAGIC && header->version == SEARCH_VERSION;
+    close(fd);
+    return ok;
+}
+
+/**
+ * @brief Records that a slot was written so searches check it directly
+ * @param table The table that was written
+ * @param slot The slot that was written
+ * @return int 1 on success, 0 otherwise
+ */
+int searchIndexApplyWrite(TableId table, long slot) {
+    const SearchDef *search = &searchDefs[table];
+    if (search->baseFile == NULL) {
+        return 1;
+    }
+
+    int fd = ioOpen(search->deltaFile, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd < 0) {
+        return 0;
+    }
+    int32_t entry = (int32_t)slot;
+    int ok = ioWrite(fd, &entry, sizeof(entry)) == (ssize_t)sizeof(entry);
+
+    struct stat st;
+    long deltaEntries = fstat(fd, &st) == 0 ? (long)(st.st_size / (off_t)sizeof(int32_t)) : 0;
+    close(fd);
+
+    // Fold the delta into the base once checking it costs more than a fraction of a scan
+    SearchHeader header;
+    long limit = SEARCH_MIN_DELTA;
+    if (readBaseHeader(search, &header) && header.rows / 8 > limit) {
+        limit = (long)(header.rows / 8);
+    }
+    if (deltaEntries > limit) {
+        ok = searchIndexRebuild(table) && ok;
+    }
+    return ok;
+}
+
+/**
+ * @brief Flushes the search files to disk; called by the log's checkpoint
+ */
+void searchIndexSync(void) {
+    for (int t = 0; t < TABLE_COUNT; t++) {
+        const char *files[] = {searchDefs[t].baseFile, searchDefs[t].deltaFile};
+        for (int i = 0; i < 2; i++) {
+            int fd = files[i] != NULL ? ioOpen(files[i], O_RDONLY) : -1;
+            if (fd >= 0) {
+                fsync(fd);
+                close(fd);
+            }
+        }
+    }
+}
+
+static int compareSlots(const void *a, const void *b) {
+    long x = *(const long *)a, y = *(const long *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Reads the posting list of one bucket from the base file
+ * @return int32_t* The slots in ascending order (caller frees), NULL on failure
+ */
+static int32_t *readPostings(int fd, uint32_t bucket, long *count) {
+    uint32_t range[2];
+    if (ioPread(fd, range, sizeof(range), directoryOffset(bucket)) != (ssize_t)sizeof(range) || range[1] < range[0]) {
+        return NULL;
+    }
+
+    *count = (long)(range[1] - range[0]);
+    int32_t *postings = malloc((size_t)*count * sizeof(int32_t) + 1);
+    ssize_t wanted = (ssize_t)((size_t)*count * sizeof(int32_t));
+    if (postings != NULL && ioPread(fd, postings, (size_t)wanted, postingsOffset(range[0])) != wanted) {
+        free(postings);
+        return NULL;
+    }
+    return postings;
+}
+
+/**
+ * @brief Finds the base-file slots whose records contain every trigram of a term
+ * @return long Number of candidate slots stored in *candidates (caller frees), -1 on failure
+ */
+static long baseCandidates(const SearchDef *search, const uint32_t *buckets, int bucketCount, long **candidates) {
+    int fd = ioOpen(search->baseFile, O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+
+    long count = -1;
+    long *result = NULL;
+    for (int b = 0; b < bucketCount; b++) {
+        long postingCount;
+        int32_t *postings = readPostings(fd, buckets[b], &postingCount);
+        if (postings == NULL) {
+            free(result);
+            close(fd);
+            return -1;
+        }
+
+        if (result == NULL) {
+            result = malloc((size_t)postingCount * sizeof(long) + 1);
+            if (result == NULL) {
+                free(postings);
+                close(fd);
+                return -1;
+            }
+            for (long i = 0; i < postingCount; i++) {
+                result[i] = postings[i];
+            }
+            count = postingCount;
+        } else {
+            // Both lists are sorted, so intersect them in one merge pass
+            long kept = 0, j = 0;
+            for (long i = 0; i < count && j < postingCount; i++) {
+                while (j < postingCount && postings[j] < result[i]) {
+                    j++;
+                }
+                if (j < postingCount && postings[j] == result[i]) {
+                    result[kept++] = result[i];
+                }
+            }
+            count = kept;
+        }
+        free(postings);
+        if (count == 0) {
+            break;
+        }
+    }
+    close(fd);
+
+    *candidates = result;
+    return count < 0 ? 0 : count;
+}
+
+/**
+ * @brief Tells whether a record is live and one of its text fields contains a term
+ */
+static int recordMatches(const SearchDef *search, const char *record, const char *term, size_t termLength) {
+    if (recordId(record) <= 0) {
+        return 0;
+    }
+    for (int i = 0; i < search->fieldCount; i++) {
+        const MatchField *field = &search->fields[i];
+        if (fieldContains(record + field->offset, field->width, term, termLength)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Finds the matching slots of a whole table
+ * @return long Number of slots stored in *slots (caller frees), -1 on failure
+ */
+static long scanTable(const SearchDef *search, const TableDef *def, const char *records, long total,
+                      const char *term, long **slots) {
+    unsigned char *hits = malloc((size_t)total + 1);
+    *slots = malloc((size_t)total * sizeof(long) + 1);
+    if (hits == NULL || *slots == NULL) {
+        free(hits);
+        free(*slots);
+        *slots = NULL;
+        return -1;
+    }
+
+    matchRecords(records, total, def->recordSize, search->fields, search->fieldCount, term, hits);
+    ioCountScan(total);
+
+    long matches = 0;
+    for (long slot = 0; slot < total; slot++) {
+        if (hits[slot] && recordId(records + (size_t)slot * def->recordSize) > 0) {
+            (*slots)[matches++] = slot;
+        }
+    }
+    free(hits);
+    return matches;
+}
+
+/**
+ * @brief Finds the records of a table whose text fields contain a term
+ * @param table TABLE_INVENTORY or TABLE_CUSTOMERS
+ * @param term The substring to look for
+ * @param slots Output for a newly allocated array of matching slots in ascending order (caller frees)
+ * @param count Output for the number of matches
+ * @return int 1 on success, 0 if the table cannot be read
+ *
+ * Terms shorter than three bytes have no trigrams and fall back to a scan.
+ */
+int searchTable(TableId table, const char *term, long **slots, long *count) {
+    const SearchDef *search = &searchDefs[table];
+    const TableDef *def = getTableDef(table);
+    *slots = NULL;
+    *count = 0;
+
+    long total;
+    const char *records = cacheTable(table, &total);
+    if (total < 0) {
+        return 0;
+    }
+
+    uint32_t buckets[MAX_NAME_LENGTH];
+    const char *texts[1] = {term};
+    int bucketCount = search->baseFile != NULL ? textBuckets(texts, 1, buckets, MAX_NAME_LENGTH) : 0;
+
+    // Read the delta first so a rebuild it triggers is already on disk
+    long *candidates = NULL;
+    long candidateCount = -1;
+    if (bucketCount > 0) {
+        SearchHeader header;
+        int32_t *delta = NULL;
+        long deltaCount = 0, covered = 0;
+        int fd = ioOpen(search->deltaFile, O_RDONLY);
+        struct stat st;
+        if (fd >= 0 && fstat(fd, &st) == 0) {
+            deltaCount = (long)(st.st_size / (off_t)sizeof(int32_t));
+            delta = malloc((size_t)deltaCount * sizeof(int32_t) + 1);
+            ssize_t wanted = (ssize_t)((size_t)deltaCount * sizeof(int32_t));
+            if (delta == NULL || ioPread(fd, delta, (size_t)wanted, 0) != wanted) {
+                deltaCount = 0;
+            }
+        }
+        if (fd >= 0) {
+            close(fd);
+        }
+
+        int fresh = readBaseHeader(search, &header);
+        covered = fresh ? (long)header.rows : 0;
+        for (long i = 0; i < deltaCount; i++) {
+            if (delta[i] + 1L > covered) {
+                covered = delta[i] + 1L;
+            }
+        }
+
+        // Records appended without reaching the delta mean the files were replaced
+        if ((!fresh || covered != total) && searchIndexRebuild(table)) {
+            deltaCount = 0;
+            records = cacheTable(table, &total);
+        }
+
+        long baseCount = baseCandidates(search, buckets, bucketCount, &candidates);
+        if (baseCount >= 0) {
+            long *merged = realloc(candidates, (size_t)(baseCount + deltaCount) * sizeof(long) + 1);
+            if (merged != NULL) {
+                for (long i = 0; i < deltaCount; i++) {
+                    merged[baseCount + i] = delta[i];
+                }
+                candidates = merged;
+                candidateCount = baseCount + deltaCount;
+            }
+        }
+        free(delta);
+    }
+
+    if (candidateCount < 0) {
+        // No usable index: run the match kernel over the whole table
+        free(candidates);
+        *count = scanTable(search, def, records, total, term, slots);
+        return *count >= 0;
+    }
+
+    qsort(candidates, (size_t)candidateCount, sizeof(long), compareSlots);
+    ioCountScan(candidateCount);
+    size_t termLength = strlen(term);
+    long matches = 0;
+    for (long i = 0; i < candidateCount; i++) {
+        long slot = candidates[i];
+        if ((i > 0 && candidates[i - 1] == slot) || slot < 0 || slot >= total) {
+            continue; // Duplicate from the delta, or a slot past the end
+        }
+        if (recordMatches(search, records + (size_t)slot * def->recordSize, term, termLength)) {
+            candidates[matches++] = slot;
+        }
+    }
+
+    *slots = candidates;
+    *count = matches;
+    return 1;
+}
@@ -0,0 +1,469 @@
+/*
+ * =====================================================================================
+ * File: server.c
+ * Description: The sbmsd server and its client side. The server listens on a
+ *              Unix domain socket (data/sbmsd.sock) and keeps the tables, the
+ *              ID indexes, the caches and the log open for as long as it runs,
+ *              so terminals share one warm process instead of each reloading
+ *              the data files.
+ *
+ *              The protocol is the command mode's: a client sends one command
+ *              per line in the same syntax as an "sbms -" script and reads
+ *              back one line of JSON per command. The first command on a
+ *              connection must be "login USER PASSWORD"; "quit" closes it.
+ *
+ *              The main thread only polls: it accepts connections and hands a
+ *              connection that has data waiting to a pool of worker threads.
+ *              A worker reads what arrived, runs every complete line and gives
+ *              the connection back. Commands from different connections run
+ *              in parallel: writes lock only the record they change and go
+ *              through the log, which serialises its own appends, and the
+ *              caches are shared safely between threads. Only the commands
+ *              that replace whole files (restores, rebuilds, checkpoints and
+ *              the compaction that follows a command once enough records
+ *              were deleted) wait for the running commands and run alone.
+ *
+ * Author: Chiemezie Agbo
+ * Date: 17-10-2026
+ * Version: 1.0
+ * =====================================================================================
+ */
+
+#define _DEFAULT_SOURCE
+#include "../include/server.h"
+#include "../include/command.h"
+#include "../include/admin.h"
+#include "../include/wal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+typedef struct Connection {
+    int fd;
+    int closed;
+    CommandSession session; // Role 0 before login
+    size_t length;
+    char buffer[SERVER_MAX_REQUEST];
+    struct Connection *nextJob;
+} Connection;
+
+static struct {
+    int wakePipe[2];
+    volatile sig_atomic_t stopping;
+    pthread_mutex_t queueMutex;
+    pthread_cond_t queueCond;
+    Connection *queueHead;
+    Connection *queueTail;
+    int draining;
+    pthread_rwlock_t dataLock; // Held for reading by commands, for writing by those that run alone
+} server = {
+    {-1, -1}, 0, PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, NULL, NULL, 0, PTHREAD_RWLOCK_INITIALIZER,
+};
+
+static int sendAll(int fd, const char *data, size_t length) {
+    while (length > 0) {
+        ssize_t n = send(fd, data, length, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return 0;
+        }
+        data += n;
+        length -= (size_t)n;
+    }
+    return 1;
+}
+
+/* Hands a connection back to the main thread; a NULL connection asks it to stop */
+static void wakeMain(Connection *conn) {
+    ssize_t written;
+    do {
+        written = write(server.wakePipe[1], &conn, sizeof(conn));
+    } while (written < 0 && errno == EINTR);
+}
+
+/**
+ * @brief Runs one request line and sends its result
+ * @return int 1 to keep the connection open, 0 to close it
+ */
+static int handleRequest(Connection *conn, char *line) {
+    char *argv[COMMAND_MAX_ARGS];
+    int argc = commandSplitLine(line, argv, COMMAND_MAX_ARGS);
+    if (argc == 0) {
+        return 1; // Blank lines and comments get no reply, like in a script
+    }
+    if (argc > 0 && strcmp(argv[0], "quit") == 0) {
+        return 0;
+    }
+
+    char *result = NULL;
+    size_t resultLength = 0;
+    FILE *out = open_memstream(&result, &resultLength);
+    if (out == NULL) {
+        return 0;
+    }
+
+    if (argc < 0) {
+        fprintf(out, "{\"ok\":false,\"error\":\"cannot parse line\"}\n");
+    } else if (strcmp(argv[0], "login") == 0) {
+        memset(&conn->session, 0, sizeof(conn->session));
+        if (argc == 3 && strlen(argv[1]) < MAX_USERNAME_LENGTH && strlen(argv[2]) < MAX_PASSWORD_LENGTH) {
+            pthread_rwlock_rdlock(&server.dataLock);
+            conn->session.role = loginUser(argv[1], argv[2]);
+            pthread_rwlock_unlock(&server.dataLock);
+            strcpy(conn->session.username, argv[1]);
+        }
+        if (conn->session.role != 0) {
+            fprintf(out, "{\"ok\":true,\"admin\":%s}\n", conn->session.role == 2 ? "true" : "false");
+        } else {
+            fprintf(out, "{\"ok\":false,\"error\":\"invalid username or password\"}\n");
+        }
+    } else if (conn->session.role == 0) {
+        fprintf(out, "{\"ok\":false,\"error\":\"login required\"}\n");
+    } else {
+        if (commandExclusive(argc, argv)) {
+            pthread_rwlock_wrlock(&server.dataLock);
+        } else {
+            pthread_rwlock_rdlock(&server.dataLock);
+        }
+        commandRunAs(&conn->session, argc, argv, out);
+        pthread_rwlock_unlock(&server.dataLock);
+
+        // Compaction rewrites the data files, so it waits for the other commands
+        if (walCompactionDue()) {
+            pthread_rwlock_wrlock(&server.dataLock);
+            walCompact();
+            pthread_rwlock_unlock(&server.dataLock);
+        }
+    }
+
+    fclose(out);
+    int ok = sendAll(conn->fd, result, resultLength);
+    free(result);
+    return ok;
+}
+
+/**
+ * @brief Reads what a client sent and runs every complete line in it
+ *
+ * Sets conn->closed when the client went away or must be dropped.
+ */
+static void serveConnection(Connection *conn) {
+    ssize_t n = recv(conn->fd, conn->buffer + conn->length, sizeof(conn->buffer) - 1 - conn->length, 0);
+    if (n < 0 && (errno == EINTR || errno == EAGAIN)) {
+        return;
+    }
+    if (n <= 0) {
+        conn->closed = 1;
+        return;
+    }
+    conn->length += (size_t)n;
+
+    char *start = conn->buffer;
+    char *end = conn->buffer + conn->length;
+    char *newline;
+    while ((newline = memchr(start, '\n', (size_t)(end - start))) != NULL) {
+        *newline = '\0';
+        if (!handleRequest(conn, start)) {
+            conn->closed = 1;
+            return;
+        }
+        start = newline + 1;
+    }
+
+    // Keep a partial line for the next read
+    conn->length = (size_t)(end - start);
+    memmove(conn->buffer, start, conn->length);
+    if (conn->length == sizeof(conn->buffer) - 1) {
+        static const char tooLong[] = "{\"ok\":false,\"error\":\"request too long\"}\n";
+        sendAll(conn->fd, tooLong, sizeof(tooLong) - 1);
+        conn->closed = 1;
+    }
+}
+
+static void *workerThread(void *arg) {
+    (void)arg;
+    while (1) {
+        pthread_mutex_lock(&server.queueMutex);
+        while (server.queueHead == NULL && !server.draining) {
+            pthread_cond_wait(&server.queueCond, &server.queueMutex);
+        }
+        Connection *conn = server.queueHead;
+        if (conn == NULL) {
+            pthread_mutex_unlock(&server.queueMutex);
+            return NULL;
+        }
+        server.queueHead = conn->nextJob;
+        if (server.queueHead == NULL) {
+            server.queueTail = NULL;
+        }
+        pthread_mutex_unlock(&server.queueMutex);
+
+        serveConnection(conn);
+        wakeMain(conn);
+    }
+}
+
+static void enqueue(Connection *conn) {
+    pthread_mutex_lock(&server.queueMutex);
+    conn->nextJob = NULL;
+    if (server.queueTail != NULL) {
+        server.queueTail->nextJob = conn;
+    } else {
+        server.queueHead = conn;
+    }
+    server.queueTail = conn;
+    pthread_cond_signal(&server.queueCond);
+    pthread_mutex_unlock(&server.queueMutex);
+}
+
+static void handleSignal(int signo) {
+    (void)signo;
+    serverStop();
+}
+
+/**
+ * @brief Asks a running server to shut down; safe to call from a signal handler
+ */
+void serverStop(void) {
+    server.stopping = 1;
+    if (server.wakePipe[1] >= 0) {
+        wakeMain(NULL);
+    }
+}
+
+/**
+ * @brief Opens the listening socket, replacing a socket file left by a dead server
+ * @return int The socket, -1 on failure
+ */
+static int openListener(const char *socketPath) {
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(socketPath) >= sizeof(address.sun_path)) {
+        return -1;
+    }
+    strcpy(address.sun_path, socketPath);
+
+    ServerClient probe;
+    if (serverConnect(socketPath, &probe)) {
+        serverDisconnect(&probe);
+        printf("Another server is already listening on %s\n", socketPath);
+        return -1;
+    }
+    unlink(socketPath);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    if (bind(fd, (struct sockaddr *)&address, sizeof(address)) != 0 || chmod(socketPath, 0660) != 0 ||
+        listen(fd, SOMAXCONN) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * @brief Serves clients until serverStop() is called or SIGINT/SIGTERM arrives
+ * @param socketPath Where to listen
+ * @param workers Number of worker threads, 1 to SERVER_MAX_WORKERS
+ * @return int 1 after a clean shutdown, 0 if the server could not start
+ */
+int serverRun(const char *socketPath, int workers) {
+    int listenFd = openListener(socketPath);
+    if (listenFd < 0) {
+        printf("Error opening socket!\n");
+        return 0;
+    }
+    if (pipe(server.wakePipe) != 0) {
+        close(listenFd);
+        return 0;
+    }
+
+    server.stopping = 0;
+    server.draining = 0;
+    signal(SIGPIPE, SIG_IGN);
+    signal(SIGINT, handleSignal);
+    signal(SIGTERM, handleSignal);
+
+    pthread_t threads[SERVER_MAX_WORKERS];
+    int started = 0;
+    while (started < workers && started < SERVER_MAX_WORKERS &&
+           pthread_create(&threads[started], NULL, workerThread, NULL) == 0) {
+        started++;
+    }
+
+    Connection *conns[SERVER_MAX_CLIENTS];
+    int busy[SERVER_MAX_CLIENTS];
+    int connCount = 0;
+    struct pollfd fds[SERVER_MAX_CLIENTS + 2];
+    int polled[SERVER_MAX_CLIENTS];
+
+    while (!server.stopping && started > 0) {
+        fds[0].fd = listenFd;
+        fds[0].events = connCount < SERVER_MAX_CLIENTS ? POLLIN : 0;
+        fds[1].fd = server.wakePipe[0];
+        fds[1].events = POLLIN;
+        int nfds = 2;
+        for (int i = 0; i < connCount; i++) {
+            if (!busy[i]) {
+                fds[nfds].fd = conns[i]->fd;
+                fds[nfds].events = POLLIN;
+                polled[nfds - 2] = i;
+                nfds++;
+            }
+        }
+
+        if (poll(fds, (nfds_t)nfds, -1) < 0) {
+            continue; // EINTR; a stop request also arrives through the pipe
+        }
+
+        // Idle connections with data go to the workers
+        for (int p = 2; p < nfds; p++) {
+            if (fds[p].revents != 0) {
+                busy[polled[p - 2]] = 1;
+                enqueue(conns[polled[p - 2]]);
+            }
+        }
+
+        // Connections the workers are done with
+        if (fds[1].revents & POLLIN) {
+            Connection *conn;
+            if (read(server.wakePipe[0], &conn, sizeof(conn)) == (ssize_t)sizeof(conn) && conn != NULL) {
+                for (int i = 0; i < connCount; i++) {
+                    if (conns[i] != conn) {
+                        continue;
+                    }
+                    busy[i] = 0;
+                    if (conn->closed) {
+                        close(conn->fd);
+                        free(conn);
+                        conns[i] = conns[connCount - 1];
+                        busy[i] = busy[connCount - 1];
+                        connCount--;
+                    }
+                    break;
+                }
+            }
+        }
+
+        if (fds[0].revents & POLLIN) {
+            int fd = accept(listenFd, NULL, NULL);
+            if (fd >= 0) {
+                fcntl(fd, F_SETFD, FD_CLOEXEC);
+            }
+            Connection *conn = fd >= 0 ? calloc(1, sizeof(Connection)) : NULL;
+            if (conn != NULL) {
+                conn->fd = fd;
+                conns[connCount] = conn;
+                busy[connCount] = 0;
+                connCount++;
+            } else if (fd >= 0) {
+                close(fd);
+            }
+        }
+    }
+
+    // Let the workers finish what they hold, then close everything
+    pthread_mutex_lock(&server.queueMutex);
+    server.draining = 1;
+    pthread_cond_broadcast(&server.queueCond);
+    pthread_mutex_unlock(&server.queueMutex);
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    for (int i = 0; i < connCount; i++) {
+        close(conns[i]->fd);
+        free(conns[i]);
+    }
+
+    close(listenFd);
+    unlink(socketPath);
+    close(server.wakePipe[0]);
+    close(server.wakePipe[1]);
+    server.wakePipe[0] = server.wakePipe[1] = -1;
+    walCheckpoint();
+    return started > 0;
+}
+
+/**
+ * @brief Connects to a running server
+ * @param socketPath The server's socket
+ * @param client Output for the connection
+ * @return int 1 if connected, 0 if no server is listening there
+ */
+int serverConnect(const char *socketPath, ServerClient *client) {
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(socketPath) >= sizeof(address.sun_path)) {
+        return 0;
+    }
+    strcpy(address.sun_path, socketPath);
+
+    client->fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (client->fd < 0) {
+        return 0;
+    }
+    if (connect(client->fd, (struct sockaddr *)&address, sizeof(address)) != 0) {
+        close(client->fd);
+        return 0;
+    }
+
+    int readFd = dup(client->fd);
+    client->in = readFd >= 0 ? fdopen(readFd, "r") : NULL;
+    if (client->in == NULL) {
+        if (readFd >= 0) {
+            close(readFd);
+        }
+        close(client->fd);
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief Sends one command line and copies the reply to out
+ * @param client A connection from serverConnect()
+ * @param request The command, without a newline
+ * @param out Where the reply goes; NULL to drop it
+ * @return int 1 if the command succeeded, 0 if it failed, -1 if the connection was lost
+ */
+int serverRequest(ServerClient *client, const char *request, FILE *out) {
+    if (!sendAll(client->fd, request, strlen(request)) || !sendAll(client->fd, "\n", 1)) {
+        return -1;
+    }
+
+    char *line = NULL;
+    size_t capacity = 0;
+    if (getline(&line, &capacity, client->in) < 0) {
+        free(line);
+        return -1;
+    }
+    if (out != NULL) {
+        fputs(line, out);
+    }
+    int ok = strncmp(line, "{\"ok\":true", 10) == 0;
+    free(line);
+    return ok;
+}
+
+/**
+ * @brief Closes a connection from serverConnect()
+ */
+void serverDisconnect(ServerClient *client) {
+    fclose(client->in);
+    close(client->fd);
+}
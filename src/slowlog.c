@@ -0,0 +1,352 @@
+/*
+ * =====================================================================================
+ * File: slowlog.c
+ * Description: Append-only log of slow operations. Every call timed by a metrics
+ *              span (see metrics.c) that takes at least its operation's
+ *              threshold is written to data/slowops.log with its end time, its
+ *              arguments (record IDs, report date range), its wall time and
+ *              the records and bytes it read and wrote, e.g.
+ *
+ *              2026-10-17 14:03:12.481 place_order 1532.118 ms order=1042
+ *              customer=7 records=3 read_bytes=4096 written_bytes=812 file_opens=2
+ *
+ *              (one line per call). Calls under the threshold cost one relaxed
+ *              load and a compare. Slow calls are copied into a fixed ring of
+ *              entries without taking a lock, and a background thread formats
+ *              and appends them every SLOW_LOG_FLUSH_MS; nothing is written to
+ *              disk on the operation's own thread. If the ring fills faster
+ *              than it is flushed, the extra calls are counted and the count is
+ *              logged instead.
+ *
+ *              Thresholds come from the SBMS_SLOW_MS environment variable: a
+ *              number of milliseconds for every operation, then optional
+ *              overrides per operation, e.g.
+ *
+ *              SBMS_SLOW_MS=100,place_order=20,sales_report=2000,get_item=off
+ *
+ *              0 logs every call and off logs none. Without the variable the
+ *              threshold is SLOW_LOG_DEFAULT_MS. Nothing is logged until
+ *              slowLogStart or slowLogConfigure has run.
+ *
+ * Author: Chiemezie Agbo
+ * Date: 17-10-2026
+ * Version: 1.0
+ * =====================================================================================
+ */
+
+#define _DEFAULT_SOURCE
+#include "../include/slowlog.h"
+#include "../include/common.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+
+#define RING_MASK (SLOW_LOG_RING_SIZE - 1)
+#define LINE_LENGTH 256
+
+typedef struct {
+    /* The lap (ring position with the index bits cleared) the entry is free
+       for, plus one once it has been filled; all zero is an empty ring */
+    _Atomic size_t lap;
+    MetricOp op;
+    uint64_t nanoseconds;
+    IoCounters io;
+    int ids[2];
+    char from[16];
+    char to[16];
+    struct timespec endedAt;
+} SlowEntry;
+
+static struct {
+    SlowEntry entries[SLOW_LOG_RING_SIZE];
+    _Atomic size_t head;     /* Next position a slow call takes */
+    size_t tail;             /* Next position to flush, under flushMutex */
+    _Atomic uint64_t dropped;
+} ring;
+
+/* Nanoseconds from which a call is logged; 0 means never */
+static _Atomic uint64_t thresholds[METRIC_COUNT];
+static pthread_mutex_t flushMutex = PTHREAD_MUTEX_INITIALIZER;
+static char flushBuffer[(SLOW_LOG_RING_SIZE + 2) * LINE_LENGTH];
+
+/* What the IDs of each operation are, as written to the log */
+static const char *idNames[METRIC_COUNT][2] = {
+    [METRIC_ADD_ITEM] = {"item", NULL},
+    [METRIC_UPDATE_ITEM] = {"item", NULL},
+    [METRIC_DELETE_ITEM] = {"item", NULL},
+    [METRIC_GET_ITEM] = {"item", NULL},
+    [METRIC_UPDATE_ITEM_BY_ID] = {"item", NULL},
+    [METRIC_PLACE_ORDER] = {"order", "customer"},
+    [METRIC_PLACE_ORDER_BATCH] = {"order", "customer"},
+    [METRIC_COMMIT_ORDER] = {"order", "customer"},
+    [METRIC_UPDATE_ORDER_STATUS] = {"order", NULL},
+    [METRIC_SEARCH_ORDER] = {"order", NULL},
+    [METRIC_GET_ORDER] = {"order", NULL},
+    [METRIC_ADD_CUSTOMER] = {"customer", NULL},
+    [METRIC_UPDATE_CUSTOMER] = {"customer", NULL},
+    [METRIC_DELETE_CUSTOMER] = {"customer", NULL},
+    [METRIC_GET_CUSTOMER] = {"customer", NULL},
+    [METRIC_PRODUCT_REPORT] = {"item", NULL},
+    [METRIC_RESTORE_TO_POINT] = {"until_order", NULL},
+};
+
+/* Reads milliseconds, or off, as a threshold in nanoseconds; returns 0 if invalid */
+static int parseThreshold(const char *text, size_t length, uint64_t *threshold) {
+    char value[32];
+    if (length == 0 || length >= sizeof(value)) {
+        return 0;
+    }
+    memcpy(value, text, length);
+    value[length] = '\0';
+    if (strcmp(value, "off") == 0) {
+        *threshold = 0;
+        return 1;
+    }
+
+    char *end;
+    double milliseconds = strtod(value, &end);
+    if (*end != '\0' || !(milliseconds >= 0) || milliseconds > 3.6e7) {
+        return 0;
+    }
+    // A threshold of 0 would read as off, so logging every call starts at 1 ns
+    uint64_t nanoseconds = (uint64_t)(milliseconds * 1e6 + 0.5);
+    *threshold = nanoseconds > 0 ? nanoseconds : 1;
+    return 1;
+}
+
+static int findOperation(const char *name, size_t length) {
+    for (int op = 0; op < METRIC_COUNT; op++) {
+        const char *opName = metricsName((MetricOp)op);
+        if (strlen(opName) == length && strncmp(opName, name, length) == 0) {
+            return op;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Sets the thresholds of every operation from a specification
+ * @param spec Milliseconds for every operation followed by comma-separated
+ *             name=milliseconds overrides, e.g. "100,sales_report=2000";
+ *             "off" instead of a number disables logging. NULL or empty
+ *             means SLOW_LOG_DEFAULT_MS for everything.
+ * @return int 1 on success, 0 if the specification is invalid (nothing changes then)
+ */
+int slowLogConfigure(const char *spec) {
+    uint64_t parsed[METRIC_COUNT];
+    for (int op = 0; op < METRIC_COUNT; op++) {
+        parsed[op] = (uint64_t)SLOW_LOG_DEFAULT_MS * 1000000;
+    }
+
+    for (const char *field = spec; field != NULL && *field != '\0';) {
+        const char *comma = strchr(field, ',');
+        size_t length = comma != NULL ? (size_t)(comma - field) : strlen(field);
+        const char *equals = memchr(field, '=', length);
+        uint64_t threshold;
+
+        if (equals == NULL) {
+            // Only the first field may set every operation at once
+            if (field != spec || !parseThreshold(field, length, &threshold)) {
+                return 0;
+            }
+            for (int op = 0; op < METRIC_COUNT; op++) {
+                parsed[op] = threshold;
+            }
+        } else {
+            int op = findOperation(field, (size_t)(equals - field));
+            if (op < 0 || !parseThreshold(equals + 1, length - (size_t)(equals - field) - 1, &threshold)) {
+                return 0;
+            }
+            parsed[op] = threshold;
+        }
+        field = comma != NULL ? comma + 1 : NULL;
+    }
+
+    for (int op = 0; op < METRIC_COUNT; op++) {
+        atomic_store_explicit(&thresholds[op], parsed[op], memory_order_relaxed);
+    }
+    return 1;
+}
+
+/**
+ * @brief Sets the threshold of one operation
+ * @param op The operation
+ * @param nanoseconds Calls at least this long are logged; 0 logs none
+ */
+void slowLogSetThreshold(MetricOp op, uint64_t nanoseconds) {
+    atomic_store_explicit(&thresholds[op], nanoseconds, memory_order_relaxed);
+}
+
+/**
+ * @brief Returns the threshold of one operation
+ * @return uint64_t Nanoseconds, or 0 if the operation is not logged
+ */
+uint64_t slowLogThreshold(MetricOp op) {
+    return atomic_load_explicit(&thresholds[op], memory_order_relaxed);
+}
+
+/**
+ * @brief Queues a finished call for the log if it reached its operation's threshold
+ * @param span The call's span, with its arguments
+ * @param nanoseconds How long the call took
+ * @param io The I/O the call did
+ *
+ * Takes no lock: concurrent callers claim ring positions with a compare-and-swap
+ * and publish each filled entry with a release store of its lap.
+ */
+void slowLogNote(const MetricSpan *span, uint64_t nanoseconds, const IoCounters *io) {
+    uint64_t threshold = atomic_load_explicit(&thresholds[span->op], memory_order_relaxed);
+    if (threshold == 0 || nanoseconds < threshold) {
+        return;
+    }
+
+    size_t position = atomic_load_explicit(&ring.head, memory_order_relaxed);
+    for (;;) {
+        SlowEntry *entry = &ring.entries[position & RING_MASK];
+        size_t lap = position & ~(size_t)RING_MASK;
+        size_t entryLap = atomic_load_explicit(&entry->lap, memory_order_acquire);
+
+        if (entryLap == lap) {
+            if (atomic_compare_exchange_weak_explicit(&ring.head, &position, position + 1, memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                entry->op = span->op;
+                entry->nanoseconds = nanoseconds;
+                entry->io = *io;
+                entry->ids[0] = span->ids[0];
+                entry->ids[1] = span->ids[1];
+                snprintf(entry->from, sizeof(entry->from), "%s", span->from != NULL ? span->from : "");
+                snprintf(entry->to, sizeof(entry->to), "%s", span->to != NULL ? span->to : "");
+                clock_gettime(CLOCK_REALTIME, &entry->endedAt);
+                atomic_store_explicit(&entry->lap, lap + 1, memory_order_release);
+                return;
+            }
+        } else if ((ptrdiff_t)(entryLap - lap) < 0) {
+            // Still holds a call from the previous lap that has not been flushed
+            atomic_fetch_add_explicit(&ring.dropped, 1, memory_order_relaxed);
+            return;
+        } else {
+            position = atomic_load_explicit(&ring.head, memory_order_relaxed);
+        }
+    }
+}
+
+static size_t formatTime(char *out, size_t size, const struct timespec *at) {
+    struct tm tm;
+    time_t seconds = at->tv_sec;
+    localtime_r(&seconds, &tm);
+    size_t length = strftime(out, size, "%Y-%m-%d %H:%M:%S", &tm);
+    return length + (size_t)snprintf(out + length, size - length, ".%03ld", at->tv_nsec / 1000000);
+}
+
+static size_t formatEntry(char *out, const SlowEntry *entry) {
+    size_t length = formatTime(out, LINE_LENGTH, &entry->endedAt);
+    length += (size_t)snprintf(out + length, LINE_LENGTH - length, " %s %.3f ms", metricsName(entry->op),
+                               (double)entry->nanoseconds / 1e6);
+    for (int i = 0; i < 2; i++) {
+        if (idNames[entry->op][i] != NULL && entry->ids[i] != 0) {
+            length += (size_t)snprintf(out + length, LINE_LENGTH - length, " %s=%d", idNames[entry->op][i],
+                                       entry->ids[i]);
+        }
+    }
+    if (entry->from[0] != '\0' || entry->to[0] != '\0') {
+        length += (size_t)snprintf(out + length, LINE_LENGTH - length, " from=%s to=%s", entry->from, entry->to);
+    }
+    length += (size_t)snprintf(out + length, LINE_LENGTH - length,
+                               " records=%llu read_bytes=%llu written_bytes=%llu file_opens=%llu\n",
+                               (unsigned long long)entry->io.recordsScanned,
+                               (unsigned long long)entry->io.bytesRead,
+                               (unsigned long long)entry->io.bytesWritten,
+                               (unsigned long long)entry->io.fileOpens);
+    return length < LINE_LENGTH ? length : LINE_LENGTH - 1;
+}
+
+/**
+ * @brief Appends every queued slow call to SLOW_LOG_FILE
+ * @return int 1 on success or if there was nothing to write, 0 otherwise
+ *
+ * Called by the flush thread and at exit. The file is opened for each batch,
+ * so it may be rotated or removed at any time.
+ */
+int slowLogFlush(void) {
+    pthread_mutex_lock(&flushMutex);
+    int ok = 1;
+    size_t count;
+    do {
+        // At most one ring's worth per write, since callers keep refilling the entries freed here
+        size_t length = 0;
+        for (count = 0; count < SLOW_LOG_RING_SIZE; count++) {
+            SlowEntry *entry = &ring.entries[ring.tail & RING_MASK];
+            size_t lap = ring.tail & ~(size_t)RING_MASK;
+            if (atomic_load_explicit(&entry->lap, memory_order_acquire) != lap + 1) {
+                break;
+            }
+            length += formatEntry(flushBuffer + length, entry);
+            atomic_store_explicit(&entry->lap, lap + SLOW_LOG_RING_SIZE, memory_order_release);
+            ring.tail++;
+        }
+
+        uint64_t dropped = atomic_exchange_explicit(&ring.dropped, 0, memory_order_relaxed);
+        if (dropped > 0) {
+            struct timespec now;
+            clock_gettime(CLOCK_REALTIME, &now);
+            length += formatTime(flushBuffer + length, LINE_LENGTH, &now);
+            length += (size_t)snprintf(flushBuffer + length, LINE_LENGTH,
+                                       " %llu slow operations not logged, the log buffer was full\n",
+                                       (unsigned long long)dropped);
+        }
+
+        if (length > 0) {
+            // Kept out of the metrics counters, which belong to the operations
+            int fd = open(SLOW_LOG_FILE, O_WRONLY | O_CREAT | O_APPEND, 0644);
+            ok = fd >= 0 && write(fd, flushBuffer, length) == (ssize_t)length && ok;
+            if (fd >= 0) {
+                ok = close(fd) == 0 && ok;
+            }
+        }
+    } while (count == SLOW_LOG_RING_SIZE);
+    pthread_mutex_unlock(&flushMutex);
+    return ok;
+}
+
+static void *flushThread(void *arg) {
+    (void)arg;
+    for (;;) {
+        struct timespec ts = {0, SLOW_LOG_FLUSH_MS * 1000000L};
+        nanosleep(&ts, NULL);
+        slowLogFlush();
+    }
+    return NULL;
+}
+
+static void flushAtExit(void) {
+    slowLogFlush();
+}
+
+/**
+ * @brief Reads the thresholds from SBMS_SLOW_MS and starts the flush thread
+ * @return int 1 on success, 0 otherwise
+ *
+ * An invalid SBMS_SLOW_MS is reported and the default threshold used instead.
+ * Whatever is still queued at exit is flushed then.
+ */
+int slowLogStart(void) {
+    const char *spec = getenv("SBMS_SLOW_MS");
+    if (!slowLogConfigure(spec)) {
+        printf("Invalid SBMS_SLOW_MS \"%s\", logging operations slower than %d ms\n", spec, SLOW_LOG_DEFAULT_MS);
+        slowLogConfigure(NULL);
+    }
+
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, flushThread, NULL) != 0) {
+        return 0;
+    }
+    pthread_detach(thread);
+    atexit(flushAtExit);
+    return 1;
+}
@@ -0,0 +1,467 @@
+/*
+ * =====================================================================================
+ * File: table.c
+ * Description: Provides slot-based access to the fixed-size record files used by
+ *              the inventory, customer and order modules. Every record starts with
+ *              its integer ID, so a single set of routines can read, write, append,
+ *              look up and delete records for all tables, keeping the per-table
+ *              ID index (see index.c) up to date along the way. Reads are served
+ *              from the table cache (see cache.c); every write is committed
+ *              through the write-ahead log (see wal.c), which then applies it.
+ *              Order writes are also copied into the report columns (see
+ *              columns.c) and the daily totals (see rollups.c), and order line
+ *              writes into the line indexes (see orderlines.c).
+ *
+ *              Deleting a record only negates its ID in place (a tombstone).
+ *              Scans skip records whose ID is not positive, and compaction
+ *              rewrites the file without them once enough have piled up.
+ *
+ * Author: Chiemezie Agbo
+ * Date: 17-10-2026
+ * Version: 1.0
+ * =====================================================================================
+ */
+
+#define _DEFAULT_SOURCE
+#include "../include/table.h"
+#include "../include/index.h"
+#include "../include/cache.h"
+#include "../include/wal.h"
+#include "../include/utils.h"
+#include "../include/admin.h"
+#include "../include/meta.h"
+#include "../include/columns.h"
+#include "../include/rollups.h"
+#include "../include/orderlines.h"
+#include "../include/search.h"
+#include "../include/hotstore.h"
+#include "../include/metrics.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+static const TableDef tableDefs[TABLE_COUNT] = {
+    [TABLE_INVENTORY] = {"inventory", INVENTORY_FILE, INVENTORY_INDEX_FILE, INVENTORY_META_FILE, INVENTORY_LOCK_FILE, sizeof(InventoryItem)},
+    [TABLE_CUSTOMERS] = {"customers", CUSTOMERS_FILE, CUSTOMERS_INDEX_FILE, CUSTOMERS_META_FILE, CUSTOMERS_LOCK_FILE, sizeof(Customer)},
+    [TABLE_ORDERS] = {"orders", ORDERS_FILE, ORDERS_INDEX_FILE, ORDERS_META_FILE, ORDERS_LOCK_FILE, sizeof(Order)},
+    [TABLE_USERS] = {"users", USERS_FILE, NULL, USERS_META_FILE, USERS_LOCK_FILE, sizeof(User)},
+    [TABLE_ORDER_LINES] = {"order_lines", ORDER_LINES_FILE, ORDER_LINES_INDEX_FILE, ORDER_LINES_META_FILE, ORDER_LINES_LOCK_FILE, sizeof(OrderLine)},
+};
+
+/**
+ * @brief Returns the static description of a table
+ * @param table The table to describe
+ * @return const TableDef* The table definition
+ */
+const TableDef *getTableDef(TableId table) {
+    return &tableDefs[table];
+}
+
+/**
+ * @brief Extracts the ID stored at the start of a record
+ * @param record Pointer to an InventoryItem, Customer or Order
+ * @return int The record ID
+ */
+int recordId(const void *record) {
+    int id;
+    memcpy(&id, record, sizeof(id));
+    return id;
+}
+
+/**
+ * @brief Returns the number of record slots in a table's data file
+ * @param table The table to inspect
+ * @return long The number of slots, 0 if the file does not exist
+ */
+long tableRecordCount(TableId table) {
+    long count;
+    cacheTable(table, &count);
+    return count < 0 ? 0 : count;
+}
+
+/**
+ * @brief Reads the record stored in a given slot
+ * @param table The table to read from
+ * @param slot The zero-based record slot
+ * @param record Buffer of at least recordSize bytes
+ * @return int 1 if the record was read, 0 otherwise
+ */
+int tableReadSlot(TableId table, long slot, void *record) {
+    const TableDef *def = getTableDef(table);
+    long count;
+    const char *records = cacheTable(table, &count);
+    if (count < 0) {
+        printf("Error opening file!\n");
+        return 0;
+    }
+    if (slot < 0 || slot >= count) {
+        return 0;
+    }
+
+    memcpy(record, records + (size_t)slot * def->recordSize, def->recordSize);
+    ioCountScan(1);
+    return 1;
+}
+
+/**
+ * @brief Overwrites the record stored in a given slot
+ * @param table The table to write to
+ * @param slot The zero-based record slot
+ * @param record The new record contents
+ * @return int 1 on success, 0 otherwise
+ */
+int tableWriteSlot(TableId table, long slot, const void *record) {
+    WalTxn txn;
+    walBegin(&txn);
+    walLogWrite(&txn, table, slot, record);
+    int ok = walCommit(&txn);
+    walEnd(&txn);
+
+    if (!ok) {
+        printf("Error opening file!\n");
+    }
+    return ok;
+}
+
+/**
+ * @brief Appends a record to the end of a table and indexes it
+ * @param table The table to append to
+ * @param record The record to append
+ * @return long The slot the record was written to, -1 on failure
+ */
+long tableAppend(TableId table, const void *record) {
+    WalTxn txn;
+    walBegin(&txn);
+    int op = walLogWrite(&txn, table, WAL_APPEND_SLOT, record);
+    long slot = walCommit(&txn) ? walSlot(&txn, op) : -1;
+    walEnd(&txn);
+
+    if (slot < 0) {
+        printf("Error opening file!\n");
+    }
+    return slot;
+}
+
+/**
+ * @brief Retrieves a record through the table's ID index
+ * @param table The table to search
+ * @param id The ID of the record to retrieve
+ * @param record Buffer to store the record
+ * @param slot Optional output for the slot the record lives in
+ * @return int 1 if found, 0 otherwise
+ */
+int tableGetById(TableId table, int id, void *record, long *slot) {
+    for (int attempt = 0; attempt < 2; attempt++) {
+        long found = indexLookup(table, id);
+        if (found < 0) {
+            return 0;
+        }
+
+        if (tableReadSlot(table, found, record) && recordId(record) == id) {
+            if (slot != NULL) {
+                *slot = found;
+            }
+            return 1;
+        }
+
+        // The index points at the wrong record, so the data file changed behind our back
+        indexRebuild(table);
+    }
+    return 0;
+}
+
+/**
+ * @brief Overwrites the stored record that has the same ID as the given record
+ * @param table The table to update
+ * @param record The updated record
+ * @return int 1 if the record was found and written, 0 otherwise
+ */
+int tableUpdateById(TableId table, const void *record) {
+    const TableDef *def = getTableDef(table);
+    char *current = malloc(def->recordSize);
+    if (current == NULL) {
+        return 0;
+    }
+
+    long slot;
+    int found = tableGetById(table, recordId(record), current, &slot);
+    free(current);
+    if (!found) {
+        return 0;
+    }
+    return tableWriteSlot(table, slot, record);
+}
+
+/**
+ * @brief Deletes a record by turning it into a tombstone
+ * @param table The table to delete from
+ * @param id The ID of the record to delete
+ * @return int 1 if the record was found and removed, 0 otherwise
+ */
+int tableDeleteById(TableId table, int id) {
+    const TableDef *def = getTableDef(table);
+    char *record = malloc(def->recordSize);
+    long slot;
+    int found = record != NULL && tableGetById(table, id, record, &slot);
+    free(record);
+    if (!found) {
+        return 0;
+    }
+
+    WalTxn txn;
+    walBegin(&txn);
+    walLogDelete(&txn, table, slot, id);
+    int ok = walCommit(&txn);
+    walEnd(&txn);
+    return ok;
+}
+
+/* Previous contents of a record, kept for the tables with derived structures */
+typedef union {
+    InventoryItem item;
+    Customer customer;
+    Order order;
+    OrderLine line;
+} DerivedRecord;
+
+static int hasDerived(TableId table) {
+    return table != TABLE_USERS;
+}
+
+/**
+ * @brief Brings the structures derived from a table up to date after a write
+ * @param before The record previously in the slot, NULL for an append
+ * @param after The record as it is now stored
+ */
+static void updateDerived(TableId table, long slot, const void *before, const void *after) {
+    switch (table) {
+        case TABLE_ORDERS:
+            columnsApplyWrite(slot, after);
+            rollupsApplyWrite(slot, before, after);
+            break;
+        case TABLE_ORDER_LINES:
+            orderLinesApplyWrite(slot, before, after);
+            break;
+        case TABLE_INVENTORY:
+        case TABLE_CUSTOMERS:
+            hotApplyWrite(table, slot, after);
+            // Deletes need nothing more: searches skip tombstones when checking candidates
+            if (recordId(after) > 0) {
+                searchIndexApplyWrite(table, slot);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief Rebuilds every structure derived from a table's data file
+ * @param table The table whose columns, totals or secondary indexes to rebuild
+ */
+void tableRebuildDerived(TableId table) {
+    switch (table) {
+        case TABLE_ORDERS:
+            columnsRebuild();
+            rollupsRebuild();
+            break;
+        case TABLE_ORDER_LINES:
+            orderLinesRebuildIndex();
+            break;
+        case TABLE_INVENTORY:
+        case TABLE_CUSTOMERS:
+            hotRebuild(table);
+            searchIndexRebuild(table);
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief Writes a record straight into a table's data file
+ * @param table The table to write to
+ * @param slot The zero-based record slot
+ * @param record The record contents
+ * @return int 1 on success, 0 otherwise
+ *
+ * Only the write-ahead log calls this; everything else goes through it.
+ */
+int tableApplyWrite(TableId table, long slot, const void *record) {
+    const TableDef *def = getTableDef(table);
+
+    // Derived structures need the record this write replaces
+    DerivedRecord before;
+    int replaced = 0;
+    if (hasDerived(table)) {
+        long count;
+        const char *records = cacheTable(table, &count);
+        if (slot < count) {
+            memcpy(&before, records + (size_t)slot * def->recordSize, def->recordSize);
+            replaced = 1;
+        }
+    }
+
+    int fd = ioOpen(def->dataFile, O_WRONLY | O_CREAT, 0644);
+    if (fd < 0) {
+        return 0;
+    }
+
+    ssize_t n = ioPwrite(fd, record, def->recordSize, (off_t)slot * (off_t)def->recordSize);
+    close(fd);
+    if (n != (ssize_t)def->recordSize) {
+        return 0;
+    }
+
+    if (hasDerived(table)) {
+        updateDerived(table, slot, replaced ? &before : NULL, record);
+    }
+    return 1;
+}
+
+/**
+ * @brief Marks the record in a slot as deleted by negating its ID
+ * @param table The table to delete from
+ * @param slot The slot holding the record
+ * @return int 1 on success, 0 otherwise
+ *
+ * Only the write-ahead log calls this; everything else goes through it.
+ */
+int tableApplyTombstone(TableId table, long slot) {
+    const TableDef *def = getTableDef(table);
+    long count;
+    const char *records = cacheTable(table, &count);
+    if (slot < 0 || slot >= count) {
+        return 0;
+    }
+
+    int id = recordId(records + (size_t)slot * def->recordSize);
+    if (id <= 0) {
+        return 1; // Already a tombstone, e.g. when the log is replayed
+    }
+
+    DerivedRecord before;
+    if (hasDerived(table)) {
+        memcpy(&before, records + (size_t)slot * def->recordSize, def->recordSize);
+    }
+
+    int tombstone = -id;
+    int fd = ioOpen(def->dataFile, O_WRONLY);
+    if (fd < 0) {
+        return 0;
+    }
+    ssize_t n = ioPwrite(fd, &tombstone, sizeof(tombstone), (off_t)slot * (off_t)def->recordSize);
+    close(fd);
+    if (n != (ssize_t)sizeof(tombstone)) {
+        return 0;
+    }
+
+    indexRemove(table, id);
+    metaAddDead(table, 1);
+    if (hasDerived(table)) {
+        // The shared mapping already shows the negated ID
+        updateDerived(table, slot, &before, records + (size_t)slot * def->recordSize);
+    }
+    return 1;
+}
+
+/**
+ * @brief Counts the tombstones in a table and stores the result in its metadata
+ * @param table The table to recount
+ *
+ * Replaying the log can count a deletion twice, so recovery recounts.
+ */
+void tableRecountDead(TableId table) {
+    const TableDef *def = getTableDef(table);
+    long count;
+    const char *records = cacheTable(table, &count);
+
+    int64_t deadCount = 0;
+    for (long slot = 0; slot < count; slot++) {
+        if (recordId(records + (size_t)slot * def->recordSize) <= 0) {
+            deadCount++;
+        }
+    }
+    metaSetDead(table, deadCount);
+}
+
+/**
+ * @brief Collects record counts and compaction figures for a table
+ * @param table The table to inspect
+ * @param stats Output for the statistics
+ */
+void tableGetStats(TableId table, TableStats *stats) {
+    const TableDef *def = getTableDef(table);
+    TableMeta meta;
+    metaRead(table, &meta);
+
+    stats->totalRecords = tableRecordCount(table);
+    stats->deadRecords = (long)meta.deadCount;
+    if (stats->deadRecords > stats->totalRecords) {
+        stats->deadRecords = stats->totalRecords;
+    }
+    stats->deadRatio = stats->totalRecords > 0 ? (double)stats->deadRecords / stats->totalRecords : 0;
+    stats->compactionThreshold = COMPACTION_THRESHOLD;
+    stats->dataBytes = (long long)stats->totalRecords * (long long)def->recordSize;
+}
+
+/**
+ * @brief Tells whether a table has enough tombstones to be worth compacting
+ * @param table The table to inspect
+ * @return int 1 if the dead-record ratio is above COMPACTION_THRESHOLD
+ */
+int tableNeedsCompaction(TableId table) {
+    TableStats stats;
+    tableGetStats(table, &stats);
+    return stats.deadRecords > 0 && stats.deadRatio > stats.compactionThreshold;
+}
+
+/**
+ * @brief Rewrites a table's data file without its tombstones
+ * @param table The table to compact
+ * @return int 1 on success, 0 otherwise
+ *
+ * Slots change, so this must only run while the write-ahead log is locked and
+ * empty; the log's checkpoint takes care of that.
+ */
+int tableCompact(TableId table) {
+    const TableDef *def = getTableDef(table);
+    char tempFile[256];
+    tempFileName(tempFile, sizeof(tempFile), def->dataFile);
+
+    long count;
+    const char *records = cacheTable(table, &count);
+    if (count < 0) {
+        return 0;
+    }
+
+    FILE *temp = ioFopen(tempFile, "wb");
+    if (temp == NULL) {
+        return 0;
+    }
+
+    int ok = 1;
+    for (long slot = 0; slot < count; slot++) {
+        const char *record = records + (size_t)slot * def->recordSize;
+        if (recordId(record) > 0 && ioFwrite(record, def->recordSize, 1, temp) != 1) {
+            ok = 0;
+            break;
+        }
+    }
+
+    // The compacted file must be on disk before it replaces the original
+    ok = ok && fflush(temp) == 0 && fsync(fileno(temp)) == 0;
+    fclose(temp);
+    if (!ok || rename(tempFile, def->dataFile) != 0) {
+        remove(tempFile);
+        return 0;
+    }
+
+    cacheInvalidate(table);
+    indexRebuild(table);
+    metaSetDead(table, 0);
+    tableRebuildDerived(table);
+    return 1;
+}
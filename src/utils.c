@@ -15,14 +15,17 @@
 #define _XOPEN_SOURCE
 #include <time.h>
 #include "../include/utils.h"
+#include "../include/wal.h"
+#include "../include/money.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
 #include <limits.h>
+#include <unistd.h>
 
 /**
- * @brief Initializes the system by creating necessary directories
+ * @brief Initializes the system by creating necessary directories and replaying the write-ahead log
  */
 void initializeSystem() {
     // Create data directory if it doesn't exist
@@ -30,6 +33,12 @@ void initializeSystem() {
     
     // Create backup directory if it doesn't exist
     system("mkdir -p data/backup");
+
+    // Bring the tables up to date with anything committed before a crash
+    walRecover();
+
+    // Data files from before fixed-point money still hold doubles
+    moneyMigrate();
 }
 
 /**
@@ -43,6 +52,23 @@ time_t parseDate(const char *dateStr) {
     return mktime(&tm);
 }
 
+/**
+ * @brief Parses a local date and time such as "2026-10-17 14:59:00"
+ * @param text The text to parse (format: YYYY-MM-DD HH:MM:SS)
+ * @return time_t The parsed time, -1 if the text is not in that format
+ */
+time_t parseDateTime(const char *text) {
+    struct tm tm = {0};
+    if (sscanf(text, "%d-%d-%d %d:%d:%d", &tm.tm_year, &tm.tm_mon, &tm.tm_mday, &tm.tm_hour, &tm.tm_min,
+               &tm.tm_sec) != 6) {
+        return (time_t)-1;
+    }
+    tm.tm_year -= 1900;
+    tm.tm_mon -= 1;
+    tm.tm_isdst = -1;
+    return mktime(&tm);
+}
+
 /**
  * @brief Formats a time_t value into a date string
  * @param timestamp The time_t value to format
@@ -191,3 +217,48 @@ int validateDateInput(char *output) {
     }
 }
 
+/**
+ * @brief Updates a CRC-32 (IEEE 802.3) checksum with a block of data
+ * @param crc The checksum so far, 0 for a new checksum
+ * @param data The data to add
+ * @param length The number of bytes in data
+ * @return uint32_t The updated checksum
+ */
+uint32_t computeCrc32(uint32_t crc, const void *data, size_t length) {
+    static uint32_t table[256];
+    static int tableReady = 0;
+
+    if (!tableReady) {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            table[i] = c;
+        }
+        tableReady = 1;
+    }
+
+    const unsigned char *bytes = data;
+    crc = ~crc;
+    for (size_t i = 0; i < length; i++) {
+        crc = table[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+
+/**
+ * @brief Builds the name of the temporary file a rewrite of path goes through
+ * @param output Buffer for the name
+ * @param size Size of the output buffer
+ * @param path The file being rewritten
+ *
+ * The name carries the process ID and a per-process counter, so two processes
+ * or two threads rebuilding the same file never write into each other's
+ * temporary file.
+ */
+void tempFileName(char *output, size_t size, const char *path) {
+    static unsigned sequence = 0;
+    snprintf(output, size, "%s.%ld.%u.tmp", path, (long)getpid(), __sync_fetch_and_add(&sequence, 1));
+}
@@ -0,0 +1,1116 @@
+/*
+ * =====================================================================================
+ * File: wal.c
+ * Description: Implements the write-ahead log (data/sbms.wal) that every table
+ *              mutation goes through. A mutation is collected in a WalTxn and
+ *              committed as one checksummed log entry; entries from concurrent
+ *              callers are grouped so a whole batch shares one write and one
+ *              fdatasync (group commit). Once an entry is durable its writes are
+ *              applied to the .dat files without syncing them. A background
+ *              thread periodically checkpoints: it syncs the table files,
+ *              truncates the log and compacts tables with too many tombstones.
+ *              On startup the log is replayed so that every committed mutation
+ *              reaches the tables even after a crash.
+ *
+ *              Log positions (LSNs) are byte positions in an endless logical
+ *              log; the file header stores the LSN of its first entry so LSNs
+ *              keep increasing across checkpoints.
+ *
+ *              A backup can pin the log (walPin): while any process holds a
+ *              pin, checkpoints still sync the tables but neither truncate the
+ *              log nor compact, so every change made while the backup copies
+ *              the table files can be read back and replayed onto the copy
+ *              (walCutChanges), giving a copy consistent at one log position.
+ *
+ *              Every checkpoint first copies the entries not yet archived into
+ *              the change archive (see archive.c); the log is only truncated
+ *              once they are safe there. walArchiveChanges reads them back so
+ *              a backup can be brought forward to a chosen time or order.
+ *
+ * Author: Chiemezie Agbo
+ * Date: 17-10-2026
+ * Version: 1.0
+ * =====================================================================================
+ */
+
+#define _DEFAULT_SOURCE
+#include "../include/wal.h"
+#include "../include/archive.h"
+#include "../include/index.h"
+#include "../include/cache.h"
+#include "../include/columns.h"
+#include "../include/rollups.h"
+#include "../include/orderlines.h"
+#include "../include/search.h"
+#include "../include/hotstore.h"
+#include "../include/utils.h"
+#include "../include/metrics.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#define WAL_MAGIC 0x4C574253u       /* "SBWL" */
+#define WAL_ENTRY_MAGIC 0x594E5445u /* "ETNY" */
+#define WAL_VERSION 1
+#define WAL_CHECKPOINT_BYTES (4L * 1024 * 1024)
+#define WAL_CHECKPOINT_SECONDS 5
+#define WAL_LOCK_BYTE 0 /* Write-locked by committers and checkpoints */
+#define WAL_PIN_BYTE 1  /* Read-locked by every process holding a pin */
+
+enum {
+    WAL_OP_WRITE = 1,
+    WAL_OP_APPEND = 2,
+    WAL_OP_TOMBSTONE = 3
+};
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t baseLsn;
+    uint64_t appliedLsn;
+} WalFileHeader;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t length;
+    uint64_t lsn;
+    int64_t timestamp;
+    uint32_t opCount;
+    uint32_t checksum;
+} WalEntryHeader;
+
+typedef struct {
+    uint16_t table;
+    uint16_t op;
+    uint32_t length;
+    int64_t slot;
+} WalOpHeader;
+
+static struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    pthread_mutex_t ioMutex;
+    pthread_cond_t checkpointCond;
+    WalTxn *queueHead;
+    WalTxn *queueTail;
+    int leaderActive;
+    int checkpointRequested;
+    int initialized;
+    int pins;
+    int fd;
+} wal = {
+    PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER,
+    PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER,
+    NULL, NULL, 0, 0, 0, 0, -1
+};
+
+static int lockWalByte(off_t byte, short type, int wait) {
+    struct flock fl;
+    memset(&fl, 0, sizeof(fl));
+    fl.l_type = type;
+    fl.l_whence = SEEK_SET;
+    fl.l_start = byte;
+    fl.l_len = 1;
+    while (fcntl(wal.fd, wait ? F_SETLKW : F_SETLK, &fl) == -1) {
+        if (errno != EINTR) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * @brief Takes or releases the cross-process lock on the log file
+ */
+static int lockWalFile(short type) {
+    return lockWalByte(WAL_LOCK_BYTE, type, 1);
+}
+
+/**
+ * @brief Tells whether this or any other process holds a pin on the log
+ *
+ * Must be called with wal.ioMutex and the file lock held.
+ */
+static int walPinned(void) {
+    if (wal.pins > 0) {
+        return 1;
+    }
+    if (!lockWalByte(WAL_PIN_BYTE, F_WRLCK, 0)) {
+        return 1;
+    }
+    lockWalByte(WAL_PIN_BYTE, F_UNLCK, 0);
+    return 0;
+}
+
+static int readHeader(WalFileHeader *header) {
+    return ioPread(wal.fd, header, sizeof(*header), 0) == (ssize_t)sizeof(*header) &&
+           header->magic == WAL_MAGIC && header->version == WAL_VERSION;
+}
+
+static int writeHeader(const WalFileHeader *header) {
+    return ioPwrite(wal.fd, header, sizeof(*header), 0) == (ssize_t)sizeof(*header);
+}
+
+static int checkpoint(int compact);
+
+/**
+ * @brief Background thread that checkpoints the log periodically or on request
+ *
+ * It only syncs and truncates the log. Compaction moves records while views,
+ * reports and server workers may be reading them, so it is left to
+ * walCheckpoint in the foreground.
+ */
+static void *checkpointThread(void *arg) {
+    (void)arg;
+    while (1) {
+        pthread_mutex_lock(&wal.mutex);
+        if (!wal.checkpointRequested) {
+            struct timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_sec += WAL_CHECKPOINT_SECONDS;
+            pthread_cond_timedwait(&wal.checkpointCond, &wal.mutex, &deadline);
+        }
+        wal.checkpointRequested = 0;
+        pthread_mutex_unlock(&wal.mutex);
+
+        checkpoint(0);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Resets the log state in a forked child, which inherits none of our threads
+ */
+static void resetAfterFork(void) {
+    pthread_mutex_init(&wal.mutex, NULL);
+    pthread_cond_init(&wal.cond, NULL);
+    pthread_mutex_init(&wal.ioMutex, NULL);
+    pthread_cond_init(&wal.checkpointCond, NULL);
+    wal.queueHead = wal.queueTail = NULL;
+    wal.leaderActive = 0;
+    wal.checkpointRequested = 0;
+    wal.initialized = 0;
+    wal.pins = 0;
+    if (wal.fd >= 0) {
+        close(wal.fd);
+        wal.fd = -1;
+    }
+}
+
+/**
+ * @brief Opens the log file and starts the checkpoint thread on first use
+ * @return int 1 if the log is ready, 0 otherwise
+ *
+ * Must be called with wal.ioMutex held.
+ */
+static int walOpen(void) {
+    if (wal.initialized) {
+        return 1;
+    }
+
+    wal.fd = ioOpen(WAL_FILE, O_RDWR | O_CREAT, 0644);
+    if (wal.fd < 0) {
+        return 0;
+    }
+
+    if (lockWalFile(F_WRLCK)) {
+        WalFileHeader header;
+        if (!readHeader(&header)) {
+            // Carry on after the archived entries, so an LSN never names two entries
+            uint64_t archiveStart;
+            uint64_t archiveEnd;
+            header.magic = WAL_MAGIC;
+            header.version = WAL_VERSION;
+            header.baseLsn = sizeof(WalFileHeader);
+            if (archiveRange(&archiveStart, &archiveEnd) && archiveEnd > header.baseLsn) {
+                header.baseLsn = archiveEnd;
+            }
+            header.appliedLsn = header.baseLsn;
+            if (ftruncate(wal.fd, sizeof(header)) != 0 || !writeHeader(&header)) {
+                lockWalFile(F_UNLCK);
+                close(wal.fd);
+                wal.fd = -1;
+                return 0;
+            }
+        }
+        lockWalFile(F_UNLCK);
+    }
+
+    // Build the checksum table before any other thread can race on it
+    computeCrc32(0, NULL, 0);
+
+    static int atforkRegistered = 0;
+    if (!atforkRegistered) {
+        pthread_atfork(NULL, NULL, resetAfterFork);
+        atforkRegistered = 1;
+    }
+
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, checkpointThread, NULL) == 0) {
+        pthread_detach(thread);
+    }
+
+    wal.initialized = 1;
+    return 1;
+}
+
+/**
+ * @brief Starts a new, empty transaction
+ * @param txn The transaction to initialise
+ */
+void walBegin(WalTxn *txn) {
+    memset(txn, 0, sizeof(*txn));
+}
+
+/**
+ * @brief Releases the memory held by a transaction
+ * @param txn The transaction to release
+ */
+void walEnd(WalTxn *txn) {
+    free(txn->ops);
+    free(txn->slots);
+    memset(txn, 0, sizeof(*txn));
+}
+
+static int addOp(WalTxn *txn, TableId table, uint16_t op, int64_t slot, const void *payload, uint32_t length) {
+    size_t needed = txn->length + sizeof(WalOpHeader) + length;
+    if (needed > txn->capacity) {
+        size_t capacity = txn->capacity ? txn->capacity : 1024;
+        while (capacity < needed) {
+            capacity *= 2;
+        }
+        unsigned char *grown = realloc(txn->ops, capacity);
+        if (grown == NULL) {
+            return -1;
+        }
+        txn->ops = grown;
+        txn->capacity = capacity;
+    }
+
+    long *slots = realloc(txn->slots, (txn->opCount + 1) * sizeof(long));
+    if (slots == NULL) {
+        return -1;
+    }
+    txn->slots = slots;
+    txn->slots[txn->opCount] = (long)slot;
+
+    WalOpHeader header = {(uint16_t)table, op, length, slot};
+    memcpy(txn->ops + txn->length, &header, sizeof(header));
+    if (length > 0) {
+        memcpy(txn->ops + txn->length + sizeof(header), payload, length);
+    }
+    txn->length = needed;
+    return (int)txn->opCount++;
+}
+
+/**
+ * @brief Adds a record write to a transaction
+ * @param txn The transaction
+ * @param table The table to write to
+ * @param slot The slot to overwrite, or WAL_APPEND_SLOT to append
+ * @param record The record contents
+ * @return int Index of the operation within the transaction, -1 on failure
+ */
+int walLogWrite(WalTxn *txn, TableId table, long slot, const void *record) {
+    const TableDef *def = getTableDef(table);
+    uint16_t op = slot == WAL_APPEND_SLOT ? WAL_OP_APPEND : WAL_OP_WRITE;
+    return addOp(txn, table, op, slot, record, (uint32_t)def->recordSize);
+}
+
+/**
+ * @brief Adds the deletion (tombstoning) of a record to a transaction
+ * @param txn The transaction
+ * @param table The table to delete from
+ * @param slot The slot holding the record
+ * @param id The ID of the record, used to find it again if compaction moved it
+ * @return int Index of the operation within the transaction, -1 on failure
+ */
+int walLogDelete(WalTxn *txn, TableId table, long slot, int id) {
+    return addOp(txn, table, WAL_OP_TOMBSTONE, slot, &id, sizeof(id));
+}
+
+/**
+ * @brief Returns the slot an operation wrote to once the transaction committed
+ * @param txn The committed transaction
+ * @param op Index returned by walLogWrite
+ * @return long The slot, -1 if unknown
+ */
+long walSlot(const WalTxn *txn, int op) {
+    if (op < 0 || (uint32_t)op >= txn->opCount) {
+        return -1;
+    }
+    return txn->slots[op];
+}
+
+/**
+ * @brief Applies the operations of one log entry to the table files
+ * @param ops The serialized operations
+ * @param length Size of ops in bytes
+ * @param live 1 when applying a fresh commit, 0 when replaying
+ * @return int 1 if every operation was applied, 0 otherwise
+ */
+static int applyOps(const unsigned char *ops, size_t length, int live) {
+    int ok = 1;
+    size_t offset = 0;
+    while (offset + sizeof(WalOpHeader) <= length) {
+        WalOpHeader header;
+        memcpy(&header, ops + offset, sizeof(header));
+        const unsigned char *payload = ops + offset + sizeof(header);
+        offset += sizeof(header) + header.length;
+        if (header.table >= TABLE_COUNT || offset > length) {
+            return 0;
+        }
+        if (header.slot < 0) {
+            ok = 0; // The record vanished before the commit, see resolveSlot
+            continue;
+        }
+
+        TableId table = (TableId)header.table;
+        switch (header.op) {
+            case WAL_OP_WRITE:
+            case WAL_OP_APPEND:
+                ok = tableApplyWrite(table, (long)header.slot, payload) && ok;
+                if (live && header.op == WAL_OP_APPEND) {
+                    indexAppend(table, recordId(payload), (long)header.slot);
+                }
+                break;
+            case WAL_OP_TOMBSTONE:
+                ok = tableApplyTombstone(table, (long)header.slot) && ok;
+                break;
+            default:
+                ok = 0;
+        }
+    }
+    return ok;
+}
+
+/**
+ * @brief Checks that a logged slot still holds the record it was meant for
+ * @return int64_t The slot to use, -1 if the record no longer exists
+ *
+ * Compaction moves records between the caller's lookup and the commit, so
+ * writes to indexed tables are re-resolved by ID while the log is locked.
+ */
+static int64_t resolveSlot(TableId table, int64_t slot, int id) {
+    const TableDef *def = getTableDef(table);
+    if (def->indexFile == NULL) {
+        return slot;
+    }
+
+    long count;
+    const char *records = cacheTable(table, &count);
+    if (slot >= 0 && slot < count && recordId(records + (size_t)slot * def->recordSize) == id) {
+        return slot;
+    }
+    return indexLookup(table, id);
+}
+
+/**
+ * @brief Resolves append slots, writes, syncs and applies a batch of transactions
+ * @param batch Linked list of transactions to commit together
+ */
+static void flushBatch(WalTxn *batch) {
+    pthread_mutex_lock(&wal.ioMutex);
+
+    WalFileHeader header;
+    struct stat st;
+    if (!walOpen() || !lockWalFile(F_WRLCK)) {
+        pthread_mutex_unlock(&wal.ioMutex);
+        return;
+    }
+    if (!readHeader(&header) || fstat(wal.fd, &st) != 0) {
+        lockWalFile(F_UNLCK);
+        pthread_mutex_unlock(&wal.ioMutex);
+        return;
+    }
+
+    // Appends go to the end of each table as it stands while we hold the lock
+    long nextSlot[TABLE_COUNT];
+    for (int t = 0; t < TABLE_COUNT; t++) {
+        nextSlot[t] = -1;
+    }
+
+    size_t total = 0;
+    for (WalTxn *txn = batch; txn != NULL; txn = txn->next) {
+        total += sizeof(WalEntryHeader) + txn->length;
+    }
+
+    unsigned char *buffer = malloc(total);
+    if (buffer == NULL) {
+        lockWalFile(F_UNLCK);
+        pthread_mutex_unlock(&wal.ioMutex);
+        return;
+    }
+
+    off_t end = st.st_size;
+    uint64_t lsn = header.baseLsn + (uint64_t)(end - (off_t)sizeof(WalFileHeader));
+    size_t position = 0;
+    for (WalTxn *txn = batch; txn != NULL; txn = txn->next) {
+        size_t offset = 0;
+        for (uint32_t i = 0; i < txn->opCount; i++) {
+            WalOpHeader op;
+            memcpy(&op, txn->ops + offset, sizeof(op));
+            if (op.op == WAL_OP_APPEND) {
+                if (nextSlot[op.table] < 0) {
+                    nextSlot[op.table] = tableRecordCount((TableId)op.table);
+                }
+                op.slot = nextSlot[op.table]++;
+            } else {
+                int id;
+                memcpy(&id, txn->ops + offset + sizeof(op), sizeof(id));
+                op.slot = resolveSlot((TableId)op.table, op.slot, id);
+            }
+            memcpy(txn->ops + offset, &op, sizeof(op));
+            txn->slots[i] = (long)op.slot;
+            offset += sizeof(op) + op.length;
+        }
+
+        WalEntryHeader entry = {WAL_ENTRY_MAGIC, (uint32_t)txn->length, lsn, (int64_t)time(NULL), txn->opCount, 0};
+        entry.checksum = computeCrc32(computeCrc32(0, &entry, sizeof(entry)), txn->ops, txn->length);
+        memcpy(buffer + position, &entry, sizeof(entry));
+        memcpy(buffer + position + sizeof(entry), txn->ops, txn->length);
+        txn->lsn = lsn;
+        position += sizeof(entry) + txn->length;
+        lsn += sizeof(entry) + txn->length;
+    }
+
+    int durable = ioPwrite(wal.fd, buffer, total, end) == (ssize_t)total && fdatasync(wal.fd) == 0;
+    free(buffer);
+
+    columnsBeginBatch();
+    for (WalTxn *txn = batch; txn != NULL; txn = txn->next) {
+        txn->ok = durable && applyOps(txn->ops, txn->length, 1);
+    }
+    columnsEndBatch();
+
+    if (durable) {
+        header.appliedLsn = lsn;
+        writeHeader(&header);
+    }
+
+    lockWalFile(F_UNLCK);
+    pthread_mutex_unlock(&wal.ioMutex);
+
+    if (end + (off_t)total > WAL_CHECKPOINT_BYTES) {
+        pthread_mutex_lock(&wal.mutex);
+        wal.checkpointRequested = 1;
+        pthread_cond_signal(&wal.checkpointCond);
+        pthread_mutex_unlock(&wal.mutex);
+    }
+}
+
+/**
+ * @brief Makes a transaction durable and applies it to the tables
+ * @param txn The transaction to commit
+ * @return int 1 on success, 0 otherwise
+ *
+ * The first caller to arrive while no flush is running becomes the leader and
+ * commits every transaction queued so far with a single fdatasync; the others
+ * wait until a leader has committed theirs.
+ */
+int walCommit(WalTxn *txn) {
+    if (txn->opCount == 0) {
+        return 1;
+    }
+
+    pthread_mutex_lock(&wal.mutex);
+    txn->next = NULL;
+    txn->done = 0;
+    txn->ok = 0;
+    if (wal.queueTail != NULL) {
+        wal.queueTail->next = txn;
+    } else {
+        wal.queueHead = txn;
+    }
+    wal.queueTail = txn;
+
+    while (!txn->done) {
+        if (wal.leaderActive) {
+            pthread_cond_wait(&wal.cond, &wal.mutex);
+            continue;
+        }
+
+        WalTxn *batch = wal.queueHead;
+        wal.queueHead = wal.queueTail = NULL;
+        wal.leaderActive = 1;
+        pthread_mutex_unlock(&wal.mutex);
+
+        flushBatch(batch);
+
+        pthread_mutex_lock(&wal.mutex);
+        while (batch != NULL) {
+            WalTxn *next = batch->next;
+            batch->done = 1;
+            batch = next;
+        }
+        wal.leaderActive = 0;
+        pthread_cond_broadcast(&wal.cond);
+    }
+    pthread_mutex_unlock(&wal.mutex);
+    return txn->ok;
+}
+
+/**
+ * @brief Reads the entry at a log offset and checks its checksum
+ * @return unsigned char* The entry's operations (caller frees), NULL if invalid
+ */
+static unsigned char *readEntry(off_t offset, off_t end, WalEntryHeader *entry) {
+    if (offset + (off_t)sizeof(*entry) > end ||
+        ioPread(wal.fd, entry, sizeof(*entry), offset) != (ssize_t)sizeof(*entry) ||
+        entry->magic != WAL_ENTRY_MAGIC ||
+        offset + (off_t)sizeof(*entry) + (off_t)entry->length > end) {
+        return NULL;
+    }
+
+    unsigned char *ops = malloc(entry->length ? entry->length : 1);
+    if (ops == NULL ||
+        ioPread(wal.fd, ops, entry->length, offset + sizeof(*entry)) != (ssize_t)entry->length) {
+        free(ops);
+        return NULL;
+    }
+
+    WalEntryHeader check = *entry;
+    check.checksum = 0;
+    if (computeCrc32(computeCrc32(0, &check, sizeof(check)), ops, entry->length) != entry->checksum) {
+        free(ops);
+        return NULL;
+    }
+    return ops;
+}
+
+/**
+ * @brief Re-applies every valid entry at or after an LSN
+ * @return int Number of entries applied
+ *
+ * An entry torn by a crashed writer is skipped by scanning forward to the
+ * next valid entry, since later writers append after it.
+ */
+static int replayFrom(const WalFileHeader *header, uint64_t fromLsn) {
+    struct stat st;
+    if (fstat(wal.fd, &st) != 0) {
+        return 0;
+    }
+
+    int applied = 0;
+    off_t offset = sizeof(WalFileHeader);
+    columnsBeginBatch();
+    while (offset + (off_t)sizeof(WalEntryHeader) <= st.st_size) {
+        WalEntryHeader entry;
+        unsigned char *ops = readEntry(offset, st.st_size, &entry);
+        if (ops == NULL) {
+            offset++;
+            continue;
+        }
+        if (entry.lsn >= fromLsn && entry.lsn >= header->baseLsn) {
+            applyOps(ops, entry.length, 0);
+            applied++;
+        }
+        free(ops);
+        offset += sizeof(entry) + entry.length;
+    }
+    columnsEndBatch();
+    return applied;
+}
+
+/**
+ * @brief Rebuilds the totals and secondary indexes derived from the tables
+ *
+ * Used after a writer died part-way through applying an entry: incremental
+ * updates to derived structures are not idempotent and may be lost or doubled.
+ */
+static void rebuildDerived(void) {
+    for (int t = 0; t < TABLE_COUNT; t++) {
+        tableRebuildDerived((TableId)t);
+    }
+}
+
+/**
+ * @brief Copies the valid log entries the change archive does not hold yet into it
+ * @return int 1 if the archive reaches the end of the log, 0 otherwise
+ *
+ * Must be called with wal.ioMutex and the file lock held.
+ */
+static int archiveLog(const WalFileHeader *header, off_t end) {
+    uint64_t archiveStart;
+    uint64_t archiveEnd;
+    uint64_t endLsn = header->baseLsn + (uint64_t)(end - (off_t)sizeof(WalFileHeader));
+    if (!archiveRange(&archiveStart, &archiveEnd)) {
+        archiveEnd = 0;
+    }
+    if (archiveEnd >= endLsn) {
+        return 1;
+    }
+
+    uint64_t fromLsn = archiveEnd > header->baseLsn ? archiveEnd : header->baseLsn;
+    unsigned char *buffer = malloc((size_t)(endLsn - fromLsn));
+    if (buffer == NULL) {
+        return 0;
+    }
+
+    // Torn entries are left behind, as replay skips them too
+    size_t length = 0;
+    off_t offset = (off_t)sizeof(WalFileHeader) + (off_t)(fromLsn - header->baseLsn);
+    while (offset + (off_t)sizeof(WalEntryHeader) <= end) {
+        WalEntryHeader entry;
+        unsigned char *ops = readEntry(offset, end, &entry);
+        if (ops == NULL) {
+            offset++;
+            continue;
+        }
+        memcpy(buffer + length, &entry, sizeof(entry));
+        memcpy(buffer + length + sizeof(entry), ops, entry.length);
+        length += sizeof(entry) + entry.length;
+        offset += sizeof(entry) + entry.length;
+        free(ops);
+    }
+
+    int ok = archiveAppend(buffer, length, fromLsn, endLsn);
+    free(buffer);
+    return ok;
+}
+
+/**
+ * @brief Syncs the table files, archives the log and empties it
+ * @param truncate 0 to keep the log, because it is pinned
+ * @return int 1 on success, 0 otherwise; the log is kept if it could not be archived
+ *
+ * Entries committed by a process that died before applying them are replayed
+ * first. Must be called with wal.ioMutex and the file lock held.
+ */
+static int walCheckpointLocked(int truncate) {
+    WalFileHeader header;
+    struct stat st;
+    if (!readHeader(&header) || fstat(wal.fd, &st) != 0) {
+        return 0;
+    }
+    if (st.st_size <= (off_t)sizeof(WalFileHeader)) {
+        return 1;
+    }
+
+    uint64_t endLsn = header.baseLsn + (uint64_t)(st.st_size - (off_t)sizeof(WalFileHeader));
+    if (header.appliedLsn < endLsn) {
+        replayFrom(&header, header.appliedLsn);
+        rebuildDerived();
+    }
+
+    for (int t = 0; t < TABLE_COUNT; t++) {
+        int fd = ioOpen(getTableDef((TableId)t)->dataFile, O_RDONLY);
+        if (fd >= 0) {
+            fsync(fd);
+            close(fd);
+        }
+    }
+    columnsSync();
+    rollupsSync();
+    orderLinesSync();
+    searchIndexSync();
+    hotSync();
+
+    int archived = archiveLog(&header, st.st_size);
+    if (!truncate || !archived) {
+        header.appliedLsn = endLsn;
+        return writeHeader(&header) && archived;
+    }
+
+    // Advance the header before truncating so LSNs never go backwards
+    header.baseLsn = endLsn;
+    header.appliedLsn = endLsn;
+    if (!writeHeader(&header) || fdatasync(wal.fd) != 0) {
+        return 0;
+    }
+    return ftruncate(wal.fd, sizeof(WalFileHeader)) == 0 && fdatasync(wal.fd) == 0;
+}
+
+/**
+ * @brief Compacts every table whose dead-record ratio crossed the threshold
+ *
+ * Must be called with the log locked and empty so no logged slot can move.
+ */
+static void compactTables(void) {
+    for (int t = 0; t < TABLE_COUNT; t++) {
+        if (tableNeedsCompaction((TableId)t)) {
+            tableCompact((TableId)t);
+        }
+    }
+}
+
+/**
+ * @brief Syncs all table files and truncates the write-ahead log
+ * @param compact 1 to also compact the tables that need it
+ * @return int 1 on success, 0 otherwise
+ */
+static int checkpoint(int compact) {
+    pthread_mutex_lock(&wal.ioMutex);
+    if (!walOpen() || !lockWalFile(F_WRLCK)) {
+        pthread_mutex_unlock(&wal.ioMutex);
+        return 0;
+    }
+
+    // A pinned log must keep its entries and every slot they refer to
+    int pinned = walPinned();
+    int ok = walCheckpointLocked(!pinned);
+    if (ok && !pinned && compact) {
+        compactTables();
+    }
+
+    lockWalFile(F_UNLCK);
+    pthread_mutex_unlock(&wal.ioMutex);
+    return ok;
+}
+
+/**
+ * @brief Syncs all table files, truncates the write-ahead log and compacts tables
+ * @return int 1 on success, 0 otherwise
+ *
+ * Compaction moves records to new slots, so this is only called from the
+ * foreground, where no other code of this process is reading the tables.
+ */
+int walCheckpoint(void) {
+    return checkpoint(1);
+}
+
+/**
+ * @brief Tells whether some table's dead-record ratio crossed the compaction threshold
+ * @return int 1 if walCompact() would compact, 0 otherwise
+ */
+int walCompactionDue(void) {
+    for (int t = 0; t < TABLE_COUNT; t++) {
+        if (tableNeedsCompaction((TableId)t)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Compacts the tables whose dead-record ratio crossed the threshold
+ * @return int 1 on success or when no table needs it, 0 otherwise
+ *
+ * A cheap check when nothing needs compacting, so the foreground calls it
+ * after every operation; like walCheckpoint, never call it while reading a table.
+ */
+int walCompact(void) {
+    return walCompactionDue() ? walCheckpoint() : 1;
+}
+
+/**
+ * @brief Replays the write-ahead log into the tables after a restart
+ * @return int 1 on success, 0 otherwise
+ *
+ * Every entry since the last checkpoint is applied again, because table
+ * writes are not synced until a checkpoint and may have been lost.
+ */
+int walRecover(void) {
+    pthread_mutex_lock(&wal.ioMutex);
+    if (!walOpen() || !lockWalFile(F_WRLCK)) {
+        pthread_mutex_unlock(&wal.ioMutex);
+        return 0;
+    }
+
+    WalFileHeader header;
+    int ok = 0;
+    if (readHeader(&header)) {
+        uint64_t endLsn = header.baseLsn + (uint64_t)(lseek(wal.fd, 0, SEEK_END) - (off_t)sizeof(WalFileHeader));
+        int interrupted = header.appliedLsn < endLsn;
+        replayFrom(&header, header.baseLsn);
+        header.appliedLsn = endLsn;
+        writeHeader(&header);
+        if (interrupted) {
+            rebuildDerived();
+        }
+        for (int t = 0; t < TABLE_COUNT; t++) {
+            tableRecountDead((TableId)t);
+        }
+        int pinned = walPinned();
+        ok = walCheckpointLocked(!pinned);
+        if (ok && !pinned) {
+            compactTables();
+        }
+    }
+
+    lockWalFile(F_UNLCK);
+    pthread_mutex_unlock(&wal.ioMutex);
+    return ok;
+}
+
+/**
+ * @brief Pins the log so that its entries and the slots they refer to stay put
+ * @param lsn Output for the LSN from which changes may be missing from the table files
+ * @return int 1 if the log is pinned, 0 otherwise
+ *
+ * The pin lasts until walCutChanges or walUnpin.
+ */
+int walPin(uint64_t *lsn) {
+    pthread_mutex_lock(&wal.ioMutex);
+    if (!walOpen() || !lockWalFile(F_WRLCK)) {
+        pthread_mutex_unlock(&wal.ioMutex);
+        return 0;
+    }
+
+    WalFileHeader header;
+    int ok = readHeader(&header) && (wal.pins > 0 || lockWalByte(WAL_PIN_BYTE, F_RDLCK, 1));
+    if (ok) {
+        wal.pins++;
+        *lsn = header.appliedLsn;
+    }
+
+    lockWalFile(F_UNLCK);
+    pthread_mutex_unlock(&wal.ioMutex);
+    return ok;
+}
+
+/**
+ * @brief Drops a pin; must be called with wal.ioMutex held
+ */
+static void releasePin(void) {
+    if (wal.pins > 0 && --wal.pins == 0) {
+        lockWalByte(WAL_PIN_BYTE, F_UNLCK, 0);
+    }
+}
+
+/**
+ * @brief Releases a pin taken with walPin without reading the changes
+ */
+void walUnpin(void) {
+    pthread_mutex_lock(&wal.ioMutex);
+    releasePin();
+    pthread_mutex_unlock(&wal.ioMutex);
+}
+
+static int forEachChange(const unsigned char *ops, size_t length, WalChangeFn apply, void *context) {
+    int ok = 1;
+    size_t offset = 0;
+    while (ok && offset + sizeof(WalOpHeader) <= length) {
+        WalOpHeader header;
+        memcpy(&header, ops + offset, sizeof(header));
+        const unsigned char *payload = ops + offset + sizeof(header);
+        offset += sizeof(header) + header.length;
+        if (header.table >= TABLE_COUNT || offset > length) {
+            return 0;
+        }
+        if (header.slot < 0) {
+            continue; // Never applied, see resolveSlot
+        }
+
+        int id;
+        memcpy(&id, payload, sizeof(id));
+        int tombstone = header.op == WAL_OP_TOMBSTONE;
+        ok = apply((TableId)header.table, (long)header.slot, tombstone ? NULL : payload, id, context);
+    }
+    return ok;
+}
+
+/**
+ * @brief Passes every change from an LSN to the current end of the log to a callback
+ * @param lsn The LSN to start at; advanced past the last entry read
+ * @param skipTorn 1 to scan past torn entries, 0 to stop at the first invalid one
+ * @return int 1 on success, 0 if the log no longer reaches back to the LSN or the callback failed
+ */
+static int readChanges(uint64_t *lsn, int skipTorn, WalChangeFn apply, void *context) {
+    WalFileHeader header;
+    struct stat st;
+    if (!readHeader(&header) || fstat(wal.fd, &st) != 0 || *lsn < header.baseLsn) {
+        return 0;
+    }
+
+    int ok = 1;
+    off_t offset = (off_t)sizeof(WalFileHeader) + (off_t)(*lsn - header.baseLsn);
+    while (ok && offset + (off_t)sizeof(WalEntryHeader) <= st.st_size) {
+        WalEntryHeader entry;
+        unsigned char *ops = readEntry(offset, st.st_size, &entry);
+        if (ops == NULL) {
+            if (!skipTorn) {
+                break; // Possibly still being written
+            }
+            offset++;
+            continue;
+        }
+        ok = forEachChange(ops, entry.length, apply, context);
+        free(ops);
+        offset += sizeof(entry) + entry.length;
+    }
+    if (offset > st.st_size) {
+        offset = st.st_size;
+    }
+    *lsn = header.baseLsn + (uint64_t)(offset - (off_t)sizeof(WalFileHeader));
+    return ok;
+}
+
+/**
+ * @brief Passes every change committed since walPin to a callback and releases the pin
+ * @param lsn The LSN returned by walPin; set to the LSN the changes end at
+ * @param apply Called for each record write (record set) or deletion (record NULL), in log order
+ * @param context Passed to the callback
+ * @return int 1 on success, 0 otherwise
+ *
+ * Most of the log is read while writers carry on; only the entries they add
+ * meanwhile are read with the log locked. Once this returns, the changes
+ * passed on and the table files as they were at walPin together describe
+ * the tables at a single point in the log, the returned LSN.
+ */
+int walCutChanges(uint64_t *lsn, WalChangeFn apply, void *context) {
+    int ok = readChanges(lsn, 0, apply, context);
+
+    pthread_mutex_lock(&wal.ioMutex);
+    if (!lockWalFile(F_WRLCK)) {
+        releasePin();
+        pthread_mutex_unlock(&wal.ioMutex);
+        return 0;
+    }
+    ok = ok && readChanges(lsn, 1, apply, context);
+    releasePin();
+    lockWalFile(F_UNLCK);
+    pthread_mutex_unlock(&wal.ioMutex);
+    return ok;
+}
+
+/* State of a pass over the change archive */
+typedef struct {
+    unsigned char *buffer;
+    size_t length;
+    size_t capacity;
+    uint64_t fromLsn;
+    int64_t untilTime;
+    int untilOrderId;
+    int stopped;
+    int orderFound;
+    long changes;
+    WalChangeFn apply;
+    void *context;
+} ArchivePass;
+
+/**
+ * @brief Tells whether a log entry placed the given order
+ */
+static int placesOrder(const unsigned char *ops, size_t length, int orderId) {
+    size_t offset = 0;
+    while (offset + sizeof(WalOpHeader) <= length) {
+        WalOpHeader header;
+        memcpy(&header, ops + offset, sizeof(header));
+        if (header.table == TABLE_ORDERS && header.op == WAL_OP_APPEND && header.length >= sizeof(int) &&
+            offset + sizeof(header) + header.length <= length &&
+            recordId(ops + offset + sizeof(header)) == orderId) {
+            return 1;
+        }
+        offset += sizeof(header) + header.length;
+    }
+    return 0;
+}
+
+/**
+ * @brief Passes the changes in one run of archived entries on, up to the stop point
+ * @return int 1 on success, 0 if an entry is damaged or the callback failed
+ *
+ * Entries may span frames, so whatever is left of an unfinished entry is kept
+ * for the next call.
+ */
+static int consumeArchive(const unsigned char *data, size_t length, void *context) {
+    ArchivePass *pass = context;
+    if (pass->length + length > pass->capacity) {
+        size_t capacity = pass->capacity ? pass->capacity : 256 * 1024;
+        while (capacity < pass->length + length) {
+            capacity *= 2;
+        }
+        unsigned char *grown = realloc(pass->buffer, capacity);
+        if (grown == NULL) {
+            return 0;
+        }
+        pass->buffer = grown;
+        pass->capacity = capacity;
+    }
+    memcpy(pass->buffer + pass->length, data, length);
+    pass->length += length;
+
+    size_t offset = 0;
+    while (pass->length - offset >= sizeof(WalEntryHeader)) {
+        WalEntryHeader entry;
+        memcpy(&entry, pass->buffer + offset, sizeof(entry));
+        if (entry.magic != WAL_ENTRY_MAGIC) {
+            return 0;
+        }
+        if (pass->length - offset - sizeof(entry) < entry.length) {
+            break;
+        }
+
+        const unsigned char *ops = pass->buffer + offset + sizeof(entry);
+        WalEntryHeader check = entry;
+        check.checksum = 0;
+        if (computeCrc32(computeCrc32(0, &check, sizeof(check)), ops, entry.length) != entry.checksum) {
+            return 0;
+        }
+        offset += sizeof(entry) + entry.length;
+
+        if (pass->stopped || entry.lsn < pass->fromLsn) {
+            continue;
+        }
+        if (pass->untilTime > 0 && entry.timestamp > pass->untilTime) {
+            pass->stopped = 1;
+            continue;
+        }
+        if (!forEachChange(ops, entry.length, pass->apply, pass->context)) {
+            return 0;
+        }
+        pass->changes += entry.opCount;
+        if (pass->untilOrderId > 0 && placesOrder(ops, entry.length, pass->untilOrderId)) {
+            pass->orderFound = 1;
+            pass->stopped = 1;
+        }
+    }
+
+    memmove(pass->buffer, pass->buffer + offset, pass->length - offset);
+    pass->length -= offset;
+    return 1;
+}
+
+/**
+ * @brief Passes the archived changes from an LSN up to a stop point to a callback
+ * @param fromLsn The LSN to start at, such as the one a backup was cut at
+ * @param untilTime Stop before the first entry committed after this time, 0 for no limit
+ * @param untilOrderId Stop after the entry that placed this order, 0 for no limit
+ * @param apply Called for each record write (record set) or deletion (record NULL), in log order
+ * @param context Passed to the callback
+ * @param changes Optional output for the number of changes passed on
+ * @return int 1 on success, 0 if the archive does not reach back to fromLsn, is
+ *         damaged, never placed the order, or the callback failed
+ *
+ * Entries still only in the log are archived first, so everything committed
+ * before the call is included. Slots in the changes are those of the table
+ * files at the time, which compaction may since have moved.
+ */
+int walArchiveChanges(uint64_t fromLsn, int64_t untilTime, int untilOrderId, WalChangeFn apply, void *context,
+                      long *changes) {
+    pthread_mutex_lock(&wal.ioMutex);
+    if (!walOpen() || !lockWalFile(F_WRLCK)) {
+        pthread_mutex_unlock(&wal.ioMutex);
+        return 0;
+    }
+    WalFileHeader header;
+    struct stat st;
+    int ok = readHeader(&header) && fstat(wal.fd, &st) == 0 && archiveLog(&header, st.st_size);
+    lockWalFile(F_UNLCK);
+    pthread_mutex_unlock(&wal.ioMutex);
+
+    uint64_t archiveStart;
+    uint64_t archiveEnd;
+    ok = ok && archiveRange(&archiveStart, &archiveEnd) && archiveStart <= fromLsn;
+
+    ArchivePass pass;
+    memset(&pass, 0, sizeof(pass));
+    pass.fromLsn = fromLsn;
+    pass.untilTime = untilTime;
+    pass.untilOrderId = untilOrderId;
+    pass.apply = apply;
+    pass.context = context;
+    ok = ok && archiveRead(consumeArchive, &pass) && pass.length == 0 && (untilOrderId <= 0 || pass.orderFound);
+    free(pass.buffer);
+
+    if (changes != NULL) {
+        *changes = pass.changes;
+    }
+    return ok;
+}
@@ -0,0 +1,222 @@
+#define _DEFAULT_SOURCE
+#include "../include/common.h"
+#include "../include/table.h"
+#include "../include/archive.h"
+#include "../include/backup.h"
+#include "../include/orders.h"
+#include "../include/wal.h"
+#include "../include/utils.h"
+#include "unity.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define ITEM_COUNT 100
+#define ORDER_COUNT 20
+
+static const char *files[] = {
+    INVENTORY_FILE, INVENTORY_INDEX_FILE, INVENTORY_HOT_FILE,
+    CUSTOMERS_FILE, CUSTOMERS_INDEX_FILE, CUSTOMERS_HOT_FILE, ORDERS_FILE, ORDERS_INDEX_FILE,
+    ORDER_LINES_FILE, ORDER_LINES_INDEX_FILE, ORDER_LINES_LINKS_FILE,
+    ORDER_LINES_BY_ORDER_FILE, ORDER_LINES_BY_ITEM_FILE,
+    BACKUP_CHUNKS_FILE, BACKUP_CHUNK_INDEX_FILE, BACKUP_SNAPSHOT_DIR "test_base.snap", ARCHIVE_FILE,
+};
+
+static void removeFiles(void) {
+    for (size_t i = 0; i < sizeof(files) / sizeof(files[0]); i++) {
+        remove(files[i]);
+    }
+}
+
+/* Finds a live item in the inventory file itself, bypassing the cache */
+static int storedItem(int id, InventoryItem *item) {
+    FILE *file = fopen(INVENTORY_FILE, "rb");
+    int found = 0;
+    while (file != NULL && !found && fread(item, sizeof(*item), 1, file) == 1) {
+        found = item->id == id;
+    }
+    if (file != NULL) {
+        fclose(file);
+    }
+    return found;
+}
+
+/* Counts the live records in a table file */
+static int liveRecords(const char *path, size_t recordSize) {
+    unsigned char record[1024];
+    FILE *file = fopen(path, "rb");
+    int count = 0;
+    while (file != NULL && fread(record, recordSize, 1, file) == 1) {
+        count += recordId(record) > 0;
+    }
+    if (file != NULL) {
+        fclose(file);
+    }
+    return count;
+}
+
+static void setPrice(int id, Money price) {
+    InventoryItem item;
+    TEST_ASSERT_TRUE(tableGetById(TABLE_INVENTORY, id, &item, NULL));
+    item.price = price;
+    TEST_ASSERT_TRUE(tableUpdateById(TABLE_INVENTORY, &item));
+}
+
+static int placeOne(int itemId) {
+    OrderItemRequest item = {itemId, 1};
+    Order order = {0};
+    order.customerId = 1;
+    TEST_ASSERT_EQUAL_INT(ORDER_PLACED, placeOrderBatch(&order, &item, 1, NULL));
+    return order.id;
+}
+
+void setUp(void) {
+    // Set up test environment
+    initializeSystem();
+    walCheckpoint();
+    removeFiles();
+
+    WalTxn txn;
+    walBegin(&txn);
+    for (int id = 1; id <= ITEM_COUNT; id++) {
+        InventoryItem item = {id, "Bolt", "Steel bolt", MONEY(0.40), MONEY(1.00), 1000};
+        walLogWrite(&txn, TABLE_INVENTORY, WAL_APPEND_SLOT, &item);
+    }
+    TEST_ASSERT_TRUE(walCommit(&txn));
+    walEnd(&txn);
+
+    Customer customer = {1, "John Doe", "john@example.com", "1234567890", "123 Main St"};
+    tableAppend(TABLE_CUSTOMERS, &customer);
+    walCheckpoint();
+}
+
+void tearDown(void) {
+    // Clean up test environment
+    walCheckpoint();
+    removeFiles();
+}
+
+void test_checkpoints_archive_the_log(void) {
+    uint64_t startLsn;
+    uint64_t endLsn;
+    TEST_ASSERT_TRUE(archiveRange(&startLsn, &endLsn));
+    TEST_ASSERT_TRUE(endLsn > startLsn);
+
+    // Table records are padded with zeros, so the archive is much smaller than the log
+    struct stat st;
+    TEST_ASSERT_EQUAL_INT(0, stat(ARCHIVE_FILE, &st));
+    TEST_ASSERT_TRUE((uint64_t)st.st_size < (endLsn - startLsn) / 2);
+
+    setPrice(1, MONEY(2.00));
+    walCheckpoint();
+    uint64_t nextEndLsn;
+    TEST_ASSERT_TRUE(archiveRange(&startLsn, &nextEndLsn));
+    TEST_ASSERT_TRUE(nextEndLsn > endLsn);
+}
+
+void test_restore_until_order_stops_after_that_order(void) {
+    TEST_ASSERT_TRUE(backupCreate("test_base", NULL));
+
+    int orderIds[ORDER_COUNT];
+    for (int i = 0; i < ORDER_COUNT; i++) {
+        orderIds[i] = placeOne(1);
+        if (i == ORDER_COUNT / 4) {
+            walCheckpoint();
+        }
+    }
+
+    long changes;
+    TEST_ASSERT_TRUE(backupRestoreUntil("test_base", 0, orderIds[ORDER_COUNT / 2 - 1], &changes));
+    TEST_ASSERT_TRUE(changes > 0);
+
+    InventoryItem item;
+    TEST_ASSERT_EQUAL_INT(ORDER_COUNT / 2, liveRecords(ORDERS_FILE, sizeof(Order)));
+    TEST_ASSERT_TRUE(storedItem(1, &item));
+    TEST_ASSERT_EQUAL_INT(1000 - ORDER_COUNT / 2, item.quantity);
+
+    // Every change, up to the last order
+    TEST_ASSERT_TRUE(backupRestoreUntil("test_base", 0, 0, NULL));
+    TEST_ASSERT_EQUAL_INT(ORDER_COUNT, liveRecords(ORDERS_FILE, sizeof(Order)));
+    TEST_ASSERT_TRUE(storedItem(1, &item));
+    TEST_ASSERT_EQUAL_INT(1000 - ORDER_COUNT, item.quantity);
+}
+
+void test_restore_until_time_skips_later_changes(void) {
+    TEST_ASSERT_TRUE(backupCreate("test_base", NULL));
+    setPrice(1, MONEY(2.00));
+    time_t committed = time(NULL);
+    while (time(NULL) == committed) {
+        usleep(10000);
+    }
+    setPrice(1, MONEY(3.00));
+
+    InventoryItem item;
+    TEST_ASSERT_TRUE(backupRestoreUntil("test_base", committed, 0, NULL));
+    TEST_ASSERT_TRUE(storedItem(1, &item));
+    TEST_ASSERT_EQUAL_INT(MONEY(2.00), item.price);
+
+    TEST_ASSERT_TRUE(backupRestoreUntil("test_base", committed + 1, 0, NULL));
+    TEST_ASSERT_TRUE(storedItem(1, &item));
+    TEST_ASSERT_EQUAL_INT(MONEY(3.00), item.price);
+}
+
+void test_restore_replays_changes_across_compaction(void) {
+    TEST_ASSERT_TRUE(backupCreate("test_base", NULL));
+
+    // Deleting most items makes the checkpoint compact the table, moving item 100
+    for (int id = 1; id <= ITEM_COUNT / 2 + 10; id++) {
+        TEST_ASSERT_TRUE(tableDeleteById(TABLE_INVENTORY, id));
+    }
+    walCheckpoint();
+    TEST_ASSERT_EQUAL_INT(ITEM_COUNT / 2 - 10, tableRecordCount(TABLE_INVENTORY));
+
+    setPrice(ITEM_COUNT, MONEY(5.00));
+    InventoryItem added = {ITEM_COUNT + 1, "Nut", "Steel nut", MONEY(0.10), MONEY(0.25), 7};
+    TEST_ASSERT_TRUE(tableAppend(TABLE_INVENTORY, &added) >= 0);
+
+    InventoryItem item;
+    TEST_ASSERT_TRUE(backupRestoreUntil("test_base", 0, 0, NULL));
+    TEST_ASSERT_EQUAL_INT(ITEM_COUNT / 2 - 9, liveRecords(INVENTORY_FILE, sizeof(InventoryItem)));
+    TEST_ASSERT_FALSE(storedItem(1, &item));
+    TEST_ASSERT_TRUE(storedItem(ITEM_COUNT, &item));
+    TEST_ASSERT_EQUAL_INT(MONEY(5.00), item.price);
+    TEST_ASSERT_TRUE(storedItem(ITEM_COUNT + 1, &item));
+    TEST_ASSERT_EQUAL_INT(7, item.quantity);
+}
+
+void test_restore_refuses_damaged_archive_or_unknown_order(void) {
+    TEST_ASSERT_TRUE(backupCreate("test_base", NULL));
+    setPrice(1, MONEY(2.00));
+    walCheckpoint();
+
+    // An order never placed after the backup is not a point to stop at
+    TEST_ASSERT_FALSE(backupRestoreUntil("test_base", 0, 999999, NULL));
+
+    struct stat st;
+    unsigned char byte;
+    int fd = open(ARCHIVE_FILE, O_RDWR);
+    TEST_ASSERT_TRUE(fd >= 0);
+    TEST_ASSERT_EQUAL_INT(0, fstat(fd, &st));
+    TEST_ASSERT_EQUAL_INT(1, pread(fd, &byte, 1, st.st_size - 10));
+    byte ^= 0x5A;
+    TEST_ASSERT_EQUAL_INT(1, pwrite(fd, &byte, 1, st.st_size - 10));
+    close(fd);
+
+    InventoryItem item;
+    TEST_ASSERT_FALSE(backupRestoreUntil("test_base", 0, 0, NULL));
+    TEST_ASSERT_TRUE(storedItem(1, &item));
+    TEST_ASSERT_EQUAL_INT(MONEY(2.00), item.price);
+    TEST_ASSERT_EQUAL_INT(-1, access(INVENTORY_FILE ".restore", F_OK));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_checkpoints_archive_the_log);
+    RUN_TEST(test_restore_until_order_stops_after_that_order);
+    RUN_TEST(test_restore_until_time_skips_later_changes);
+    RUN_TEST(test_restore_replays_changes_across_compaction);
+    RUN_TEST(test_restore_refuses_damaged_archive_or_unknown_order);
+    return UNITY_END();
+}
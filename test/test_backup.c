@@ -0,0 +1,272 @@
+#define _DEFAULT_SOURCE
+#include "../include/common.h"
+#include "../include/table.h"
+#include "../include/backup.h"
+#include "../include/orders.h"
+#include "../include/wal.h"
+#include "../include/utils.h"
+#include "unity.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#define LEGACY_BACKUP BACKUP_DIR "test_legacy"
+#define ITEM_COUNT 1000
+#define ORDER_COUNT 300
+#define MAX_SNAPSHOTS 1000
+
+static const char *files[] = {
+    INVENTORY_FILE, INVENTORY_INDEX_FILE, INVENTORY_HOT_FILE,
+    CUSTOMERS_FILE, CUSTOMERS_INDEX_FILE, CUSTOMERS_HOT_FILE, ORDERS_FILE, ORDERS_INDEX_FILE,
+    ORDER_LINES_FILE, ORDER_LINES_INDEX_FILE, ORDER_LINES_LINKS_FILE,
+    ORDER_LINES_BY_ORDER_FILE, ORDER_LINES_BY_ITEM_FILE,
+    BACKUP_CHUNKS_FILE, BACKUP_CHUNK_INDEX_FILE, LEGACY_BACKUP "/inventory.dat",
+};
+
+static void removeSnapshot(const char *name) {
+    char path[256];
+    snprintf(path, sizeof(path), "%s%s.snap", BACKUP_SNAPSHOT_DIR, name);
+    remove(path);
+}
+
+/* Number of test_N snapshots the last test took, removed even if it failed */
+static int numberedSnapshots = 0;
+
+static void removeFiles(void) {
+    for (size_t i = 0; i < sizeof(files) / sizeof(files[0]); i++) {
+        remove(files[i]);
+    }
+    removeSnapshot("test_full");
+    removeSnapshot("test_next");
+    for (; numberedSnapshots > 0; numberedSnapshots--) {
+        char name[32];
+        snprintf(name, sizeof(name), "test_%d", numberedSnapshots - 1);
+        removeSnapshot(name);
+    }
+    rmdir(LEGACY_BACKUP);
+}
+
+static void setPrice(int id, Money price) {
+    InventoryItem item;
+    TEST_ASSERT_TRUE(tableGetById(TABLE_INVENTORY, id, &item, NULL));
+    item.price = price;
+    TEST_ASSERT_TRUE(tableUpdateById(TABLE_INVENTORY, &item));
+    walCheckpoint();
+}
+
+static Money priceOf(int id) {
+    InventoryItem item;
+    TEST_ASSERT_TRUE(tableGetById(TABLE_INVENTORY, id, &item, NULL));
+    return item.price;
+}
+
+/* Adds up the live quantities in the inventory or order lines file */
+static long liveQuantity(const char *path, TableId table) {
+    FILE *file = fopen(path, "rb");
+    long total = 0;
+    if (file == NULL) {
+        return 0;
+    }
+    if (table == TABLE_INVENTORY) {
+        InventoryItem item;
+        while (fread(&item, sizeof(item), 1, file) == 1) {
+            total += item.id > 0 ? item.quantity : 0;
+        }
+    } else {
+        OrderLine line;
+        while (fread(&line, sizeof(line), 1, file) == 1) {
+            total += line.id > 0 ? line.quantity : 0;
+        }
+    }
+    fclose(file);
+    return total;
+}
+
+void setUp(void) {
+    // Set up test environment
+    initializeSystem();
+    mkdir(BACKUP_DIR, 0755);
+    removeFiles();
+
+    WalTxn txn;
+    walBegin(&txn);
+    for (int id = 1; id <= ITEM_COUNT; id++) {
+        InventoryItem item = {id, "Bolt", "Steel bolt", MONEY(0.40), MONEY(1.00), id};
+        walLogWrite(&txn, TABLE_INVENTORY, WAL_APPEND_SLOT, &item);
+    }
+    TEST_ASSERT_TRUE(walCommit(&txn));
+    walEnd(&txn);
+    walCheckpoint();
+
+    Customer customer = {1, "John Doe", "john@example.com", "1234567890", "123 Main St"};
+    tableAppend(TABLE_CUSTOMERS, &customer);
+}
+
+void tearDown(void) {
+    // Clean up test environment
+    walCheckpoint();
+    removeFiles();
+}
+
+void test_next_backup_stores_only_changed_blocks(void) {
+    BackupStats stats;
+    TEST_ASSERT_TRUE(backupCreate("test_full", &stats));
+    TEST_ASSERT_EQUAL_INT(stats.totalBytes, stats.newBytes);
+    TEST_ASSERT_TRUE(backupVerify("test_full"));
+
+    // Item 1 lives in the first block of a file several blocks long
+    TEST_ASSERT_TRUE(ITEM_COUNT * sizeof(InventoryItem) > 2 * BACKUP_BLOCK_SIZE);
+    setPrice(1, MONEY(1.50));
+
+    TEST_ASSERT_TRUE(backupCreate("test_next", &stats));
+    TEST_ASSERT_EQUAL_INT(BACKUP_BLOCK_SIZE, stats.newBytes);
+    TEST_ASSERT_TRUE(backupVerify("test_next"));
+    TEST_ASSERT_TRUE(backupVerify("test_full"));
+
+    // Nothing changed since, so nothing is added
+    TEST_ASSERT_TRUE(backupCreate("test_next", &stats));
+    TEST_ASSERT_EQUAL_INT(0, stats.newBytes);
+    TEST_ASSERT_EQUAL_INT(0, stats.storedBytes);
+}
+
+void test_backup_stores_blocks_compressed(void) {
+    BackupStats stats;
+    TEST_ASSERT_TRUE(backupCreate("test_full", &stats));
+    TEST_ASSERT_TRUE(stats.storedBytes > 0);
+    TEST_ASSERT_TRUE(stats.storedBytes < stats.newBytes / 2);
+
+    struct stat st;
+    TEST_ASSERT_EQUAL_INT(0, stat(BACKUP_CHUNKS_FILE, &st));
+    TEST_ASSERT_EQUAL_INT(stats.storedBytes, st.st_size);
+}
+
+void test_restore_refuses_damaged_backup(void) {
+    TEST_ASSERT_TRUE(backupCreate("test_full", NULL));
+    setPrice(1, MONEY(1.50));
+
+    struct stat st;
+    unsigned char byte;
+    int fd = open(BACKUP_CHUNKS_FILE, O_RDWR);
+    TEST_ASSERT_TRUE(fd >= 0);
+    TEST_ASSERT_EQUAL_INT(0, fstat(fd, &st));
+    TEST_ASSERT_EQUAL_INT(1, pread(fd, &byte, 1, st.st_size / 2));
+    byte ^= 0x5A;
+    TEST_ASSERT_EQUAL_INT(1, pwrite(fd, &byte, 1, st.st_size / 2));
+    close(fd);
+
+    TEST_ASSERT_FALSE(backupVerify("test_full"));
+    TEST_ASSERT_FALSE(backupRestore("test_full"));
+    TEST_ASSERT_EQUAL_INT(MONEY(1.50), priceOf(1));
+    TEST_ASSERT_EQUAL_INT(-1, access(INVENTORY_FILE ".restore", F_OK));
+    TEST_ASSERT_FALSE(backupRestore("test_missing"));
+}
+
+void test_restore_brings_back_backed_up_records(void) {
+    TEST_ASSERT_TRUE(backupCreate("test_full", NULL));
+    setPrice(1, MONEY(1.50));
+    setPrice(ITEM_COUNT, MONEY(2.50));
+    TEST_ASSERT_TRUE(backupCreate("test_next", NULL));
+
+    TEST_ASSERT_TRUE(backupRestore("test_full"));
+    TEST_ASSERT_EQUAL_INT(MONEY(1.00), priceOf(1));
+    TEST_ASSERT_EQUAL_INT(MONEY(1.00), priceOf(ITEM_COUNT));
+
+    TEST_ASSERT_TRUE(backupRestore("test_next"));
+    TEST_ASSERT_EQUAL_INT(MONEY(1.50), priceOf(1));
+    TEST_ASSERT_EQUAL_INT(MONEY(2.50), priceOf(ITEM_COUNT));
+}
+
+void test_restore_empties_tables_written_after_the_backup(void) {
+    // Taken before any order existed
+    TEST_ASSERT_TRUE(backupCreate("test_full", NULL));
+    TEST_ASSERT_TRUE(backupVerify("test_full"));
+
+    OrderItemRequest item = {ITEM_COUNT, 3};
+    Order order = {0};
+    order.customerId = 1;
+    TEST_ASSERT_EQUAL_INT(ORDER_PLACED, placeOrderBatch(&order, &item, 1, NULL));
+    walCheckpoint();
+    TEST_ASSERT_EQUAL_INT(3, liveQuantity(ORDER_LINES_FILE, TABLE_ORDER_LINES));
+
+    TEST_ASSERT_TRUE(backupRestore("test_full"));
+    TEST_ASSERT_EQUAL_INT(0, tableRecordCount(TABLE_ORDERS));
+    TEST_ASSERT_EQUAL_INT(0, liveQuantity(ORDER_LINES_FILE, TABLE_ORDER_LINES));
+    TEST_ASSERT_EQUAL_INT((long)ITEM_COUNT * (ITEM_COUNT + 1) / 2, liveQuantity(INVENTORY_FILE, TABLE_INVENTORY));
+}
+
+void test_restore_reads_old_backup_directories(void) {
+    // Earlier versions copied every table file into its own directory
+    mkdir(LEGACY_BACKUP, 0755);
+    FILE *in = fopen(INVENTORY_FILE, "rb");
+    FILE *out = fopen(LEGACY_BACKUP "/inventory.dat", "wb");
+    TEST_ASSERT_NOT_NULL(in);
+    TEST_ASSERT_NOT_NULL(out);
+    char buffer[4096];
+    size_t got;
+    while ((got = fread(buffer, 1, sizeof(buffer), in)) > 0) {
+        fwrite(buffer, 1, got, out);
+    }
+    fclose(in);
+    fclose(out);
+
+    setPrice(1, MONEY(1.50));
+    TEST_ASSERT_TRUE(backupRestore("test_legacy"));
+    TEST_ASSERT_EQUAL_INT(MONEY(1.00), priceOf(1));
+}
+
+void test_backup_taken_while_orders_are_placed_is_consistent(void) {
+    fflush(stdout);
+    pid_t seller = fork();
+    TEST_ASSERT_TRUE(seller >= 0);
+    if (seller == 0) {
+        for (int i = 0; i < ORDER_COUNT; i++) {
+            OrderItemRequest item = {ITEM_COUNT - i % 10, 1};
+            Order order = {0};
+            order.customerId = 1;
+            placeOrderBatch(&order, &item, 1, NULL);
+        }
+        _exit(0);
+    }
+
+    int backups = 0;
+    int status;
+    do {
+        char name[32];
+        snprintf(name, sizeof(name), "test_%d", backups);
+        backups++;
+        numberedSnapshots = backups;
+        TEST_ASSERT_TRUE(backupCreate(name, NULL));
+    } while (waitpid(seller, &status, WNOHANG) == 0 && backups < MAX_SNAPSHOTS);
+    if (backups == MAX_SNAPSHOTS) {
+        waitpid(seller, &status, 0);
+    }
+    TEST_ASSERT_TRUE(backups > 1);
+    TEST_ASSERT_TRUE(WIFEXITED(status));
+
+    // Each order moves one unit from an item's stock to an order line, so any
+    // cut through the log keeps the sum of the two at the starting stock
+    long startingStock = (long)ITEM_COUNT * (ITEM_COUNT + 1) / 2;
+    walCheckpoint();
+    for (int i = 0; i < backups; i++) {
+        char name[32];
+        snprintf(name, sizeof(name), "test_%d", i);
+        TEST_ASSERT_TRUE(backupRestore(name));
+        TEST_ASSERT_EQUAL_INT(startingStock, liveQuantity(INVENTORY_FILE, TABLE_INVENTORY) +
+                                                 liveQuantity(ORDER_LINES_FILE, TABLE_ORDER_LINES));
+    }
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_next_backup_stores_only_changed_blocks);
+    RUN_TEST(test_backup_stores_blocks_compressed);
+    RUN_TEST(test_restore_refuses_damaged_backup);
+    RUN_TEST(test_restore_brings_back_backed_up_records);
+    RUN_TEST(test_restore_empties_tables_written_after_the_backup);
+    RUN_TEST(test_restore_reads_old_backup_directories);
+    RUN_TEST(test_backup_taken_while_orders_are_placed_is_consistent);
+    return UNITY_END();
+}
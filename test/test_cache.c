@@ -0,0 +1,156 @@
+#include "../include/common.h"
+#include "../include/table.h"
+#include "../include/cache.h"
+#include "../include/wal.h"
+#include "../include/utils.h"
+#include "unity.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#define REPLACEMENT_FILE "data/inventory.dat.new"
+
+/* Appends items straight to a data file, as another process would */
+static void writeItems(const char *path, const char *mode, int firstId, int count) {
+    FILE *file = fopen(path, mode);
+    for (int id = firstId; id < firstId + count; id++) {
+        InventoryItem item = {id, "Item", "Description", MONEY(1.0), MONEY(2.0), id};
+        fwrite(&item, sizeof(item), 1, file);
+    }
+    fclose(file);
+}
+
+void setUp(void) {
+    // Set up test environment
+    initializeSystem();
+    walCheckpoint();
+    remove(INVENTORY_FILE);
+    remove(INVENTORY_INDEX_FILE);
+    remove(INVENTORY_META_FILE);
+    remove(REPLACEMENT_FILE);
+    cacheInvalidate(TABLE_INVENTORY);
+}
+
+void tearDown(void) {
+    // Clean up test environment
+    walCheckpoint();
+    cacheInvalidate(TABLE_INVENTORY);
+    remove(INVENTORY_FILE);
+    remove(INVENTORY_INDEX_FILE);
+    remove(INVENTORY_META_FILE);
+    remove(REPLACEMENT_FILE);
+}
+
+void test_appended_records_become_visible(void) {
+    writeItems(INVENTORY_FILE, "wb", 1, 10);
+    long count;
+    const InventoryItem *items = cacheTable(TABLE_INVENTORY, &count);
+    TEST_ASSERT_NOT_NULL(items);
+    TEST_ASSERT_EQUAL_INT(10, count);
+
+    writeItems(INVENTORY_FILE, "ab", 11, 1);
+    items = cacheTable(TABLE_INVENTORY, &count);
+    TEST_ASSERT_EQUAL_INT(11, count);
+    TEST_ASSERT_EQUAL_INT(11, items[10].id);
+
+    // A record still being written is left out until it is whole
+    FILE *file = fopen(INVENTORY_FILE, "ab");
+    fwrite("partial", 1, 7, file);
+    fclose(file);
+    cacheTable(TABLE_INVENTORY, &count);
+    TEST_ASSERT_EQUAL_INT(11, count);
+}
+
+void test_replaced_file_of_the_same_size_is_remapped(void) {
+    writeItems(INVENTORY_FILE, "wb", 1, 10);
+    long count;
+    const InventoryItem *items = cacheTable(TABLE_INVENTORY, &count);
+    TEST_ASSERT_EQUAL_INT(1, items[0].id);
+
+    // Compaction and restore write a new file and rename it over the old one
+    writeItems(REPLACEMENT_FILE, "wb", 101, 10);
+    TEST_ASSERT_EQUAL_INT(0, rename(REPLACEMENT_FILE, INVENTORY_FILE));
+
+    items = cacheTable(TABLE_INVENTORY, &count);
+    TEST_ASSERT_EQUAL_INT(10, count);
+    TEST_ASSERT_EQUAL_INT(101, items[0].id);
+    TEST_ASSERT_EQUAL_INT(110, items[9].id);
+}
+
+void test_missing_file_has_no_records(void) {
+    long count = 0;
+    TEST_ASSERT_NULL(cacheTable(TABLE_INVENTORY, &count));
+    TEST_ASSERT_EQUAL_INT(-1, count);
+
+    // An empty file exists but maps nothing
+    writeItems(INVENTORY_FILE, "wb", 1, 0);
+    TEST_ASSERT_NULL(cacheTable(TABLE_INVENTORY, &count));
+    TEST_ASSERT_EQUAL_INT(0, count);
+
+    // A file removed after it was mapped is reported missing too
+    writeItems(INVENTORY_FILE, "wb", 1, 3);
+    TEST_ASSERT_NOT_NULL(cacheTable(TABLE_INVENTORY, &count));
+    remove(INVENTORY_FILE);
+    TEST_ASSERT_NULL(cacheTable(TABLE_INVENTORY, &count));
+    TEST_ASSERT_EQUAL_INT(-1, count);
+}
+
+static volatile int writerDone;
+
+/* Reads every record over and over, the way views and reports walk the mapping */
+static void *readRecords(void *arg) {
+    long *badRecords = arg;
+    while (!writerDone) {
+        long count;
+        const InventoryItem *items = cacheTable(TABLE_INVENTORY, &count);
+        for (long i = 0; i < count; i++) {
+            if (abs(items[i].id) != items[i].quantity) {
+                (*badRecords)++;
+            }
+        }
+    }
+    return NULL;
+}
+
+void test_readers_survive_remaps_by_other_threads(void) {
+    long badRecords = 0;
+    writerDone = 0;
+    pthread_t reader;
+    TEST_ASSERT_EQUAL_INT(0, pthread_create(&reader, NULL, readRecords, &badRecords));
+
+    // Appends grow the table and compaction replaces its file under the reader
+    int nextId = 1;
+    for (int round = 0; round < 50; round++) {
+        for (int i = 0; i < 20; i++, nextId++) {
+            InventoryItem item = {nextId, "Item", "Description", MONEY(1.0), MONEY(2.0), nextId};
+            TEST_ASSERT_TRUE(tableAppend(TABLE_INVENTORY, &item) >= 0);
+        }
+        for (int id = nextId - 20; id < nextId - 1; id++) {
+            TEST_ASSERT_TRUE(tableDeleteById(TABLE_INVENTORY, id));
+        }
+        TEST_ASSERT_TRUE(walCheckpoint());
+    }
+
+    writerDone = 1;
+    pthread_join(reader, NULL);
+    TEST_ASSERT_EQUAL_INT(0, badRecords);
+
+    long count;
+    long live = 0;
+    const InventoryItem *items = cacheTable(TABLE_INVENTORY, &count);
+    for (long i = 0; i < count; i++) {
+        live += items[i].id > 0;
+    }
+    TEST_ASSERT_EQUAL_INT(50, live);
+    TEST_ASSERT_EQUAL_INT(50, count);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_appended_records_become_visible);
+    RUN_TEST(test_replaced_file_of_the_same_size_is_remapped);
+    RUN_TEST(test_missing_file_has_no_records);
+    RUN_TEST(test_readers_survive_remaps_by_other_threads);
+    return UNITY_END();
+}
@@ -0,0 +1,183 @@
+#include "../include/common.h"
+#include "../include/table.h"
+#include "../include/columns.h"
+#include "../include/financial.h"
+#include "../include/wal.h"
+#include "../include/utils.h"
+#include "unity.h"
+#include <stdio.h>
+#include <string.h>
+
+static void removeColumnFiles(void) {
+    const char *names[] = {"", ".id", ".customer", ".date", ".amount", ".profit", ".status"};
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        char path[256];
+        snprintf(path, sizeof(path), "%s%s", ORDERS_COLUMNS_FILE, names[i]);
+        remove(path);
+    }
+}
+
+static void appendOrder(int id, time_t orderDate, Money totalAmount, Money profit) {
+    Order order = {id, 1, orderDate, totalAmount, "Pending", profit};
+    tableAppend(TABLE_ORDERS, &order);
+}
+
+void setUp(void) {
+    // Set up test environment
+    initializeSystem();
+    remove(ORDERS_FILE);
+    remove(ORDERS_INDEX_FILE);
+    removeColumnFiles();
+}
+
+void tearDown(void) {
+    // Clean up test environment
+    walCheckpoint();
+    remove(ORDERS_FILE);
+    remove(ORDERS_INDEX_FILE);
+    removeColumnFiles();
+}
+
+void test_columns_follow_appends_updates_and_deletes(void) {
+    appendOrder(1, 1609459200, MONEY(100.00), MONEY(40.00));
+    appendOrder(2, 1609545600, MONEY(150.00), MONEY(60.00));
+
+    OrderColumns columns;
+    TEST_ASSERT_TRUE(columnsLoad(ORDER_COLUMN_MASK(ORDER_COLUMN_ID) | ORDER_COLUMN_MASK(ORDER_COLUMN_STATUS), &columns));
+    TEST_ASSERT_EQUAL_INT(2, columns.count);
+    TEST_ASSERT_EQUAL_INT(2, columns.id[1]);
+    TEST_ASSERT_EQUAL_INT(ORDER_STATUS_PENDING, columns.status[0]);
+    TEST_ASSERT_NULL(columns.totalAmount);
+
+    Order order = {1, 1, 1609459200, MONEY(100.00), "Shipped", MONEY(40.00)};
+    tableUpdateById(TABLE_ORDERS, &order);
+    appendOrder(3, 1609632000, MONEY(80.00), MONEY(20.00));
+    tableDeleteById(TABLE_ORDERS, 2);
+
+    TEST_ASSERT_TRUE(columnsLoad(ORDER_COLUMN_MASK(ORDER_COLUMN_STATUS) | ORDER_COLUMN_MASK(ORDER_COLUMN_AMOUNT), &columns));
+    TEST_ASSERT_EQUAL_INT(3, columns.count);
+    TEST_ASSERT_EQUAL_INT(ORDER_STATUS_SHIPPED, columns.status[0]);
+    TEST_ASSERT_EQUAL_INT(ORDER_STATUS_DELETED, columns.status[1]);
+    TEST_ASSERT_EQUAL_INT(MONEY(80.00), columns.totalAmount[2]);
+}
+
+void test_reports_skip_deleted_orders(void) {
+    appendOrder(1, parseDate("2021-01-01"), MONEY(100.00), MONEY(40.00));
+    appendOrder(2, parseDate("2021-01-02"), MONEY(150.00), MONEY(60.00));
+    appendOrder(3, parseDate("2021-02-01"), MONEY(500.00), MONEY(100.00));
+    tableDeleteById(TABLE_ORDERS, 2);
+
+    SalesReport sales;
+    generateSalesReport("2021-01-01", "2021-01-31", &sales);
+    TEST_ASSERT_EQUAL_INT(MONEY(100.00), sales.totalSales);
+    TEST_ASSERT_EQUAL_INT(1, sales.orderCount);
+
+    ProfitReport profit;
+    generateProfitReport("2021-01-01", "2021-02-01", &profit);
+    TEST_ASSERT_EQUAL_INT(MONEY(600.00), profit.totalRevenue);
+    TEST_ASSERT_EQUAL_INT(MONEY(140.00), profit.totalProfit);
+
+    // Segments the range only partly covers are summed row by row
+    generateProfitReport("2021-01-02", "2021-02-01", &profit);
+    TEST_ASSERT_EQUAL_INT(MONEY(500.00), profit.totalRevenue);
+    TEST_ASSERT_EQUAL_INT(MONEY(100.00), profit.totalProfit);
+
+    // Fully covered ones take their zone map's sums, which follow updates
+    Order order = {1, 1, parseDate("2021-01-01"), MONEY(120.00), "Shipped", MONEY(45.00)};
+    tableUpdateById(TABLE_ORDERS, &order);
+    generateProfitReport("2021-01-01", "2021-01-31", &profit);
+    TEST_ASSERT_EQUAL_INT(MONEY(120.00), profit.totalRevenue);
+    TEST_ASSERT_EQUAL_INT(MONEY(45.00), profit.totalProfit);
+}
+
+void test_columns_rebuild_when_missing_or_stale(void) {
+    appendOrder(1, 1609459200, MONEY(100.00), MONEY(40.00));
+    appendOrder(2, 1609545600, MONEY(150.00), MONEY(60.00));
+    removeColumnFiles();
+
+    OrderColumns columns;
+    TEST_ASSERT_TRUE(columnsLoad(ORDER_COLUMN_MASK(ORDER_COLUMN_AMOUNT), &columns));
+    TEST_ASSERT_EQUAL_INT(2, columns.count);
+    TEST_ASSERT_EQUAL_INT(MONEY(150.00), columns.totalAmount[1]);
+
+    // Replace the data file behind the columns' back
+    walCheckpoint();
+    remove(ORDERS_FILE);
+    appendOrder(7, 1609459200, MONEY(12.50), MONEY(2.50));
+
+    TEST_ASSERT_TRUE(columnsLoad(ORDER_COLUMN_MASK(ORDER_COLUMN_ID) | ORDER_COLUMN_MASK(ORDER_COLUMN_AMOUNT), &columns));
+    TEST_ASSERT_EQUAL_INT(1, columns.count);
+    TEST_ASSERT_EQUAL_INT(7, columns.id[0]);
+    TEST_ASSERT_EQUAL_INT(MONEY(12.50), columns.totalAmount[0]);
+}
+
+void test_segments_follow_months_and_survive_replay(void) {
+    appendOrder(1, parseDate("2021-01-05"), MONEY(10.00), MONEY(1.00));
+    appendOrder(2, parseDate("2021-01-20"), MONEY(20.00), MONEY(2.00));
+    appendOrder(3, parseDate("2021-02-03"), MONEY(30.00), MONEY(3.00));
+    appendOrder(4, parseDate("2021-03-15"), MONEY(40.00), MONEY(4.00));
+    tableDeleteById(TABLE_ORDERS, 2);
+
+    // Replaying the log applies every write a second time
+    walRecover();
+
+    OrderColumns columns;
+    TEST_ASSERT_TRUE(columnsLoad(0, &columns));
+    TEST_ASSERT_EQUAL_INT(3, columns.segmentCount);
+    TEST_ASSERT_EQUAL_INT(2, columns.segments[0].rowCount);
+    TEST_ASSERT_EQUAL_INT(1, columns.segments[0].liveCount);
+    TEST_ASSERT_EQUAL_INT(MONEY(10.00), columns.segments[0].totalAmount);
+    TEST_ASSERT_EQUAL_INT(3, columns.segments[2].firstRow);
+
+    SalesReport sales;
+    generateSalesReport("2021-01-01", "2021-02-10", &sales);
+    TEST_ASSERT_EQUAL_INT(MONEY(40.00), sales.totalSales);
+    TEST_ASSERT_EQUAL_INT(2, sales.orderCount);
+
+    generateSalesReport("2021-02-01", "2021-03-01", &sales);
+    TEST_ASSERT_EQUAL_INT(MONEY(30.00), sales.totalSales);
+    TEST_ASSERT_EQUAL_INT(1, sales.orderCount);
+}
+
+void test_writes_to_older_segments_match_a_rebuild(void) {
+    for (int month = 1; month <= 12; month++) {
+        char date[16];
+        snprintf(date, sizeof(date), "2021-%02d-10", month);
+        appendOrder(month, parseDate(date), MONEY(10.00) * month, MONEY(1.00) * month);
+    }
+
+    // Updates and deletes land in segments before the last one
+    Order order = {3, 1, parseDate("2021-03-10"), MONEY(99.00), "Shipped", MONEY(9.00)};
+    TEST_ASSERT_TRUE(tableUpdateById(TABLE_ORDERS, &order));
+    TEST_ASSERT_TRUE(tableDeleteById(TABLE_ORDERS, 8));
+    TEST_ASSERT_TRUE(tableDeleteById(TABLE_ORDERS, 1));
+
+    OrderColumns columns;
+    TEST_ASSERT_TRUE(columnsLoad(0, &columns));
+    TEST_ASSERT_EQUAL_INT(12, columns.segmentCount);
+    OrderSegment patched[12];
+    memcpy(patched, columns.segments, sizeof(patched));
+    TEST_ASSERT_EQUAL_INT(MONEY(99.00), patched[2].totalAmount);
+    TEST_ASSERT_EQUAL_INT(0, patched[7].liveCount);
+    TEST_ASSERT_EQUAL_INT(0, patched[0].liveCount);
+
+    removeColumnFiles();
+    TEST_ASSERT_TRUE(columnsLoad(0, &columns));
+    TEST_ASSERT_EQUAL_INT(12, columns.segmentCount);
+    for (int i = 0; i < 12; i++) {
+        TEST_ASSERT_EQUAL_INT(columns.segments[i].firstRow, patched[i].firstRow);
+        TEST_ASSERT_EQUAL_INT(columns.segments[i].liveCount, patched[i].liveCount);
+        TEST_ASSERT_EQUAL_INT(columns.segments[i].totalAmount, patched[i].totalAmount);
+        TEST_ASSERT_EQUAL_INT(columns.segments[i].profit, patched[i].profit);
+    }
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_columns_follow_appends_updates_and_deletes);
+    RUN_TEST(test_reports_skip_deleted_orders);
+    RUN_TEST(test_columns_rebuild_when_missing_or_stale);
+    RUN_TEST(test_segments_follow_months_and_survive_replay);
+    RUN_TEST(test_writes_to_older_segments_match_a_rebuild);
+    return UNITY_END();
+}
@@ -0,0 +1,133 @@
+#include "../include/common.h"
+#include "../include/command.h"
+#include "../include/table.h"
+#include "../include/wal.h"
+#include "../include/utils.h"
+#include "../include/metrics.h"
+#include "unity.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *files[] = {
+    ORDERS_FILE, ORDERS_INDEX_FILE, INVENTORY_FILE, INVENTORY_INDEX_FILE, INVENTORY_HOT_FILE,
+    INVENTORY_SEARCH_FILE, INVENTORY_SEARCH_DELTA_FILE, CUSTOMERS_FILE, CUSTOMERS_INDEX_FILE, CUSTOMERS_HOT_FILE,
+    ORDER_LINES_FILE, ORDER_LINES_INDEX_FILE, ORDER_LINES_LINKS_FILE,
+    ORDER_LINES_BY_ORDER_FILE, ORDER_LINES_BY_ITEM_FILE,
+    INVENTORY_META_FILE, CUSTOMERS_META_FILE, ORDERS_META_FILE, ORDER_LINES_META_FILE,
+};
+
+static char result[4096];
+
+static void removeFiles(void) {
+    for (size_t i = 0; i < sizeof(files) / sizeof(files[0]); i++) {
+        remove(files[i]);
+    }
+}
+
+/* Runs one script line and keeps what it printed in result */
+static int run(const char *text) {
+    char line[512];
+    strcpy(line, text);
+    FILE *out = tmpfile();
+    TEST_ASSERT_NOT_NULL(out);
+    int ok = commandRunLine(line, out);
+    rewind(out);
+    size_t length = fread(result, 1, sizeof(result) - 1, out);
+    result[length] = '\0';
+    fclose(out);
+    return ok;
+}
+
+void setUp(void) {
+    // Set up test environment
+    initializeSystem();
+    removeFiles();
+}
+
+void tearDown(void) {
+    // Clean up test environment
+    walCheckpoint();
+    removeFiles();
+}
+
+void test_commands_print_json_results(void) {
+    TEST_ASSERT_TRUE(run("customer add --name \"Jo \\\"JJ\\\" Doe\" --phone 555-0100"));
+    TEST_ASSERT_NOT_NULL(strstr(result, "\"name\":\"Jo \\\"JJ\\\" Doe\""));
+
+    TEST_ASSERT_TRUE(run("item add --name \"Steel Bolt\" --cost 0.40 --price 1.00 --quantity 10"));
+    TEST_ASSERT_NOT_NULL(strstr(result, "\"cost\":0.40,\"price\":1.00,\"quantity\":10"));
+
+    TEST_ASSERT_TRUE(run("order place --customer 1 --item 1:4 --item 1"));
+    TEST_ASSERT_NOT_NULL(strstr(result, "{\"ok\":true,\"order\":"));
+    TEST_ASSERT_NOT_NULL(strstr(result, "\"totalAmount\":5.00"));
+
+    TEST_ASSERT_TRUE(run("item get 1"));
+    TEST_ASSERT_NOT_NULL(strstr(result, "\"quantity\":5"));
+
+    TEST_ASSERT_TRUE(run("item search Bolt   # trailing comment"));
+    TEST_ASSERT_NOT_NULL(strstr(result, "\"items\":[{\"id\":1,"));
+
+    TEST_ASSERT_TRUE(run("order status 1 shipped"));
+    TEST_ASSERT_NOT_NULL(strstr(result, "\"status\":\"Shipped\""));
+}
+
+void test_failures_are_reported_not_fatal(void) {
+    TEST_ASSERT_TRUE(run("   "));
+    TEST_ASSERT_EQUAL_STRING("", result);
+
+    TEST_ASSERT_FALSE(run("item get 99"));
+    TEST_ASSERT_EQUAL_STRING("{\"ok\":false,\"error\":\"item not found\"}\n", result);
+
+    TEST_ASSERT_FALSE(run("item add --name Bolt --cost 2 --price 1 --quantity 1"));
+    TEST_ASSERT_NOT_NULL(strstr(result, "price is below cost"));
+
+    TEST_ASSERT_FALSE(run("order place --customer 1 --item 1:2"));
+    TEST_ASSERT_NOT_NULL(strstr(result, "customer not found"));
+
+    TEST_ASSERT_FALSE(run("item add --name \"unterminated"));
+    TEST_ASSERT_NOT_NULL(strstr(result, "cannot parse line"));
+
+    TEST_ASSERT_FALSE(run("frobnicate"));
+    TEST_ASSERT_EQUAL_INT(0, tableRecordCount(TABLE_INVENTORY)); // The rejected add wrote nothing
+}
+
+void test_commands_are_timed_like_the_menus(void) {
+    metricsReset();
+    TEST_ASSERT_TRUE(run("customer add --name Jo"));
+    TEST_ASSERT_TRUE(run("customer update 1 --phone 555-0100"));
+    TEST_ASSERT_TRUE(run("item add --name Bolt --cost 0.40 --price 1.00 --quantity 10"));
+    TEST_ASSERT_TRUE(run("item update 1 --quantity 12"));
+    TEST_ASSERT_FALSE(run("item update 1 --cost 5"));
+    TEST_ASSERT_NOT_NULL(strstr(result, "price is below cost"));
+    TEST_ASSERT_TRUE(run("item search Bolt"));
+    TEST_ASSERT_TRUE(run("order place --customer 1 --item 1:2"));
+    TEST_ASSERT_TRUE(run("order status 1 completed"));
+    TEST_ASSERT_TRUE(run("customer delete 1"));
+
+    static const struct {
+        MetricOp op;
+        int count;
+    } expected[] = {
+        {METRIC_ADD_CUSTOMER, 1}, {METRIC_UPDATE_CUSTOMER, 1}, {METRIC_ADD_ITEM, 1},
+        {METRIC_UPDATE_ITEM, 2},  {METRIC_SEARCH_ITEMS, 1},    {METRIC_PLACE_ORDER, 1},
+        {METRIC_UPDATE_ORDER_STATUS, 1}, {METRIC_DELETE_CUSTOMER, 1},
+    };
+    for (size_t i = 0; i < sizeof(expected) / sizeof(expected[0]); i++) {
+        MetricTotals totals;
+        metricsGet(expected[i].op, &totals);
+        TEST_ASSERT_EQUAL_INT(expected[i].count, (int)totals.count);
+    }
+
+    // The refused update left the item as it was
+    TEST_ASSERT_TRUE(run("item get 1"));
+    TEST_ASSERT_NOT_NULL(strstr(result, "\"cost\":0.40,\"price\":1.00,\"quantity\":10"));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_commands_print_json_results);
+    RUN_TEST(test_failures_are_reported_not_fatal);
+    RUN_TEST(test_commands_are_timed_like_the_menus);
+    return UNITY_END();
+}
@@ -0,0 +1,100 @@
+#include "../include/compress.h"
+#include "../include/common.h"
+#include "unity.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static unsigned char input[COMPRESS_MAX_BLOCK];
+static unsigned char packed[COMPRESS_MAX_BLOCK + COMPRESS_MAX_BLOCK / 255 + 16];
+static unsigned char output[COMPRESS_MAX_BLOCK];
+
+void setUp(void) {
+    // Set up test environment
+    memset(input, 0, sizeof(input));
+    memset(output, 0xAA, sizeof(output));
+}
+
+void tearDown(void) {
+    // Clean up test environment
+}
+
+/* Compresses and expands a block, returning the compressed size */
+static size_t roundTrip(size_t length) {
+    size_t packedLength = compressBlock(input, length, packed, sizeof(packed));
+    if (packedLength > 0) {
+        TEST_ASSERT_TRUE(packedLength < length);
+        TEST_ASSERT_TRUE(decompressBlock(packed, packedLength, output, length));
+        TEST_ASSERT_TRUE(memcmp(input, output, length) == 0);
+    }
+    return packedLength;
+}
+
+void test_zeros_compress_to_almost_nothing(void) {
+    size_t packedLength = roundTrip(COMPRESS_MAX_BLOCK);
+    TEST_ASSERT_TRUE(packedLength > 0);
+    TEST_ASSERT_TRUE(packedLength < 512);
+}
+
+void test_inventory_records_round_trip_smaller(void) {
+    size_t length = COMPRESS_MAX_BLOCK / sizeof(InventoryItem) * sizeof(InventoryItem);
+    InventoryItem *items = (InventoryItem *)input;
+    for (size_t i = 0; i < length / sizeof(InventoryItem); i++) {
+        InventoryItem item = {(int)i + 1, "", "", MONEY(0.40), MONEY(1.00), (int)(i * 7 % 500)};
+        snprintf(item.name, sizeof(item.name), "Item %zu", i);
+        snprintf(item.description, sizeof(item.description), "Description of item %zu", i);
+        items[i] = item;
+    }
+
+    size_t packedLength = roundTrip(length);
+    TEST_ASSERT_TRUE(packedLength > 0);
+    TEST_ASSERT_TRUE(packedLength < length / 3);
+}
+
+void test_random_data_is_left_uncompressed(void) {
+    srand(42);
+    for (size_t i = 0; i < COMPRESS_MAX_BLOCK; i++) {
+        input[i] = (unsigned char)(rand() >> 7);
+    }
+    TEST_ASSERT_EQUAL_INT(0, roundTrip(COMPRESS_MAX_BLOCK));
+
+    // A short block with a repeat in it still round trips
+    memcpy(input + 100, input, 100);
+    TEST_ASSERT_TRUE(roundTrip(200) > 0);
+}
+
+void test_damaged_blocks_are_rejected(void) {
+    for (size_t i = 0; i < COMPRESS_MAX_BLOCK; i++) {
+        input[i] = (unsigned char)(i % 251 < 32 ? i : 0);
+    }
+    size_t packedLength = compressBlock(input, COMPRESS_MAX_BLOCK, packed, sizeof(packed));
+    TEST_ASSERT_TRUE(packedLength > 0);
+
+    // Cut short, or expanding to the wrong size
+    TEST_ASSERT_FALSE(decompressBlock(packed, packedLength - 1, output, COMPRESS_MAX_BLOCK));
+    TEST_ASSERT_FALSE(decompressBlock(packed, packedLength, output, COMPRESS_MAX_BLOCK - 1));
+
+    // A match reaching back before the start of the block
+    unsigned char bad[] = {0x10, 'a', 0x05, 0x00};
+    TEST_ASSERT_FALSE(decompressBlock(bad, sizeof(bad), output, 5));
+
+    // Garbage never writes past the output buffer
+    memset(output, 0xAA, sizeof(output));
+    srand(7);
+    for (int round = 0; round < 1000; round++) {
+        for (size_t i = 0; i < 64; i++) {
+            packed[i] = (unsigned char)(rand() >> 7);
+        }
+        decompressBlock(packed, 64, output, 100);
+    }
+    TEST_ASSERT_EQUAL_INT(0xAA, output[100]);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_zeros_compress_to_almost_nothing);
+    RUN_TEST(test_inventory_records_round_trip_smaller);
+    RUN_TEST(test_random_data_is_left_uncompressed);
+    RUN_TEST(test_damaged_blocks_are_rejected);
+    return UNITY_END();
+}
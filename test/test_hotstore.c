@@ -0,0 +1,136 @@
+#include "../include/common.h"
+#include "../include/table.h"
+#include "../include/hotstore.h"
+#include "../include/financial.h"
+#include "../include/wal.h"
+#include "../include/utils.h"
+#include "unity.h"
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+
+static const char *files[] = {
+    INVENTORY_FILE, INVENTORY_INDEX_FILE, INVENTORY_HOT_FILE, INVENTORY_SEARCH_FILE, INVENTORY_SEARCH_DELTA_FILE,
+    CUSTOMERS_FILE, CUSTOMERS_INDEX_FILE, CUSTOMERS_HOT_FILE, CUSTOMERS_SEARCH_FILE, CUSTOMERS_SEARCH_DELTA_FILE,
+};
+
+static void removeFiles(void) {
+    for (size_t i = 0; i < sizeof(files) / sizeof(files[0]); i++) {
+        remove(files[i]);
+    }
+}
+
+void setUp(void) {
+    // Set up test environment
+    initializeSystem();
+    removeFiles();
+}
+
+void tearDown(void) {
+    // Clean up test environment
+    walCheckpoint();
+    removeFiles();
+}
+
+void test_hot_records_follow_writes(void) {
+    InventoryItem bolt = {1, "Bolt", "Steel bolt", MONEY(0.50), MONEY(1.00), 100};
+    InventoryItem nut = {2, "Nut", "Steel nut", MONEY(0.25), MONEY(0.75), 40};
+    tableAppend(TABLE_INVENTORY, &bolt);
+    tableAppend(TABLE_INVENTORY, &nut);
+
+    long count;
+    const InventoryHot *hot = hotTable(TABLE_INVENTORY, &count);
+    TEST_ASSERT_EQUAL_INT(2, count);
+    TEST_ASSERT_EQUAL_INT(40, hot[1].quantity);
+
+    bolt.quantity = 60;
+    tableUpdateById(TABLE_INVENTORY, &bolt);
+    tableDeleteById(TABLE_INVENTORY, 2);
+    InventoryItem washer = {3, "Washer", "Zinc washer", MONEY(0.10), MONEY(0.20), 10};
+    tableAppend(TABLE_INVENTORY, &washer);
+
+    hot = hotTable(TABLE_INVENTORY, &count);
+    TEST_ASSERT_EQUAL_INT(3, count);
+    TEST_ASSERT_EQUAL_INT(60, hot[0].quantity);
+    TEST_ASSERT_EQUAL_INT(-2, hot[1].id);
+    TEST_ASSERT_EQUAL_STRING("Washer", hot[2].namePrefix);
+
+    InventoryValueReport report;
+    generateInventoryValue(&report);
+    TEST_ASSERT_EQUAL_INT(70, report.totalItems);
+    TEST_ASSERT_EQUAL_INT(MONEY(31.00), report.totalCost);
+    TEST_ASSERT_EQUAL_INT(MONEY(62.00), report.totalValue);
+}
+
+void test_hot_file_is_built_from_existing_data(void) {
+    Customer customer = {5, "A Customer With A Rather Long Full Name", "c@example.com", "555-0199", "9 Side St"};
+    tableAppend(TABLE_CUSTOMERS, &customer);
+
+    // Data written before the split has no hot file yet
+    walCheckpoint();
+    remove(CUSTOMERS_HOT_FILE);
+
+    CustomerHot hot;
+    TEST_ASSERT_TRUE(hotGetById(TABLE_CUSTOMERS, 5, &hot));
+    TEST_ASSERT_EQUAL_STRING("555-0199", hot.phone);
+    TEST_ASSERT_EQUAL_INT(HOT_NAME_PREFIX - 1, (int)strlen(hot.namePrefix));
+    TEST_ASSERT_FALSE(hotGetById(TABLE_CUSTOMERS, 6, &hot));
+
+    long count;
+    const CustomerHot *customers = hotTable(TABLE_CUSTOMERS, &count);
+    TEST_ASSERT_EQUAL_INT(1, count);
+    TEST_ASSERT_EQUAL_INT(5, customers[0].id);
+}
+
+static volatile int writerDone;
+
+static void *readHotRecords(void *arg) {
+    long *badRecords = arg;
+    while (!writerDone) {
+        long count;
+        const InventoryHot *hot = hotTable(TABLE_INVENTORY, &count);
+        for (long i = 0; i < count; i++) {
+            if (hot[i].id > 0 && hot[i].quantity != hot[i].id) {
+                (*badRecords)++;
+            }
+        }
+    }
+    return NULL;
+}
+
+void test_hot_records_can_be_read_from_several_threads(void) {
+    long badRecords[2] = {0, 0};
+    writerDone = 0;
+    pthread_t readers[2];
+    for (int i = 0; i < 2; i++) {
+        TEST_ASSERT_EQUAL_INT(0, pthread_create(&readers[i], NULL, readHotRecords, &badRecords[i]));
+    }
+
+    // Appends grow the hot file and removing it makes the readers rebuild it
+    for (int id = 1; id <= 300; id++) {
+        InventoryItem item = {id, "Item", "Description", MONEY(1.00), MONEY(2.00), id};
+        TEST_ASSERT_TRUE(tableAppend(TABLE_INVENTORY, &item) >= 0);
+        if (id % 50 == 0) {
+            remove(INVENTORY_HOT_FILE);
+        }
+    }
+
+    writerDone = 1;
+    for (int i = 0; i < 2; i++) {
+        pthread_join(readers[i], NULL);
+        TEST_ASSERT_EQUAL_INT(0, badRecords[i]);
+    }
+
+    long count;
+    const InventoryHot *hot = hotTable(TABLE_INVENTORY, &count);
+    TEST_ASSERT_EQUAL_INT(300, count);
+    TEST_ASSERT_EQUAL_INT(300, hot[299].quantity);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_hot_records_follow_writes);
+    RUN_TEST(test_hot_file_is_built_from_existing_data);
+    RUN_TEST(test_hot_records_can_be_read_from_several_threads);
+    return UNITY_END();
+}
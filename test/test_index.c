@@ -0,0 +1,161 @@
+#include "../include/common.h"
+#include "../include/table.h"
+#include "../include/index.h"
+#include "../include/wal.h"
+#include "../include/utils.h"
+#include "unity.h"
+#include <stdio.h>
+#include <string.h>
+
+void setUp(void) {
+    // Set up test environment
+    initializeSystem();
+    remove(INVENTORY_FILE);
+    remove(INVENTORY_INDEX_FILE);
+    remove(INVENTORY_META_FILE);
+}
+
+void tearDown(void) {
+    // Clean up test environment
+    walCheckpoint();
+    remove(INVENTORY_FILE);
+    remove(INVENTORY_INDEX_FILE);
+    remove(INVENTORY_META_FILE);
+}
+
+static void appendItems(int count) {
+    for (int i = 1; i <= count; i++) {
+        InventoryItem item = {i, "Item", "Description", MONEY(1.0), MONEY(2.0), i};
+        tableAppend(TABLE_INVENTORY, &item);
+    }
+}
+
+void test_lookup_returns_slot(void) {
+    appendItems(100);
+
+    TEST_ASSERT_EQUAL_INT(0, indexLookup(TABLE_INVENTORY, 1));
+    TEST_ASSERT_EQUAL_INT(41, indexLookup(TABLE_INVENTORY, 42));
+    TEST_ASSERT_EQUAL_INT(-1, indexLookup(TABLE_INVENTORY, 101));
+
+    InventoryItem item;
+    TEST_ASSERT_TRUE(tableGetById(TABLE_INVENTORY, 77, &item, NULL));
+    TEST_ASSERT_EQUAL_INT(77, item.quantity);
+}
+
+void test_missing_index_is_rebuilt(void) {
+    appendItems(10);
+    remove(INVENTORY_INDEX_FILE);
+
+    InventoryItem item;
+    TEST_ASSERT_TRUE(tableGetById(TABLE_INVENTORY, 7, &item, NULL));
+    TEST_ASSERT_EQUAL_INT(7, item.id);
+}
+
+void test_stale_index_is_rebuilt(void) {
+    appendItems(10);
+
+    // Replace the data file behind the index's back
+    remove(INVENTORY_FILE);
+    FILE *file = fopen(INVENTORY_FILE, "wb");
+    InventoryItem item = {50, "Other", "Description", MONEY(1.0), MONEY(2.0), 5};
+    fwrite(&item, sizeof(item), 1, file);
+    fclose(file);
+
+    TEST_ASSERT_FALSE(tableGetById(TABLE_INVENTORY, 7, &item, NULL));
+    TEST_ASSERT_TRUE(tableGetById(TABLE_INVENTORY, 50, &item, NULL));
+}
+
+void test_delete_updates_index(void) {
+    appendItems(5);
+
+    TEST_ASSERT_TRUE(tableDeleteById(TABLE_INVENTORY, 2));
+
+    InventoryItem item;
+    TEST_ASSERT_FALSE(tableGetById(TABLE_INVENTORY, 2, &item, NULL));
+    TEST_ASSERT_TRUE(tableGetById(TABLE_INVENTORY, 5, &item, NULL));
+    TEST_ASSERT_EQUAL_INT(5, item.quantity);
+
+    // The record stays in place as a tombstone until compaction
+    TEST_ASSERT_EQUAL_INT(5, tableRecordCount(TABLE_INVENTORY));
+}
+
+void test_compaction_reclaims_tombstones(void) {
+    appendItems(8);
+    tableDeleteById(TABLE_INVENTORY, 1);
+    tableDeleteById(TABLE_INVENTORY, 4);
+    tableDeleteById(TABLE_INVENTORY, 6);
+
+    TableStats stats;
+    tableGetStats(TABLE_INVENTORY, &stats);
+    TEST_ASSERT_EQUAL_INT(3, stats.deadRecords);
+    TEST_ASSERT_TRUE(tableNeedsCompaction(TABLE_INVENTORY));
+
+    // Checkpointing compacts tables over the threshold
+    walCheckpoint();
+
+    tableGetStats(TABLE_INVENTORY, &stats);
+    TEST_ASSERT_EQUAL_INT(5, stats.totalRecords);
+    TEST_ASSERT_EQUAL_INT(0, stats.deadRecords);
+
+    InventoryItem item;
+    TEST_ASSERT_FALSE(tableGetById(TABLE_INVENTORY, 4, &item, NULL));
+    TEST_ASSERT_TRUE(tableGetById(TABLE_INVENTORY, 8, &item, NULL));
+    TEST_ASSERT_EQUAL_INT(8, item.quantity);
+}
+
+void test_compact_waits_for_the_threshold(void) {
+    appendItems(10);
+    tableDeleteById(TABLE_INVENTORY, 2);
+
+    // One tombstone in ten is below the threshold and stays
+    TableStats stats;
+    TEST_ASSERT_TRUE(walCompact());
+    tableGetStats(TABLE_INVENTORY, &stats);
+    TEST_ASSERT_EQUAL_INT(10, stats.totalRecords);
+    TEST_ASSERT_EQUAL_INT(1, stats.deadRecords);
+
+    tableDeleteById(TABLE_INVENTORY, 4);
+    tableDeleteById(TABLE_INVENTORY, 6);
+    TEST_ASSERT_TRUE(walCompact());
+    tableGetStats(TABLE_INVENTORY, &stats);
+    TEST_ASSERT_EQUAL_INT(7, stats.totalRecords);
+    TEST_ASSERT_EQUAL_INT(0, stats.deadRecords);
+}
+
+void test_rebuild_leaves_other_temp_files_alone(void) {
+    appendItems(10);
+
+    // Another process rebuilding the same index writes its own temporary file
+    const char *otherTemp = INVENTORY_INDEX_FILE ".1.tmp";
+    FILE *file = fopen(otherTemp, "wb");
+    TEST_ASSERT_NOT_NULL(file);
+    fputs("partial", file);
+    fclose(file);
+
+    TEST_ASSERT_TRUE(indexRebuild(TABLE_INVENTORY));
+    TEST_ASSERT_EQUAL_INT(6, indexLookup(TABLE_INVENTORY, 7));
+
+    char ownTemp[256];
+    tempFileName(ownTemp, sizeof(ownTemp), INVENTORY_INDEX_FILE);
+    TEST_ASSERT_NULL(fopen(ownTemp, "rb"));
+
+    char contents[16] = {0};
+    file = fopen(otherTemp, "rb");
+    TEST_ASSERT_NOT_NULL(file);
+    TEST_ASSERT_TRUE(fgets(contents, sizeof(contents), file) != NULL);
+    fclose(file);
+    remove(otherTemp);
+    TEST_ASSERT_EQUAL_STRING("partial", contents);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_lookup_returns_slot);
+    RUN_TEST(test_missing_index_is_rebuilt);
+    RUN_TEST(test_stale_index_is_rebuilt);
+    RUN_TEST(test_delete_updates_index);
+    RUN_TEST(test_compaction_reclaims_tombstones);
+    RUN_TEST(test_compact_waits_for_the_threshold);
+    RUN_TEST(test_rebuild_leaves_other_temp_files_alone);
+    return UNITY_END();
+}
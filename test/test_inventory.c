@@ -15,7 +15,7 @@ void tearDown(void) {
 }
 
 void test_add_inventory_item(void) {
-    InventoryItem item = {0, "Test Item", "Test Description", 10.99, 19.99, 100};
+    InventoryItem item = {0, "Test Item", "Test Description", MONEY(10.99), MONEY(19.99), 100};
     addInventoryItem(&item);
 
     InventoryItem retrieved_item;
@@ -24,16 +24,16 @@ void test_add_inventory_item(void) {
     TEST_ASSERT_TRUE(found);
     TEST_ASSERT_EQUAL_STRING(item.name, retrieved_item.name);
     TEST_ASSERT_EQUAL_STRING(item.description, retrieved_item.description);
-    TEST_ASSERT_EQUAL_FLOAT(item.cost, retrieved_item.cost);
-    TEST_ASSERT_EQUAL_FLOAT(item.price, retrieved_item.price);
+    TEST_ASSERT_EQUAL_INT(item.cost, retrieved_item.cost);
+    TEST_ASSERT_EQUAL_INT(item.price, retrieved_item.price);
     TEST_ASSERT_EQUAL_INT(item.quantity, retrieved_item.quantity);
 }
 
 void test_update_inventory_item(void) {
-    InventoryItem item = {0, "Test Item", "Test Description", 10.99, 19.99, 100};
+    InventoryItem item = {0, "Test Item", "Test Description", MONEY(10.99), MONEY(19.99), 100};
     addInventoryItem(&item);
 
-    item.price = 24.99;
+    item.price = MONEY(24.99);
     item.quantity = 150;
     updateInventoryItemById(&item);
 
@@ -41,12 +41,12 @@ void test_update_inventory_item(void) {
     int found = getInventoryItemById(item.id, &retrieved_item);
 
     TEST_ASSERT_TRUE(found);
-    TEST_ASSERT_EQUAL_FLOAT(24.99, retrieved_item.price);
+    TEST_ASSERT_EQUAL_INT(MONEY(24.99), retrieved_item.price);
     TEST_ASSERT_EQUAL_INT(150, retrieved_item.quantity);
 }
 
 void test_delete_inventory_item(void) {
-    InventoryItem item = {0, "Test Item", "Test Description", 10.99, 19.99, 100};
+    InventoryItem item = {0, "Test Item", "Test Description", MONEY(10.99), MONEY(19.99), 100};
     addInventoryItem(&item);
 
     deleteInventoryItem(item.id);
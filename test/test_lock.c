@@ -0,0 +1,136 @@
+#define _DEFAULT_SOURCE
+#include "../include/common.h"
+#include "../include/table.h"
+#include "../include/lock.h"
+#include "../include/orders.h"
+#include "../include/inventory.h"
+#include "../include/wal.h"
+#include "../include/utils.h"
+#include "unity.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#define SELLERS 8
+#define SALES_PER_SELLER 25
+#define STOCK 120
+
+static const char *files[] = {
+    ORDERS_FILE, ORDERS_INDEX_FILE, INVENTORY_FILE, INVENTORY_INDEX_FILE, INVENTORY_HOT_FILE,
+    CUSTOMERS_FILE, CUSTOMERS_INDEX_FILE, CUSTOMERS_HOT_FILE,
+    ORDER_LINES_FILE, ORDER_LINES_INDEX_FILE, ORDER_LINES_LINKS_FILE,
+    ORDER_LINES_BY_ORDER_FILE, ORDER_LINES_BY_ITEM_FILE,
+};
+
+static void removeFiles(void) {
+    for (size_t i = 0; i < sizeof(files) / sizeof(files[0]); i++) {
+        remove(files[i]);
+    }
+}
+
+static int stockOf(int itemId) {
+    InventoryItem item;
+    TEST_ASSERT_TRUE(tableGetById(TABLE_INVENTORY, itemId, &item, NULL));
+    return item.quantity;
+}
+
+/* Waits for a child and returns its exit status, -1 if it was killed */
+static int waitChild(pid_t pid) {
+    int status;
+    waitpid(pid, &status, 0);
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+void setUp(void) {
+    // Set up test environment
+    initializeSystem();
+    removeFiles();
+
+    Customer customer = {1, "John Doe", "john@example.com", "1234567890", "123 Main St"};
+    InventoryItem bolt = {1, "Bolt", "Steel bolt", MONEY(0.40), MONEY(1.00), STOCK};
+    InventoryItem nut = {2, "Nut", "Steel nut", MONEY(0.10), MONEY(0.25), 50};
+    tableAppend(TABLE_CUSTOMERS, &customer);
+    tableAppend(TABLE_INVENTORY, &bolt);
+    tableAppend(TABLE_INVENTORY, &nut);
+}
+
+void tearDown(void) {
+    // Clean up test environment
+    walCheckpoint();
+    removeFiles();
+}
+
+void test_sellers_in_many_processes_never_oversell(void) {
+    pid_t sellers[SELLERS];
+    fflush(stdout);
+    for (int i = 0; i < SELLERS; i++) {
+        sellers[i] = fork();
+        TEST_ASSERT_TRUE(sellers[i] >= 0);
+        if (sellers[i] == 0) {
+            OrderItemRequest item = {1, 1};
+            int placed = 0;
+            for (int sale = 0; sale < SALES_PER_SELLER; sale++) {
+                Order order = {0};
+                order.customerId = 1;
+                placed += placeOrderBatch(&order, &item, 1, NULL) == ORDER_PLACED;
+            }
+            _exit(placed);
+        }
+    }
+
+    int placed = 0;
+    for (int i = 0; i < SELLERS; i++) {
+        int sold = waitChild(sellers[i]);
+        TEST_ASSERT_TRUE(sold >= 0);
+        placed += sold;
+    }
+
+    TEST_ASSERT_EQUAL_INT(STOCK, placed);
+    TEST_ASSERT_EQUAL_INT(0, stockOf(1));
+    TEST_ASSERT_EQUAL_INT(STOCK, tableRecordCount(TABLE_ORDERS));
+}
+
+void test_locks_are_per_record(void) {
+    TEST_ASSERT_TRUE(recordLock(TABLE_INVENTORY, 1));
+    fflush(stdout);
+
+    // Another record can be updated while item 1 is held
+    pid_t other = fork();
+    TEST_ASSERT_TRUE(other >= 0);
+    if (other == 0) {
+        alarm(5);
+        InventoryItem nut = {2, "Nut", "Steel nut", MONEY(0.10), MONEY(0.25), 40};
+        updateInventoryItemById(&nut);
+        _exit(0);
+    }
+    TEST_ASSERT_EQUAL_INT(0, waitChild(other));
+    TEST_ASSERT_EQUAL_INT(40, stockOf(2));
+
+    // The held record itself blocks other processes until it is released
+    pid_t same = fork();
+    TEST_ASSERT_TRUE(same >= 0);
+    if (same == 0) {
+        alarm(1);
+        recordLock(TABLE_INVENTORY, 1);
+        _exit(0);
+    }
+    TEST_ASSERT_EQUAL_INT(-1, waitChild(same));
+
+    recordUnlock(TABLE_INVENTORY, 1);
+    same = fork();
+    TEST_ASSERT_TRUE(same >= 0);
+    if (same == 0) {
+        alarm(5);
+        _exit(recordLock(TABLE_INVENTORY, 1) ? 0 : 1);
+    }
+    TEST_ASSERT_EQUAL_INT(0, waitChild(same));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_sellers_in_many_processes_never_oversell);
+    RUN_TEST(test_locks_are_per_record);
+    return UNITY_END();
+}
@@ -0,0 +1,78 @@
+#include "../include/common.h"
+#include "../include/match.h"
+#include "unity.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+
+static const char *kernelNames[] = {"avx2", "sse2", "scalar"};
+
+/* Fills a field with text from a small alphabet so terms match often */
+static void randomField(char *field, size_t width) {
+    memset(field, 'z', width); // Bytes after the NUL must not match
+    size_t length = (size_t)rand() % width;
+    for (size_t i = 0; i < length; i++) {
+        field[i] = "abc"[rand() % 3];
+    }
+    field[length] = '\0';
+}
+
+void setUp(void) {
+    srand(42);
+}
+
+void tearDown(void) {
+    matchSetKernel(NULL);
+}
+
+void test_kernels_agree_with_strstr(void) {
+    char field[MAX_DESCRIPTION_LENGTH];
+    char needle[MAX_NAME_LENGTH];
+
+    for (size_t k = 0; k < sizeof(kernelNames) / sizeof(kernelNames[0]); k++) {
+        if (!matchSetKernel(kernelNames[k])) {
+            continue; // Not available on this CPU
+        }
+        for (int round = 0; round < 20000; round++) {
+            randomField(field, sizeof(field));
+            size_t needleLength = 1 + (size_t)rand() % 6;
+            for (size_t i = 0; i < needleLength; i++) {
+                needle[i] = "abcz"[rand() % 4];
+            }
+            needle[needleLength] = '\0';
+
+            int expected = strstr(field, needle) != NULL;
+            TEST_ASSERT_EQUAL_INT(expected, fieldContains(field, sizeof(field), needle, needleLength));
+        }
+    }
+}
+
+void test_match_records_checks_every_field_of_a_block(void) {
+    InventoryItem items[3];
+    memset(items, 0, sizeof(items));
+    strcpy(items[0].name, "Blue Widget");
+    strcpy(items[0].description, "steel");
+    strcpy(items[1].name, "Red Gadget");
+    strcpy(items[1].description, "A widget in all but name");
+    strcpy(items[2].name, "Green Gadget");
+    strcpy(items[2].description, "plastic");
+
+    MatchField fields[] = {
+        {offsetof(InventoryItem, name), MAX_NAME_LENGTH},
+        {offsetof(InventoryItem, description), MAX_DESCRIPTION_LENGTH},
+    };
+    unsigned char hits[3];
+    TEST_ASSERT_EQUAL_INT(1, matchRecords(items, 3, sizeof(InventoryItem), fields, 1, "idget", hits));
+    TEST_ASSERT_EQUAL_INT(2, matchRecords(items, 3, sizeof(InventoryItem), fields, 2, "idget", hits));
+    TEST_ASSERT_EQUAL_INT(1, hits[0]);
+    TEST_ASSERT_EQUAL_INT(1, hits[1]);
+    TEST_ASSERT_EQUAL_INT(0, hits[2]);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_kernels_agree_with_strstr);
+    RUN_TEST(test_match_records_checks_every_field_of_a_block);
+    return UNITY_END();
+}
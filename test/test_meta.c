@@ -0,0 +1,101 @@
+#define _DEFAULT_SOURCE
+#include "../include/common.h"
+#include "../include/table.h"
+#include "../include/meta.h"
+#include "../include/wal.h"
+#include "../include/utils.h"
+#include "unity.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#define PROCESSES 4
+#define IDS_PER_PROCESS 200
+#define ID_LOG_FILE "data/test_meta_ids.txt"
+
+void setUp(void) {
+    // Set up test environment
+    initializeSystem();
+    remove(INVENTORY_FILE);
+    remove(INVENTORY_INDEX_FILE);
+    remove(INVENTORY_META_FILE);
+}
+
+void tearDown(void) {
+    // Clean up test environment
+    walCheckpoint();
+    remove(INVENTORY_FILE);
+    remove(INVENTORY_INDEX_FILE);
+    remove(INVENTORY_META_FILE);
+    remove(ID_LOG_FILE);
+}
+
+void test_allocate_seeds_from_table_and_skips_deleted_ids(void) {
+    InventoryItem item = {5, "Item", "Description", MONEY(1.0), MONEY(2.0), 10};
+    tableAppend(TABLE_INVENTORY, &item);
+    tableDeleteById(TABLE_INVENTORY, 5);
+    remove(INVENTORY_META_FILE);
+
+    TEST_ASSERT_EQUAL_INT(6, metaAllocateId(TABLE_INVENTORY));
+    TEST_ASSERT_EQUAL_INT(7, metaAllocateId(TABLE_INVENTORY));
+}
+
+void test_reset_rescans_after_data_file_replaced(void) {
+    TEST_ASSERT_EQUAL_INT(1, metaAllocateId(TABLE_INVENTORY));
+    TEST_ASSERT_EQUAL_INT(2, metaAllocateId(TABLE_INVENTORY));
+
+    InventoryItem item = {40, "Item", "Description", MONEY(1.0), MONEY(2.0), 10};
+    tableAppend(TABLE_INVENTORY, &item);
+    metaReset(TABLE_INVENTORY);
+
+    TEST_ASSERT_EQUAL_INT(41, metaAllocateId(TABLE_INVENTORY));
+}
+
+void test_concurrent_processes_never_share_an_id(void) {
+    FILE *log = fopen(ID_LOG_FILE, "w");
+    TEST_ASSERT_NOT_NULL(log);
+    fclose(log);
+
+    for (int p = 0; p < PROCESSES; p++) {
+        pid_t pid = fork();
+        TEST_ASSERT_TRUE(pid >= 0);
+        if (pid == 0) {
+            char line[IDS_PER_PROCESS * 12];
+            size_t length = 0;
+            for (int i = 0; i < IDS_PER_PROCESS; i++) {
+                length += snprintf(line + length, sizeof(line) - length, "%d\n", metaAllocateId(TABLE_INVENTORY));
+            }
+            log = fopen(ID_LOG_FILE, "a");
+            fwrite(line, 1, length, log);
+            fclose(log);
+            _exit(0);
+        }
+    }
+    for (int p = 0; p < PROCESSES; p++) {
+        wait(NULL);
+    }
+
+    static char seen[PROCESSES * IDS_PER_PROCESS + 1];
+    memset(seen, 0, sizeof(seen));
+    log = fopen(ID_LOG_FILE, "r");
+    TEST_ASSERT_NOT_NULL(log);
+    int id, total = 0;
+    while (fscanf(log, "%d", &id) == 1) {
+        TEST_ASSERT_TRUE(id >= 1 && id <= PROCESSES * IDS_PER_PROCESS);
+        TEST_ASSERT_FALSE(seen[id]);
+        seen[id] = 1;
+        total++;
+    }
+    fclose(log);
+    TEST_ASSERT_EQUAL_INT(PROCESSES * IDS_PER_PROCESS, total);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_allocate_seeds_from_table_and_skips_deleted_ids);
+    RUN_TEST(test_reset_rescans_after_data_file_replaced);
+    RUN_TEST(test_concurrent_processes_never_share_an_id);
+    return UNITY_END();
+}
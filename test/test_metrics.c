@@ -0,0 +1,149 @@
+#define _DEFAULT_SOURCE
+#include "../include/common.h"
+#include "../include/table.h"
+#include "../include/inventory.h"
+#include "../include/financial.h"
+#include "../include/metrics.h"
+#include "../include/wal.h"
+#include "../include/utils.h"
+#include "unity.h"
+#include <stdio.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+
+static const char *files[] = {
+    INVENTORY_FILE, INVENTORY_INDEX_FILE, INVENTORY_HOT_FILE, INVENTORY_SEARCH_FILE, INVENTORY_SEARCH_DELTA_FILE,
+    METRICS_FILE,
+};
+
+static void removeFiles(void) {
+    for (size_t i = 0; i < sizeof(files) / sizeof(files[0]); i++) {
+        remove(files[i]);
+    }
+}
+
+void setUp(void) {
+    // Set up test environment
+    initializeSystem();
+    removeFiles();
+
+    InventoryItem bolt = {1, "Bolt", "Steel bolt", MONEY(0.50), MONEY(1.00), 100};
+    InventoryItem nut = {2, "Nut", "Steel nut", MONEY(0.25), MONEY(0.75), 40};
+    tableAppend(TABLE_INVENTORY, &bolt);
+    tableAppend(TABLE_INVENTORY, &nut);
+    walCheckpoint();
+    metricsReset();
+}
+
+void tearDown(void) {
+    // Clean up test environment
+    walCheckpoint();
+    removeFiles();
+}
+
+void test_quantiles_come_from_the_histogram(void) {
+    // 1 to 1000 microseconds, one call each
+    IoCounters io = {0, 0, 0, 0};
+    for (int i = 1; i <= 1000; i++) {
+        metricsRecord(METRIC_GET_ITEM, (uint64_t)i * 1000, &io);
+    }
+
+    MetricTotals totals;
+    metricsGet(METRIC_GET_ITEM, &totals);
+    TEST_ASSERT_EQUAL_INT(1000, (int)totals.count);
+    TEST_ASSERT_EQUAL_INT(1000000, (int)totals.maxNs);
+
+    // Within one sub-bucket (1/16) above the exact value
+    uint64_t p50 = metricsQuantile(METRIC_GET_ITEM, 0.5);
+    uint64_t p99 = metricsQuantile(METRIC_GET_ITEM, 0.99);
+    TEST_ASSERT_TRUE(p50 >= 500000 && p50 <= 500000 + 500000 / 16);
+    TEST_ASSERT_TRUE(p99 >= 990000 && p99 <= 990000 + 990000 / 16);
+    TEST_ASSERT_EQUAL_INT(1000000, (int)metricsQuantile(METRIC_GET_ITEM, 1.0));
+    TEST_ASSERT_EQUAL_INT(0, (int)metricsQuantile(METRIC_GET_ORDER, 0.5));
+}
+
+void test_operations_count_their_io(void) {
+    InventoryItem item;
+    TEST_ASSERT_TRUE(getInventoryItemById(1, &item));
+
+    MetricTotals totals;
+    metricsGet(METRIC_GET_ITEM, &totals);
+    TEST_ASSERT_EQUAL_INT(1, (int)totals.count);
+    TEST_ASSERT_TRUE(totals.totalNs > 0);
+    TEST_ASSERT_EQUAL_INT(1, (int)totals.io.recordsScanned);
+
+    // The update goes to the log and nested calls are charged to it as well
+    item.quantity = 90;
+    updateInventoryItemById(&item);
+    metricsGet(METRIC_UPDATE_ITEM_BY_ID, &totals);
+    TEST_ASSERT_EQUAL_INT(1, (int)totals.count);
+    TEST_ASSERT_TRUE(totals.io.bytesWritten >= sizeof(InventoryItem));
+
+    InventoryValueReport report;
+    generateInventoryValue(&report);
+    metricsGet(METRIC_INVENTORY_VALUE, &totals);
+    TEST_ASSERT_EQUAL_INT(1, (int)totals.count);
+    TEST_ASSERT_EQUAL_INT(2, (int)totals.io.recordsScanned);
+    TEST_ASSERT_TRUE(totals.io.fileOpens >= 1);
+    TEST_ASSERT_TRUE(totals.io.bytesRead > 0);
+    TEST_ASSERT_EQUAL_INT(130, report.totalItems);
+}
+
+void test_metrics_are_written_in_prometheus_format(void) {
+    InventoryItem item;
+    getInventoryItemById(1, &item);
+    getInventoryItemById(2, &item);
+
+    char text[8192];
+    FILE *out = tmpfile();
+    TEST_ASSERT_NOT_NULL(out);
+    TEST_ASSERT_TRUE(metricsWrite(out));
+    rewind(out);
+    size_t length = fread(text, 1, sizeof(text) - 1, out);
+    text[length] = '\0';
+    fclose(out);
+
+    TEST_ASSERT_NOT_NULL(strstr(text, "# TYPE sbms_operation_duration_seconds summary\n"));
+    TEST_ASSERT_NOT_NULL(strstr(text, "sbms_operation_duration_seconds{op=\"get_item\",quantile=\"0.99\"} "));
+    TEST_ASSERT_NOT_NULL(strstr(text, "sbms_operation_duration_seconds_count{op=\"get_item\"} 2\n"));
+    TEST_ASSERT_NOT_NULL(strstr(text, "sbms_operation_records_scanned_total{op=\"get_item\"} 2\n"));
+    TEST_ASSERT_NOT_NULL(strstr(text, "# TYPE sbms_operation_file_opens_total counter\n"));
+
+    // Operations never called are left out
+    TEST_ASSERT_NULL(strstr(text, "op=\"get_order\""));
+}
+
+void test_sigusr1_writes_the_metrics_file(void) {
+    InventoryItem item;
+    getInventoryItemById(1, &item);
+
+    TEST_ASSERT_EQUAL_INT(0, kill(getpid(), SIGUSR1));
+    for (int i = 0; i < 200 && access(METRICS_FILE, F_OK) != 0; i++) {
+        usleep(10000);
+    }
+
+    char line[256];
+    int found = 0;
+    FILE *file = fopen(METRICS_FILE, "r");
+    TEST_ASSERT_NOT_NULL(file);
+    while (fgets(line, sizeof(line), file) != NULL) {
+        found |= strcmp(line, "sbms_operation_duration_seconds_count{op=\"get_item\"} 1\n") == 0;
+    }
+    fclose(file);
+    TEST_ASSERT_TRUE(found);
+}
+
+int main(void) {
+    // As in sbms and sbmsd, before the log starts its thread
+    if (!metricsStartSignalDump()) {
+        return 1;
+    }
+
+    UNITY_BEGIN();
+    RUN_TEST(test_quantiles_come_from_the_histogram);
+    RUN_TEST(test_operations_count_their_io);
+    RUN_TEST(test_metrics_are_written_in_prometheus_format);
+    RUN_TEST(test_sigusr1_writes_the_metrics_file);
+    return UNITY_END();
+}
@@ -0,0 +1,98 @@
+#include "../include/common.h"
+#include "../include/money.h"
+#include "../include/table.h"
+#include "../include/wal.h"
+#include "../include/utils.h"
+#include "unity.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* An inventory record as the data file held it before amounts were cents */
+typedef struct {
+    int id;
+    char name[MAX_NAME_LENGTH];
+    char description[MAX_DESCRIPTION_LENGTH];
+    double cost;
+    double price;
+    int quantity;
+} OldInventoryItem;
+
+void setUp(void) {
+    // Set up test environment
+    initializeSystem();
+    remove(INVENTORY_FILE);
+    remove(INVENTORY_INDEX_FILE);
+    srand(7);
+}
+
+void tearDown(void) {
+    // Clean up test environment
+    walCheckpoint();
+    remove(INVENTORY_FILE);
+    remove(INVENTORY_INDEX_FILE);
+}
+
+void test_conversion_rounds_to_the_cent(void) {
+    TEST_ASSERT_EQUAL_INT(1099, moneyFromDouble(10.99));
+    TEST_ASSERT_EQUAL_INT(-250, moneyFromDouble(-2.5));
+    TEST_ASSERT_EQUAL_INT(30, moneyFromDouble(0.1 + 0.2));
+    TEST_ASSERT_EQUAL_FLOAT(19.99, moneyToDouble(MONEY(19.99)));
+
+    // Ten cents added a thousand times is exactly a hundred dollars
+    Money total = 0;
+    for (int i = 0; i < 1000; i++) {
+        total += MONEY(0.10);
+    }
+    TEST_ASSERT_EQUAL_INT(MONEY(100.00), total);
+}
+
+void test_sums_match_a_plain_loop(void) {
+    // Odd lengths exercise the tails left over after the vector loop
+    for (long count = 0; count < 70; count++) {
+        Money values[70];
+        uint8_t selected[70];
+        Money expected = 0, expectedSelected = 0;
+        for (long i = 0; i < count; i++) {
+            values[i] = (Money)(rand() % 2000000) - 1000000;
+            selected[i] = (uint8_t)(rand() % 3 == 0 ? 0 : rand() % 255 + 1);
+            expected += values[i];
+            expectedSelected += selected[i] ? values[i] : 0;
+        }
+        TEST_ASSERT_EQUAL_INT(expected, moneySum(values, count));
+        TEST_ASSERT_EQUAL_INT(expectedSelected, moneySumSelected(values, selected, count));
+    }
+}
+
+void test_migration_converts_old_records_once(void) {
+    OldInventoryItem old[2];
+    memset(old, 0, sizeof(old));
+    old[0] = (OldInventoryItem){1, "Bolt", "Steel bolt", 0.35, 1.10, 10};
+    old[1] = (OldInventoryItem){2, "Nut", "Steel nut", 0.0, 19.99, 5};
+    TEST_ASSERT_EQUAL_INT(sizeof(InventoryItem), sizeof(OldInventoryItem));
+
+    FILE *file = fopen(INVENTORY_FILE, "wb");
+    TEST_ASSERT_NOT_NULL(file);
+    fwrite(old, sizeof(old), 1, file);
+    fclose(file);
+
+    TEST_ASSERT_TRUE(moneyMigrateTables());
+    TEST_ASSERT_TRUE(moneyMigrateTables()); // Already converted: nothing changes
+
+    InventoryItem item;
+    TEST_ASSERT_TRUE(tableGetById(TABLE_INVENTORY, 1, &item, NULL));
+    TEST_ASSERT_EQUAL_INT(MONEY(0.35), item.cost);
+    TEST_ASSERT_EQUAL_INT(MONEY(1.10), item.price);
+    TEST_ASSERT_TRUE(tableGetById(TABLE_INVENTORY, 2, &item, NULL));
+    TEST_ASSERT_EQUAL_INT(0, item.cost);
+    TEST_ASSERT_EQUAL_INT(MONEY(19.99), item.price);
+    TEST_ASSERT_EQUAL_INT(5, item.quantity);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_conversion_rounds_to_the_cent);
+    RUN_TEST(test_sums_match_a_plain_loop);
+    RUN_TEST(test_migration_converts_old_records_once);
+    return UNITY_END();
+}
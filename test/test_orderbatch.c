@@ -0,0 +1,99 @@
+#include "../include/common.h"
+#include "../include/table.h"
+#include "../include/orders.h"
+#include "../include/orderlines.h"
+#include "../include/wal.h"
+#include "../include/utils.h"
+#include "unity.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+static const char *files[] = {
+    ORDERS_FILE, ORDERS_INDEX_FILE, INVENTORY_FILE, INVENTORY_INDEX_FILE, INVENTORY_HOT_FILE,
+    CUSTOMERS_FILE, CUSTOMERS_INDEX_FILE, CUSTOMERS_HOT_FILE,
+    ORDER_LINES_FILE, ORDER_LINES_INDEX_FILE, ORDER_LINES_LINKS_FILE,
+    ORDER_LINES_BY_ORDER_FILE, ORDER_LINES_BY_ITEM_FILE,
+};
+
+static void removeFiles(void) {
+    for (size_t i = 0; i < sizeof(files) / sizeof(files[0]); i++) {
+        remove(files[i]);
+    }
+}
+
+static int stockOf(int itemId) {
+    InventoryItem item;
+    TEST_ASSERT_TRUE(tableGetById(TABLE_INVENTORY, itemId, &item, NULL));
+    return item.quantity;
+}
+
+void setUp(void) {
+    // Set up test environment
+    initializeSystem();
+    removeFiles();
+
+    Customer customer = {1, "John Doe", "john@example.com", "1234567890", "123 Main St"};
+    InventoryItem bolt = {1, "Bolt", "Steel bolt", MONEY(0.40), MONEY(1.00), 10};
+    InventoryItem nut = {2, "Nut", "Steel nut", MONEY(0.10), MONEY(0.25), 3};
+    tableAppend(TABLE_CUSTOMERS, &customer);
+    tableAppend(TABLE_INVENTORY, &bolt);
+    tableAppend(TABLE_INVENTORY, &nut);
+}
+
+void tearDown(void) {
+    // Clean up test environment
+    walCheckpoint();
+    removeFiles();
+}
+
+void test_batch_places_order_and_takes_stock(void) {
+    OrderItemRequest items[] = {{1, 4}, {2, 3}, {1, 2}};
+    Order order = {0};
+    order.customerId = 1;
+
+    TEST_ASSERT_EQUAL_INT(ORDER_PLACED, placeOrderBatch(&order, items, 3, NULL));
+    TEST_ASSERT_EQUAL_INT(MONEY(6.75), order.totalAmount);
+    TEST_ASSERT_EQUAL_INT(MONEY(6.75) - MONEY(2.70), order.profit);
+    TEST_ASSERT_EQUAL_INT(4, stockOf(1));
+    TEST_ASSERT_EQUAL_INT(0, stockOf(2));
+
+    Order stored;
+    TEST_ASSERT_TRUE(getOrderById(order.id, &stored));
+    TEST_ASSERT_EQUAL_INT(order.totalAmount, stored.totalAmount);
+
+    OrderLine *lines;
+    long count;
+    TEST_ASSERT_TRUE(orderLinesForOrder(order.id, &lines, &count));
+    TEST_ASSERT_EQUAL_INT(3, count);
+    free(lines);
+}
+
+void test_rejected_batch_writes_nothing(void) {
+    // The bolts are in stock, but the two nut lines together want four of three
+    OrderItemRequest items[] = {{1, 6}, {2, 2}, {2, 2}};
+    Order order = {0};
+    order.customerId = 1;
+    int failedItem;
+
+    TEST_ASSERT_EQUAL_INT(ORDER_OUT_OF_STOCK, placeOrderBatch(&order, items, 3, &failedItem));
+    TEST_ASSERT_EQUAL_INT(2, failedItem);
+    TEST_ASSERT_EQUAL_INT(10, stockOf(1));
+    TEST_ASSERT_EQUAL_INT(3, stockOf(2));
+    TEST_ASSERT_EQUAL_INT(0, tableRecordCount(TABLE_ORDERS));
+
+    OrderItemRequest unknown[] = {{1, 1}, {9, 1}};
+    TEST_ASSERT_EQUAL_INT(ORDER_UNKNOWN_ITEM, placeOrderBatch(&order, unknown, 2, &failedItem));
+    TEST_ASSERT_EQUAL_INT(1, failedItem);
+
+    order.customerId = 5;
+    TEST_ASSERT_EQUAL_INT(ORDER_UNKNOWN_CUSTOMER, placeOrderBatch(&order, items, 1, &failedItem));
+    TEST_ASSERT_EQUAL_INT(0, tableRecordCount(TABLE_ORDERS));
+    TEST_ASSERT_EQUAL_INT(10, stockOf(1));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_batch_places_order_and_takes_stock);
+    RUN_TEST(test_rejected_batch_writes_nothing);
+    return UNITY_END();
+}
@@ -0,0 +1,113 @@
+#include "../include/common.h"
+#include "../include/table.h"
+#include "../include/orders.h"
+#include "../include/orderlines.h"
+#include "../include/financial.h"
+#include "../include/wal.h"
+#include "../include/utils.h"
+#include "unity.h"
+#include <stdio.h>
+#include <string.h>
+
+static const char *files[] = {
+    ORDERS_FILE, ORDERS_INDEX_FILE, INVENTORY_FILE, INVENTORY_INDEX_FILE,
+    ORDER_LINES_FILE, ORDER_LINES_INDEX_FILE, ORDER_LINES_LINKS_FILE,
+    ORDER_LINES_BY_ORDER_FILE, ORDER_LINES_BY_ITEM_FILE,
+};
+
+static void removeFiles(void) {
+    for (size_t i = 0; i < sizeof(files) / sizeof(files[0]); i++) {
+        remove(files[i]);
+    }
+}
+
+static void placeTestOrder(int id, time_t orderDate, int itemId, int quantity, int otherItemId) {
+    Order order = {id, 1, orderDate, 0, "Pending", 0};
+    OrderLine lines[2] = {
+        {0, 0, itemId, quantity, MONEY(10.00), MONEY(6.00), orderDate},
+        {0, 0, otherItemId, 1, MONEY(3.00), MONEY(1.00), orderDate},
+    };
+    order.totalAmount = quantity * MONEY(10.00) + MONEY(3.00);
+    order.profit = quantity * MONEY(4.00) + MONEY(2.00);
+    TEST_ASSERT_TRUE(commitOrder(&order, lines, 2));
+}
+
+void setUp(void) {
+    // Set up test environment
+    initializeSystem();
+    removeFiles();
+}
+
+void tearDown(void) {
+    // Clean up test environment
+    walCheckpoint();
+    removeFiles();
+}
+
+void test_lines_are_found_by_order_and_item(void) {
+    placeTestOrder(1, parseDate("2021-01-01"), 7, 2, 8);
+    placeTestOrder(2, parseDate("2021-01-02"), 8, 5, 7);
+
+    OrderLine *lines;
+    long count;
+    TEST_ASSERT_TRUE(orderLinesForOrder(2, &lines, &count));
+    TEST_ASSERT_EQUAL_INT(2, count);
+    TEST_ASSERT_EQUAL_INT(8, lines[0].itemId);
+    TEST_ASSERT_EQUAL_INT(5, lines[0].quantity);
+    free(lines);
+
+    TEST_ASSERT_TRUE(orderLinesForItem(7, &lines, &count));
+    TEST_ASSERT_EQUAL_INT(2, count);
+    TEST_ASSERT_EQUAL_INT(2, lines[0].orderId); // Newest first
+    TEST_ASSERT_EQUAL_INT(1, lines[1].orderId);
+    free(lines);
+}
+
+void test_indexes_rebuild_and_survive_replay(void) {
+    placeTestOrder(1, parseDate("2021-01-01"), 7, 2, 8);
+    OrderLine *lines;
+    long count;
+    TEST_ASSERT_TRUE(orderLinesForItem(7, &lines, &count));
+    free(lines);
+
+    placeTestOrder(2, parseDate("2021-01-02"), 7, 4, 8);
+    walRecover();
+    remove(ORDER_LINES_BY_ITEM_FILE);
+    orderLinesRebuildIndex();
+    placeTestOrder(3, parseDate("2021-01-03"), 7, 1, 8);
+
+    TEST_ASSERT_TRUE(orderLinesForItem(7, &lines, &count));
+    TEST_ASSERT_EQUAL_INT(3, count);
+    TEST_ASSERT_EQUAL_INT(3, lines[0].orderId);
+    TEST_ASSERT_EQUAL_INT(1, lines[2].orderId);
+    free(lines);
+
+    TEST_ASSERT_TRUE(orderLinesForItem(8, &lines, &count));
+    TEST_ASSERT_EQUAL_INT(3, count);
+    free(lines);
+}
+
+void test_product_report(void) {
+    InventoryItem item = {7, "Widget", "Description", MONEY(6.00), MONEY(10.00), 10};
+    tableAppend(TABLE_INVENTORY, &item);
+    placeTestOrder(1, parseDate("2021-01-01"), 7, 2, 8);
+    placeTestOrder(2, parseDate("2021-01-02") + 3600, 7, 8, 8);
+    placeTestOrder(3, parseDate("2021-01-03"), 7, 5, 8);
+
+    ProductReport report;
+    generateProductReport(7, "2021-01-01", "2021-01-02", &report);
+    TEST_ASSERT_EQUAL_INT(2, report.lineCount);
+    TEST_ASSERT_EQUAL_INT(10, report.unitsSold);
+    TEST_ASSERT_EQUAL_INT(MONEY(100.00), report.revenue);
+    TEST_ASSERT_EQUAL_INT(MONEY(40.00), report.profit);
+    TEST_ASSERT_EQUAL_FLOAT(50.00, report.sellThrough);
+    TEST_ASSERT_EQUAL_FLOAT(1.00, report.turnover);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_lines_are_found_by_order_and_item);
+    RUN_TEST(test_indexes_rebuild_and_survive_replay);
+    RUN_TEST(test_product_report);
+    return UNITY_END();
+}
@@ -24,7 +24,7 @@ void test_place_order(void) {
     Customer customer = {0, "John Doe", "john@example.com", "1234567890", "123 Main St"};
     addCustomer(&customer);
 
-    InventoryItem item = {0, "Test Item", "Test Description", 10.99, 19.99, 100};
+    InventoryItem item = {0, "Test Item", "Test Description", MONEY(10.99), MONEY(19.99), 100};
     addInventoryItem(&item);
 
     Order order = {0};
@@ -43,7 +43,7 @@ void test_update_order_status(void) {
     Customer customer = {0, "John Doe", "john@example.com", "1234567890", "123 Main St"};
     addCustomer(&customer);
 
-    InventoryItem item = {0, "Test Item", "Test Description", 10.99, 19.99, 100};
+    InventoryItem item = {0, "Test Item", "Test Description", MONEY(10.99), MONEY(19.99), 100};
     addInventoryItem(&item);
 
     Order order = {0};
@@ -0,0 +1,99 @@
+#include "../include/common.h"
+#include "../include/table.h"
+#include "../include/rollups.h"
+#include "../include/columns.h"
+#include "../include/financial.h"
+#include "../include/wal.h"
+#include "../include/utils.h"
+#include "unity.h"
+#include <stdio.h>
+#include <string.h>
+
+static void appendOrder(int id, time_t orderDate, Money totalAmount, Money profit) {
+    Order order = {id, 1, orderDate, totalAmount, "Pending", profit};
+    tableAppend(TABLE_ORDERS, &order);
+}
+
+void setUp(void) {
+    // Set up test environment
+    initializeSystem();
+    remove(ORDERS_FILE);
+    remove(ORDERS_INDEX_FILE);
+    remove(ROLLUPS_FILE);
+}
+
+void tearDown(void) {
+    // Clean up test environment
+    walCheckpoint();
+    remove(ORDERS_FILE);
+    remove(ORDERS_INDEX_FILE);
+    remove(ROLLUPS_FILE);
+}
+
+void test_rollups_follow_status_updates_and_deletes(void) {
+    appendOrder(1, parseDate("2021-01-01"), MONEY(100.00), MONEY(40.00));
+    appendOrder(2, parseDate("2021-01-01"), MONEY(50.00), MONEY(10.00));
+    appendOrder(3, parseDate("2021-01-02"), MONEY(70.00), MONEY(20.00));
+
+    DailyRollup total;
+    long day = rollupDayFromDate("2021-01-01");
+    TEST_ASSERT_TRUE(rollupsSum(day, day, &total));
+    TEST_ASSERT_EQUAL_INT(2, total.orderCount);
+    TEST_ASSERT_EQUAL_INT(MONEY(150.00), total.revenue);
+    TEST_ASSERT_EQUAL_INT(MONEY(100.00), total.cost);
+    TEST_ASSERT_EQUAL_INT(2, total.statusCounts[ORDER_STATUS_PENDING]);
+
+    Order order = {1, 1, parseDate("2021-01-01"), MONEY(100.00), "Shipped", MONEY(40.00)};
+    tableUpdateById(TABLE_ORDERS, &order);
+    tableDeleteById(TABLE_ORDERS, 2);
+
+    TEST_ASSERT_TRUE(rollupsSum(day, day + 1, &total));
+    TEST_ASSERT_EQUAL_INT(2, total.orderCount);
+    TEST_ASSERT_EQUAL_INT(MONEY(170.00), total.revenue);
+    TEST_ASSERT_EQUAL_INT(MONEY(60.00), total.profit);
+    TEST_ASSERT_EQUAL_INT(1, total.statusCounts[ORDER_STATUS_PENDING]);
+    TEST_ASSERT_EQUAL_INT(1, total.statusCounts[ORDER_STATUS_SHIPPED]);
+}
+
+void test_reports_include_the_whole_end_day(void) {
+    appendOrder(1, parseDate("2021-01-01"), MONEY(100.00), MONEY(40.00));
+    appendOrder(2, parseDate("2021-01-02") + 15 * 3600, MONEY(150.00), MONEY(60.00));
+    appendOrder(3, parseDate("2021-01-03"), MONEY(500.00), MONEY(100.00));
+
+    SalesReport sales;
+    generateSalesReport("2021-01-01", "2021-01-02", &sales);
+    TEST_ASSERT_EQUAL_INT(MONEY(250.00), sales.totalSales);
+    TEST_ASSERT_EQUAL_INT(2, sales.orderCount);
+
+    ProfitReport summary, listing;
+    generateProfitSummary("2021-01-02", "2021-01-03", &summary);
+    generateProfitReport("2021-01-02", "2021-01-03", &listing);
+    TEST_ASSERT_EQUAL_INT(MONEY(650.00), summary.totalRevenue);
+    TEST_ASSERT_EQUAL_INT(MONEY(160.00), summary.totalProfit);
+    TEST_ASSERT_EQUAL_INT(listing.totalRevenue, summary.totalRevenue);
+    TEST_ASSERT_EQUAL_INT(listing.totalProfit, summary.totalProfit);
+}
+
+void test_rollups_rebuild_when_orders_replaced(void) {
+    appendOrder(1, parseDate("2021-01-01"), MONEY(100.00), MONEY(40.00));
+    appendOrder(2, parseDate("2021-01-01"), MONEY(50.00), MONEY(10.00));
+
+    // Replace the orders behind the totals' back
+    walCheckpoint();
+    remove(ORDERS_FILE);
+    appendOrder(3, parseDate("2021-01-01"), MONEY(20.00), MONEY(5.00));
+
+    DailyRollup total;
+    long day = rollupDayFromDate("2021-01-01");
+    TEST_ASSERT_TRUE(rollupsSum(day, day, &total));
+    TEST_ASSERT_EQUAL_INT(1, total.orderCount);
+    TEST_ASSERT_EQUAL_INT(MONEY(20.00), total.revenue);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_rollups_follow_status_updates_and_deletes);
+    RUN_TEST(test_reports_include_the_whole_end_day);
+    RUN_TEST(test_rollups_rebuild_when_orders_replaced);
+    return UNITY_END();
+}
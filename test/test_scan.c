@@ -0,0 +1,195 @@
+#define _DEFAULT_SOURCE
+#include "../include/common.h"
+#include "../include/table.h"
+#include "../include/scan.h"
+#include "../include/rollups.h"
+#include "../include/columns.h"
+#include "../include/metrics.h"
+#include "../include/wal.h"
+#include "../include/utils.h"
+#include "unity.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Enough orders for four partitions */
+#define TEST_ORDERS (4 * SCAN_MIN_PARTITION_RECORDS + 123)
+
+typedef struct {
+    long firstSlot;
+    long nextSlot;
+    long records;
+    int outOfOrder;
+    Money revenue;
+} TestPartial;
+
+static void removeFiles(void) {
+    const char *names[] = {"", ".id", ".customer", ".date", ".amount", ".profit", ".status"};
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        char path[256];
+        snprintf(path, sizeof(path), "%s%s", ORDERS_COLUMNS_FILE, names[i]);
+        remove(path);
+    }
+    remove(ORDERS_FILE);
+    remove(ORDERS_INDEX_FILE);
+    remove(ORDERS_META_FILE);
+    remove(ROLLUPS_FILE);
+}
+
+/* Orders a few hours apart over about two years; every seventh one deleted */
+static void writeOrders(void) {
+    FILE *file = fopen(ORDERS_FILE, "wb");
+    for (int i = 0; i < TEST_ORDERS; i++) {
+        Order order = {i % 7 == 6 ? 0 : i + 1, 1 + i % 50, 1609459200 + (time_t)i * 1000, 1000 + i % 977,
+                       "Completed", 100 + i % 311};
+        if (i % 3 == 0) {
+            strcpy(order.status, "Pending");
+        }
+        fwrite(&order, sizeof(order), 1, file);
+    }
+    fclose(file);
+}
+
+static void visitOrders(void *state, const void *records, long firstSlot, long count, void *arg) {
+    TestPartial *partial = state;
+    const Order *orders = records;
+    (void)arg;
+    if (partial->records == 0) {
+        partial->firstSlot = firstSlot;
+    } else if (firstSlot != partial->nextSlot) {
+        partial->outOfOrder = 1;
+    }
+    partial->nextSlot = firstSlot + count;
+    partial->records += count;
+    for (long i = 0; i < count; i++) {
+        partial->revenue += orders[i].id > 0 ? orders[i].totalAmount : 0;
+    }
+}
+
+void setUp(void) {
+    // Set up test environment
+    initializeSystem();
+    walCheckpoint();
+    removeFiles();
+    writeOrders();
+}
+
+void tearDown(void) {
+    // Clean up test environment
+    scanSetThreadCount(0);
+    removeFiles();
+}
+
+void test_partitions_cover_every_record_once_in_order(void) {
+    scanSetThreadCount(4);
+    TableScan scan;
+    TEST_ASSERT_TRUE(scanOpen(TABLE_ORDERS, &scan));
+    TEST_ASSERT_EQUAL_INT(TEST_ORDERS, scan.records);
+
+    IoCounters before;
+    IoCounters after;
+    ioCountersGet(&before);
+    TestPartial partials[SCAN_MAX_THREADS];
+    int partitions;
+    TEST_ASSERT_TRUE(scanRun(&scan, visitOrders, NULL, partials, sizeof(partials[0]), &partitions));
+    ioCountersGet(&after);
+    scanClose(&scan);
+
+    TEST_ASSERT_EQUAL_INT(4, partitions);
+    long nextSlot = 0;
+    Money revenue = 0;
+    for (int p = 0; p < partitions; p++) {
+        TEST_ASSERT_EQUAL_INT(nextSlot, partials[p].firstSlot);
+        TEST_ASSERT_FALSE(partials[p].outOfOrder);
+        nextSlot = partials[p].nextSlot;
+        revenue += partials[p].revenue;
+    }
+    TEST_ASSERT_EQUAL_INT(TEST_ORDERS, nextSlot);
+
+    Money expected = 0;
+    for (int i = 0; i < TEST_ORDERS; i++) {
+        expected += i % 7 == 6 ? 0 : 1000 + i % 977;
+    }
+    TEST_ASSERT_TRUE(revenue == expected);
+
+    // The workers' reads are charged to the caller
+    TEST_ASSERT_EQUAL_INT(TEST_ORDERS, (int)(after.recordsScanned - before.recordsScanned));
+    TEST_ASSERT_TRUE(after.bytesRead - before.bytesRead == (uint64_t)TEST_ORDERS * sizeof(Order));
+}
+
+void test_small_tables_use_fewer_threads(void) {
+    scanSetThreadCount(8);
+    remove(ORDERS_FILE);
+    TableScan scan;
+    TEST_ASSERT_TRUE(scanOpen(TABLE_ORDERS, &scan));
+    TEST_ASSERT_EQUAL_INT(0, scan.records);
+
+    TestPartial partials[SCAN_MAX_THREADS];
+    int partitions;
+    TEST_ASSERT_TRUE(scanRun(&scan, visitOrders, NULL, partials, sizeof(partials[0]), &partitions));
+    scanClose(&scan);
+    TEST_ASSERT_EQUAL_INT(1, partitions);
+    TEST_ASSERT_EQUAL_INT(0, partials[0].records);
+}
+
+void test_rebuilds_do_not_depend_on_the_thread_count(void) {
+    DailyRollup serial;
+    DailyRollup parallel;
+    long firstDay = rollupDayFromDate("2021-01-01");
+    long lastDay = rollupDayFromDate("2023-12-31");
+
+    scanSetThreadCount(1);
+    TEST_ASSERT_TRUE(rollupsRebuild());
+    TEST_ASSERT_TRUE(rollupsSum(firstDay, lastDay, &serial));
+    TEST_ASSERT_TRUE(columnsRebuild());
+    OrderColumns columns;
+    TEST_ASSERT_TRUE(columnsLoad(ORDER_COLUMN_MASK(ORDER_COLUMN_AMOUNT), &columns));
+    OrderSegment *segments = malloc((size_t)columns.segmentCount * sizeof(OrderSegment));
+    long segmentCount = columns.segmentCount;
+    memcpy(segments, columns.segments, (size_t)segmentCount * sizeof(OrderSegment));
+
+    scanSetThreadCount(5);
+    TEST_ASSERT_TRUE(rollupsRebuild());
+    TEST_ASSERT_TRUE(rollupsSum(firstDay, lastDay, &parallel));
+    TEST_ASSERT_TRUE(memcmp(&serial, &parallel, sizeof(serial)) == 0);
+    TEST_ASSERT_EQUAL_INT(TEST_ORDERS - TEST_ORDERS / 7, (int)parallel.orderCount);
+
+    // Segments are cut where a month or a full segment ends, whichever partition the rows came from
+    TEST_ASSERT_TRUE(columnsRebuild());
+    TEST_ASSERT_TRUE(columnsLoad(ORDER_COLUMN_MASK(ORDER_COLUMN_AMOUNT), &columns));
+    TEST_ASSERT_EQUAL_INT(segmentCount, columns.segmentCount);
+    TEST_ASSERT_TRUE(memcmp(segments, columns.segments, (size_t)segmentCount * sizeof(OrderSegment)) == 0);
+    TEST_ASSERT_TRUE(columns.totalAmount[TEST_ORDERS - 1] == 1000 + (TEST_ORDERS - 1) % 977);
+    free(segments);
+}
+
+void test_local_dates_match_localtime_across_dst(void) {
+    setenv("TZ", "America/New_York", 1);
+    tzset();
+
+    // Every 20 minutes through both 2021 changes
+    ScanDayCache cache;
+    memset(&cache, 0, sizeof(cache));
+    int mismatches = 0;
+    for (time_t t = 1615600000; t < 1636400000; t += 1200) {
+        struct tm expected;
+        struct tm actual;
+        localtime_r(&t, &expected);
+        TEST_ASSERT_TRUE(scanLocalDate(&cache, t, &actual));
+        mismatches += expected.tm_year != actual.tm_year || expected.tm_mon != actual.tm_mon ||
+                      expected.tm_mday != actual.tm_mday;
+    }
+    TEST_ASSERT_EQUAL_INT(0, mismatches);
+
+    unsetenv("TZ");
+    tzset();
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_partitions_cover_every_record_once_in_order);
+    RUN_TEST(test_small_tables_use_fewer_threads);
+    RUN_TEST(test_rebuilds_do_not_depend_on_the_thread_count);
+    RUN_TEST(test_local_dates_match_localtime_across_dst);
+    return UNITY_END();
+}
@@ -0,0 +1,125 @@
+#include "../include/common.h"
+#include "../include/table.h"
+#include "../include/search.h"
+#include "../include/wal.h"
+#include "../include/utils.h"
+#include "unity.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *files[] = {
+    INVENTORY_FILE, INVENTORY_INDEX_FILE, INVENTORY_SEARCH_FILE, INVENTORY_SEARCH_DELTA_FILE,
+    CUSTOMERS_FILE, CUSTOMERS_INDEX_FILE, CUSTOMERS_SEARCH_FILE, CUSTOMERS_SEARCH_DELTA_FILE,
+};
+
+static void removeFiles(void) {
+    for (size_t i = 0; i < sizeof(files) / sizeof(files[0]); i++) {
+        remove(files[i]);
+    }
+}
+
+static void appendItem(int id, const char *name, const char *description) {
+    InventoryItem item = {id, "", "", MONEY(1.00), MONEY(2.00), 5};
+    strcpy(item.name, name);
+    strcpy(item.description, description);
+    tableAppend(TABLE_INVENTORY, &item);
+}
+
+/* Returns the IDs of the items matching a term, as a count plus the first two */
+static long searchItems(const char *term, int *firstId, int *secondId) {
+    long *slots, count;
+    TEST_ASSERT_TRUE(searchTable(TABLE_INVENTORY, term, &slots, &count));
+    InventoryItem item;
+    *firstId = *secondId = 0;
+    if (count > 0 && tableReadSlot(TABLE_INVENTORY, slots[0], &item)) {
+        *firstId = item.id;
+    }
+    if (count > 1 && tableReadSlot(TABLE_INVENTORY, slots[1], &item)) {
+        *secondId = item.id;
+    }
+    free(slots);
+    return count;
+}
+
+void setUp(void) {
+    // Set up test environment
+    initializeSystem();
+    removeFiles();
+}
+
+void tearDown(void) {
+    // Clean up test environment
+    walCheckpoint();
+    removeFiles();
+}
+
+void test_search_follows_adds_updates_and_deletes(void) {
+    appendItem(1, "Blue Widget", "Small steel widget");
+    appendItem(2, "Red Gadget", "Large plastic gadget");
+    appendItem(3, "Green Widget", "Plastic widget for kids");
+
+    int first, second;
+    TEST_ASSERT_EQUAL_INT(2, searchItems("Widget", &first, &second));
+    TEST_ASSERT_EQUAL_INT(1, first);
+    TEST_ASSERT_EQUAL_INT(3, second);
+    TEST_ASSERT_EQUAL_INT(2, searchItems("lastic", &first, &second));
+    TEST_ASSERT_EQUAL_INT(0, searchItems("widgets", &first, &second));
+
+    InventoryItem item = {2, "Red Widget", "Large plastic widget", MONEY(1.00), MONEY(2.00), 5};
+    tableUpdateById(TABLE_INVENTORY, &item);
+    tableDeleteById(TABLE_INVENTORY, 1);
+
+    TEST_ASSERT_EQUAL_INT(2, searchItems("Widget", &first, &second));
+    TEST_ASSERT_EQUAL_INT(2, first);
+    TEST_ASSERT_EQUAL_INT(3, second);
+    TEST_ASSERT_EQUAL_INT(0, searchItems("Gadget", &first, &second));
+}
+
+void test_short_terms_and_customers(void) {
+    Customer alice = {1, "Alice Smith", "alice@example.com", "555-0100", "1 Main St"};
+    Customer bob = {2, "Bob Jones", "bob@shop.org", "555-0101", "2 High St"};
+    tableAppend(TABLE_CUSTOMERS, &alice);
+    tableAppend(TABLE_CUSTOMERS, &bob);
+
+    long *slots, count;
+    TEST_ASSERT_TRUE(searchTable(TABLE_CUSTOMERS, "shop.org", &slots, &count));
+    TEST_ASSERT_EQUAL_INT(1, count);
+    TEST_ASSERT_EQUAL_INT(1, slots[0]);
+    free(slots);
+
+    // Too short for a trigram: every record is checked
+    TEST_ASSERT_TRUE(searchTable(TABLE_CUSTOMERS, "o", &slots, &count));
+    TEST_ASSERT_EQUAL_INT(2, count);
+    free(slots);
+}
+
+void test_search_rebuilds_when_missing_or_stale(void) {
+    appendItem(1, "Blue Widget", "Small steel widget");
+    walCheckpoint();
+    remove(INVENTORY_SEARCH_FILE);
+    remove(INVENTORY_SEARCH_DELTA_FILE);
+
+    int first, second;
+    TEST_ASSERT_EQUAL_INT(1, searchItems("steel", &first, &second));
+    TEST_ASSERT_EQUAL_INT(1, first);
+
+    // Replace the data file behind the index's back
+    remove(INVENTORY_FILE);
+    appendItem(7, "Copper Pipe", "Half inch pipe");
+    appendItem(8, "Brass Valve", "Fits half inch pipe");
+    remove(INVENTORY_SEARCH_DELTA_FILE);
+
+    TEST_ASSERT_EQUAL_INT(0, searchItems("steel", &first, &second));
+    TEST_ASSERT_EQUAL_INT(2, searchItems("pipe", &first, &second));
+    TEST_ASSERT_EQUAL_INT(7, first);
+    TEST_ASSERT_EQUAL_INT(8, second);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_search_follows_adds_updates_and_deletes);
+    RUN_TEST(test_short_terms_and_customers);
+    RUN_TEST(test_search_rebuilds_when_missing_or_stale);
+    return UNITY_END();
+}
@@ -0,0 +1,218 @@
+#define _DEFAULT_SOURCE
+#include "../include/common.h"
+#include "../include/server.h"
+#include "../include/client.h"
+#include "../include/admin.h"
+#include "../include/table.h"
+#include "../include/wal.h"
+#include "../include/utils.h"
+#include "../include/cache.h"
+#include "unity.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#define TEST_SOCKET "data/test_sbmsd.sock"
+#define TEST_CLIENTS 4
+#define TEST_ORDERS 25
+
+static const char *files[] = {
+    ORDERS_FILE, ORDERS_INDEX_FILE, INVENTORY_FILE, INVENTORY_INDEX_FILE, INVENTORY_HOT_FILE,
+    CUSTOMERS_FILE, CUSTOMERS_INDEX_FILE, CUSTOMERS_HOT_FILE,
+    ORDER_LINES_FILE, ORDER_LINES_INDEX_FILE, ORDER_LINES_LINKS_FILE,
+    ORDER_LINES_BY_ORDER_FILE, ORDER_LINES_BY_ITEM_FILE,
+};
+
+static pthread_t serverThread;
+
+static void removeFiles(void) {
+    for (size_t i = 0; i < sizeof(files) / sizeof(files[0]); i++) {
+        remove(files[i]);
+    }
+}
+
+static void *runServer(void *arg) {
+    (void)arg;
+    serverRun(TEST_SOCKET, 3);
+    return NULL;
+}
+
+static int connectClient(ServerClient *client) {
+    // The server thread may still be binding its socket
+    for (int attempt = 0; attempt < 200; attempt++) {
+        if (serverConnect(TEST_SOCKET, client)) {
+            return 1;
+        }
+        usleep(10000);
+    }
+    return 0;
+}
+
+static void *placeOrders(void *arg) {
+    int *placed = arg;
+    ServerClient client;
+    if (!serverConnect(TEST_SOCKET, &client)) {
+        return NULL;
+    }
+    if (serverRequest(&client, "login admin 0000", NULL) == 1) {
+        for (int i = 0; i < TEST_ORDERS; i++) {
+            *placed += serverRequest(&client, "order place --customer 1 --item 1:1", NULL) == 1;
+        }
+    }
+    serverDisconnect(&client);
+    return NULL;
+}
+
+void setUp(void) {
+    // Set up test environment
+    initializeSystem();
+    ensureDefaultAdmin();
+    removeFiles();
+
+    Customer customer = {1, "John Doe", "john@example.com", "1234567890", "123 Main St"};
+    InventoryItem bolt = {1, "Bolt", "Steel bolt", MONEY(0.40), MONEY(1.00), 1000};
+    tableAppend(TABLE_CUSTOMERS, &customer);
+    tableAppend(TABLE_INVENTORY, &bolt);
+    TEST_ASSERT_EQUAL_INT(0, pthread_create(&serverThread, NULL, runServer, NULL));
+}
+
+void tearDown(void) {
+    // Clean up test environment
+    serverStop();
+    pthread_join(serverThread, NULL);
+    walCheckpoint();
+    removeFiles();
+}
+
+void test_requests_need_login(void) {
+    ServerClient client;
+    TEST_ASSERT_TRUE(connectClient(&client));
+
+    FILE *out = tmpfile();
+    TEST_ASSERT_EQUAL_INT(0, serverRequest(&client, "item get 1", out));
+    TEST_ASSERT_EQUAL_INT(0, serverRequest(&client, "login admin wrong", out));
+    TEST_ASSERT_EQUAL_INT(1, serverRequest(&client, "login admin 0000", out));
+    TEST_ASSERT_EQUAL_INT(1, serverRequest(&client, "item get 1", out));
+
+    char reply[512];
+    rewind(out);
+    TEST_ASSERT_NOT_NULL(fgets(reply, sizeof(reply), out));
+    TEST_ASSERT_EQUAL_STRING("{\"ok\":false,\"error\":\"login required\"}\n", reply);
+    fgets(reply, sizeof(reply), out);
+    fgets(reply, sizeof(reply), out);
+    TEST_ASSERT_NOT_NULL(fgets(reply, sizeof(reply), out));
+    TEST_ASSERT_NOT_NULL(strstr(reply, "\"name\":\"Bolt\""));
+    fclose(out);
+    serverDisconnect(&client);
+}
+
+void test_concurrent_clients_share_one_process(void) {
+    ServerClient client;
+    TEST_ASSERT_TRUE(connectClient(&client));
+    serverDisconnect(&client);
+
+    pthread_t clients[TEST_CLIENTS];
+    int placed[TEST_CLIENTS] = {0};
+    for (int i = 0; i < TEST_CLIENTS; i++) {
+        TEST_ASSERT_EQUAL_INT(0, pthread_create(&clients[i], NULL, placeOrders, &placed[i]));
+    }
+    for (int i = 0; i < TEST_CLIENTS; i++) {
+        pthread_join(clients[i], NULL);
+        TEST_ASSERT_EQUAL_INT(TEST_ORDERS, placed[i]);
+    }
+
+    InventoryItem bolt;
+    TEST_ASSERT_TRUE(tableGetById(TABLE_INVENTORY, 1, &bolt, NULL));
+    TEST_ASSERT_EQUAL_INT(1000 - TEST_CLIENTS * TEST_ORDERS, bolt.quantity);
+    TEST_ASSERT_EQUAL_INT(TEST_CLIENTS * TEST_ORDERS, tableRecordCount(TABLE_ORDERS));
+}
+
+void test_menus_go_through_the_server(void) {
+    ServerClient client;
+    TEST_ASSERT_TRUE(connectClient(&client));
+
+    // A wrong password, then an item added and an order placed from the menus
+    FILE *script = fopen("data/test_client_input.txt", "w");
+    fputs("admin\nwrong\nadmin\n0000\n"
+          "2\n1\nNut\nHex \"M6\" nut\n0.10\n0.25\n500\n6\n"
+          "3\n1\n1\n1\n1\n3\n5\n"
+          "7\n", script);
+    fclose(script);
+    TEST_ASSERT_NOT_NULL(freopen("data/test_client_input.txt", "r", stdin));
+    TEST_ASSERT_TRUE(clientSession(&client));
+    serverDisconnect(&client);
+    remove("data/test_client_input.txt");
+
+    InventoryItem item;
+    TEST_ASSERT_EQUAL_INT(2, tableRecordCount(TABLE_INVENTORY));
+    TEST_ASSERT_TRUE(tableReadSlot(TABLE_INVENTORY, 1, &item));
+    TEST_ASSERT_EQUAL_STRING("Hex \"M6\" nut", item.description);
+    TEST_ASSERT_EQUAL_INT(MONEY(0.25), item.price);
+    TEST_ASSERT_TRUE(tableGetById(TABLE_INVENTORY, 1, &item, NULL));
+    TEST_ASSERT_EQUAL_INT(997, item.quantity);
+    TEST_ASSERT_EQUAL_INT(1, tableRecordCount(TABLE_ORDERS));
+}
+
+void test_table_replies_show_what_the_menus_show(void) {
+    ServerClient client;
+    TEST_ASSERT_TRUE(connectClient(&client));
+
+    FILE *out = tmpfile();
+    TEST_ASSERT_EQUAL_INT(1, serverRequest(&client, "login admin 0000", NULL));
+    TEST_ASSERT_EQUAL_INT(1, serverRequest(&client, "table item list", out));
+    TEST_ASSERT_EQUAL_INT(0, serverRequest(&client, "table order get 99", out));
+
+    char reply[4096];
+    rewind(out);
+    TEST_ASSERT_NOT_NULL(fgets(reply, sizeof(reply), out));
+    TEST_ASSERT_EQUAL_INT(0, strncmp(reply, "{\"ok\":true,\"text\":\"", 19));
+    TEST_ASSERT_NOT_NULL(strstr(reply, "Bolt"));
+    TEST_ASSERT_NOT_NULL(strstr(reply, "\\u000a"));
+    TEST_ASSERT_NOT_NULL(fgets(reply, sizeof(reply), out));
+    TEST_ASSERT_EQUAL_STRING("{\"ok\":false,\"error\":\"order not found\"}\n", reply);
+    fclose(out);
+    serverDisconnect(&client);
+}
+
+void test_admin_commands_need_an_admin(void) {
+    ServerClient client;
+    TEST_ASSERT_TRUE(connectClient(&client));
+    walCheckpoint();
+    long users = tableRecordCount(TABLE_USERS);
+
+    FILE *out = tmpfile();
+    TEST_ASSERT_EQUAL_INT(1, serverRequest(&client, "login admin 0000", NULL));
+    TEST_ASSERT_EQUAL_INT(1, serverRequest(&client, "user add clerk pw", NULL));
+    TEST_ASSERT_EQUAL_INT(1, serverRequest(&client, "login clerk pw", out));
+    TEST_ASSERT_EQUAL_INT(0, serverRequest(&client, "user list", out));
+    TEST_ASSERT_EQUAL_INT(0, serverRequest(&client, "table backup create", out));
+    TEST_ASSERT_EQUAL_INT(1, serverRequest(&client, "item get 1", NULL));
+
+    char reply[512];
+    rewind(out);
+    TEST_ASSERT_NOT_NULL(fgets(reply, sizeof(reply), out));
+    TEST_ASSERT_EQUAL_STRING("{\"ok\":true,\"admin\":false}\n", reply);
+    TEST_ASSERT_NOT_NULL(fgets(reply, sizeof(reply), out));
+    TEST_ASSERT_EQUAL_STRING("{\"ok\":false,\"error\":\"admin login required\"}\n", reply);
+    TEST_ASSERT_NOT_NULL(fgets(reply, sizeof(reply), out));
+    TEST_ASSERT_EQUAL_STRING("{\"ok\":false,\"error\":\"admin login required\"}\n", reply);
+    fclose(out);
+    serverDisconnect(&client);
+
+    // Drop the test user again
+    walCheckpoint();
+    TEST_ASSERT_EQUAL_INT(0, truncate(getTableDef(TABLE_USERS)->dataFile, users * (long)sizeof(User)));
+    cacheInvalidate(TABLE_USERS);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_requests_need_login);
+    RUN_TEST(test_concurrent_clients_share_one_process);
+    RUN_TEST(test_menus_go_through_the_server);
+    RUN_TEST(test_table_replies_show_what_the_menus_show);
+    RUN_TEST(test_admin_commands_need_an_admin);
+    return UNITY_END();
+}
@@ -0,0 +1,164 @@
+#define _DEFAULT_SOURCE
+#include "../include/common.h"
+#include "../include/table.h"
+#include "../include/inventory.h"
+#include "../include/orders.h"
+#include "../include/financial.h"
+#include "../include/command.h"
+#include "../include/metrics.h"
+#include "../include/slowlog.h"
+#include "../include/wal.h"
+#include "../include/utils.h"
+#include "unity.h"
+#include <stdio.h>
+#include <string.h>
+
+static const char *files[] = {
+    INVENTORY_FILE, INVENTORY_INDEX_FILE, INVENTORY_HOT_FILE, INVENTORY_SEARCH_FILE, INVENTORY_SEARCH_DELTA_FILE,
+    SLOW_LOG_FILE,
+};
+
+static void removeFiles(void) {
+    for (size_t i = 0; i < sizeof(files) / sizeof(files[0]); i++) {
+        remove(files[i]);
+    }
+}
+
+/* Reads the whole slow-operation log into text and returns its number of lines */
+static int readLog(char *text, size_t size) {
+    text[0] = '\0';
+    FILE *file = fopen(SLOW_LOG_FILE, "r");
+    if (file == NULL) {
+        return 0;
+    }
+    size_t length = fread(text, 1, size - 1, file);
+    text[length] = '\0';
+    fclose(file);
+
+    int lines = 0;
+    for (size_t i = 0; i < length; i++) {
+        lines += text[i] == '\n';
+    }
+    return lines;
+}
+
+void setUp(void) {
+    // Set up test environment
+    initializeSystem();
+    removeFiles();
+
+    InventoryItem bolt = {1, "Bolt", "Steel bolt", MONEY(0.50), MONEY(1.00), 100};
+    tableAppend(TABLE_INVENTORY, &bolt);
+    walCheckpoint();
+    slowLogConfigure("off");
+}
+
+void tearDown(void) {
+    // Clean up test environment
+    slowLogFlush();
+    walCheckpoint();
+    removeFiles();
+}
+
+void test_thresholds_are_configured_per_operation(void) {
+    TEST_ASSERT_TRUE(slowLogConfigure(NULL));
+    TEST_ASSERT_EQUAL_INT(SLOW_LOG_DEFAULT_MS * 1000000, (int)slowLogThreshold(METRIC_PLACE_ORDER));
+
+    TEST_ASSERT_TRUE(slowLogConfigure("250,place_order=20,sales_report=1.5,get_item=off"));
+    TEST_ASSERT_EQUAL_INT(250000000, (int)slowLogThreshold(METRIC_GET_ORDER));
+    TEST_ASSERT_EQUAL_INT(20000000, (int)slowLogThreshold(METRIC_PLACE_ORDER));
+    TEST_ASSERT_EQUAL_INT(1500000, (int)slowLogThreshold(METRIC_SALES_REPORT));
+    TEST_ASSERT_EQUAL_INT(0, (int)slowLogThreshold(METRIC_GET_ITEM));
+
+    // 0 logs everything, which must not read as off
+    TEST_ASSERT_TRUE(slowLogConfigure("0"));
+    TEST_ASSERT_EQUAL_INT(1, (int)slowLogThreshold(METRIC_GET_ITEM));
+
+    // Invalid specifications change nothing
+    TEST_ASSERT_FALSE(slowLogConfigure("fast"));
+    TEST_ASSERT_FALSE(slowLogConfigure("100,no_such_op=5"));
+    TEST_ASSERT_FALSE(slowLogConfigure("place_order=5,100"));
+    TEST_ASSERT_FALSE(slowLogConfigure("-1"));
+    TEST_ASSERT_EQUAL_INT(1, (int)slowLogThreshold(METRIC_GET_ITEM));
+}
+
+void test_only_calls_over_the_threshold_are_logged(void) {
+    slowLogSetThreshold(METRIC_GET_ITEM, 1);
+    slowLogSetThreshold(METRIC_GET_ORDER, 3600000000000ull);
+
+    InventoryItem item;
+    Order order;
+    TEST_ASSERT_TRUE(getInventoryItemById(1, &item));
+    getOrderById(1, &order);
+    TEST_ASSERT_TRUE(slowLogFlush());
+
+    char text[4096];
+    TEST_ASSERT_EQUAL_INT(1, readLog(text, sizeof(text)));
+    TEST_ASSERT_NOT_NULL(strstr(text, " get_item "));
+    TEST_ASSERT_NOT_NULL(strstr(text, " ms item=1 records=1 read_bytes="));
+    TEST_ASSERT_NULL(strstr(text, "get_order"));
+
+    // The log is only appended to
+    getInventoryItemById(1, &item);
+    TEST_ASSERT_TRUE(slowLogFlush());
+    TEST_ASSERT_EQUAL_INT(2, readLog(text, sizeof(text)));
+}
+
+void test_reports_log_their_date_range(void) {
+    slowLogSetThreshold(METRIC_SALES_REPORT, 1);
+
+    SalesReport report;
+    generateSalesReport("2024-01-01", "2024-12-31", &report);
+    TEST_ASSERT_TRUE(slowLogFlush());
+
+    char text[4096];
+    TEST_ASSERT_EQUAL_INT(1, readLog(text, sizeof(text)));
+    TEST_ASSERT_NOT_NULL(strstr(text, " sales_report "));
+    TEST_ASSERT_NOT_NULL(strstr(text, " from=2024-01-01 to=2024-12-31 records="));
+}
+
+void test_a_full_buffer_counts_the_calls_it_drops(void) {
+    slowLogSetThreshold(METRIC_GET_ITEM, 1);
+
+    InventoryItem item;
+    for (int i = 0; i < SLOW_LOG_RING_SIZE + 10; i++) {
+        getInventoryItemById(1, &item);
+    }
+    TEST_ASSERT_TRUE(slowLogFlush());
+
+    static char text[SLOW_LOG_RING_SIZE * 256];
+    TEST_ASSERT_EQUAL_INT(SLOW_LOG_RING_SIZE + 1, readLog(text, sizeof(text)));
+    TEST_ASSERT_NOT_NULL(strstr(text, " 10 slow operations not logged, the log buffer was full\n"));
+
+    // The freed entries are used again
+    getInventoryItemById(1, &item);
+    TEST_ASSERT_TRUE(slowLogFlush());
+    TEST_ASSERT_EQUAL_INT(SLOW_LOG_RING_SIZE + 2, readLog(text, sizeof(text)));
+}
+
+void test_commands_are_logged_like_the_menus(void) {
+    // 0 logs every call, the same as running with SBMS_SLOW_MS=0
+    TEST_ASSERT_TRUE(slowLogConfigure("0"));
+
+    char *argv[] = {"item", "get", "1"};
+    FILE *out = fopen("/dev/null", "w");
+    TEST_ASSERT_NOT_NULL(out);
+    TEST_ASSERT_TRUE(commandRun(3, argv, out));
+    fclose(out);
+    TEST_ASSERT_TRUE(slowLogFlush());
+
+    char text[4096];
+    TEST_ASSERT_TRUE(readLog(text, sizeof(text)) >= 1);
+    TEST_ASSERT_NOT_NULL(strstr(text, " get_item "));
+    TEST_ASSERT_NOT_NULL(strstr(text, " item=1 "));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_thresholds_are_configured_per_operation);
+    RUN_TEST(test_only_calls_over_the_threshold_are_logged);
+    RUN_TEST(test_reports_log_their_date_range);
+    RUN_TEST(test_a_full_buffer_counts_the_calls_it_drops);
+    RUN_TEST(test_commands_are_logged_like_the_menus);
+    return UNITY_END();
+}
@@ -0,0 +1,92 @@
+#include "../include/common.h"
+#include "../include/table.h"
+#include "../include/wal.h"
+#include "../include/utils.h"
+#include "unity.h"
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+
+#define THREADS 8
+#define APPENDS_PER_THREAD 100
+
+void setUp(void) {
+    // Set up test environment
+    initializeSystem();
+    remove(INVENTORY_FILE);
+    remove(INVENTORY_INDEX_FILE);
+}
+
+void tearDown(void) {
+    // Clean up test environment
+    walCheckpoint();
+    remove(INVENTORY_FILE);
+    remove(INVENTORY_INDEX_FILE);
+}
+
+void test_recover_replays_committed_writes(void) {
+    InventoryItem item = {1, "Item", "Description", MONEY(1.0), MONEY(2.0), 10};
+    tableAppend(TABLE_INVENTORY, &item);
+    item.quantity = 7;
+    tableUpdateById(TABLE_INVENTORY, &item);
+
+    // Simulate losing the unsynced table writes in a crash
+    remove(INVENTORY_FILE);
+    walRecover();
+
+    InventoryItem retrieved_item;
+    TEST_ASSERT_TRUE(tableGetById(TABLE_INVENTORY, 1, &retrieved_item, NULL));
+    TEST_ASSERT_EQUAL_INT(7, retrieved_item.quantity);
+}
+
+void test_multi_op_transaction_is_atomic(void) {
+    InventoryItem first = {1, "First", "Description", MONEY(1.0), MONEY(2.0), 1};
+    InventoryItem second = {2, "Second", "Description", MONEY(1.0), MONEY(2.0), 2};
+
+    WalTxn txn;
+    walBegin(&txn);
+    int firstOp = walLogWrite(&txn, TABLE_INVENTORY, WAL_APPEND_SLOT, &first);
+    int secondOp = walLogWrite(&txn, TABLE_INVENTORY, WAL_APPEND_SLOT, &second);
+    TEST_ASSERT_TRUE(walCommit(&txn));
+    TEST_ASSERT_EQUAL_INT(0, walSlot(&txn, firstOp));
+    TEST_ASSERT_EQUAL_INT(1, walSlot(&txn, secondOp));
+    walEnd(&txn);
+
+    TEST_ASSERT_EQUAL_INT(2, tableRecordCount(TABLE_INVENTORY));
+}
+
+static void *appendWorker(void *arg) {
+    int base = *(int *)arg;
+    for (int i = 1; i <= APPENDS_PER_THREAD; i++) {
+        InventoryItem item = {base + i, "Item", "Description", MONEY(1.0), MONEY(2.0), i};
+        tableAppend(TABLE_INVENTORY, &item);
+    }
+    return NULL;
+}
+
+void test_group_commit_from_many_threads(void) {
+    pthread_t threads[THREADS];
+    int bases[THREADS];
+    for (int t = 0; t < THREADS; t++) {
+        bases[t] = t * APPENDS_PER_THREAD;
+        pthread_create(&threads[t], NULL, appendWorker, &bases[t]);
+    }
+    for (int t = 0; t < THREADS; t++) {
+        pthread_join(threads[t], NULL);
+    }
+
+    TEST_ASSERT_EQUAL_INT(THREADS * APPENDS_PER_THREAD, tableRecordCount(TABLE_INVENTORY));
+
+    InventoryItem item;
+    for (int id = 1; id <= THREADS * APPENDS_PER_THREAD; id++) {
+        TEST_ASSERT_TRUE(tableGetById(TABLE_INVENTORY, id, &item, NULL));
+    }
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_recover_replays_committed_writes);
+    RUN_TEST(test_multi_op_transaction_is_atomic);
+    RUN_TEST(test_group_commit_from_many_threads);
+    return UNITY_END();
+}